@@ -1063,6 +1063,7 @@ ParseArgs(int argc, char **argv)
     if ((*argv)[0] == '-') {
       if (!strcmp(*argv, "-v")) print_verbose = 1;
       else if (!strcmp(*argv, "-debug")) print_debug = 1;
+      else if (!strcmp(*argv, "-threads")) { argc--; argv++; RNSetNumThreads(atoi(*argv)); }
       else if (!strcmp(*argv, "-create_planar_segments")) { create_planar_segments = TRUE; }
       else if (!strcmp(*argv, "-create_multiresolution_hierarchy")) create_multiresolution_hierarchy = TRUE;
       else if (!strcmp(*argv, "-max_image_resolution")) { argc--; argv++; max_image_resolution = atoi(*argv); }
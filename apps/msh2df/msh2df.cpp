@@ -22,8 +22,11 @@ static double grid_border = 3; // in grid units
 static int grid_max_resolution = 512; // in grid units
 static int refinement_radius = 9; // in grid units
 static double truncation_distance = RN_INFINITY; // in world units
+static int distance_estimation_method = 0; // 0=grid and kdtree, 1=jump flooding
+static double band_radius = 2; // in grid units
+static int benchmark_distance_estimation = 0;
 static int estimate_sign = FALSE;
-static int sign_estimation_method = 1; // flood fill
+static int sign_estimation_method = 1; // 0=normals, 1=flood fill, 2=winding number
 static RNBoolean input_is_manifold = 0;
 static RNBoolean input_is_range_scan = 0;
 static R3Point scan_viewpoint(0,0,0);
@@ -47,6 +50,46 @@ struct Point {
   
 
   
+////////////////////////////////////////////////////////////////////////
+// Brick utility functions
+////////////////////////////////////////////////////////////////////////
+
+// Grid cells are processed in parallel in bricks of brick_size^3 cells.
+// Each task reads and writes only the cells of its own bricks (or reads
+// from a copy of the grid), so no two tasks write the same cell.
+
+static const int brick_size = 8;
+
+
+
+static int
+NBricks(const R3Grid *grid)
+{
+  // Return number of bricks covering grid
+  int nx = (grid->XResolution() + brick_size - 1) / brick_size;
+  int ny = (grid->YResolution() + brick_size - 1) / brick_size;
+  int nz = (grid->ZResolution() + brick_size - 1) / brick_size;
+  return nx * ny * nz;
+}
+
+
+
+static void
+BrickRange(const R3Grid *grid, int brick, int lo[3], int hi[3])
+{
+  // Compute range of grid cells in brick (hi is exclusive)
+  int nx = (grid->XResolution() + brick_size - 1) / brick_size;
+  int ny = (grid->YResolution() + brick_size - 1) / brick_size;
+  int b[3] = { brick % nx, (brick / nx) % ny, brick / (nx * ny) };
+  for (int dim = 0; dim < 3; dim++) {
+    lo[dim] = b[dim] * brick_size;
+    hi[dim] = lo[dim] + brick_size;
+    if (hi[dim] > grid->Resolution(dim)) hi[dim] = grid->Resolution(dim);
+  }
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Input/output
 ////////////////////////////////////////////////////////////////////////
@@ -232,6 +275,54 @@ EstimateDistanceUsingGrid(R3Grid *grid, R3Mesh *mesh)
 
 
 
+struct RefineDistanceData {
+  R3Grid *grid;
+  const R3MeshSearchTree *search_tree;
+  RNLength grid_spacing;
+  RNScalar max_distance;
+};
+
+
+
+static void
+RefineDistanceInBricks(int start, int end, void *data)
+{
+  // Get data
+  RefineDistanceData *rd = (RefineDistanceData *) data;
+  R3Grid *grid = rd->grid;
+  RNLength grid_spacing = rd->grid_spacing;
+  RNScalar max_distance = rd->max_distance;
+
+  // Compute the precise distance at every grid cell in bricks
+  for (int brick = start; brick < end; brick++) {
+    int lo[3], hi[3];
+    BrickRange(grid, brick, lo, hi);
+    for (int iz = lo[2]; iz < hi[2]; iz++) {
+      for (int iy = lo[1]; iy < hi[1]; iy++) {
+        for (int ix = lo[0]; ix < hi[0]; ix++) {
+          R3Point world_position = grid->WorldPosition(ix, iy, iz);
+          RNScalar grid_distance = grid->GridValue(ix, iy, iz);
+          RNScalar sign = (grid_distance >= 0) ? 1 : -1;
+          grid_distance = fabs(grid_distance);
+          if (grid_distance > max_distance) continue;
+          RNScalar distance = (grid_distance > grid_spacing) ? grid_distance : grid_spacing;
+          while (distance < max_distance) {
+            distance *= 1.25;
+            R3MeshIntersection closest;
+            rd->search_tree->FindClosest(world_position, closest, 0, distance);
+            if (closest.type != R3_MESH_NULL_TYPE) {
+              grid->SetGridValue(ix, iy, iz, sign * closest.t);
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+
+
 static int
 RefineDistanceUsingKdtree(R3Grid *grid, R3Mesh *mesh, int refinement_radius)
 {
@@ -242,36 +333,410 @@ RefineDistanceUsingKdtree(R3Grid *grid, R3Mesh *mesh, int refinement_radius)
   // Create mesh search tree
   R3MeshSearchTree search_tree(mesh);
 
-  // Compute the precise distance at every grid cell
+  // Compute the precise distance at every grid cell (in parallel over bricks)
   RNLength grid_spacing = grid->GridToWorldScaleFactor();
   RNScalar max_distance = refinement_radius * grid_spacing;
   if (max_distance > mesh->BBox().DiagonalLength()) max_distance = mesh->BBox().DiagonalLength();
   if (max_distance > truncation_distance) max_distance = truncation_distance;
-  for (int iz = 0; iz < grid->ZResolution(); iz++) {
+  RefineDistanceData data;
+  data.grid = grid;
+  data.search_tree = &search_tree;
+  data.grid_spacing = grid_spacing;
+  data.max_distance = max_distance;
+  RNParallelFor(0, NBricks(grid), RefineDistanceInBricks, &data, 1);
+  
+  // Print statistics
+  if (print_verbose) {
+    printf("Refined distance using kdtree ...\n");
+    printf("  Time = %.2f seconds\n", start_time.Elapsed());
+    printf("  Resolution = %d %d %d\n", grid->XResolution(), grid->YResolution(), grid->ZResolution());
+    printf("  Spacing = %g\n", grid->GridToWorldScaleFactor());
+    printf("  Cardinality = %d\n", grid->Cardinality());
+    printf("  Volume = %g\n", grid->Volume());
+    RNInterval grid_range = grid->Range();
+    printf("  Minimum = %g\n", grid_range.Min());
+    printf("  Maximum = %g\n", grid_range.Max());
+    printf("  L1Norm = %g\n", grid->L1Norm());
+    printf("  L2Norm = %g\n", grid->L2Norm());
+    printf("  Refinement grid radius = %d\n", refinement_radius);
+    printf("  Refinement world radius = %g\n", max_distance);
+    fflush(stdout);
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Distance estimation using a narrow band and jump flooding
+////////////////////////////////////////////////////////////////////////
+
+// Exact distances are computed for grid cells within band_radius of the
+// surface by visiting the cells near every face.  Each of those cells
+// becomes a seed holding its closest surface point.  Seeds are then
+// propagated to the rest of the grid by jump flooding: in passes with
+// steps N/2, N/4, ..., 1 (and a final extra pass with step 1), every cell
+// takes the closest seed held by itself or its 26 neighbors at the current
+// step.  Passes read one seed array and write another, so the result does
+// not depend on the order in which cells are visited.
+
+static void
+CellRange(const R3Grid *grid, const R3Box& world_box, RNLength offset, int lo[3], int hi[3])
+{
+  // Compute range of grid cells within offset of box (hi is exclusive)
+  R3Point p0 = grid->GridPosition(world_box.Min() - offset * R3ones_vector);
+  R3Point p1 = grid->GridPosition(world_box.Max() + offset * R3ones_vector);
+  for (int dim = 0; dim < 3; dim++) {
+    lo[dim] = (int) ceil(p0[dim]);
+    hi[dim] = (int) floor(p1[dim]) + 1;
+    if (lo[dim] < 0) lo[dim] = 0;
+    if (hi[dim] > grid->Resolution(dim)) hi[dim] = grid->Resolution(dim);
+  }
+}
+
+
+
+struct BandData {
+  const R3Grid *grid;
+  const R3Mesh *mesh;
+  const int *brick_face_starts;
+  const int *brick_faces;
+  RNLength band_distance;
+  int *seeds;
+  std::vector<R3Point> *brick_seed_positions;
+};
+
+
+
+static void
+ComputeBandInBricks(int start, int end, void *data)
+{
+  // Get data
+  BandData *bd = (BandData *) data;
+  const R3Grid *grid = bd->grid;
+  const R3Mesh *mesh = bd->mesh;
+  RNScalar band_squared_distance = bd->band_distance * bd->band_distance;
+  R3Point world_positions[brick_size * brick_size * brick_size];
+  RNScalar squared_distances[brick_size * brick_size * brick_size];
+  R3Point closest_points[brick_size * brick_size * brick_size];
+
+  // Compute closest points for cells in band in bricks
+  for (int brick = start; brick < end; brick++) {
+    int lo[3], hi[3];
+    BrickRange(grid, brick, lo, hi);
+    int nx = hi[0] - lo[0];
+    int ny = hi[1] - lo[1];
+    for (int iz = lo[2]; iz < hi[2]; iz++) {
+      for (int iy = lo[1]; iy < hi[1]; iy++) {
+        for (int ix = lo[0]; ix < hi[0]; ix++) {
+          int i = ((iz - lo[2]) * ny + (iy - lo[1])) * nx + (ix - lo[0]);
+          world_positions[i] = grid->WorldPosition(ix, iy, iz);
+          squared_distances[i] = FLT_MAX;
+        }
+      }
+    }
+
+    // Visit cells near every face overlapping brick
+    for (int k = bd->brick_face_starts[brick]; k < bd->brick_face_starts[brick+1]; k++) {
+      R3MeshFace *face = mesh->Face(bd->brick_faces[k]);
+      const R3Plane& plane = mesh->FacePlane(face);
+      const R3Box& face_bbox = mesh->FaceBBox(face);
+      int flo[3], fhi[3];
+      CellRange(grid, face_bbox, bd->band_distance, flo, fhi);
+      for (int dim = 0; dim < 3; dim++) {
+        if (flo[dim] < lo[dim]) flo[dim] = lo[dim];
+        if (fhi[dim] > hi[dim]) fhi[dim] = hi[dim];
+      }
+      for (int iz = flo[2]; iz < fhi[2]; iz++) {
+        for (int iy = flo[1]; iy < fhi[1]; iy++) {
+          for (int ix = flo[0]; ix < fhi[0]; ix++) {
+            int i = ((iz - lo[2]) * ny + (iy - lo[1])) * nx + (ix - lo[0]);
+            const R3Point& world_position = world_positions[i];
+            RNScalar bound = (band_squared_distance < squared_distances[i]) ? band_squared_distance : squared_distances[i];
+            RNScalar box_squared_distance = 0;
+            for (int dim = 0; dim < 3; dim++) {
+              RNScalar d = 0;
+              if (world_position[dim] < face_bbox[RN_LO][dim]) d = face_bbox[RN_LO][dim] - world_position[dim];
+              else if (world_position[dim] > face_bbox[RN_HI][dim]) d = world_position[dim] - face_bbox[RN_HI][dim];
+              box_squared_distance += d * d;
+            }
+            if (box_squared_distance > bound) continue;
+            RNScalar plane_distance = R3SignedDistance(plane, world_position);
+            if (plane_distance * plane_distance > bound) continue;
+            R3Point closest_point = mesh->ClosestPointOnFace(face, world_position);
+            RNScalar squared_distance = R3SquaredDistance(world_position, closest_point);
+            if (squared_distance < squared_distances[i]) {
+              squared_distances[i] = squared_distance;
+              closest_points[i] = closest_point;
+            }
+          }
+        }
+      }
+    }
+
+    // Create seeds for cells in band (indexed within brick for now)
+    std::vector<R3Point>& seed_positions = bd->brick_seed_positions[brick];
+    for (int iz = lo[2]; iz < hi[2]; iz++) {
+      for (int iy = lo[1]; iy < hi[1]; iy++) {
+        for (int ix = lo[0]; ix < hi[0]; ix++) {
+          int i = ((iz - lo[2]) * ny + (iy - lo[1])) * nx + (ix - lo[0]);
+          int grid_index;
+          grid->IndicesToIndex(ix, iy, iz, grid_index);
+          if (squared_distances[i] <= band_squared_distance) {
+            bd->seeds[grid_index] = seed_positions.size();
+            seed_positions.push_back(closest_points[i]);
+          }
+          else {
+            bd->seeds[grid_index] = -1;
+          }
+        }
+      }
+    }
+  }
+}
+
+
+
+struct GatherSeedsData {
+  const R3Grid *grid;
+  const int *brick_seed_offsets;
+  std::vector<R3Point> *brick_seed_positions;
+  R3Point *seed_positions;
+  int *seeds;
+};
+
+
+
+static void
+GatherSeedsInBricks(int start, int end, void *data)
+{
+  // Get data
+  GatherSeedsData *gd = (GatherSeedsData *) data;
+  const R3Grid *grid = gd->grid;
+
+  // Convert seed indices from brick to global numbering
+  for (int brick = start; brick < end; brick++) {
+    int offset = gd->brick_seed_offsets[brick];
+    std::vector<R3Point>& brick_seed_positions = gd->brick_seed_positions[brick];
+    for (unsigned int i = 0; i < brick_seed_positions.size(); i++) {
+      gd->seed_positions[offset + i] = brick_seed_positions[i];
+    }
+    int lo[3], hi[3];
+    BrickRange(grid, brick, lo, hi);
+    for (int iz = lo[2]; iz < hi[2]; iz++) {
+      for (int iy = lo[1]; iy < hi[1]; iy++) {
+        for (int ix = lo[0]; ix < hi[0]; ix++) {
+          int grid_index;
+          grid->IndicesToIndex(ix, iy, iz, grid_index);
+          if (gd->seeds[grid_index] >= 0) gd->seeds[grid_index] += offset;
+        }
+      }
+    }
+
+    // Release memory for brick
+    std::vector<R3Point>().swap(brick_seed_positions);
+  }
+}
+
+
+
+struct JumpFloodData {
+  R3Grid *grid;
+  const R3Point *seed_positions;
+  const int *seeds;
+  int *updated_seeds;
+  int step;
+  RNLength max_distance;
+  RNBoolean update_distances;
+};
+
+
+
+static void
+JumpFloodInSlices(int start, int end, void *data)
+{
+  // Get data
+  JumpFloodData *jd = (JumpFloodData *) data;
+  R3Grid *grid = jd->grid;
+  const R3Point *seed_positions = jd->seed_positions;
+  const int *seeds = jd->seeds;
+  int step = jd->step;
+
+  // Find closest seed among neighbors at step for every cell in slices
+  for (int iz = start; iz < end; iz++) {
     for (int iy = 0; iy < grid->YResolution(); iy++) {
+      R3Point row_position = grid->WorldPosition(0, iy, iz);
+      R3Vector row_step = grid->WorldPosition(1, iy, iz) - row_position;
       for (int ix = 0; ix < grid->XResolution(); ix++) {
-        R3Point world_position = grid->WorldPosition(ix, iy, iz);
-        RNScalar grid_distance = grid->GridValue(ix, iy, iz);
-        RNScalar sign = (grid_distance >= 0) ? 1 : -1;
-        grid_distance = fabs(grid_distance);
-        if (grid_distance > max_distance) continue;
-        RNScalar distance = (grid_distance > grid_spacing) ? grid_distance : grid_spacing;
-        while (distance < max_distance) {
-          distance *= 1.25;
-          R3MeshIntersection closest;
-          search_tree.FindClosest(world_position, closest, 0, distance);
-          if (closest.type != R3_MESH_NULL_TYPE) {
-            grid->SetGridValue(ix, iy, iz, sign * closest.t);
-            break;
+        R3Point world_position = row_position + ix * row_step;
+        int grid_index;
+        grid->IndicesToIndex(ix, iy, iz, grid_index);
+        int best_seed = seeds[grid_index];
+        RNScalar best_squared_distance = FLT_MAX;
+        if (best_seed >= 0) best_squared_distance = R3SquaredDistance(world_position, seed_positions[best_seed]);
+        for (int dz = -step; dz <= step; dz += step) {
+          int gz = iz + dz;
+          if ((gz < 0) || (gz >= grid->ZResolution())) continue;
+          for (int dy = -step; dy <= step; dy += step) {
+            int gy = iy + dy;
+            if ((gy < 0) || (gy >= grid->YResolution())) continue;
+            for (int dx = -step; dx <= step; dx += step) {
+              int gx = ix + dx;
+              if ((gx < 0) || (gx >= grid->XResolution())) continue;
+              int neighbor_index;
+              grid->IndicesToIndex(gx, gy, gz, neighbor_index);
+              int seed = seeds[neighbor_index];
+              if ((seed < 0) || (seed == best_seed)) continue;
+              RNScalar squared_distance = R3SquaredDistance(world_position, seed_positions[seed]);
+              if (squared_distance < best_squared_distance) {
+                best_squared_distance = squared_distance;
+                best_seed = seed;
+              }
+            }
           }
         }
+
+        // Update seed
+        jd->updated_seeds[grid_index] = best_seed;
+
+        // Update distance
+        if (jd->update_distances) {
+          RNScalar distance = (best_seed >= 0) ? sqrt(best_squared_distance) : jd->max_distance;
+          grid->SetGridValue(grid_index, distance);
+        }
       }
     }
   }
-  
+}
+
+
+
+static int
+EstimateDistanceUsingJumpFlooding(R3Grid *grid, R3Mesh *mesh, RNLength band_radius)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+
+  // Get convenient variables
+  RNLength grid_spacing = grid->GridToWorldScaleFactor();
+  RNLength band_distance = band_radius * grid_spacing;
+  int nbricks = NBricks(grid);
+  int nbx = (grid->XResolution() + brick_size - 1) / brick_size;
+  int nby = (grid->YResolution() + brick_size - 1) / brick_size;
+
+  // Count faces near each brick (also updates face planes and bboxes before threads read them)
+  int *brick_face_starts = new int [ nbricks + 1 ];
+  for (int i = 0; i <= nbricks; i++) brick_face_starts[i] = 0;
+  for (int i = 0; i < mesh->NFaces(); i++) {
+    R3MeshFace *face = mesh->Face(i);
+    mesh->FacePlane(face);
+    int lo[3], hi[3];
+    CellRange(grid, mesh->FaceBBox(face), band_distance, lo, hi);
+    if ((lo[0] >= hi[0]) || (lo[1] >= hi[1]) || (lo[2] >= hi[2])) continue;
+    for (int bz = lo[2] / brick_size; bz <= (hi[2] - 1) / brick_size; bz++) {
+      for (int by = lo[1] / brick_size; by <= (hi[1] - 1) / brick_size; by++) {
+        for (int bx = lo[0] / brick_size; bx <= (hi[0] - 1) / brick_size; bx++) {
+          brick_face_starts[(bz * nby + by) * nbx + bx + 1]++;
+        }
+      }
+    }
+  }
+
+  // List faces near each brick
+  for (int i = 0; i < nbricks; i++) brick_face_starts[i+1] += brick_face_starts[i];
+  int *brick_faces = new int [ brick_face_starts[nbricks] ];
+  int *brick_face_counts = new int [ nbricks ];
+  for (int i = 0; i < nbricks; i++) brick_face_counts[i] = 0;
+  for (int i = 0; i < mesh->NFaces(); i++) {
+    R3MeshFace *face = mesh->Face(i);
+    int lo[3], hi[3];
+    CellRange(grid, mesh->FaceBBox(face), band_distance, lo, hi);
+    if ((lo[0] >= hi[0]) || (lo[1] >= hi[1]) || (lo[2] >= hi[2])) continue;
+    for (int bz = lo[2] / brick_size; bz <= (hi[2] - 1) / brick_size; bz++) {
+      for (int by = lo[1] / brick_size; by <= (hi[1] - 1) / brick_size; by++) {
+        for (int bx = lo[0] / brick_size; bx <= (hi[0] - 1) / brick_size; bx++) {
+          int brick = (bz * nby + by) * nbx + bx;
+          brick_faces[brick_face_starts[brick] + brick_face_counts[brick]++] = i;
+        }
+      }
+    }
+  }
+  delete [] brick_face_counts;
+
+  // Compute closest points for cells in band (in parallel over bricks)
+  int *seeds = new int [ grid->NEntries() ];
+  std::vector<R3Point> *brick_seed_positions = new std::vector<R3Point> [ nbricks ];
+  BandData band_data;
+  band_data.grid = grid;
+  band_data.mesh = mesh;
+  band_data.brick_face_starts = brick_face_starts;
+  band_data.brick_faces = brick_faces;
+  band_data.band_distance = band_distance;
+  band_data.seeds = seeds;
+  band_data.brick_seed_positions = brick_seed_positions;
+  RNParallelFor(0, nbricks, ComputeBandInBricks, &band_data, 1);
+  delete [] brick_face_starts;
+  delete [] brick_faces;
+
+  // Gather seeds from all bricks
+  int *brick_seed_offsets = new int [ nbricks ];
+  int nseeds = 0;
+  for (int i = 0; i < nbricks; i++) {
+    brick_seed_offsets[i] = nseeds;
+    nseeds += brick_seed_positions[i].size();
+  }
+  R3Point *seed_positions = new R3Point [ (nseeds > 0) ? nseeds : 1 ];
+  GatherSeedsData gather_data;
+  gather_data.grid = grid;
+  gather_data.brick_seed_offsets = brick_seed_offsets;
+  gather_data.brick_seed_positions = brick_seed_positions;
+  gather_data.seed_positions = seed_positions;
+  gather_data.seeds = seeds;
+  RNParallelFor(0, nbricks, GatherSeedsInBricks, &gather_data, 1);
+  delete [] brick_seed_offsets;
+  delete [] brick_seed_positions;
+
+  // Choose first step (only cells within truncation distance need exact seeds)
+  int max_resolution = grid->XResolution();
+  if (grid->YResolution() > max_resolution) max_resolution = grid->YResolution();
+  if (grid->ZResolution() > max_resolution) max_resolution = grid->ZResolution();
+  int max_step = max_resolution;
+  if (truncation_distance < RN_INFINITY) {
+    int truncation_steps = (int) ceil(truncation_distance / grid_spacing) + 1;
+    if (truncation_steps < max_step) max_step = truncation_steps;
+  }
+  int first_step = 1;
+  while (2 * first_step < max_step) first_step *= 2;
+
+  // Propagate seeds (in parallel over slices)
+  int *updated_seeds = new int [ grid->NEntries() ];
+  JumpFloodData flood_data;
+  flood_data.grid = grid;
+  flood_data.seed_positions = seed_positions;
+  flood_data.max_distance = grid->WorldBox().DiagonalLength();
+  std::vector<int> steps;
+  for (int step = first_step; step >= 1; step /= 2) steps.push_back(step);
+  steps.push_back(1);
+  for (unsigned int i = 0; i < steps.size(); i++) {
+    flood_data.seeds = seeds;
+    flood_data.updated_seeds = updated_seeds;
+    flood_data.step = steps[i];
+    flood_data.update_distances = (i == steps.size() - 1) ? TRUE : FALSE;
+    RNParallelFor(0, grid->ZResolution(), JumpFloodInSlices, &flood_data, 1);
+    int *swap = seeds; seeds = updated_seeds; updated_seeds = swap;
+  }
+
+  // Delete temporary memory
+  delete [] seed_positions;
+  delete [] updated_seeds;
+  delete [] seeds;
+
   // Print statistics
   if (print_verbose) {
-    printf("Refined distance using kdtree ...\n");
+    printf("Estimated distance using jump flooding ...\n");
     printf("  Time = %.2f seconds\n", start_time.Elapsed());
     printf("  Resolution = %d %d %d\n", grid->XResolution(), grid->YResolution(), grid->ZResolution());
     printf("  Spacing = %g\n", grid->GridToWorldScaleFactor());
@@ -282,8 +747,9 @@ RefineDistanceUsingKdtree(R3Grid *grid, R3Mesh *mesh, int refinement_radius)
     printf("  Maximum = %g\n", grid_range.Max());
     printf("  L1Norm = %g\n", grid->L1Norm());
     printf("  L2Norm = %g\n", grid->L2Norm());
-    printf("  Refinement grid radius = %d\n", refinement_radius);
-    printf("  Refinement world radius = %g\n", max_distance);
+    printf("  Band grid radius = %g\n", band_radius);
+    printf("  # Seeds = %d\n", nseeds);
+    printf("  # Passes = %d\n", (int) steps.size());
     fflush(stdout);
   }
 
@@ -293,6 +759,80 @@ RefineDistanceUsingKdtree(R3Grid *grid, R3Mesh *mesh, int refinement_radius)
 
 
 
+////////////////////////////////////////////////////////////////////////
+// Distance estimation benchmark
+////////////////////////////////////////////////////////////////////////
+
+static void
+CompareDistances(const R3Grid *grid, const R3Grid *reference_grid,
+  RNScalar& mean_error, RNScalar& max_error)
+{
+  // Compute mean and maximum absolute difference (in grid units)
+  RNScalar sum = 0;
+  max_error = 0;
+  RNScalar world_to_grid = grid->WorldToGridScaleFactor();
+  for (int i = 0; i < grid->NEntries(); i++) {
+    RNScalar error = world_to_grid * fabs(grid->GridValue(i) - reference_grid->GridValue(i));
+    if (error > max_error) max_error = error;
+    sum += error;
+  }
+  mean_error = (grid->NEntries() > 0) ? sum / grid->NEntries() : 0;
+}
+
+
+
+static int
+BenchmarkDistanceEstimation(const R3Grid *grid, R3Mesh *mesh)
+{
+  // Compute reference distances by refining everywhere in grid
+  RNTime reference_time;
+  reference_time.Read();
+  int reference_radius = grid->XResolution() + grid->YResolution() + grid->ZResolution();
+  R3Grid reference_grid(*grid);
+  if (!EstimateDistanceUsingGrid(&reference_grid, mesh)) return 0;
+  if (!RefineDistanceUsingKdtree(&reference_grid, mesh, reference_radius)) return 0;
+  RNScalar reference_seconds = reference_time.Elapsed();
+
+  // Estimate distances with grid and kdtree refinement
+  RNTime grid_time;
+  grid_time.Read();
+  R3Grid grid_method_grid(*grid);
+  if (!EstimateDistanceUsingGrid(&grid_method_grid, mesh)) return 0;
+  if (refinement_radius > 0) {
+    if (!RefineDistanceUsingKdtree(&grid_method_grid, mesh, refinement_radius)) return 0;
+  }
+  RNScalar grid_seconds = grid_time.Elapsed();
+
+  // Estimate distances with jump flooding
+  RNTime jump_flood_time;
+  jump_flood_time.Read();
+  R3Grid jump_flood_grid(*grid);
+  if (!EstimateDistanceUsingJumpFlooding(&jump_flood_grid, mesh, band_radius)) return 0;
+  RNScalar jump_flood_seconds = jump_flood_time.Elapsed();
+
+  // Compare with reference distances
+  RNScalar grid_mean_error, grid_max_error;
+  RNScalar jump_flood_mean_error, jump_flood_max_error;
+  CompareDistances(&grid_method_grid, &reference_grid, grid_mean_error, grid_max_error);
+  CompareDistances(&jump_flood_grid, &reference_grid, jump_flood_mean_error, jump_flood_max_error);
+
+  // Print statistics
+  printf("Benchmarked distance estimation ...\n");
+  printf("  Resolution = %d %d %d\n", grid->XResolution(), grid->YResolution(), grid->ZResolution());
+  printf("  # Threads = %d\n", RNNumThreads());
+  printf("  Reference time = %.2f seconds\n", reference_seconds);
+  printf("  Grid time = %.2f seconds\n", grid_seconds);
+  printf("  Grid error = %g mean, %g max (grid units)\n", grid_mean_error, grid_max_error);
+  printf("  Jump flood time = %.2f seconds\n", jump_flood_seconds);
+  printf("  Jump flood error = %g mean, %g max (grid units)\n", jump_flood_mean_error, jump_flood_max_error);
+  fflush(stdout);
+
+  // Return success
+  return 1;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Sign estimation
 // -1=interior, 1=exterior
@@ -463,6 +1003,112 @@ EstimateSignUsingFloodFill(R3Grid *grid, R3Mesh *mesh)
 
 
 
+static void
+EstimateSignUsingWindingNumberInBlock(R3Grid *grid, const R3MeshWindingTree *tree, const int lo[3], const int hi[3])
+{
+  // Check if block is far from surface (then cells are all inside or all outside,
+  // unless the winding number crosses 1/2 in a hole, which the corners should reveal)
+  RNLength grid_spacing = grid->GridToWorldScaleFactor();
+  int n[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+  if (n[0] * n[1] * n[2] > 8) {
+    RNScalar max_distance = 0;
+    for (int iz = lo[2]; iz < hi[2]; iz++) {
+      for (int iy = lo[1]; iy < hi[1]; iy++) {
+        for (int ix = lo[0]; ix < hi[0]; ix++) {
+          RNScalar distance = grid->GridValue(ix, iy, iz);
+          if (distance > max_distance) max_distance = distance;
+        }
+      }
+    }
+    RNLength diameter = sqrt((RNScalar) ((n[0]-1)*(n[0]-1) + (n[1]-1)*(n[1]-1) + (n[2]-1)*(n[2]-1))) * grid_spacing;
+    if (max_distance > diameter + 2 * grid_spacing) {
+      int ninside = 0;
+      for (int corner = 0; corner < 8; corner++) {
+        int ix = (corner & 1) ? hi[0] - 1 : lo[0];
+        int iy = (corner & 2) ? hi[1] - 1 : lo[1];
+        int iz = (corner & 4) ? hi[2] - 1 : lo[2];
+        if (tree->IsInside(grid->WorldPosition(ix, iy, iz))) ninside++;
+      }
+      if ((ninside == 0) || (ninside == 8)) {
+        // Apply same sign to all cells (-1=interior, 1=exterior)
+        if (ninside == 0) return;
+        for (int iz = lo[2]; iz < hi[2]; iz++) {
+          for (int iy = lo[1]; iy < hi[1]; iy++) {
+            for (int ix = lo[0]; ix < hi[0]; ix++) {
+              grid->SetGridValue(ix, iy, iz, -fabs(grid->GridValue(ix, iy, iz)));
+            }
+          }
+        }
+        return;
+      }
+    }
+
+    // Split block into octants
+    int mid[3] = { lo[0] + (n[0]+1)/2, lo[1] + (n[1]+1)/2, lo[2] + (n[2]+1)/2 };
+    for (int octant = 0; octant < 8; octant++) {
+      int child_lo[3], child_hi[3];
+      for (int dim = 0; dim < 3; dim++) {
+        child_lo[dim] = (octant & (1 << dim)) ? mid[dim] : lo[dim];
+        child_hi[dim] = (octant & (1 << dim)) ? hi[dim] : mid[dim];
+      }
+      if ((child_lo[0] == child_hi[0]) || (child_lo[1] == child_hi[1]) || (child_lo[2] == child_hi[2])) continue;
+      EstimateSignUsingWindingNumberInBlock(grid, tree, child_lo, child_hi);
+    }
+    return;
+  }
+
+  // Estimate sign of every cell in small block
+  for (int iz = lo[2]; iz < hi[2]; iz++) {
+    for (int iy = lo[1]; iy < hi[1]; iy++) {
+      for (int ix = lo[0]; ix < hi[0]; ix++) {
+        if (!tree->IsInside(grid->WorldPosition(ix, iy, iz))) continue;
+        grid->SetGridValue(ix, iy, iz, -fabs(grid->GridValue(ix, iy, iz)));
+      }
+    }
+  }
+}
+
+
+
+struct WindingNumberSignData {
+  R3Grid *grid;
+  const R3MeshWindingTree *tree;
+};
+
+
+
+static void
+EstimateSignUsingWindingNumberInBricks(int start, int end, void *data)
+{
+  // Estimate signs of grid cells in bricks
+  WindingNumberSignData *wd = (WindingNumberSignData *) data;
+  for (int brick = start; brick < end; brick++) {
+    int lo[3], hi[3];
+    BrickRange(wd->grid, brick, lo, hi);
+    EstimateSignUsingWindingNumberInBlock(wd->grid, wd->tree, lo, hi);
+  }
+}
+
+
+
+static int
+EstimateSignUsingWindingNumber(R3Grid *grid, R3Mesh *mesh)
+{
+  // Create winding number tree
+  R3MeshWindingTree tree(mesh);
+
+  // Estimate signs of grid cells (in parallel over bricks)
+  WindingNumberSignData data;
+  data.grid = grid;
+  data.tree = &tree;
+  RNParallelFor(0, NBricks(grid), EstimateSignUsingWindingNumberInBricks, &data, 1);
+
+  // Return success
+  return 1;
+}
+
+
+
 static int
 EstimateSign(R3Grid *grid, R3Mesh *mesh)
 {
@@ -478,6 +1124,9 @@ EstimateSign(R3Grid *grid, R3Mesh *mesh)
   else if (sign_estimation_method == 1) {
     if (!EstimateSignUsingFloodFill(grid, mesh)) return 0;
   }
+  else if (sign_estimation_method == 2) {
+    if (!EstimateSignUsingWindingNumber(grid, mesh)) return 0;
+  }
   else {
     RNFail("Unrecognized sign estimation method: %d\n", sign_estimation_method);
     return 0;
@@ -640,64 +1289,104 @@ UpdateSignedDistanceUsingGrid(R3Grid *grid, R3Mesh *mesh)
 
 
 
+struct RefineSignedDistanceData {
+  R3Grid *grid;
+  const R3Kdtree<Point *> *kdtree;
+  RNLength grid_spacing;
+  RNScalar max_distance;
+  int *miss_counts;
+};
+
+
+
+static void
+RefineSignedDistanceInBricks(int start, int end, void *data)
+{
+  // Get data
+  RefineSignedDistanceData *rd = (RefineSignedDistanceData *) data;
+  R3Grid *grid = rd->grid;
+  RNLength grid_spacing = rd->grid_spacing;
+  RNScalar max_distance = rd->max_distance;
+
+  // Compute distance to closest point sample at every negative grid cell in bricks
+  for (int brick = start; brick < end; brick++) {
+    int lo[3], hi[3];
+    BrickRange(grid, brick, lo, hi);
+    for (int iz = lo[2]; iz < hi[2]; iz++) {
+      for (int iy = lo[1]; iy < hi[1]; iy++) {
+        for (int ix = lo[0]; ix < hi[0]; ix++) {
+          // Get current distance
+          RNScalar grid_distance = grid->GridValue(ix, iy, iz);
+          RNScalar sign = (grid_distance < 0) ? -1 : 1;
+
+          // Check if in swath on negative side
+          if (grid_distance >= 0) continue;
+          if (grid_distance < -max_distance) continue;
+
+          // Get world position
+          R3Point world_position = grid->WorldPosition(ix, iy, iz);
+
+          // Find closest point sample
+          Point *closest = rd->kdtree->FindClosest(world_position, 0, fabs(grid_distance) + grid_spacing);
+          if (!closest) {
+            // Indicate should be interpolated later
+            grid->SetGridValue(ix, iy, iz, -FLT_MAX);
+            rd->miss_counts[brick]++;
+            continue;
+          }
+
+          // Compute distance to closest point sample
+          R3Point closest_position = closest->position;
+          R3Plane plane(closest->position, closest->normal);
+          R3Point projected_position = world_position; projected_position.Project(plane);
+          R3Vector tangent_vector = projected_position - closest->position;
+          RNLength tangent_distance = tangent_vector.Length();
+          if (RNIsPositive(tangent_distance)) {
+            tangent_vector /= tangent_distance;
+            if (tangent_distance > closest->radius) tangent_distance = closest->radius;
+            closest_position = closest->position + tangent_distance * tangent_vector;
+          }
+        
+          // Set grid value
+          RNScalar closest_distance = R3Distance(world_position, closest_position);
+          grid->SetGridValue(ix, iy, iz, sign * closest_distance);
+        }
+      }
+    }
+  }
+}
+
+
+
 static int
 RefineSignedDistanceUsingKdtree(R3Grid *grid, const RNArray<Point *>& points, int refinement_radius)
 {
   // Start statistics
   RNTime start_time;
   start_time.Read();
-  int miss_count = 0;
 
   // Create kdtree for point samples 
   Point tmp; int position_offset = (unsigned char *) &(tmp.position) - (unsigned char *) &tmp;
   R3Kdtree<Point *> kdtree(points, position_offset);
   
-  // Compute distance to closest point sample at every negative grid cell
+  // Compute distance to closest point sample at every negative grid cell (in parallel over bricks)
   RNLength grid_spacing = grid->GridToWorldScaleFactor();
   RNScalar max_distance = refinement_radius * grid_spacing;
   if (max_distance > grid->WorldBox().DiagonalLength()) max_distance = grid->WorldBox().DiagonalLength();
   if (max_distance > truncation_distance) max_distance = truncation_distance;
-  for (int iz = 0; iz < grid->ZResolution(); iz++) {
-    for (int iy = 0; iy < grid->YResolution(); iy++) {
-      for (int ix = 0; ix < grid->XResolution(); ix++) {
-        // Get current distance
-        RNScalar grid_distance = grid->GridValue(ix, iy, iz);
-        RNScalar sign = (grid_distance < 0) ? -1 : 1;
-
-        // Check if in swath on negative side
-        if (grid_distance >= 0) continue;
-        if (grid_distance < -max_distance) continue;
-
-        // Get world position
-        R3Point world_position = grid->WorldPosition(ix, iy, iz);
-
-        // Find closest point sample
-        Point *closest = kdtree.FindClosest(world_position, 0, fabs(grid_distance) + grid_spacing);
-        if (!closest) {
-          // Indicate should be interpolated later
-          grid->SetGridValue(ix, iy, iz, -FLT_MAX);
-          miss_count++;
-          continue;
-        }
-
-        // Compute distance to closest point sample
-        R3Point closest_position = closest->position;
-        R3Plane plane(closest->position, closest->normal);
-        R3Point projected_position = world_position; projected_position.Project(plane);
-        R3Vector tangent_vector = projected_position - closest->position;
-        RNLength tangent_distance = tangent_vector.Length();
-        if (RNIsPositive(tangent_distance)) {
-          tangent_vector /= tangent_distance;
-          if (tangent_distance > closest->radius) tangent_distance = closest->radius;
-          closest_position = closest->position + tangent_distance * tangent_vector;
-        }
-        
-        // Set grid value
-        RNScalar closest_distance = R3Distance(world_position, closest_position);
-        grid->SetGridValue(ix, iy, iz, sign * closest_distance);
-      }
-    }
-  }
+  int nbricks = NBricks(grid);
+  int *miss_counts = new int [ nbricks ];
+  for (int i = 0; i < nbricks; i++) miss_counts[i] = 0;
+  RefineSignedDistanceData data;
+  data.grid = grid;
+  data.kdtree = &kdtree;
+  data.grid_spacing = grid_spacing;
+  data.max_distance = max_distance;
+  data.miss_counts = miss_counts;
+  RNParallelFor(0, nbricks, RefineSignedDistanceInBricks, &data, 1);
+  int miss_count = 0;
+  for (int i = 0; i < nbricks; i++) miss_count += miss_counts[i];
+  delete [] miss_counts;
 
   // Fill in missing values (-FLT_MAX)
   grid->Substitute(0, 0.000123456);
@@ -734,58 +1423,109 @@ RefineSignedDistanceUsingKdtree(R3Grid *grid, const RNArray<Point *>& points, in
 // Grid processing
 ////////////////////////////////////////////////////////////////////////
 
+struct SmoothDistanceData {
+  R3Grid *grid;
+  const R3Grid *copy_grid;
+  RNScalar min_distance;
+  RNScalar max_distance;
+  RNLength truncation_distance;
+  int *counts;
+};
+
+
+
+static void
+SmoothDistanceInBricks(int start, int end, void *data)
+{
+  // Get data
+  SmoothDistanceData *sd = (SmoothDistanceData *) data;
+  R3Grid *grid = sd->grid;
+  const R3Grid& copy_grid = *(sd->copy_grid);
+  RNScalar min_distance = sd->min_distance;
+  RNScalar max_distance = sd->max_distance;
+  RNLength truncation_distance = sd->truncation_distance;
+
+  // Smooth and truncate distance at grid cells in bricks
+  for (int brick = start; brick < end; brick++) {
+    int lo[3], hi[3];
+    BrickRange(grid, brick, lo, hi);
+    for (int iz = lo[2]; iz < hi[2]; iz++) {
+      for (int iy = lo[1]; iy < hi[1]; iy++) {
+        for (int ix = lo[0]; ix < hi[0]; ix++) {
+          RNScalar distance = copy_grid.GridValue(ix, iy, iz);
+
+          // Check if on refinement boundary
+          if ((fabs(distance) <= max_distance) && (fabs(distance) >= min_distance)) {
+            // Compute weighted sum of distances for neighbor cells
+            RNScalar sum_weight = 0;
+            RNScalar sum_distance = 0;
+            for (int dz = -1; dz <= 1; dz++) {
+              int gz = iz + dz;
+              if ((gz < 0) || (gz >= grid->ZResolution())) continue;
+              for (int dy = -1; dy <= 1; dy++) {
+                int gy = iy + dy;
+                if ((gy < 0) || (gy >= grid->YResolution())) continue;
+                for (int dx = -1; dx <= 1; dx++) {
+                  int gx = ix + dx;
+                  if ((gx < 0) || (gx >= grid->XResolution())) continue;
+                  RNScalar weight = pow(2, -(dx + dy + dz));
+                  sum_distance += weight * copy_grid.GridValue(gx, gy, gz);
+                  sum_weight += weight;
+                }
+              }
+            }
+
+            // Compute smoothed distance
+            if (!RNIsZero(sum_weight)) {
+              distance = sum_distance / sum_weight;
+              grid->SetGridValue(ix, iy, iz, distance);
+              sd->counts[brick]++;
+            }
+          }
+
+          // Truncate distance
+          if (truncation_distance < RN_INFINITY) {
+            if (distance <= -truncation_distance) grid->SetGridValue(ix, iy, iz, -truncation_distance);
+            else if (distance > truncation_distance) grid->SetGridValue(ix, iy, iz, truncation_distance);
+          }
+        }
+      }
+    }
+  }
+}
+
+
+
 static int
-SmoothDistanceAtRefinementBoundary(R3Grid *grid, int refinement_radius)
+SmoothDistanceAtRefinementBoundary(R3Grid *grid, int refinement_radius, RNLength truncation_distance = RN_INFINITY)
 {
   // Start statistics
   RNTime start_time;
   start_time.Read();
-  int count = 0;
 
   // Copy original grid values
   R3Grid copy_grid(*grid);
   
-  // Smooth distance at grid cells near boundary between kdtree and grid estimation
+  // Smooth distance at grid cells near boundary between kdtree and grid estimation,
+  // and truncate distances in the same pass (in parallel over bricks)
   RNLength grid_spacing = grid->GridToWorldScaleFactor();
   RNScalar min_distance = (refinement_radius-2) * grid_spacing;
   RNScalar max_distance = (refinement_radius+2) * grid_spacing;
   if (min_distance < 2*grid_spacing) min_distance = 2*grid_spacing;
-  for (int iz = 0; iz < grid->ZResolution(); iz++) {
-    for (int iy = 0; iy < grid->YResolution(); iy++) {
-      for (int ix = 0; ix < grid->XResolution(); ix++) {
-        // Check if on refinement boundary
-        RNScalar grid_value = copy_grid.GridValue(ix, iy, iz);
-        if (fabs(grid_value) > max_distance) continue;
-        if (fabs(grid_value) < min_distance) continue;
-
-        // Compute weighted sum of distances for neighbor cells
-        RNScalar sum_weight = 0;
-        RNScalar sum_distance = 0;
-        for (int dz = -1; dz <= 1; dz++) {
-          int gz = iz + dz;
-          if ((gz < 0) || (gz >= grid->ZResolution())) continue;
-          for (int dy = -1; dy <= 1; dy++) {
-            int gy = iy + dy;
-            if ((gy < 0) || (gy >= grid->YResolution())) continue;
-            for (int dx = -1; dx <= 1; dx++) {
-              int gx = ix + dx;
-              if ((gx < 0) || (gx >= grid->XResolution())) continue;
-              RNScalar weight = pow(2, -(dx + dy + dz));
-              RNScalar distance = copy_grid.GridValue(gx, gy, gz);
-              sum_distance += weight * distance;
-              sum_weight += weight;
-            }
-          }
-        }
-        
-        // Set smoothed distance
-        if (RNIsZero(sum_weight)) continue;
-        RNScalar distance = sum_distance / sum_weight;
-        grid->SetGridValue(ix, iy, iz, distance);
-        count++;
-      }
-    }
-  }
+  int nbricks = NBricks(grid);
+  int *counts = new int [ nbricks ];
+  for (int i = 0; i < nbricks; i++) counts[i] = 0;
+  SmoothDistanceData data;
+  data.grid = grid;
+  data.copy_grid = &copy_grid;
+  data.min_distance = min_distance;
+  data.max_distance = max_distance;
+  data.truncation_distance = truncation_distance;
+  data.counts = counts;
+  RNParallelFor(0, nbricks, SmoothDistanceInBricks, &data, 1);
+  int count = 0;
+  for (int i = 0; i < nbricks; i++) count += counts[i];
+  delete [] counts;
 
   // Print statistics
   if (print_verbose) {
@@ -801,6 +1541,7 @@ SmoothDistanceAtRefinementBoundary(R3Grid *grid, int refinement_radius)
     printf("  L1Norm = %g\n", grid->L1Norm());
     printf("  L2Norm = %g\n", grid->L2Norm());
     printf("  Count = %d\n", count);
+    if (truncation_distance < RN_INFINITY) printf("  Threshold = %g\n", truncation_distance);
     fflush(stdout);
   }
 
@@ -922,12 +1663,21 @@ ParseArgs(int argc, char **argv)
       else if (!strcmp(*argv, "-estimate_sign")) estimate_sign = 1; 
       else if (!strcmp(*argv, "-estimate_sign_using_normals")) { estimate_sign = 1; sign_estimation_method = 0; }
       else if (!strcmp(*argv, "-estimate_sign_using_flood_fill")) { estimate_sign = 1; sign_estimation_method = 1; }
+      else if (!strcmp(*argv, "-estimate_sign_using_winding_number")) { estimate_sign = 1; sign_estimation_method = 2; }
       else if (!strcmp(*argv, "-sign_estimation_method")) { argc--; argv++; sign_estimation_method = atoi(*argv); }
       else if (!strcmp(*argv, "-truncation_distance")) { argc--; argv++; truncation_distance = atof(*argv); }
       else if (!strcmp(*argv, "-spacing")) { argc--; argv++; target_grid_spacing = atof(*argv); }
       else if (!strcmp(*argv, "-border")) { argc--; argv++; grid_border = atof(*argv); }
       else if (!strcmp(*argv, "-max_resolution")) { argc--; argv++; grid_max_resolution = atoi(*argv); }
       else if (!strcmp(*argv, "-refinement_radius")) { argc--; argv++; refinement_radius = atoi(*argv); }
+      else if (!strcmp(*argv, "-band_radius")) { argc--; argv++; band_radius = atof(*argv); }
+      else if (!strcmp(*argv, "-benchmark")) benchmark_distance_estimation = 1; 
+      else if (!strcmp(*argv, "-method")) {
+        argc--; argv++;
+        if (!strcmp(*argv, "grid")) distance_estimation_method = 0;
+        else if (!strcmp(*argv, "jump_flood")) distance_estimation_method = 1;
+        else { RNFail("Invalid distance estimation method: %s\n", *argv); exit(1); }
+      }
       else if (!strcmp(*argv, "-output_mesh")) { argc--; argv++; output_mesh_filename = *argv; }
       else if (!strcmp(*argv, "-output_points")) { argc--; argv++; output_points_filename = *argv; }
       else if (!strcmp(*argv, "-input_is_manifold")) { input_is_manifold = 1; }
@@ -989,20 +1739,35 @@ main(int argc, char **argv)
   R3Mesh *mesh = ReadMesh(input_mesh_filename);
   if (!mesh) exit(-1);
 
+  // Compute face planes and vertex normals before they are read by many threads
+  mesh->UpdateDerivedQuantities(FALSE);
+
   // Update program arguments based on mesh properties
   if (grid_bbox.IsEmpty()) grid_bbox = mesh->BBox();
   if (IsManifold(mesh)) input_is_manifold = TRUE;
-  if (input_is_manifold) sign_estimation_method = 1;
+  if (input_is_manifold && (sign_estimation_method == 0)) sign_estimation_method = 1;
 
   // Initialize grid with appropriate dimensions
   R3Grid grid(grid_bbox, target_grid_spacing, 5, grid_max_resolution, grid_border);
 
+  // Compare distance estimation methods
+  if (benchmark_distance_estimation) {
+    if (!BenchmarkDistanceEstimation(&grid, mesh)) exit(-1);
+  }
+
   // Estimate distance
-  if (!EstimateDistanceUsingGrid(&grid, mesh)) return 0;
+  if (distance_estimation_method == 0) {
+    // Estimate distance at grid resolution
+    if (!EstimateDistanceUsingGrid(&grid, mesh)) return 0;
 
-  // Refine distance
-  if (refinement_radius > 0) {
-    if (!RefineDistanceUsingKdtree(&grid, mesh, refinement_radius)) return 0;
+    // Refine distance
+    if (refinement_radius > 0) {
+      if (!RefineDistanceUsingKdtree(&grid, mesh, refinement_radius)) return 0;
+    }
+  }
+  else {
+    // Estimate distance in narrow band and propagate outward
+    if (!EstimateDistanceUsingJumpFlooding(&grid, mesh, band_radius)) return 0;
   }
 
   // Estimate sign
@@ -1037,13 +1802,13 @@ main(int argc, char **argv)
     if (!DeletePoints(points)) return 0;
   }
 
-  // Truncate distance
-  if (refinement_radius > 0) {
-    if (!SmoothDistanceAtRefinementBoundary(&grid, refinement_radius)) exit(-1);
+  // Smooth and truncate distance (jump flooding leaves no refinement boundary unless signed distances were updated)
+  if ((refinement_radius > 0) && ((distance_estimation_method == 0) || update_distances)) {
+    if (!SmoothDistanceAtRefinementBoundary(&grid, refinement_radius, truncation_distance)) exit(-1);
+  }
+  else {
+    if (!TruncateDistance(&grid, truncation_distance)) exit(-1);
   }
-
-  // Truncate distance
-  if (!TruncateDistance(&grid, truncation_distance)) exit(-1);
 
   // Write grid
   if (output_grid_filename) {
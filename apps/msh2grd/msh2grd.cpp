@@ -18,6 +18,7 @@ static int min_resolution = 16;
 static int max_resolution = 512;
 static double grid_spacing = 0.1;
 static int sdf = 0;
+static int stream = 0;
 static int print_verbose = 0;
 
 
@@ -55,18 +56,91 @@ ReadMesh(char *mesh_name)
 
 
 
-static RNLength
-ShortestEdgeLength(R3Mesh *mesh, R3MeshFace *face)
+static void
+RasterizeSignVotes(R3Grid *signs, const R3Point& p0, const R3Point& p1, const R3Point& p2)
 {
-  // Return shortest edge on face
-  RNLength d0 = mesh->EdgeLength(mesh->EdgeOnFace(face, 0));
-  RNLength d1 = mesh->EdgeLength(mesh->EdgeOnFace(face, 1));
-  RNLength d2 = mesh->EdgeLength(mesh->EdgeOnFace(face, 2));
-  RNLength d = FLT_MAX;
-  if (d0 < d) d = d0;
-  if (d1 < d) d = d1;
-  if (d2 < d) d = d2;
-  return d;
+  // Get shortest edge length
+  RNLength e = FLT_MAX;
+  RNLength d0 = R3Distance(p1, p2);
+  RNLength d1 = R3Distance(p2, p0);
+  RNLength d2 = R3Distance(p0, p1);
+  if (d0 < e) e = d0;
+  if (d1 < e) e = d1;
+  if (d2 < e) e = d2;
+  if (e > grid_spacing) e = grid_spacing;
+
+  // Vote for positive sign just in front of triangle and negative sign just behind it
+  R3Point p = (p0 + p1 + p2) / 3.0;
+  const R3Vector& normal = R3Plane(p0, p1, p2).Normal();
+  signs->RasterizeWorldPoint(p + e * normal, 1.0);
+  signs->RasterizeWorldPoint(p - e * normal, -1.0);
+}
+
+
+
+static void
+FinishGrid(R3Grid *grid, const R3Grid *signs)
+{
+  // Make binary (in case triangles overlap)
+  grid->Threshold(0.5, 0, 1);
+
+  // Check if should compute sdf
+  if (sdf && signs) {
+    // Compute distance grid
+    grid->SquaredDistanceTransform();
+    grid->Sqrt();
+    grid->Multiply(grid->GridToWorldScaleFactor());
+
+    // Allocate temmporary memory
+    int *votes = new int [ grid->NEntries() ];
+    int *components = new int [ grid->NEntries() ];
+    for (int i = 0; i < grid->NEntries(); i++) votes[i] = 0;
+    for (int i = 0; i < grid->NEntries(); i++) components[i] = 0;
+
+    // Vote for connected components
+    int ncomponents = grid->ConnectedComponents(0, grid->NEntries(), NULL, NULL, components);
+    if (ncomponents > 0) {
+      for (int i = 0; i < grid->NEntries(); i++) {
+        int component = components[i];
+        if (component < 0) continue;
+        votes[component] += signs->GridValue(i);
+      }
+
+      // Set signs by votes on connected components
+      for (int i = 0; i < grid->NEntries(); i++) {
+        int component = components[i];
+        if (component < 0) continue;
+        if (votes[component] < 0) {
+          RNScalar d = grid->GridValue(i);
+          grid->SetGridValue(i, -d);
+        }
+      }
+    }
+    
+    // Delete temporary memory
+    delete [] components;
+    delete [] votes;
+  }
+}
+
+
+
+static void
+PrintGridStatistics(R3Grid *grid, const RNTime& start_time)
+{
+  // Print statistics
+  printf("Created grid ...\n");
+  printf("  Time = %.2f seconds\n", start_time.Elapsed());
+  printf("  Resolution = %d %d %d\n", grid->XResolution(), grid->YResolution(), grid->ZResolution());
+  printf("  Spacing = %g\n", grid->GridToWorldScaleFactor());
+  printf("  Cardinality = %d\n", grid->Cardinality());
+  printf("  Volume = %g\n", grid->Volume());
+  RNInterval grid_range = grid->Range();
+  printf("  Minimum = %g\n", grid_range.Min());
+  printf("  Maximum = %g\n", grid_range.Max());
+  printf("  L1Norm = %g\n", grid->L1Norm());
+  printf("  L2Norm = %g\n", grid->L2Norm());
+  fflush(stdout);
 }
 
 
@@ -105,75 +179,94 @@ CreateGrid(R3Mesh *mesh)
     }
   }
 
-  // Make binary (in case triangles overlap)
-  grid->Threshold(0.5, 0, 1);
-
-  // Check if should compute sdf
+  // Vote for signs by connected component
+  R3Grid *signs = NULL;
   if (sdf) {
-    // Compute distance grid
-    grid->SquaredDistanceTransform();
-    grid->Sqrt();
-    grid->Multiply(grid->GridToWorldScaleFactor());
-
-    // Allocate temmporary memory
-    int *votes = new int [ grid->NEntries() ];
-    int *components = new int [ grid->NEntries() ];
-    for (int i = 0; i < grid->NEntries(); i++) votes[i] = 0;
-    for (int i = 0; i < grid->NEntries(); i++) components[i] = 0;
-
-    // Vote for signs by connected component
-    R3Grid signs(*grid);
-    signs.Clear(0);
+    signs = new R3Grid(*grid);
+    signs->Clear(0);
     for (int i = 0; i < mesh->NFaces(); i++) {
       R3MeshFace *face = mesh->Face(i);
-      RNLength e = ShortestEdgeLength(mesh, face);
-      if (e > grid_spacing) e = grid_spacing;
-      R3Point p = mesh->FaceCentroid(face);
-      R3Point p1 = p + e * mesh->FaceNormal(face);
-      R3Point p2 = p - e * mesh->FaceNormal(face);
-      signs.RasterizeWorldPoint(p1, 1.0);
-      signs.RasterizeWorldPoint(p2, -1.0);
+      const R3Point& p0 = mesh->VertexPosition(mesh->VertexOnFace(face, 0));
+      const R3Point& p1 = mesh->VertexPosition(mesh->VertexOnFace(face, 1));
+      const R3Point& p2 = mesh->VertexPosition(mesh->VertexOnFace(face, 2));
+      RasterizeSignVotes(signs, p0, p1, p2);
     }
+  }
 
-    // Vote for connected components
-    int ncomponents = grid->ConnectedComponents(0, grid->NEntries(), NULL, NULL, components);
-    if (ncomponents > 0) {
-      for (int i = 0; i < grid->NEntries(); i++) {
-        int component = components[i];
-        if (component < 0) continue;
-        votes[component] += signs.GridValue(i);
-      }
+  // Threshold grid and compute sdf
+  FinishGrid(grid, signs);
+  if (signs) delete signs;
 
-      // Set signs by votes on connected components
-      for (int i = 0; i < grid->NEntries(); i++) {
-        int component = components[i];
-        if (component < 0) continue;
-        if (votes[component] < 0) {
-          RNScalar d = grid->GridValue(i);
-          grid->SetGridValue(i, -d);
-        }
-      }
+  // Print statistics
+  if (print_verbose) PrintGridStatistics(grid, start_time);
+
+  // Return grid
+  return grid;
+}
+
+
+
+static R3Grid *
+StreamGrid(const char *mesh_name)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+
+  // Compute bounding box in a first pass over the input
+  R3MeshStreamReader reader;
+  R3MeshStreamElement element;
+  int type;
+  if (!reader.Open(mesh_name)) return NULL;
+  while ((type = reader.ReadElement(&element)) > 0) { }
+  if (type < 0) return NULL;
+  R3Box bbox = reader.BBox();
+  if (!reader.Close()) return NULL;
+
+  // Allocate grids
+  R3Grid *grid = new R3Grid(bbox, grid_spacing, min_resolution, max_resolution);
+  if (!grid) {
+    RNFail("Unable to allocate grid\n");
+    return NULL;
+  }
+  R3Grid *signs = NULL;
+  if (sdf) {
+    signs = new R3Grid(*grid);
+    signs->Clear(0);
+  }
+
+  // Rasterize triangles (and sign votes) in a second pass
+  int status = reader.Open(mesh_name);
+  if (status) {
+    while ((type = reader.ReadElement(&element)) > 0) {
+      if (type != R3_MESH_STREAM_TRIANGLE) continue;
+      const R3Point& p0 = element.positions[0];
+      const R3Point& p1 = element.positions[1];
+      const R3Point& p2 = element.positions[2];
+      grid->RasterizeWorldTriangle(p0, p1, p2, 1.0);
+      if (signs) RasterizeSignVotes(signs, p0, p1, p2);
     }
-    
-    // Delete temporary memory
-    delete [] components;
-    delete [] votes;
+    if (type < 0) status = 0;
+    if (!reader.Close()) status = 0;
   }
 
+  // Delete grids if second pass failed
+  if (!status) {
+    if (signs) delete signs;
+    delete grid;
+    return NULL;
+  }
+
+  // Threshold grid and compute sdf
+  FinishGrid(grid, signs);
+  if (signs) delete signs;
+
   // Print statistics
   if (print_verbose) {
-    printf("Created grid ...\n");
-    printf("  Time = %.2f seconds\n", start_time.Elapsed());
-    printf("  Resolution = %d %d %d\n", grid->XResolution(), grid->YResolution(), grid->ZResolution());
-    printf("  Spacing = %g\n", grid->GridToWorldScaleFactor());
-    printf("  Cardinality = %d\n", grid->Cardinality());
-    printf("  Volume = %g\n", grid->Volume());
-    RNInterval grid_range = grid->Range();
-    printf("  Minimum = %g\n", grid_range.Min());
-    printf("  Maximum = %g\n", grid_range.Max());
-    printf("  L1Norm = %g\n", grid->L1Norm());
-    printf("  L2Norm = %g\n", grid->L2Norm());
-    fflush(stdout);
+    printf("Streamed mesh ...\n");
+    printf("  # Triangles = %d\n", reader.NTriangles());
+    printf("  Max Active Vertices = %d\n", reader.MaxActiveVertices());
+    PrintGridStatistics(grid, start_time);
   }
 
   // Return grid
@@ -215,6 +308,7 @@ ParseArgs(int argc, char **argv)
     if ((*argv)[0] == '-') {
       if (!strcmp(*argv, "-v")) print_verbose = 1; 
       else if (!strcmp(*argv, "-sdf")) sdf = 1; 
+      else if (!strcmp(*argv, "-stream")) stream = 1; 
       else if (!strcmp(*argv, "-spacing")) { argc--; argv++; grid_spacing = atof(*argv); }
       else if (!strcmp(*argv, "-min_resolution")) { argc--; argv++; min_resolution = atoi(*argv); }
       else if (!strcmp(*argv, "-max_resolution")) { argc--; argv++; max_resolution = atoi(*argv); }
@@ -246,13 +340,22 @@ main(int argc, char **argv)
   // Parse program arguments
   if (!ParseArgs(argc, argv)) exit(-1);
 
-  // Read mesh file
-  R3Mesh *mesh = ReadMesh(mesh_name);
-  if (!mesh) exit(-1);
-
   // Create grid from mesh
-  R3Grid *grid = CreateGrid(mesh);
-  if (!grid) exit(-1);
+  R3Grid *grid = NULL;
+  if (stream) {
+    // Rasterize triangles as they are read, without building mesh
+    grid = StreamGrid(mesh_name);
+    if (!grid) exit(-1);
+  }
+  else {
+    // Read mesh file
+    R3Mesh *mesh = ReadMesh(mesh_name);
+    if (!mesh) exit(-1);
+
+    // Create grid from mesh
+    grid = CreateGrid(mesh);
+    if (!grid) exit(-1);
+  }
 
   // Write grid
   int status = WriteGrid(grid, grid_name);
@@ -6,7 +6,7 @@
 
 namespace gaps {}
 using namespace gaps;
-#include "R3Shapes/R3Shapes.h"
+#include "R3Utils/R3Utils.h"
 
 
 
@@ -24,13 +24,19 @@ int copy_materials = 0;
 int flip_faces = 0;
 int clean = 0;
 int swap_edges = 0;
+int reorder = 0;
+int stream = 0;
 int fill_holes = 0;
 int delete_interior_faces = 0;
 RNScalar smooth_factor = 0;
+RNScalar implicit_smooth_time_step = 0;
 R3Affine xform(R4Matrix(1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1));
 RNLength min_edge_length = 0;
 RNLength max_edge_length = 0;
 RNLength min_component_area = 0;
+int simplify_nfaces = -1;
+RNLength simplify_error = 0;
+int simplify_in_parallel = 0;
 char *xform_name = NULL;
 int scale_by_area = 0;
 int scale_by_pca = 0;
@@ -444,6 +450,236 @@ DeleteInteriorFaces(R3Mesh *mesh)
 
 
 
+static int
+ImplicitSmooth(R3Mesh *mesh)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+
+  // Take one implicit step of mean curvature flow with the cotangent laplacian
+  R3MeshLaplacian laplacian(mesh);
+  RNScalar assembly_time = start_time.Elapsed();
+  int converged = laplacian.Smooth(implicit_smooth_time_step);
+
+  // Print debug statistics
+  if (print_verbose) {
+    printf("  Smoothed mesh implicitly ...\n");
+    printf("    Time = %.2f seconds\n", start_time.Elapsed());
+    printf("    Assembly time = %.2f seconds\n", assembly_time);
+    printf("    # Laplacian Entries = %d\n", laplacian.Matrix().NEntries());
+    printf("    Converged = %s\n", (converged) ? "Yes" : "No");
+    fflush(stdout);
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+static int
+Simplify(R3Mesh *mesh)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+  int nfaces = mesh->NFaces();
+
+  // Collapse edges in order of quadric error
+  R3MeshSimplifier simplifier(mesh);
+  int target_nfaces = (simplify_nfaces >= 0) ? simplify_nfaces : 0;
+  int ncollapses = (simplify_in_parallel) ?
+    simplifier.SimplifyInParallel(target_nfaces, simplify_error) :
+    simplifier.Simplify(target_nfaces, simplify_error);
+
+  // Print debug statistics
+  if (print_verbose) {
+    printf("  Simplified mesh ...\n");
+    printf("    Time = %.2f seconds\n", start_time.Elapsed());
+    printf("    # Collapsed Edges = %d\n", ncollapses);
+    printf("    # Deleted Faces = %d\n", nfaces - mesh->NFaces());
+    printf("    # Remaining Faces = %d\n", mesh->NFaces());
+    fflush(stdout);
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+static RNScalar
+TraverseMesh(R3Mesh *mesh, int nrounds)
+{
+  // Visit the vertices of every face and the neighbors of every vertex
+  // (returns a sum so that the traversal is not optimized away)
+  RNScalar sum = 0;
+  for (int round = 0; round < nrounds; round++) {
+    for (int i = 0; i < mesh->NFaces(); i++) {
+      R3MeshFace *face = mesh->Face(i);
+      for (int j = 0; j < 3; j++) {
+        sum += mesh->VertexPosition(mesh->VertexOnFace(face, j)).X();
+      }
+    }
+    for (int i = 0; i < mesh->NVertices(); i++) {
+      R3MeshVertex *vertex = mesh->Vertex(i);
+      for (int j = 0; j < mesh->VertexValence(vertex); j++) {
+        R3MeshEdge *edge = mesh->EdgeOnVertex(vertex, j);
+        sum += mesh->VertexPosition(mesh->VertexAcrossEdge(edge, vertex)).Y();
+      }
+    }
+  }
+  return sum;
+}
+
+
+
+static int
+Reorder(R3Mesh *mesh)
+{
+  // Time a traversal of the mesh in its original order
+  const int ntraversals = 5;
+  RNTime traversal_time;
+  RNScalar before_time = 0, before_sum = 0;
+  if (print_verbose) {
+    traversal_time.Read();
+    before_sum = TraverseMesh(mesh, ntraversals);
+    before_time = traversal_time.Elapsed();
+  }
+
+  // Reorder vertices, edges, and faces
+  RNTime start_time;
+  start_time.Read();
+  if (!mesh->Reorder()) return 0;
+  RNScalar reorder_time = start_time.Elapsed();
+
+  // Print debug statistics (with time of the same traversal in the new order)
+  if (print_verbose) {
+    traversal_time.Read();
+    RNScalar after_sum = TraverseMesh(mesh, ntraversals);
+    RNScalar after_time = traversal_time.Elapsed();
+    printf("  Reordered mesh ...\n");
+    printf("    Time = %.2f seconds\n", reorder_time);
+    printf("    Traversal time before = %.3f seconds\n", before_time / ntraversals);
+    printf("    Traversal time after = %.3f seconds\n", after_time / ntraversals);
+    printf("    Traversal sums = %g %g\n", before_sum, after_sum);
+    fflush(stdout);
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// STREAMING FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+static int
+StreamMesh(void)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+
+  // Check options (only operators that work triangle by triangle are supported)
+  if (merge_list_name || source_mesh_name || rotate_by_pca || scale_by_pca || align_by_pca ||
+      delete_interior_faces || (min_component_area > 0) || fill_holes || 
+      (smooth_factor > 0) || (implicit_smooth_time_step > 0) ||
+      (min_edge_length > 0) || (max_edge_length > 0) || 
+      (simplify_nfaces >= 0) || (simplify_error > 0) || swap_edges || reorder) {
+    RNFail("Only transformations, -scale_by_area, -center_at_origin, -flip, and -clean are supported with -stream\n");
+    return 0;
+  }
+
+  // Compute area and centroid in a first pass over the input
+  if (scale_by_area || translate_by_centroid) {
+    R3MeshStreamReader reader;
+    if (!reader.Open(input_mesh_name)) return 0;
+    R3MeshStreamElement element;
+    int type;
+    while ((type = reader.ReadElement(&element)) > 0) { }
+    if (type < 0) return 0;
+    if (scale_by_area) {
+      RNArea area = reader.Area();
+      if (area > 0) xform.Scale(1 / sqrt(area));
+    }
+    if (translate_by_centroid) {
+      R3Point centroid = reader.Centroid();
+      xform.Translate(-centroid.Vector());
+    }
+  }
+
+  // Open input and output streams
+  R3MeshStreamReader reader;
+  if (!reader.Open(input_mesh_name, TRUE)) return 0;
+  R3MeshStreamWriter writer;
+  if (!writer.Open(output_mesh_name)) return 0;
+
+  // Process elements one at a time
+  R3MeshStreamElement element;
+  int type, ndegenerate = 0;
+  while ((type = reader.ReadElement(&element)) > 0) {
+    if (type == R3_MESH_STREAM_TRIANGLE) {
+      // Transform
+      if (!xform.IsIdentity()) {
+        for (int k = 0; k < 3; k++) element.positions[k].Transform(xform);
+      }
+
+      // Clean
+      if (clean) {
+        const R3Point *p = element.positions;
+        if (((p[1] - p[0]) % (p[2] - p[0])).IsZero()) { ndegenerate++; continue; }
+      }
+
+      // Flip
+      if (flip_faces) {
+        int swap_index = element.vertex_indices[1];
+        element.vertex_indices[1] = element.vertex_indices[2];
+        element.vertex_indices[2] = swap_index;
+        R3Point swap_position = element.positions[1];
+        element.positions[1] = element.positions[2];
+        element.positions[2] = swap_position;
+      }
+    }
+
+    // Write element
+    if (!writer.WriteElement(element)) return 0;
+  }
+
+  // Check for read error
+  if (type < 0) return 0;
+
+  // Close files
+  if (!reader.Close()) return 0;
+  if (!writer.Close()) return 0;
+
+  // Print statistics
+  if (print_verbose) {
+    const R3Box& bbox = reader.BBox();
+    printf("Streamed mesh ...\n");
+    printf("  Time = %.2f seconds\n", start_time.Elapsed());
+    printf("  # Input Triangles = %d\n", reader.NTriangles());
+    printf("  # Input Vertices = %d\n", reader.NVertices());
+    printf("  # Output Triangles = %d\n", writer.NTriangles());
+    printf("  # Output Vertices = %d\n", writer.NVertices());
+    printf("  # Degenerate Triangles = %d\n", ndegenerate);
+    printf("  Max Active Input Vertices = %d\n", reader.MaxActiveVertices());
+    printf("  Max Active Output Vertices = %d\n", writer.MaxActiveVertices());
+    printf("  Input Area = %g\n", reader.Area());
+    printf("  Input BBox = ( %g %g %g ) ( %g %g %g )\n",
+      bbox.XMin(), bbox.YMin(), bbox.ZMin(), bbox.XMax(), bbox.YMax(), bbox.ZMax());
+    fflush(stdout);
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // PROGRAM ARGUMENT PARSING
 ////////////////////////////////////////////////////////////////////////
@@ -467,6 +703,8 @@ int ParseArgs(int argc, char **argv)
       else if (!strcmp(*argv, "-fill_holes")) fill_holes = 1;
       else if (!strcmp(*argv, "-delete_interior_faces")) delete_interior_faces = 1;
       else if (!strcmp(*argv, "-swap_edges")) swap_edges = 1;
+      else if (!strcmp(*argv, "-reorder")) reorder = 1;
+      else if (!strcmp(*argv, "-stream")) stream = 1;
       else if (!strcmp(*argv, "-scale_by_area")) scale_by_area = 1;
       else if (!strcmp(*argv, "-scale_by_pca")) scale_by_pca = 1;
       else if (!strcmp(*argv, "-translate_by_centroid")) translate_by_centroid = 1;
@@ -478,6 +716,7 @@ int ParseArgs(int argc, char **argv)
       else if (!strcmp(*argv, "-copy_segments")) copy_segments = 1;
       else if (!strcmp(*argv, "-copy_materials")) copy_materials = 1;
       else if (!strcmp(*argv, "-smooth"))  { argv++; argc--; smooth_factor = atof(*argv); }
+      else if (!strcmp(*argv, "-implicit_smooth"))  { argv++; argc--; implicit_smooth_time_step = atof(*argv); }
       else if (!strcmp(*argv, "-scale")) { argv++; argc--; xform = R3identity_affine; xform.Scale(atof(*argv)); xform.Transform(prev_xform); }
       else if (!strcmp(*argv, "-tx")) { argv++; argc--; xform = R3identity_affine; xform.XTranslate(atof(*argv)); xform.Transform(prev_xform); }
       else if (!strcmp(*argv, "-ty")) { argv++; argc--; xform = R3identity_affine; xform.YTranslate(atof(*argv)); xform.Transform(prev_xform);}
@@ -491,6 +730,10 @@ int ParseArgs(int argc, char **argv)
       else if (!strcmp(*argv, "-xform")) { argv++; argc--; R4Matrix m;  if (ReadMatrix(m, *argv)) { xform = R3identity_affine; xform.Transform(R3Affine(m)); xform.Transform(prev_xform);} } 
       else if (!strcmp(*argv, "-min_edge_length")) { argv++; argc--; min_edge_length = atof(*argv); }
       else if (!strcmp(*argv, "-max_edge_length")) { argv++; argc--; max_edge_length = atof(*argv); }
+      else if (!strcmp(*argv, "-simplify")) { argv++; argc--; simplify_nfaces = atoi(*argv); }
+      else if (!strcmp(*argv, "-simplify_error")) { argv++; argc--; simplify_error = atof(*argv); }
+      else if (!strcmp(*argv, "-simplify_in_parallel")) simplify_in_parallel = 1;
+      else if (!strcmp(*argv, "-threads")) { argv++; argc--; RNSetNumThreads(atoi(*argv)); }
       else if (!strcmp(*argv, "-remove_small_components")) { argv++; argc--; min_component_area = atof(*argv); }
       else if (!strcmp(*argv, "-source_mesh")) { argv++; argc--; source_mesh_name = *argv; }
       else if (!strcmp(*argv, "-merge_list")) { argv++; argc--; merge_list_name = *argv; }
@@ -547,6 +790,15 @@ int main(int argc, char **argv)
   // Check number of arguments
   if (!ParseArgs(argc, argv)) exit(1);
 
+  // Process mesh in bounded memory without building it
+  if (stream) {
+    if (!StreamMesh()) exit(-1);
+    if (!xform.IsIdentity() && output_xform_name) {
+      if (!WriteMatrix(xform.Matrix(), output_xform_name)) exit(-1);
+    }
+    return 0;
+  }
+
   // Read mesh
   R3Mesh *mesh = ReadMesh(input_mesh_name);
   if (!mesh) exit(-1);
@@ -636,6 +888,11 @@ int main(int argc, char **argv)
     mesh->Smooth(smooth_factor);
   }
 
+  // Smooth implicitly
+  if (implicit_smooth_time_step > 0) {
+    if (!ImplicitSmooth(mesh)) exit(-1);
+  }
+
   // Subdivide edges that are too long
   if (max_edge_length > 0) {
     mesh->SubdivideLongEdges(max_edge_length);
@@ -646,11 +903,21 @@ int main(int argc, char **argv)
     mesh->CollapseShortEdges(min_edge_length);
   }
 
+  // Simplify with quadric error metrics
+  if ((simplify_nfaces >= 0) || (simplify_error > 0)) {
+    if (!Simplify(mesh)) exit(-1);
+  }
+
   // Swap edges
   if (swap_edges) {
     mesh->SwapEdges();
   }
 
+  // Reorder vertices, edges, and faces for locality
+  if (reorder) {
+    if (!Reorder(mesh)) exit(-1);
+  }
+
   // Transfer colors
   if (source_mesh_name) {
     CopyFromSource(mesh, source_mesh_name);
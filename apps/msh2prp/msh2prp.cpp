@@ -374,10 +374,78 @@ InsertProperty(R3MeshPropertySet *properties, R3MeshProperty *property, int num_
 
 
 
+////////////////////////////////////////////////////////////////////////
+// Parallel property utility functions
+////////////////////////////////////////////////////////////////////////
+
+struct VertexKernelData {
+  R3Mesh *mesh;
+  int nvalues;
+  RNScalar *values;
+  void (*kernel)(R3Mesh *mesh, int vertex_index, RNScalar *values, void *data);
+  void *data;
+};
+
+
+
+static void
+ComputeVertexValuesTask(int start, int end, void *data)
+{
+  // Evaluate kernel for range of vertices
+  VertexKernelData *kernel_data = (VertexKernelData *) data;
+  for (int i = start; i < end; i++) {
+    RNScalar *values = &kernel_data->values[i * kernel_data->nvalues];
+    (*kernel_data->kernel)(kernel_data->mesh, i, values, kernel_data->data);
+  }
+}
+
+
+
+static void
+ComputeVertexProperties(R3Mesh *mesh, R3MeshProperty **properties, int nproperties,
+  void (*kernel)(R3Mesh *mesh, int vertex_index, RNScalar *values, void *data), void *data)
+{
+  // Evaluate kernel for every vertex in parallel (kernel fills one value per property)
+  // The kernel must only read the mesh (see R3Mesh::UpdateDerivedQuantities) and data --
+  // each vertex is computed independently, so the values do not depend on the number of threads
+  VertexKernelData kernel_data;
+  kernel_data.mesh = mesh;
+  kernel_data.nvalues = nproperties;
+  kernel_data.values = new RNScalar [ nproperties * mesh->NVertices() ];
+  kernel_data.kernel = kernel;
+  kernel_data.data = data;
+  RNParallelFor(0, mesh->NVertices(), ComputeVertexValuesTask, &kernel_data, 64);
+
+  // Assign values to properties
+  for (int i = 0; i < mesh->NVertices(); i++) {
+    for (int j = 0; j < nproperties; j++) {
+      properties[j]->SetVertexValue(i, kernel_data.values[i * nproperties + j]);
+    }
+  }
+
+  // Delete values
+  delete [] kernel_data.values;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Basic properties
 ////////////////////////////////////////////////////////////////////////
 
+static void
+ComputeBasicValues(R3Mesh *mesh, int vertex_index, RNScalar *values, void *data)
+{
+  // Compute index, valence, average edge length, and area of vertex
+  R3MeshVertex *vertex = mesh->Vertex(vertex_index);
+  values[0] = mesh->VertexID(vertex);
+  values[1] = mesh->VertexValence(vertex);
+  values[2] = mesh->VertexAverageEdgeLength(vertex);
+  values[3] = mesh->VertexArea(vertex);
+}
+
+
+
 static R3MeshPropertySet *
 ComputeBasicProperties(R3Mesh *mesh)
 {
@@ -403,13 +471,8 @@ ComputeBasicProperties(R3Mesh *mesh)
   R3MeshProperty *area = new R3MeshProperty(mesh, "Area");
 
   // Compute properties
-  for (int i = 0; i < mesh->NVertices(); i++) {
-    R3MeshVertex *vertex = mesh->Vertex(i);
-    index->SetVertexValue(i, mesh->VertexID(vertex));
-    valence->SetVertexValue(i, mesh->VertexValence(vertex));
-    length->SetVertexValue(i, mesh->VertexAverageEdgeLength(vertex));
-    area->SetVertexValue(i, mesh->VertexArea(vertex));
-  }
+  R3MeshProperty *vertex_properties[4] = { index, valence, length, area };
+  ComputeVertexProperties(mesh, vertex_properties, 4, ComputeBasicValues, NULL);
 
   // Insert properties at multiple scales
   InsertProperty(properties, index);
@@ -434,6 +497,23 @@ ComputeBasicProperties(R3Mesh *mesh)
 // Basic properties
 ////////////////////////////////////////////////////////////////////////
 
+static void
+ComputeCoordinateValues(R3Mesh *mesh, int vertex_index, RNScalar *values, void *data)
+{
+  // Compute position and normal of vertex
+  R3MeshVertex *vertex = mesh->Vertex(vertex_index);
+  const R3Point& position = mesh->VertexPosition(vertex);
+  const R3Vector& normal = mesh->VertexNormal(vertex);
+  values[0] = position.X();
+  values[1] = position.Y();
+  values[2] = position.Z();
+  values[3] = normal.X();
+  values[4] = normal.Y();
+  values[5] = normal.Z();
+}
+
+
+
 static R3MeshPropertySet *
 ComputeCoordinateProperties(R3Mesh *mesh)
 {
@@ -461,17 +541,8 @@ ComputeCoordinateProperties(R3Mesh *mesh)
   R3MeshProperty *znormal = new R3MeshProperty(mesh, "ZNormal");
 
   // Compute properties
-  for (int i = 0; i < mesh->NVertices(); i++) {
-    R3MeshVertex *vertex = mesh->Vertex(i);
-    const R3Point& position = mesh->VertexPosition(vertex);
-    const R3Vector& normal = mesh->VertexNormal(vertex);
-    xposition->SetVertexValue(i, position.X());
-    yposition->SetVertexValue(i, position.Y());
-    zposition->SetVertexValue(i, position.Z());
-    xnormal->SetVertexValue(i, normal.X());
-    ynormal->SetVertexValue(i, normal.Y());
-    znormal->SetVertexValue(i, normal.Z());
-  }
+  R3MeshProperty *vertex_properties[6] = { xposition, yposition, zposition, xnormal, ynormal, znormal };
+  ComputeVertexProperties(mesh, vertex_properties, 6, ComputeCoordinateValues, NULL);
 
   // Insert properties at multiple scales
   InsertProperty(properties, xposition);
@@ -582,38 +653,29 @@ static void diagonalize_curv(const R3Vector &old_u, const R3Vector &old_v,
 
 
 
-static R3MeshPropertySet *
-ComputeCurvatureProperties(R3Mesh *mesh)
-{
-  // Start statistics
-  RNTime start_time;
-  start_time.Read();
-  if (print_verbose) {
-    printf("Computing curvature properties ...\n");
-    fflush(stdout);
-  }
+struct CurvatureData {
+  int *vertex_corner_offsets;
+  int *vertex_corners;
+  R3Vector *cornerareas;
+  double *pointareas;
+  R3Vector *pdir1;
+  R3Vector *pdir2;
+  R3Vector *face_t;
+  R3Vector *face_b;
+  RNScalar *face_m;
+  R3Mesh *mesh;
+};
 
-  // Allocate property set
-  R3MeshPropertySet *properties = new R3MeshPropertySet(mesh);
-  if (!properties) {
-    RNFail("Unable to allocate property set.\n");
-    return NULL;
-  }
 
-  // Allocate properites
-  R3MeshProperty *gauss = new R3MeshProperty(mesh, "GaussCurvature");
-  R3MeshProperty *mean = new R3MeshProperty(mesh, "MeanCurvature");
-  R3MeshProperty *min = new R3MeshProperty(mesh, "MinCurvature");
-  R3MeshProperty *max = new R3MeshProperty(mesh, "MaxCurvature");
-
-  // Get convenient variables
-  int nf = mesh->NFaces();
-  int nv = mesh->NVertices();
 
-  // Compute Vertex Area
-  double *pointareas = new double [ nv ];
-  R3Vector *cornerareas = new R3Vector [ nf ];
-  for (int i = 0; i < nf; i++) {
+static void
+ComputeCurvatureCornerAreas(int start, int end, void *data)
+{
+  // Compute area of each corner for range of faces
+  CurvatureData *curvature_data = (CurvatureData *) data;
+  R3Mesh *mesh = curvature_data->mesh;
+  R3Vector *cornerareas = curvature_data->cornerareas;
+  for (int i = start; i < end; i++) {
     // Edges
     R3MeshFace * face = mesh->Face(i);
     R3MeshVertex * vertex[3];
@@ -655,41 +717,50 @@ ComputeCurvatureProperties(R3Mesh *mesh)
       for (int j = 0; j < 3; j++)
         cornerareas[i][j] = ewscale * (ew[(j+1)%3] + ew[(j+2)%3]);
     }
-    pointareas[mesh->VertexID(vertex[0])] += cornerareas[i][0];
-    pointareas[mesh->VertexID(vertex[1])] += cornerareas[i][1];
-    pointareas[mesh->VertexID(vertex[2])] += cornerareas[i][2];
   }
+}
 
-  RNScalar *curv1 = new RNScalar [nv];
-  RNScalar *curv2 = new RNScalar [nv];
-  RNScalar *curv12 = new RNScalar [nv];
-  R3Vector *pdir1 = new R3Vector [nv];
-  R3Vector *pdir2 = new R3Vector [nv];
 
-  // Set up an initial coordinate system per vertex
-  for (int i = 0; i < nf; i++) {
-    R3MeshFace * face = mesh->Face(i);
-    R3MeshVertex * vertex[3];
-    vertex[0] = mesh->VertexOnFace(face, 0);
-    vertex[1] = mesh->VertexOnFace(face, 1);
-    vertex[2] = mesh->VertexOnFace(face, 2);
-    pdir1[mesh->VertexID(vertex[0])] = mesh->VertexPosition(vertex[1]) -
-      mesh->VertexPosition(vertex[0]);
-    pdir1[mesh->VertexID(vertex[1])] = mesh->VertexPosition(vertex[2]) -
-      mesh->VertexPosition(vertex[1]);
-    pdir1[mesh->VertexID(vertex[2])] = mesh->VertexPosition(vertex[0]) -
-      mesh->VertexPosition(vertex[2]);
-  }
 
-  for (int i = 0; i < nv; i++) {
-    R3MeshVertex * vertex = mesh->Vertex(i);
-    pdir1[i] = pdir1[i] % mesh->VertexNormal(vertex);
-    pdir1[i].Normalize();
-    pdir2[i] = mesh->VertexNormal(vertex) % pdir1[i];
+static void
+ComputeCurvatureVertexFrames(int start, int end, void *data)
+{
+  // Compute area and initial coordinate system for range of vertices
+  // (corners are visited in face order, so sums match a serial loop over faces)
+  CurvatureData *curvature_data = (CurvatureData *) data;
+  R3Mesh *mesh = curvature_data->mesh;
+  for (int i = start; i < end; i++) {
+    R3MeshVertex *vertex = mesh->Vertex(i);
+    const R3Vector& normal = mesh->VertexNormal(vertex);
+    double pointarea = 0;
+    R3Vector pdir1 = R3zero_vector;
+    for (int k = curvature_data->vertex_corner_offsets[i]; k < curvature_data->vertex_corner_offsets[i+1]; k++) {
+      int corner = curvature_data->vertex_corners[k];
+      int face_index = corner / 3;
+      int j = corner % 3;
+      pointarea += curvature_data->cornerareas[face_index][j];
+      if (k == curvature_data->vertex_corner_offsets[i+1] - 1) {
+        R3MeshFace *face = mesh->Face(face_index);
+        pdir1 = mesh->VertexPosition(mesh->VertexOnFace(face, (j+1)%3)) - mesh->VertexPosition(vertex);
+      }
+    }
+    pdir1 = pdir1 % normal;
+    pdir1.Normalize();
+    curvature_data->pointareas[i] = pointarea;
+    curvature_data->pdir1[i] = pdir1;
+    curvature_data->pdir2[i] = normal % pdir1;
   }
+}
 
-  // Compute curvature per-face
-  for (int i = 0; i < nf; i++) {
+
+
+static void
+ComputeCurvatureFaceTensors(int start, int end, void *data)
+{
+  // Compute curvature tensor for range of faces
+  CurvatureData *curvature_data = (CurvatureData *) data;
+  R3Mesh *mesh = curvature_data->mesh;
+  for (int i = start; i < end; i++) {
     R3MeshFace * face = mesh->Face(i);
     R3MeshVertex * vertex[3];
     vertex[0] = mesh->VertexOnFace(face, 0);
@@ -708,7 +779,8 @@ ComputeCurvatureProperties(R3Mesh *mesh)
     b.Normalize();
 
     // Estimate curvature based on variation of normals along edges
-    RNScalar m[3] = { 0.0, 0.0, 0.0 };
+    RNScalar *m = &curvature_data->face_m[3*i];
+    m[0] = m[1] = m[2] = 0.0;
     RNScalar w[3][3] = { {0,0,0}, {0,0,0}, {0,0,0} };
     for (int j = 0; j < 3; j++) {
       RNScalar u = e[j].Dot(t);
@@ -728,39 +800,127 @@ ComputeCurvatureProperties(R3Mesh *mesh)
     w[1][2] = w[0][1];
     w[1][0] = w[0][1];
     w[2][1] = w[1][2];
-    RNScalar * matrix_a = new RNScalar[9];
+    RNScalar matrix_a[9];
     for (int kk=0; kk<9; kk++) {
       matrix_a[kk] = w[kk/3][kk%3];
     }
-    RNScalar * bp = new RNScalar[3];
+    RNScalar bp[3];
     bp[0]=m[0];bp[1]=m[1];bp[2]=m[2];
     RNSvdSolve(3, 3, matrix_a, bp, m, 0.0);
-    delete[] matrix_a;
-    delete[] bp;
-    // Push it back out to the vertices
+    curvature_data->face_t[i] = t;
+    curvature_data->face_b[i] = b;
+  }
+}
+
+
+
+static void
+ComputeCurvatureValues(R3Mesh *mesh, int vertex_index, RNScalar *values, void *data)
+{
+  // Push face curvatures out to vertex (in face order, so sums match a serial loop over faces)
+  CurvatureData *curvature_data = (CurvatureData *) data;
+  const R3Vector& pdir1 = curvature_data->pdir1[vertex_index];
+  const R3Vector& pdir2 = curvature_data->pdir2[vertex_index];
+  double pointarea = curvature_data->pointareas[vertex_index];
+  RNScalar curv1 = 0, curv12 = 0, curv2 = 0;
+  for (int k = curvature_data->vertex_corner_offsets[vertex_index]; k < curvature_data->vertex_corner_offsets[vertex_index+1]; k++) {
+    int corner = curvature_data->vertex_corners[k];
+    int face_index = corner / 3;
+    int j = corner % 3;
+    const RNScalar *m = &curvature_data->face_m[3*face_index];
+    RNScalar c1, c12, c2;
+    proj_curv(curvature_data->face_t[face_index], curvature_data->face_b[face_index], m[0], m[1], m[2], pdir1, pdir2, c1, c12, c2);
+    RNScalar wt = (pointarea > 0) ? curvature_data->cornerareas[face_index][j] / pointarea : 1;
+    curv1  += wt * c1;
+    curv12 += wt * c12;
+    curv2  += wt * c2;
+  }
+
+  // Compute principal curvatures
+  R3Vector normal = mesh->VertexNormal(mesh->Vertex(vertex_index));
+  R3Vector principal_dir1, principal_dir2;
+  RNScalar k1, k2;
+  diagonalize_curv(pdir1, pdir2,
+                   curv1, curv12, curv2,
+                   normal, principal_dir1, principal_dir2,
+                   k1, k2);
+  values[0] = k1 * k2;
+  values[1] = (k1 + k2)/2;
+  values[2] = k1;
+  values[3] = k2;
+}
+
+
+
+static R3MeshPropertySet *
+ComputeCurvatureProperties(R3Mesh *mesh)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+  if (print_verbose) {
+    printf("Computing curvature properties ...\n");
+    fflush(stdout);
+  }
+
+  // Allocate property set
+  R3MeshPropertySet *properties = new R3MeshPropertySet(mesh);
+  if (!properties) {
+    RNFail("Unable to allocate property set.\n");
+    return NULL;
+  }
+
+  // Allocate properites
+  R3MeshProperty *gauss = new R3MeshProperty(mesh, "GaussCurvature");
+  R3MeshProperty *mean = new R3MeshProperty(mesh, "MeanCurvature");
+  R3MeshProperty *min = new R3MeshProperty(mesh, "MinCurvature");
+  R3MeshProperty *max = new R3MeshProperty(mesh, "MaxCurvature");
+
+  // Get convenient variables
+  int nf = mesh->NFaces();
+  int nv = mesh->NVertices();
+
+  // Make list of face corners at each vertex, sorted by face
+  CurvatureData data;
+  data.mesh = mesh;
+  data.vertex_corner_offsets = new int [ nv + 1 ];
+  data.vertex_corners = new int [ 3 * nf ];
+  for (int i = 0; i <= nv; i++) data.vertex_corner_offsets[i] = 0;
+  for (int i = 0; i < nf; i++) {
+    R3MeshFace *face = mesh->Face(i);
     for (int j = 0; j < 3; j++) {
-      int vj = mesh->VertexID(vertex[j]);
-      RNScalar c1, c12, c2;
-      proj_curv(t, b, m[0], m[1], m[2], pdir1[vj], pdir2[vj], c1, c12, c2);
-      RNScalar wt = (pointareas[vj] > 0) ? cornerareas[i][j] / pointareas[vj] : 1;
-      curv1[vj]  += wt * c1;
-      curv12[vj] += wt * c12;
-      curv2[vj]  += wt * c2;
+      data.vertex_corner_offsets[mesh->VertexID(mesh->VertexOnFace(face, j)) + 1]++;
     }
   }
-
-  for (int i = 0; i < nv; i++) {
-    R3MeshVertex * vertex = mesh->Vertex(i);
-    R3Vector normal = mesh->VertexNormal(vertex);
-    diagonalize_curv(pdir1[i], pdir2[i],
-                     curv1[i], curv12[i], curv2[i],
-                     normal, pdir1[i], pdir2[i],
-                     curv1[i], curv2[i]);
-    gauss->SetVertexValue(i, curv1[i] * curv2[i]);
-    mean->SetVertexValue(i, (curv1[i] + curv2[i])/2);
-    max->SetVertexValue(i, curv1[i]);
-    min->SetVertexValue(i, curv2[i]);
+  for (int i = 0; i < nv; i++) data.vertex_corner_offsets[i+1] += data.vertex_corner_offsets[i];
+  int *vertex_corner_counts = new int [ nv ];
+  for (int i = 0; i < nv; i++) vertex_corner_counts[i] = 0;
+  for (int i = 0; i < nf; i++) {
+    R3MeshFace *face = mesh->Face(i);
+    for (int j = 0; j < 3; j++) {
+      int vj = mesh->VertexID(mesh->VertexOnFace(face, j));
+      data.vertex_corners[data.vertex_corner_offsets[vj] + vertex_corner_counts[vj]++] = 3*i + j;
+    }
   }
+  delete [] vertex_corner_counts;
+
+  // Compute vertex areas and initial coordinate system per vertex
+  data.cornerareas = new R3Vector [ nf ];
+  data.pointareas = new double [ nv ];
+  data.pdir1 = new R3Vector [nv];
+  data.pdir2 = new R3Vector [nv];
+  RNParallelFor(0, nf, ComputeCurvatureCornerAreas, &data, 1024);
+  RNParallelFor(0, nv, ComputeCurvatureVertexFrames, &data, 1024);
+
+  // Compute curvature per-face
+  data.face_t = new R3Vector [ nf ];
+  data.face_b = new R3Vector [ nf ];
+  data.face_m = new RNScalar [ 3 * nf ];
+  RNParallelFor(0, nf, ComputeCurvatureFaceTensors, &data, 256);
+
+  // Compute curvature per-vertex
+  R3MeshProperty *vertex_properties[4] = { gauss, mean, max, min };
+  ComputeVertexProperties(mesh, vertex_properties, 4, ComputeCurvatureValues, &data);
 
   // Insert properties at multiple scales
   InsertProperty(properties, gauss);
@@ -769,13 +929,15 @@ ComputeCurvatureProperties(R3Mesh *mesh)
   InsertProperty(properties, min);
 
   // Delete temporary memory
-  delete [] pointareas;
-  delete [] cornerareas;
-  delete [] curv1;
-  delete [] curv2;
-  delete [] curv12;
-  delete [] pdir1;
-  delete [] pdir2;
+  delete [] data.vertex_corner_offsets;
+  delete [] data.vertex_corners;
+  delete [] data.pointareas;
+  delete [] data.cornerareas;
+  delete [] data.pdir1;
+  delete [] data.pdir2;
+  delete [] data.face_t;
+  delete [] data.face_b;
+  delete [] data.face_m;
 
   // Print statistics
   if (print_verbose) {
@@ -794,32 +956,26 @@ ComputeCurvatureProperties(R3Mesh *mesh)
 // Laplacian properties
 ////////////////////////////////////////////////////////////////////////
 
-static R3MeshPropertySet *
-ComputeLaplacianProperties(R3Mesh *mesh)
-{
-  // Start statistics
-  RNTime start_time;
-  start_time.Read();
-  if (print_verbose) {
-    printf("Computing laplacian properties ...\n");
-    fflush(stdout);
-  }
+struct LaplacianData {
+  R3Mesh *mesh;
+  int n;
+  RNScalar *laplacian_matrix;
+  RNScalar *eigenvectors;
+  RNScalar *decays;
+  int ntimes;
+};
 
-  // Allocate property set
-  R3MeshPropertySet *properties = new R3MeshPropertySet(mesh);
-  if (!properties) {
-    RNFail("Unable to allocate property set.\n");
-    return NULL;
-  }
 
-  // Allocate/initialize laplacian matrix
-  int n = mesh->NVertices();
-  RNScalar *laplacian_matrix = new RNScalar [ n * n ];
-  for (int i = 0; i < n * n; i++) laplacian_matrix[i] = 0;
-  for (int i = 0; i < n; i++) laplacian_matrix[i*n+i] = -1;
 
-  // Compute laplacian matrix entries
-  for (int i1 = 0; i1 < n; i1++) {
+static void
+ComputeLaplacianRows(int start, int end, void *data)
+{
+  // Compute laplacian matrix entries for range of rows
+  LaplacianData *laplacian_data = (LaplacianData *) data;
+  R3Mesh *mesh = laplacian_data->mesh;
+  RNScalar *laplacian_matrix = laplacian_data->laplacian_matrix;
+  int n = laplacian_data->n;
+  for (int i1 = start; i1 < end; i1++) {
     RNScalar total_weight = 0;
     R3MeshVertex *v1 = mesh->Vertex(i1);
     const R3Point& p1 = mesh->VertexPosition(v1);
@@ -860,6 +1016,59 @@ ComputeLaplacianProperties(R3Mesh *mesh)
       }
     }
   }
+}
+
+
+
+static void
+ComputeHeatKernelSignatureValues(R3Mesh *mesh, int vertex_index, RNScalar *values, void *data)
+{
+  // Compute heat kernel signature of vertex at several times
+  LaplacianData *laplacian_data = (LaplacianData *) data;
+  int n = laplacian_data->n;
+  for (int k = 0; k < laplacian_data->ntimes; k++) {
+    const RNScalar *decays = &laplacian_data->decays[k*n];
+    RNScalar hks = 0;
+    for (int j = 0; j < n; j++) {
+      RNScalar phi = laplacian_data->eigenvectors[j*n+vertex_index];
+      hks += decays[j] * phi * phi;
+    }
+    values[k] = hks;
+  }
+}
+
+
+
+static R3MeshPropertySet *
+ComputeLaplacianProperties(R3Mesh *mesh)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+  if (print_verbose) {
+    printf("Computing laplacian properties ...\n");
+    fflush(stdout);
+  }
+
+  // Allocate property set
+  R3MeshPropertySet *properties = new R3MeshPropertySet(mesh);
+  if (!properties) {
+    RNFail("Unable to allocate property set.\n");
+    return NULL;
+  }
+
+  // Allocate/initialize laplacian matrix
+  int n = mesh->NVertices();
+  RNScalar *laplacian_matrix = new RNScalar [ n * n ];
+  for (int i = 0; i < n * n; i++) laplacian_matrix[i] = 0;
+  for (int i = 0; i < n; i++) laplacian_matrix[i*n+i] = -1;
+
+  // Compute laplacian matrix entries
+  LaplacianData data;
+  data.mesh = mesh;
+  data.n = n;
+  data.laplacian_matrix = laplacian_matrix;
+  RNParallelFor(0, n, ComputeLaplacianRows, &data, 64);
 
   // Compute eigenvectors of laplacian
   RNScalar *u = new RNScalar [ n * n ];
@@ -872,26 +1081,28 @@ ComputeLaplacianProperties(R3Mesh *mesh)
   RNScalar lambda1 = eigenvalues[n-2];
   if (lambda1 > 0) time_scale = 1 / (2 * lambda1);
 
-  // Compute HKS at several times
-  RNScalar *hks = new RNScalar [ n ];
+  // Compute decay of each eigenvector at several times
+  const int ntimes = 8;
+  RNScalar *decays = new RNScalar [ ntimes * n ];
   RNScalar t = 0.01 * time_scale;
-  for (int k = 0; k < 8; k++) {
+  for (int k = 0; k < ntimes; k++) {
+    for (int j = 0; j < n; j++) decays[k*n+j] = exp(-t * eigenvalues[j]);
+    t *= 2;
+  }
+
+  // Compute HKS at several times
+  R3MeshProperty *hks_properties[ntimes];
+  for (int k = 0; k < ntimes; k++) {
     char name[256];
     sprintf(name, "HeatKernelSignature%d", k+1);
-    R3MeshProperty *property = new R3MeshProperty(mesh, name);
-    for (int i = 0; i < n; i++) {
-      RNScalar hks = 0;
-      for (int j = 0; j < n; j++) {
-        RNScalar lambda = eigenvalues[j];
-        RNScalar phi = eigenvectors[j*n+i];
-        hks += exp(-t * lambda) * phi * phi;
-      }
-      property->SetVertexValue(i, hks);
-    }
-    InsertProperty(properties, property);
-    t *= 2;
+    hks_properties[k] = new R3MeshProperty(mesh, name);
   }
-  delete [] hks;
+  data.eigenvectors = eigenvectors;
+  data.decays = decays;
+  data.ntimes = ntimes;
+  ComputeVertexProperties(mesh, hks_properties, ntimes, ComputeHeatKernelSignatureValues, &data);
+  for (int k = 0; k < ntimes; k++) InsertProperty(properties, hks_properties[k]);
+  delete [] decays;
 
   // Create/insert properties
   int num_eigenvalues = 10;
@@ -926,6 +1137,17 @@ ComputeLaplacianProperties(R3Mesh *mesh)
 // Volume properties
 ////////////////////////////////////////////////////////////////////////
 
+static void
+ComputeVolumeValues(R3Mesh *mesh, int vertex_index, RNScalar *values, void *data)
+{
+  // Look up grid value at vertex position
+  R3Grid *grid = (R3Grid *) data;
+  const R3Point& position = mesh->VertexPosition(mesh->Vertex(vertex_index));
+  values[0] = grid->WorldValue(position);
+}
+
+
+
 static R3MeshPropertySet *
 ComputeVolumeProperties(R3Mesh *mesh)
 {
@@ -961,12 +1183,7 @@ ComputeVolumeProperties(R3Mesh *mesh)
 
     // Compute vertex values
     grid->Blur(sigma);
-    for (int i = 0; i < mesh->NVertices(); i++) {
-      R3MeshVertex *vertex = mesh->Vertex(i);
-      const R3Point& position = mesh->VertexPosition(vertex);
-      RNScalar value = grid->WorldValue(position);
-      property->SetVertexValue(i, value);
-    }
+    ComputeVertexProperties(mesh, &property, 1, ComputeVolumeValues, grid);
 
     // Insert property
     InsertProperty(properties, property);
@@ -1057,6 +1274,48 @@ ComputeBoundaryProperties(R3Mesh *mesh)
 // Dijkstra distance properties
 ////////////////////////////////////////////////////////////////////////
 
+struct DijkstraDistanceData {
+  R3Mesh *mesh;
+  RNScalar *mean_values;
+  RNScalar *stddev_values;
+  RNScalar *median_values;
+  RNScalar *ten_values;
+  RNScalar *ninety_values;
+  RNScalar *maximum_values;
+};
+
+
+
+static RNScalar
+DijkstraPercentile(const R3MeshDijkstraWorkspace *workspace, int nvalues, RNScalar percentile)
+{
+  // Return distance at given percentile (0-100) -- vertices are reached in order of increasing distance
+  if (nvalues == 0) return 0;
+  int index = (int) (percentile * nvalues / 100.0);
+  if (index >= nvalues) index = nvalues-1;
+  if (index >= workspace->NReachedVertices()) return FLT_MAX;
+  return workspace->VertexDistance(workspace->ReachedVertex(index));
+}
+
+
+
+static void
+ComputeDijkstraDistanceStatistics(const R3MeshDijkstraWorkspace *workspace, int vertex_index, void *data)
+{
+  // Compute statistics of distances from one vertex to all others
+  DijkstraDistanceData *dijkstra_data = (DijkstraDistanceData *) data;
+  int nvertices = dijkstra_data->mesh->NVertices();
+  RNScalar *distances = (RNScalar *) workspace->Distances();
+  dijkstra_data->mean_values[vertex_index] = Mean(distances, nvertices);
+  dijkstra_data->stddev_values[vertex_index] = StandardDeviation(distances, nvertices);
+  dijkstra_data->median_values[vertex_index] = DijkstraPercentile(workspace, nvertices, 50);
+  dijkstra_data->ten_values[vertex_index] = DijkstraPercentile(workspace, nvertices, 10);
+  dijkstra_data->ninety_values[vertex_index] = DijkstraPercentile(workspace, nvertices, 90);
+  dijkstra_data->maximum_values[vertex_index] = Maximum(distances, nvertices);
+}
+
+
+
 static R3MeshPropertySet *
 ComputeDijkstraDistanceProperties(R3Mesh *mesh)
 {
@@ -1075,26 +1334,36 @@ ComputeDijkstraDistanceProperties(R3Mesh *mesh)
     return NULL;
   }
 
-  // Allocate/insert properties
-  R3MeshProperty *mean_property = new R3MeshProperty(mesh, "DijkstraDistanceMean");
-  R3MeshProperty *stddev_property = new R3MeshProperty(mesh, "DijkstraDistanceStddev");
-  R3MeshProperty *median_property = new R3MeshProperty(mesh, "DijkstraDistanceMedian");
-  R3MeshProperty *ten_property = new R3MeshProperty(mesh, "DijkstraDistanceTen");
-  R3MeshProperty *ninety_property = new R3MeshProperty(mesh, "DijkstraDistanceNinety");
-  R3MeshProperty *maximum_property = new R3MeshProperty(mesh, "DijkstraDistanceMaximum");
- 
-  // Compute properties
-  for (int i = 0; i < mesh->NVertices(); i++) {
-    R3MeshVertex *vertex = mesh->Vertex(i);
-    RNLength *distances = mesh->DijkstraDistances(vertex);
-    mean_property->SetVertexValue(i, Mean(distances, mesh->NVertices()));
-    stddev_property->SetVertexValue(i, StandardDeviation(distances, mesh->NVertices()));
-    median_property->SetVertexValue(i, Median(distances, mesh->NVertices()));
-    ten_property->SetVertexValue(i, Percentile(distances, mesh->NVertices(), 10));
-    ninety_property->SetVertexValue(i, Percentile(distances, mesh->NVertices(), 90));
-    maximum_property->SetVertexValue(i, Maximum(distances, mesh->NVertices()));
-    delete [] distances;
-  }
+  // Allocate property values
+  DijkstraDistanceData data;
+  data.mesh = mesh;
+  data.mean_values = new RNScalar [ mesh->NVertices() ];
+  data.stddev_values = new RNScalar [ mesh->NVertices() ];
+  data.median_values = new RNScalar [ mesh->NVertices() ];
+  data.ten_values = new RNScalar [ mesh->NVertices() ];
+  data.ninety_values = new RNScalar [ mesh->NVertices() ];
+  data.maximum_values = new RNScalar [ mesh->NVertices() ];
+
+  // Compute property values from every vertex in parallel
+  RNArray<R3MeshVertex *> vertices;
+  for (int i = 0; i < mesh->NVertices(); i++) vertices.Insert(mesh->Vertex(i));
+  R3MeshDijkstraWorkspace::SearchFromEach(mesh, vertices, 0, ComputeDijkstraDistanceStatistics, &data);
+
+  // Allocate properties
+  R3MeshProperty *mean_property = new R3MeshProperty(mesh, "DijkstraDistanceMean", data.mean_values);
+  R3MeshProperty *stddev_property = new R3MeshProperty(mesh, "DijkstraDistanceStddev", data.stddev_values);
+  R3MeshProperty *median_property = new R3MeshProperty(mesh, "DijkstraDistanceMedian", data.median_values);
+  R3MeshProperty *ten_property = new R3MeshProperty(mesh, "DijkstraDistanceTen", data.ten_values);
+  R3MeshProperty *ninety_property = new R3MeshProperty(mesh, "DijkstraDistanceNinety", data.ninety_values);
+  R3MeshProperty *maximum_property = new R3MeshProperty(mesh, "DijkstraDistanceMaximum", data.maximum_values);
+
+  // Delete property values
+  delete [] data.mean_values;
+  delete [] data.stddev_values;
+  delete [] data.median_values;
+  delete [] data.ten_values;
+  delete [] data.ninety_values;
+  delete [] data.maximum_values;
 
   // Insert properties
   InsertProperty(properties, mean_property);
@@ -1117,6 +1386,61 @@ ComputeDijkstraDistanceProperties(R3Mesh *mesh)
 
 
 
+struct DijkstraHistogramData {
+  R3Mesh *mesh;
+  RNScalar *distances;
+  RNScalar *votes;
+  int nsamples;
+  RNScalar **bin_values;
+  int nbins;
+  RNScalar normalization;
+};
+
+
+
+static void
+CopyDijkstraHistogramDistances(const R3MeshDijkstraWorkspace *workspace, int sample_index, void *data)
+{
+  // Copy distances from one sample vertex
+  DijkstraHistogramData *histogram_data = (DijkstraHistogramData *) data;
+  int nvertices = histogram_data->mesh->NVertices();
+  const RNLength *distances = workspace->Distances();
+  RNScalar *copy = &histogram_data->distances[sample_index * nvertices];
+  for (int j = 0; j < nvertices; j++) copy[j] = distances[j];
+}
+
+
+
+static void
+AddDijkstraHistogramVotes(int start, int end, void *data)
+{
+  // Add votes for range of vertices from samples (in order, so sums do not depend on threads)
+  DijkstraHistogramData *histogram_data = (DijkstraHistogramData *) data;
+  int nvertices = histogram_data->mesh->NVertices();
+  int nbins = histogram_data->nbins;
+  RNScalar **bin_values = histogram_data->bin_values;
+  for (int j = start; j < end; j++) {
+    for (int i = 0; i < histogram_data->nsamples; i++) {
+      RNScalar vote = histogram_data->votes[i];
+      RNScalar distance = histogram_data->distances[i * nvertices + j];
+      RNScalar bin = (distance < FLT_MAX) ? histogram_data->normalization * distance : nbins-1;
+      int bin1 = (int) bin;
+      int bin2 = bin1 + 1;
+      RNScalar t = bin - bin1;
+      if (bin1 >= nbins) bin1 = nbins-1;
+      if (bin2 >= nbins) bin2 = nbins-1;
+      RNScalar& value1 = bin_values[bin1][j];
+      if (value1 == RN_UNKNOWN) value1 = (1-t) * vote;
+      else value1 += (1-t) * vote;
+      RNScalar& value2 = bin_values[bin2][j];
+      if (value2 == RN_UNKNOWN) value2 = t * vote;
+      else value2 += t * vote;
+    }
+  }
+}
+
+
+
 static R3MeshPropertySet *
 ComputeDijkstraHistogramProperties(R3Mesh *mesh)
 {
@@ -1142,14 +1466,6 @@ ComputeDijkstraHistogramProperties(R3Mesh *mesh)
     return NULL;
   }
 
-  // Allocate/insert properties
-  for (int i = 0; i < nbins; i++) {
-    char name[1024];
-    sprintf(name, "DijkstraHistogramBin%d", i);
-    R3MeshProperty *property = new R3MeshProperty(mesh, name);
-    properties->Insert(property);
-  }
- 
   // Create a sampled set of vertices
   RNScalar *weights = new RNScalar [ mesh->NVertices() ];
   RNArray<R3MeshVertex *> *samples = CreateVertexSampling(mesh, nsamples, weights);
@@ -1162,31 +1478,49 @@ ComputeDijkstraHistogramProperties(R3Mesh *mesh)
   RNScalar area = mesh->Area();
   RNScalar normalization = (area > 0) ? nbins / (1.5 * sqrt(area)) : 1;
 
-  // Compute histogram of distances
+  // Allocate histogram values
+  RNScalar **bin_values = new RNScalar * [ nbins ];
+  for (int i = 0; i < nbins; i++) {
+    bin_values[i] = new RNScalar [ mesh->NVertices() ];
+    for (int j = 0; j < mesh->NVertices(); j++) bin_values[i][j] = 0;
+  }
+
+  // Compute histogram of distances, searching from chunks of samples in parallel
+  int chunk_size = 4 * RNNumThreads();
+  DijkstraHistogramData data;
+  data.mesh = mesh;
+  data.distances = new RNScalar [ chunk_size * mesh->NVertices() ];
+  data.bin_values = bin_values;
+  data.nbins = nbins;
+  data.normalization = normalization;
   RNScalar total_vote = 0;
-  for (int i = 0; i < samples->NEntries(); i++) {
-    R3MeshVertex *vertex = samples->Kth(i);
-    RNScalar vote = weights[i];
+  for (int chunk_start = 0; chunk_start < samples->NEntries(); chunk_start += chunk_size) {
+    // Compute distances from samples in chunk
+    RNArray<R3MeshVertex *> chunk_samples;
+    int chunk_end = chunk_start + chunk_size;
+    if (chunk_end > samples->NEntries()) chunk_end = samples->NEntries();
+    for (int i = chunk_start; i < chunk_end; i++) chunk_samples.Insert(samples->Kth(i));
+    R3MeshDijkstraWorkspace::SearchFromEach(mesh, chunk_samples, 0, CopyDijkstraHistogramDistances, &data);
 
-    // Compute distances to other vertices
-    RNLength *distances = mesh->DijkstraDistances(vertex);
-
-    // Add values to histogram
-    for (int j = 0; j < mesh->NVertices(); j++) {
-      RNScalar bin = normalization * distances[j];
-      int bin1 = (int) bin;
-      int bin2 = bin1 + 1;
-      RNScalar t = bin - bin1;
-      if (bin1 >= nbins) bin1 = nbins-1;
-      if (bin2 >= nbins) bin2 = nbins-1;
-      properties->Property(bin1)->AddVertexValue(j, (1-t) * vote);
-      properties->Property(bin2)->AddVertexValue(j, t * vote);
-    }
+    // Add votes to histogram bins
+    data.votes = &weights[chunk_start];
+    data.nsamples = chunk_samples.NEntries();
+    RNParallelFor(0, mesh->NVertices(), AddDijkstraHistogramVotes, &data, 1024);
+  }
 
-    // Delete distances
-    delete [] distances;
+  // Create properties
+  for (int i = 0; i < nbins; i++) {
+    char name[1024];
+    sprintf(name, "DijkstraHistogramBin%d", i);
+    R3MeshProperty *property = new R3MeshProperty(mesh, name, bin_values[i]);
+    properties->Insert(property);
+    delete [] bin_values[i];
   }
 
+  // Delete histogram values
+  delete [] bin_values;
+  delete [] data.distances;
+
   // Normalize distribution by total_vote
   if (total_vote > 0) {
     for (int i = 1; i < nbins; i++) {
@@ -1226,6 +1560,85 @@ ComputeDijkstraHistogramProperties(R3Mesh *mesh)
 // Ray tracing properties
 ////////////////////////////////////////////////////////////////////////
 
+static const int raytrace_nphis = 8;
+static const int raytrace_nthetas = 8;
+
+
+
+struct RayTracingData {
+  R3MeshSearchTree *tree;
+  unsigned long long seed;
+};
+
+
+
+static RNScalar
+RayTracingRandomScalar(unsigned long long *state)
+{
+  // Return next value in [0,1) of a splitmix64 sequence
+  unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z = z ^ (z >> 31);
+  return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+
+static void
+ComputeRayTracingValues(R3Mesh *mesh, int vertex_index, RNScalar *values, void *data)
+{
+  // Get convenient variables
+  RayTracingData *raytrace_data = (RayTracingData *) data;
+  unsigned long long random_state = raytrace_data->seed ^ (0xD1B54A32D192ED03ULL * (vertex_index + 1));
+  const int num_rays = raytrace_nphis * raytrace_nthetas;
+  double interior_distances[num_rays];
+
+  // Get vertex info
+  R3MeshVertex *vertex = mesh->Vertex(vertex_index);
+  const R3Point& vertex_position = mesh->VertexPosition(vertex);
+  const R3Vector& vertex_normal = mesh->VertexNormal(vertex);
+  R3Vector phi_rotation_axis = vertex_normal % R3xyz_triad.Axis(vertex_normal.MinDimension());
+  R3Vector theta_rotation_axis = vertex_normal;
+
+  // Compute intersections of mesh with random rays from vertex 
+  int num_intersections = 0;
+  int num_interior_distances = 0;
+  for (int j = 0; j < raytrace_nthetas; j++) {
+    RNAngle theta = (j+RayTracingRandomScalar(&random_state)) * RN_TWO_PI / raytrace_nthetas;
+    for (int k = 0; k < raytrace_nphis; k++) {
+      RNAngle phi = (k+RayTracingRandomScalar(&random_state)) * RN_PI / raytrace_nphis;
+
+      // Compute ray
+      R3Vector ray_direction = vertex_normal;
+      ray_direction.Rotate(phi_rotation_axis, phi);
+      ray_direction.Rotate(theta_rotation_axis, theta);
+      R3Point ray_source_position = vertex_position + 1000 * RN_EPSILON * ray_direction;
+      R3Ray ray(ray_source_position, ray_direction);
+
+      // Compute ray intersection
+      R3MeshIntersection intersection;
+      raytrace_data->tree->FindIntersection(ray, intersection);
+      if (intersection.type != R3_MESH_NULL_TYPE) {
+        num_intersections++;
+        const R3Vector& face_normal = mesh->FaceNormal(intersection.face);
+        if (ray_direction.Dot(face_normal) > 0) {
+          interior_distances[num_interior_distances] = intersection.t;
+          num_interior_distances++;
+        }
+      }
+    }
+  }
+
+  // Compute values
+  values[0] = Median(interior_distances, num_interior_distances);
+  values[1] = Percentile(interior_distances, num_interior_distances, 10);
+  values[2] = Percentile(interior_distances, num_interior_distances, 90);
+  values[3] = (RNScalar) num_intersections / (RNScalar) num_rays;
+}
+
+
+
 static R3MeshPropertySet *
 ComputeRayTracingProperties(R3Mesh *mesh)
 {
@@ -1249,54 +1662,21 @@ ComputeRayTracingProperties(R3Mesh *mesh)
   R3MeshProperty *ten_property = new R3MeshProperty(mesh, "RayLengthTen");
   R3MeshProperty *ninety_property = new R3MeshProperty(mesh, "RayLengthNinety");
   R3MeshProperty *coverage_property = new R3MeshProperty(mesh, "RayCoverage");
+
+  // Draw one seed for the random ray offsets (each vertex generates its own
+  // sequence from the seed and its index, so values do not depend on the number of threads)
+  RayTracingData data;
+  data.seed = (unsigned long long) (RNRandomScalar() * 9007199254740992.0);
+
+  // Create search tree for ray intersections
+  data.tree = new R3MeshSearchTree(mesh);
     
   // Compute properties based on intersections of random rays
-  const int nphis = 8;
-  const int nthetas = 8;
-  const int num_rays = nphis * nthetas;
-  double interior_distances[num_rays];
-  for (int i = 0; i < mesh->NVertices(); i++) {
-    // Get vertex info
-    R3MeshVertex *vertex = mesh->Vertex(i);
-    const R3Point& vertex_position = mesh->VertexPosition(vertex);
-    const R3Vector& vertex_normal = mesh->VertexNormal(vertex);
-    R3Vector phi_rotation_axis = vertex_normal % R3xyz_triad.Axis(vertex_normal.MinDimension());
-    R3Vector theta_rotation_axis = vertex_normal;
-
-    // Compute intersections of mesh with random rays from vertex 
-    int num_intersections = 0;
-    int num_interior_distances = 0;
-    for (int j = 0; j < nthetas; j++) {
-      RNAngle theta = (j+RNRandomScalar()) * RN_TWO_PI / nthetas;
-      for (int k = 0; k < nphis; k++) {
-        RNAngle phi = (k+RNRandomScalar()) * RN_PI / nphis;
-
-        // Compute ray
-        R3Vector ray_direction = vertex_normal;
-        ray_direction.Rotate(phi_rotation_axis, phi);
-        ray_direction.Rotate(theta_rotation_axis, theta);
-        R3Point ray_source_position = vertex_position + 1000 * RN_EPSILON * ray_direction;
-        R3Ray ray(ray_source_position, ray_direction);
-
-        // Compute ray intersection
-        R3MeshIntersection intersection;
-        if (mesh->Intersection(ray, &intersection)) {
-          num_intersections++;
-          const R3Vector& face_normal = mesh->FaceNormal(intersection.face);
-          if (ray_direction.Dot(face_normal) > 0) {
-            interior_distances[num_interior_distances] = intersection.t;
-            num_interior_distances++;
-          }
-        }
-      }
-    }
+  R3MeshProperty *vertex_properties[4] = { median_property, ten_property, ninety_property, coverage_property };
+  ComputeVertexProperties(mesh, vertex_properties, 4, ComputeRayTracingValues, &data);
 
-    // Compute properties
-    median_property->SetVertexValue(i, Median(interior_distances, num_interior_distances));
-    ten_property->SetVertexValue(i, Percentile(interior_distances, num_interior_distances, 10));
-    ninety_property->SetVertexValue(i, Percentile(interior_distances, num_interior_distances, 90));
-    coverage_property->SetVertexValue(i, (RNScalar) num_intersections / (RNScalar) num_rays);
-  }
+  // Delete search tree
+  delete data.tree;
 
   // Blur the properties to reduce effects of undersampling
   RNScalar sigma = Sigma(mesh);
@@ -1847,6 +2227,9 @@ ComputeProperties(R3Mesh *mesh)
     return NULL;
   }
 
+  // Compute derived mesh quantities, so that properties can be computed in parallel
+  mesh->UpdateDerivedQuantities();
+
   // Compute basic properties
   if (compute_basic_properties) {
     R3MeshPropertySet *basic_properties = ComputeBasicProperties(mesh);
@@ -1963,6 +2346,8 @@ ParseArgs(int argc, char **argv)
     if ((*argv)[0] == '-') {
       if (!strcmp(*argv, "-v")) print_verbose = 1;
       else if (!strcmp(*argv, "-debug")) print_debug = 1;
+      else if (!strcmp(*argv, "-threads")) { argc--; argv++; RNSetNumThreads(atoi(*argv)); }
+      else if (!strcmp(*argv, "-seed")) { argc--; argv++; RNSeedRandomScalar(atof(*argv)); }
       else if (!strcmp(*argv, "-basic")) { compute_basic_properties = 1; }
       else if (!strcmp(*argv, "-coordinate")) { compute_coordinate_properties = 1; }
       else if (!strcmp(*argv, "-curvature")) { compute_curvature_properties = 1; }
@@ -32,6 +32,8 @@ enum {
   PROPERTY_EXTREMA,
   CENTER_OF_MASS,
   VERTEX_CLOSEST_TO_CENTER_OF_MASS,
+  POISSON_DISK_SURFACE_POINTS,
+  PARALLEL_FURTHEST_VERTEX,
   NUM_SELECTION_METHODS
 };
 
@@ -55,8 +57,13 @@ static double min_relative_spacing = -1;
 static double max_distance = FLT_MAX;
 static double near_surface_bias_exponent = 2;
 static double curvature_exponent = 0;
+static double furthest_vertex_tolerance = 0.95;
+static double benchmark_radius = 0;
+static int benchmark_knn = 0;
+static int test_dynamic_kdtree = 0;
 static RNScalar curvature_max = 100;
 static RNBoolean binary_sdf = FALSE;
+static RNBoolean stream = FALSE;
 static RNBoolean print_verbose = FALSE;
 static RNBoolean print_debug = FALSE;
 
@@ -559,6 +566,275 @@ SelectRandomSurfacePoints(R3Mesh *mesh, R3MeshProperty *property, int npoints)
 
 
 
+////////////////////////////////////////////////////////////////////////
+// Poisson disk surface point sampling
+////////////////////////////////////////////////////////////////////////
+
+// Random surface points are candidates.  Each one is accepted if no
+// accepted candidate is within the spacing (found with a hash grid).
+// Candidates are tried in phases over the cells of a uniform grid.  Cells
+// have diagonal equal to the spacing, so at most one candidate is accepted
+// in each cell, and two cells whose coordinates are equal modulo 3 cannot
+// hold conflicting candidates.  So, the cells of one phase are processed
+// in parallel, and the result does not depend on the number of threads.
+
+struct PoissonDiskCell {
+  int phase;
+  unsigned long long key;
+  int candidate;
+};
+
+
+
+struct PoissonDiskData {
+  const R3HashGrid *grid;
+  const R3Point *positions;
+  RNLength spacing;
+  const int *cell_starts;
+  int *cell_cursors;
+  int *cell_conflicts;
+  int *active_cells;
+  unsigned char *accepted;
+};
+
+
+
+static bool
+ComparePoissonDiskCells(const PoissonDiskCell& c1, const PoissonDiskCell& c2)
+{
+  // Sort by cell, then candidate (random) order
+  if (c1.key != c2.key) return c1.key < c2.key;
+  return c1.candidate < c2.candidate;
+}
+
+
+
+static void
+TryPoissonDiskCandidates(int start, int end, void *data)
+{
+  // Get data
+  PoissonDiskData *pd = (PoissonDiskData *) data;
+  std::vector<int> neighbors;
+
+  // Try next candidate in each active cell
+  for (int i = start; i < end; i++) {
+    int cell = pd->active_cells[i];
+    int candidate = pd->cell_cursors[cell]++;
+    const R3Point& position = pd->positions[candidate];
+
+    // Check accepted candidate that rejected previous candidate in cell
+    int conflict = pd->cell_conflicts[cell];
+    if (conflict >= 0) {
+      RNLength distance_squared = R3SquaredDistance(position, pd->positions[conflict]);
+      if (distance_squared > pd->spacing * pd->spacing) conflict = -1;
+    }
+
+    // Check all accepted candidates within spacing
+    if (conflict < 0) {
+      neighbors.clear();
+      pd->grid->FindAll(position, 0, pd->spacing, neighbors);
+      for (unsigned int j = 0; j < neighbors.size(); j++) {
+        if (pd->accepted[neighbors[j]]) { conflict = neighbors[j]; break; }
+      }
+    }
+
+    // Accept candidate and close cell, or remember conflict
+    if (conflict < 0) {
+      pd->accepted[candidate] = 1;
+      pd->cell_cursors[cell] = pd->cell_starts[cell+1];
+    }
+    else {
+      pd->cell_conflicts[cell] = conflict;
+    }
+  }
+}
+
+
+
+static RNArray<Point *> *
+SelectPoissonDiskSurfacePoints(R3Mesh *mesh, int npoints, double min_spacing)
+{
+  // Allocate array of points
+  RNArray<Point *> *points = new RNArray<Point *>();
+  if (!points) {
+    RNFail("Unable to allocate array of points\n");
+    return NULL;
+  }
+
+  // Determine spacing (this sampler yields about 0.6 * area / spacing^2 points)
+  RNArea area = mesh->Area();
+  if (area <= 0) return points;
+  RNLength spacing = min_spacing;
+  if ((spacing <= 0) && (npoints > 0)) spacing = sqrt(0.6 * area / npoints);
+  if (spacing <= 0) return points;
+
+  // Determine number of candidates
+  const RNScalar candidates_per_spacing_squared = 8;
+  RNScalar ncandidates_ideal = candidates_per_spacing_squared * area / (spacing * spacing);
+  if (ncandidates_ideal > 64 * 1024 * 1024) {
+    RNFail("Spacing %g is too small for Poisson disk sampling\n", spacing);
+    return NULL;
+  }
+
+  // Generate candidates at random surface points
+  RNSeedRandomScalar();
+  std::vector<R3Point> positions;
+  std::vector<R3Vector> normals;
+  for (int i = 0; i < mesh->NFaces(); i++) {
+    R3MeshFace *face = mesh->Face(i);
+
+    // Get vertex positions
+    R3MeshVertex *v0 = mesh->VertexOnFace(face, 0);
+    R3MeshVertex *v1 = mesh->VertexOnFace(face, 1);
+    R3MeshVertex *v2 = mesh->VertexOnFace(face, 2);
+    const R3Point& p0 = mesh->VertexPosition(v0);
+    const R3Point& p1 = mesh->VertexPosition(v1);
+    const R3Point& p2 = mesh->VertexPosition(v2);
+    const R3Vector& n0 = mesh->VertexNormal(v0);
+    const R3Vector& n1 = mesh->VertexNormal(v1);
+    const R3Vector& n2 = mesh->VertexNormal(v2);
+
+    // Determine number of candidates for face
+    RNScalar ideal_face_ncandidates = ncandidates_ideal * mesh->FaceArea(face) / area;
+    int face_ncandidates = (int) ideal_face_ncandidates;
+    RNScalar remainder = ideal_face_ncandidates - face_ncandidates;
+    if (remainder > RNRandomScalar()) face_ncandidates++;
+
+    // Generate random candidates in face
+    for (int j = 0; j < face_ncandidates; j++) {
+      RNScalar r1 = sqrt(RNRandomScalar());
+      RNScalar r2 = RNRandomScalar();
+      RNScalar t0 = (1.0 - r1);
+      RNScalar t1 = r1 * (1.0 - r2);
+      RNScalar t2 = r1 * r2;
+      R3Vector normal = t0*n0 + t1*n1 + t2*n2; normal.Normalize();
+      positions.push_back(t0*p0 + t1*p1 + t2*p2);
+      normals.push_back(normal);
+    }
+  }
+
+  // Shuffle candidates, so that order within cells is random
+  int ncandidates = positions.size();
+  if (ncandidates == 0) return points;
+  for (int i = ncandidates-1; i > 0; i--) {
+    int k = (int) (RNRandomScalar() * (i + 1));
+    if (k > i) k = i;
+    std::swap(positions[i], positions[k]);
+    std::swap(normals[i], normals[k]);
+  }
+
+  // Compute cell of each candidate (cell diagonal equals spacing)
+  R3Box bbox = R3null_box;
+  for (int i = 0; i < ncandidates; i++) bbox.Union(positions[i]);
+  RNLength cell_size = spacing / sqrt(3.0);
+  if (bbox.LongestAxisLength() / cell_size > (1 << 21) - 1) {
+    RNFail("Spacing %g is too small for Poisson disk sampling\n", spacing);
+    return NULL;
+  }
+  std::vector<PoissonDiskCell> sorted_candidates(ncandidates);
+  for (int i = 0; i < ncandidates; i++) {
+    int cell[3];
+    for (int dim = 0; dim < 3; dim++) cell[dim] = (int) ((positions[i][dim] - bbox[RN_LO][dim]) / cell_size);
+    PoissonDiskCell& c = sorted_candidates[i];
+    c.phase = 9*(cell[0] % 3) + 3*(cell[1] % 3) + (cell[2] % 3);
+    c.key = ((unsigned long long) cell[0] << 42) | ((unsigned long long) cell[1] << 21) | (unsigned long long) cell[2];
+    c.candidate = i;
+  }
+
+  // Sort candidates by cell, so that nearby candidates are nearby in memory
+  std::sort(sorted_candidates.begin(), sorted_candidates.end(), ComparePoissonDiskCells);
+  std::vector<R3Point> sorted_positions(ncandidates);
+  std::vector<R3Vector> sorted_normals(ncandidates);
+  std::vector<int> cell_starts, cell_phases, phase_starts(28, 0);
+  for (int i = 0; i < ncandidates; i++) {
+    const PoissonDiskCell& c = sorted_candidates[i];
+    sorted_positions[i] = positions[c.candidate];
+    sorted_normals[i] = normals[c.candidate];
+    if ((i > 0) && (c.key == sorted_candidates[i-1].key)) continue;
+    cell_starts.push_back(i);
+    cell_phases.push_back(c.phase);
+    phase_starts[c.phase+1]++;
+  }
+  int ncells = cell_starts.size();
+  cell_starts.push_back(ncandidates);
+
+  // Group cells by phase
+  for (int i = 1; i <= 27; i++) phase_starts[i] += phase_starts[i-1];
+  std::vector<int> active_cells(ncells);
+  std::vector<int> phase_ends(phase_starts.begin(), phase_starts.end() - 1);
+  for (int i = 0; i < ncells; i++) active_cells[phase_ends[cell_phases[i]]++] = i;
+
+  // Build hash grid for finding candidates within spacing
+  R3HashGrid grid(&sorted_positions[0], ncandidates, spacing);
+
+  // Initialize sampling data
+  std::vector<int> cell_cursors(cell_starts.begin(), cell_starts.end() - 1);
+  std::vector<int> cell_conflicts(ncells, -1);
+  std::vector<unsigned char> accepted(ncandidates, 0);
+  PoissonDiskData data;
+  data.grid = &grid;
+  data.positions = &sorted_positions[0];
+  data.spacing = spacing;
+  data.cell_starts = &cell_starts[0];
+  data.cell_cursors = &cell_cursors[0];
+  data.cell_conflicts = &cell_conflicts[0];
+  data.active_cells = &active_cells[0];
+  data.accepted = &accepted[0];
+
+  // Try one candidate in every active cell per phase, until all cells are closed
+  int phase_order[27];
+  for (int i = 0; i < 27; i++) phase_order[i] = i;
+  std::vector<int> nactive(phase_starts.begin() + 1, phase_starts.end());
+  for (int i = 0; i < 27; i++) nactive[i] -= phase_starts[i];
+  RNBoolean done = FALSE;
+  while (!done) {
+    // Visit phases in random order
+    for (int i = 26; i > 0; i--) {
+      int k = (int) (RNRandomScalar() * (i + 1));
+      if (k > i) k = i;
+      std::swap(phase_order[i], phase_order[k]);
+    }
+
+    // Process phases one at a time, cells of each phase in parallel
+    done = TRUE;
+    for (int i = 0; i < 27; i++) {
+      int phase = phase_order[i];
+      int start = phase_starts[phase];
+      if (nactive[phase] == 0) continue;
+      RNParallelFor(start, start + nactive[phase], TryPoissonDiskCandidates, &data, 256);
+
+      // Remove closed cells from active list
+      int count = 0;
+      for (int j = start; j < start + nactive[phase]; j++) {
+        int cell = active_cells[j];
+        if (cell_cursors[cell] < cell_starts[cell+1]) active_cells[start + count++] = cell;
+      }
+      nactive[phase] = count;
+      if (count > 0) done = FALSE;
+    }
+  }
+
+  // Create points for accepted candidates
+  for (int i = 0; i < ncandidates; i++) {
+    if (!accepted[i]) continue;
+    Point *point = new Point(sorted_positions[i], sorted_normals[i]);
+    points->Insert(point);
+  }
+
+  // Print statistics
+  if (print_debug) {
+    printf("  Poisson disk spacing = %g\n", spacing);
+    printf("  # Candidates = %d\n", ncandidates);
+    printf("  # Cells = %d\n", ncells);
+    fflush(stdout);
+  }
+
+  // Return points
+  return points;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Vertex sampling
 ////////////////////////////////////////////////////////////////////////
@@ -820,6 +1096,304 @@ SelectFurthestPoints(R3Mesh *mesh, int npoints, double min_spacing)
 
 
 
+////////////////////////////////////////////////////////////////////////
+// Parallel furthest vertex sampling
+////////////////////////////////////////////////////////////////////////
+
+// Distances to the closest selected vertex are updated incrementally.
+// Each new vertex grows a Dijkstra front that stops wherever it does not
+// decrease the current distance.  Several vertices are selected per
+// iteration, and their fronts are grown in parallel.  A vertex joins a
+// batch only if its distance and its straight-line distance to every
+// vertex already in the batch are at least furthest_vertex_tolerance times
+// the current maximum distance, so each selected vertex is within that
+// factor of the exact furthest vertex.  A tolerance of 1 selects one
+// vertex at a time, like SelectFurthestPoints.
+
+static const int furthest_max_batch_size = 64;
+static const int furthest_block_size = 256;
+
+
+
+struct FurthestVertexFront {
+  int seed;
+  std::vector<int> vertices;
+  std::vector<RNScalar> distances;
+};
+
+
+
+struct FurthestVertexData {
+  const int *edge_offsets;
+  const int *edge_vertices;
+  const RNScalar *edge_lengths;
+  const RNScalar *distances;
+  FurthestVertexFront *fronts;
+};
+
+
+
+// Tentative distances of a front are kept in an open addressing hash
+// table sized by the front (not by the mesh), so memory used by the
+// fronts grown in parallel does not grow with the number of threads
+
+struct FurthestVertexDistances {
+  std::vector<int> keys;
+  std::vector<RNScalar> values;
+  int nentries;
+};
+
+
+
+static RNScalar&
+FrontDistance(FurthestVertexDistances& table, int vertex)
+{
+  // Grow table if it would become more than half full
+  if (2 * (table.nentries + 1) > (int) table.keys.size()) {
+    std::vector<int> old_keys;
+    std::vector<RNScalar> old_values;
+    old_keys.swap(table.keys);
+    old_values.swap(table.values);
+    int size = (old_keys.empty()) ? 1024 : 2 * old_keys.size();
+    table.keys.assign(size, -1);
+    table.values.assign(size, FLT_MAX);
+    table.nentries = 0;
+    for (unsigned int i = 0; i < old_keys.size(); i++) {
+      if (old_keys[i] >= 0) FrontDistance(table, old_keys[i]) = old_values[i];
+    }
+  }
+
+  // Find slot of vertex (inserting it with distance FLT_MAX if not found)
+  unsigned int mask = table.keys.size() - 1;
+  unsigned int slot = ((unsigned int) vertex * 2654435761U) & mask;
+  while ((table.keys[slot] >= 0) && (table.keys[slot] != vertex)) slot = (slot + 1) & mask;
+  if (table.keys[slot] < 0) { table.keys[slot] = vertex; table.nentries++; }
+  return table.values[slot];
+}
+
+
+
+static void
+GrowFurthestVertexFronts(int start, int end, void *data)
+{
+  // Get data
+  FurthestVertexData *fd = (FurthestVertexData *) data;
+  FurthestVertexDistances front_distances;
+  front_distances.nentries = 0;
+  std::vector< std::pair<RNScalar, int> > heap;
+  std::greater< std::pair<RNScalar, int> > compare;
+
+  // Grow front from each seed
+  for (int i = start; i < end; i++) {
+    FurthestVertexFront& front = fd->fronts[i];
+    front.vertices.clear();
+    front.distances.clear();
+
+    // Initialize heap with seed
+    heap.clear();
+    FrontDistance(front_distances, front.seed) = 0;
+    heap.push_back(std::pair<RNScalar, int>(0, front.seed));
+
+    // Visit vertices closer to seed than to any selected vertex
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), compare);
+      RNScalar distance = heap.back().first;
+      int vertex = heap.back().second;
+      heap.pop_back();
+      if (distance > FrontDistance(front_distances, vertex)) continue;
+      front.vertices.push_back(vertex);
+      front.distances.push_back(distance);
+      for (int j = fd->edge_offsets[vertex]; j < fd->edge_offsets[vertex+1]; j++) {
+        int neighbor = fd->edge_vertices[j];
+        RNScalar neighbor_distance = distance + fd->edge_lengths[j];
+        if (neighbor_distance >= fd->distances[neighbor]) continue;
+        RNScalar& front_distance = FrontDistance(front_distances, neighbor);
+        if (neighbor_distance >= front_distance) continue;
+        front_distance = neighbor_distance;
+        heap.push_back(std::pair<RNScalar, int>(neighbor_distance, neighbor));
+        std::push_heap(heap.begin(), heap.end(), compare);
+      }
+    }
+
+    // Reset front distances for next seed (every vertex in the table was
+    // visited, so clear just their slots unless the table is nearly full)
+    if (front_distances.keys.size() > 4 * front.vertices.size()) {
+      unsigned int mask = front_distances.keys.size() - 1;
+      for (unsigned int j = 0; j < front.vertices.size(); j++) {
+        unsigned int slot = ((unsigned int) front.vertices[j] * 2654435761U) & mask;
+        while (front_distances.keys[slot] != front.vertices[j]) slot = (slot + 1) & mask;
+        front_distances.keys[slot] = -1;
+        front_distances.values[slot] = FLT_MAX;
+      }
+    }
+    else {
+      std::fill(front_distances.keys.begin(), front_distances.keys.end(), -1);
+      std::fill(front_distances.values.begin(), front_distances.values.end(), FLT_MAX);
+    }
+    front_distances.nentries = 0;
+  }
+}
+
+
+
+static RNArray<Point *> *
+SelectParallelFurthestPoints(R3Mesh *mesh, int npoints, double min_spacing)
+{
+  // Check/adjust number of points
+  int nvertices = mesh->NVertices();
+  if ((npoints < 0) || (npoints > nvertices)) npoints = nvertices;
+
+  // Allocate array of points
+  RNArray<Point *> *points = new RNArray<Point *>();
+  if (!points) {
+    RNFail("Unable to allocate array of points\n");
+    return NULL;
+  }
+
+  // Copy vertex adjacencies and edge lengths
+  std::vector<int> edge_offsets(nvertices + 1, 0);
+  std::vector<int> edge_vertices;
+  std::vector<RNScalar> edge_lengths;
+  for (int i = 0; i < nvertices; i++) {
+    R3MeshVertex *vertex = mesh->Vertex(i);
+    for (int j = 0; j < mesh->VertexValence(vertex); j++) {
+      R3MeshEdge *edge = mesh->EdgeOnVertex(vertex, j);
+      R3MeshVertex *neighbor_vertex = mesh->VertexAcrossEdge(edge, vertex);
+      edge_vertices.push_back(mesh->VertexID(neighbor_vertex));
+      edge_lengths.push_back(mesh->EdgeLength(edge));
+    }
+    edge_offsets[i+1] = edge_vertices.size();
+  }
+
+  // Initialize distances (vertices without edges are never selected)
+  std::vector<RNScalar> distances(nvertices, FLT_MAX);
+  for (int i = 0; i < nvertices; i++) {
+    if (edge_offsets[i+1] == edge_offsets[i]) distances[i] = -1;
+  }
+
+  // Initialize front data
+  std::vector<FurthestVertexFront> fronts(furthest_max_batch_size);
+  FurthestVertexData data;
+  data.edge_offsets = &edge_offsets[0];
+  data.edge_vertices = (edge_vertices.empty()) ? NULL : &edge_vertices[0];
+  data.edge_lengths = (edge_lengths.empty()) ? NULL : &edge_lengths[0];
+  data.distances = &distances[0];
+  data.fronts = &fronts[0];
+
+  // Find vertex furthest from an arbitrary vertex in each connected component
+  std::vector<unsigned char> visited(nvertices, 0);
+  std::vector< std::pair<RNScalar, int> > component_seeds;
+  for (int i = 0; i < nvertices; i++) {
+    if (visited[i] || (distances[i] < 0)) continue;
+    fronts[0].seed = i;
+    GrowFurthestVertexFronts(0, 1, &data);
+    const FurthestVertexFront& front = fronts[0];
+    for (unsigned int j = 0; j < front.vertices.size(); j++) visited[front.vertices[j]] = 1;
+    component_seeds.push_back(std::pair<RNScalar, int>(-front.distances.back(), front.vertices.back()));
+  }
+
+  // Select vertex of each component, components with largest extent first
+  std::sort(component_seeds.begin(), component_seeds.end());
+  std::vector<int> batch;
+  for (unsigned int i = 0; i < component_seeds.size(); i++) {
+    if ((int) i >= npoints) break;
+    batch.push_back(component_seeds[i].second);
+  }
+
+  // Compute block maxima of distances
+  int nblocks = (nvertices + furthest_block_size - 1) / furthest_block_size;
+  std::vector<int> block_furthest(nblocks, -1);
+  std::vector<unsigned char> block_dirty(nblocks, 1);
+
+  // Select batches of vertices
+  int nbatches = 0;
+  while (!batch.empty()) {
+    // Grow fronts from batch in parallel
+    int batch_size = batch.size();
+    if (batch_size > (int) fronts.size()) fronts.resize(batch_size);
+    data.fronts = &fronts[0];
+    for (int i = 0; i < batch_size; i++) fronts[i].seed = batch[i];
+    RNParallelFor(0, batch_size, GrowFurthestVertexFronts, &data, 1);
+    nbatches++;
+
+    // Insert points and update distances
+    for (int i = 0; i < batch_size; i++) {
+      const FurthestVertexFront& front = fronts[i];
+      Point *point = new Point(mesh, mesh->Vertex(front.seed));
+      points->Insert(point);
+      for (unsigned int j = 0; j < front.vertices.size(); j++) {
+        int vertex = front.vertices[j];
+        if (front.distances[j] >= distances[vertex]) continue;
+        distances[vertex] = front.distances[j];
+        block_dirty[vertex / furthest_block_size] = 1;
+      }
+    }
+
+    // Check number of points
+    batch.clear();
+    int nremaining = npoints - points->NEntries();
+    if (nremaining <= 0) break;
+
+    // Update furthest vertex in each changed block
+    for (int b = 0; b < nblocks; b++) {
+      if (!block_dirty[b]) continue;
+      int furthest = -1;
+      int end = (b + 1) * furthest_block_size;
+      if (end > nvertices) end = nvertices;
+      for (int i = b * furthest_block_size; i < end; i++) {
+        if (distances[i] <= 0) continue;
+        if ((furthest < 0) || (distances[i] > distances[furthest])) furthest = i;
+      }
+      block_furthest[b] = furthest;
+      block_dirty[b] = 0;
+    }
+
+    // Gather furthest vertex of blocks within tolerance of maximum distance
+    RNScalar max_distance = 0;
+    for (int b = 0; b < nblocks; b++) {
+      int furthest = block_furthest[b];
+      if ((furthest >= 0) && (distances[furthest] > max_distance)) max_distance = distances[furthest];
+    }
+    if (max_distance <= 0) break;
+    if ((min_spacing > 0) && (max_distance < min_spacing)) break;
+    RNScalar min_distance = furthest_vertex_tolerance * max_distance;
+    std::vector< std::pair<RNScalar, int> > candidates;
+    for (int b = 0; b < nblocks; b++) {
+      int furthest = block_furthest[b];
+      if ((furthest < 0) || (distances[furthest] < min_distance)) continue;
+      candidates.push_back(std::pair<RNScalar, int>(-distances[furthest], furthest));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // Select candidates far from each other
+    RNScalar min_distance_squared = min_distance * min_distance;
+    for (unsigned int i = 0; i < candidates.size(); i++) {
+      int candidate = candidates[i].second;
+      const R3Point& position = mesh->VertexPosition(mesh->Vertex(candidate));
+      RNBoolean conflict = FALSE;
+      for (unsigned int j = 0; j < batch.size(); j++) {
+        const R3Point& batch_position = mesh->VertexPosition(mesh->Vertex(batch[j]));
+        if (R3SquaredDistance(position, batch_position) < min_distance_squared) { conflict = TRUE; break; }
+      }
+      if (conflict) continue;
+      batch.push_back(candidate);
+      if ((int) batch.size() >= nremaining) break;
+      if ((int) batch.size() >= furthest_max_batch_size) break;
+    }
+  }
+
+  // Print statistics
+  if (print_debug) {
+    printf("  # Batches = %d\n", nbatches);
+    fflush(stdout);
+  }
+
+  // Return points
+  return points;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Property extrema sampling
 ////////////////////////////////////////////////////////////////////////
@@ -1662,6 +2236,10 @@ SelectPoints(R3Mesh *mesh, R3MeshProperty *property, int selection_method)
     points= SelectVisibleSurfacePoints(mesh, num_points, min_spacing);
   else if (selection_method == ITERATIVE_FURTHEST_VERTEX) 
     points= SelectFurthestPoints(mesh, num_points, min_spacing);
+  else if (selection_method == PARALLEL_FURTHEST_VERTEX) 
+    points= SelectParallelFurthestPoints(mesh, num_points, min_spacing);
+  else if (selection_method == POISSON_DISK_SURFACE_POINTS) 
+    points= SelectPoissonDiskSurfacePoints(mesh, num_points, min_spacing);
   else if (selection_method == PROPERTY_MINIMA) 
     points= SelectPropertyExtrema(mesh, property, num_points, min_spacing, PROPERTY_MINIMA);
   else if (selection_method == PROPERTY_MAXIMA) 
@@ -1729,6 +2307,491 @@ SelectPoints(R3Mesh *mesh, R3MeshProperty *property, int selection_method)
 
 
 
+////////////////////////////////////////////////////////////////////////
+// Streaming surface point sampling
+////////////////////////////////////////////////////////////////////////
+
+static int
+WriteStreamPoint(FILE *fp, int format, const R3Point& position, const R3Vector& normal)
+{
+  // Write point in format of output file
+  if (format == 0) {
+    fprintf(fp, "%g %g %g\n", position.X(), position.Y(), position.Z());
+  }
+  else if (format == 1) {
+    fprintf(fp, "%g %g %g   %g %g %g\n", position.X(), position.Y(), position.Z(),
+      normal.X(), normal.Y(), normal.Z());
+  }
+  else {
+    float coordinates[6];
+    coordinates[0] = position.X();
+    coordinates[1] = position.Y();
+    coordinates[2] = position.Z();
+    coordinates[3] = normal.X();
+    coordinates[4] = normal.Y();
+    coordinates[5] = normal.Z();
+    if (fwrite(coordinates, sizeof(float), 6, fp) != (unsigned int) 6) return 0;
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+static int
+StreamPoints(const char *mesh_name, const char *points_name)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+
+  // Check options (only random surface points are supported)
+  if ((selection_method != RANDOM_SURFACE_POINTS) || property_name || (curvature_exponent > 0)) {
+    RNFail("Only random surface points without property or curvature weighting are supported with -stream\n");
+    return 0;
+  }
+
+  // Determine output format
+  int format = -1;
+  const char *extension = strrchr(points_name, '.');
+  if (extension && !strcmp(extension, ".xyz")) format = 0;
+  else if (extension && !strcmp(extension, ".xyzn")) format = 1;
+  else if (extension && !strcmp(extension, ".pts")) format = 2;
+  else {
+    RNFail("Only .xyz, .xyzn, and .pts outputs are supported with -stream: %s\n", points_name);
+    return 0;
+  }
+
+  // Compute total area in a first pass over the input
+  R3MeshStreamReader reader;
+  R3MeshStreamElement element;
+  int type;
+  if (!reader.Open(mesh_name)) return 0;
+  while ((type = reader.ReadElement(&element)) > 0) { }
+  if (type < 0) return 0;
+  RNArea total_area = reader.Area();
+  if (!reader.Close()) return 0;
+
+  // Determine number of points
+  int npoints = num_points;
+  if (npoints <= 0) npoints = (max_points > 0) ? max_points : 1024;
+  if ((min_points > 0) && (npoints < min_points)) npoints = min_points;
+
+  // Open output file
+  FILE *fp = fopen(points_name, (format == 2) ? "wb" : "w");
+  if (!fp) {
+    RNFail("Unable to open output file %s\n", points_name);
+    return 0;
+  }
+
+  // Generate points in a second pass.  Triangle i gets the points with
+  // indices between floor(npoints*A(i-1)/A + offset) and floor(npoints*A(i)/A + offset),
+  // where A(i) is the area read up to triangle i, so exactly npoints are
+  // generated (the reader sums areas in the same order in both passes)
+  // and each triangle gets a number proportional to its area in expectation.
+  RNSeedRandomScalar();
+  RNScalar offset = RNRandomScalar();
+  int count = 0;
+  if (!reader.Open(mesh_name)) { fclose(fp); return 0; }
+  while ((type = reader.ReadElement(&element)) > 0) {
+    if (type != R3_MESH_STREAM_TRIANGLE) continue;
+    if (total_area == 0) continue;
+
+    // Determine number of points for triangle
+    const R3Point& p0 = element.positions[0];
+    const R3Point& p1 = element.positions[1];
+    const R3Point& p2 = element.positions[2];
+    int end = (int) (npoints * reader.Area() / total_area + offset);
+    if (end > npoints) end = npoints;
+    if (end <= count) continue;
+    R3Vector normal = (p1 - p0) % (p2 - p0);
+    normal.Normalize();
+
+    // Generate random points in triangle
+    while (count < end) {
+      RNScalar r1 = sqrt(RNRandomScalar());
+      RNScalar r2 = RNRandomScalar();
+      RNScalar t0 = (1.0 - r1);
+      RNScalar t1 = r1 * (1.0 - r2);
+      RNScalar t2 = r1 * r2;
+      R3Point position = t0*p0 + t1*p1 + t2*p2;
+      if (!WriteStreamPoint(fp, format, position, normal)) {
+        RNFail("Unable to write point to output file %s\n", points_name);
+        fclose(fp);
+        return 0;
+      }
+      count++;
+    }
+  }
+
+  // Close files
+  fclose(fp);
+  if (type < 0) return 0;
+  if (!reader.Close()) return 0;
+
+  // Print message
+  if (print_verbose) {
+    printf("Streamed points ...\n");
+    printf("  Time = %.2f seconds\n", start_time.Elapsed());
+    printf("  # Points = %d\n", count);
+    printf("  # Triangles = %d\n", reader.NTriangles());
+    printf("  Max Active Vertices = %d\n", reader.MaxActiveVertices());
+    printf("  Area = %g\n", total_area);
+    fflush(stdout);
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Neighbor search benchmark
+////////////////////////////////////////////////////////////////////////
+
+static int
+BenchmarkNeighborSearch(R3Mesh *mesh, RNLength radius)
+{
+  // Check radius
+  if (radius <= 0) {
+    RNFail("Benchmark radius must be positive: %g\n", radius);
+    return 0;
+  }
+
+  // Create a point for every vertex
+  int npoints = mesh->NVertices();
+  Point *vertex_points = new Point [ npoints ];
+  RNArray<Point *> array;
+  R3Point *positions = new R3Point [ npoints ];
+  for (int i = 0; i < npoints; i++) {
+    vertex_points[i] = Point(mesh, mesh->Vertex(i));
+    positions[i] = vertex_points[i].position;
+    array.Insert(&vertex_points[i]);
+  }
+
+  // Build kdtree
+  RNTime kdtree_build_time;
+  kdtree_build_time.Read();
+  Point tmp; int position_offset = (unsigned char *) &(tmp.position) - (unsigned char *) &tmp;
+  R3Kdtree<Point *> kdtree(array, position_offset);
+  RNScalar kdtree_build_seconds = kdtree_build_time.Elapsed();
+
+  // Find all within radius of every vertex with kdtree
+  RNTime kdtree_query_time;
+  kdtree_query_time.Read();
+  long long kdtree_count = 0;
+  for (int i = 0; i < npoints; i++) {
+    RNArray<Point *> neighbors;
+    kdtree.FindAll(positions[i], 0, radius, neighbors);
+    kdtree_count += neighbors.NEntries();
+  }
+  RNScalar kdtree_query_seconds = kdtree_query_time.Elapsed();
+
+  // Build hash grid
+  RNTime grid_build_time;
+  grid_build_time.Read();
+  R3HashGrid grid(positions, npoints, radius);
+  RNScalar grid_build_seconds = grid_build_time.Elapsed();
+
+  // Find all within radius of every vertex with hash grid
+  RNTime grid_query_time;
+  grid_query_time.Read();
+  long long grid_count = 0;
+  std::vector<int> neighbors;
+  for (int i = 0; i < npoints; i++) {
+    neighbors.clear();
+    grid.FindAll(positions[i], 0, radius, neighbors);
+    grid_count += neighbors.size();
+  }
+  RNScalar grid_query_seconds = grid_query_time.Elapsed();
+
+  // Print statistics
+  printf("Benchmarked neighbor search ...\n");
+  printf("  Radius = %g\n", radius);
+  printf("  # Points = %d\n", npoints);
+  printf("  Kdtree build time = %.3f seconds\n", kdtree_build_seconds);
+  printf("  Kdtree query time = %.3f seconds\n", kdtree_query_seconds);
+  printf("  Hash grid build time = %.3f seconds\n", grid_build_seconds);
+  printf("  Hash grid query time = %.3f seconds\n", grid_query_seconds);
+  printf("  # Neighbors = %lld (kdtree), %lld (hash grid)\n", kdtree_count, grid_count);
+  printf("  Average # neighbors = %.1f\n", (npoints > 0) ? (double) grid_count / npoints : 0.0);
+  fflush(stdout);
+
+  // Delete temporary memory
+  delete [] vertex_points;
+  delete [] positions;
+
+  // Check that searches agree
+  if (kdtree_count != grid_count) {
+    RNFail("Kdtree and hash grid found different numbers of neighbors\n");
+    return 0;
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+static int
+BenchmarkKNearestNeighborSearch(R3Mesh *mesh, int k)
+{
+  // Check number of neighbors
+  if (k <= 0) {
+    RNFail("Benchmark number of neighbors must be positive: %d\n", k);
+    return 0;
+  }
+
+  // Create a point for every vertex
+  int npoints = mesh->NVertices();
+  Point *vertex_points = new Point [ npoints ];
+  RNArray<Point *> array;
+  R3Point *positions = new R3Point [ npoints ];
+  for (int i = 0; i < npoints; i++) {
+    vertex_points[i] = Point(mesh, mesh->Vertex(i));
+    positions[i] = vertex_points[i].position;
+    array.Insert(&vertex_points[i]);
+  }
+
+  // Build kdtree
+  RNTime kdtree_build_time;
+  kdtree_build_time.Read();
+  Point tmp; int position_offset = (unsigned char *) &(tmp.position) - (unsigned char *) &tmp;
+  R3Kdtree<Point *> kdtree(array, position_offset);
+  RNScalar kdtree_build_seconds = kdtree_build_time.Elapsed();
+
+  // Find K closest to every vertex with kdtree
+  RNTime kdtree_query_time;
+  kdtree_query_time.Read();
+  RNLength *kdtree_distances = new RNLength [ npoints * k ];
+  int *kdtree_counts = new int [ npoints ];
+  for (int i = 0; i < npoints; i++) {
+    RNArray<Point *> neighbors;
+    kdtree_counts[i] = kdtree.FindClosest(positions[i], 0, FLT_MAX, k, neighbors, &kdtree_distances[i*k]);
+  }
+  RNScalar kdtree_query_seconds = kdtree_query_time.Elapsed();
+
+  // Build static kdtree
+  RNTime static_build_time;
+  static_build_time.Read();
+  R3StaticKdtree static_kdtree(positions, npoints);
+  RNScalar static_build_seconds = static_build_time.Elapsed();
+
+  // Find K closest to every vertex with static kdtree
+  RNTime static_query_time;
+  static_query_time.Read();
+  RNLength *static_distances = new RNLength [ npoints * k ];
+  int *static_counts = new int [ npoints ];
+  int *indices = new int [ k ];
+  for (int i = 0; i < npoints; i++) {
+    static_counts[i] = static_kdtree.FindClosest(positions[i], 0, FLT_MAX, k, indices, &static_distances[i*k]);
+  }
+  RNScalar static_query_seconds = static_query_time.Elapsed();
+
+  // Compare distances of neighbors (static kdtree stores float coordinates)
+  int nmismatches = 0;
+  RNLength tolerance = 1.0E-5 * mesh->BBox().DiagonalLength();
+  for (int i = 0; i < npoints; i++) {
+    if (kdtree_counts[i] != static_counts[i]) { nmismatches++; continue; }
+    for (int j = 0; j < kdtree_counts[i]; j++) {
+      if (fabs(kdtree_distances[i*k+j] - static_distances[i*k+j]) > tolerance) { nmismatches++; break; }
+    }
+  }
+
+  // Print statistics
+  printf("Benchmarked K nearest neighbor search ...\n");
+  printf("  K = %d\n", k);
+  printf("  # Points = %d\n", npoints);
+  printf("  Kdtree build time = %.3f seconds\n", kdtree_build_seconds);
+  printf("  Kdtree query time = %.3f seconds\n", kdtree_query_seconds);
+  printf("  Static kdtree build time = %.3f seconds\n", static_build_seconds);
+  printf("  Static kdtree query time = %.3f seconds\n", static_query_seconds);
+  printf("  # Mismatched queries = %d\n", nmismatches);
+  fflush(stdout);
+
+  // Delete temporary memory
+  delete [] vertex_points;
+  delete [] positions;
+  delete [] kdtree_distances;
+  delete [] kdtree_counts;
+  delete [] static_distances;
+  delete [] static_counts;
+  delete [] indices;
+
+  // Check that searches agree
+  if (nmismatches > 0) {
+    RNFail("Kdtree and static kdtree found different neighbors for %d queries\n", nmismatches);
+    return 0;
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+static void
+FindDifferentNeighbors(std::vector<int>& ids1, std::vector<int>& ids2, std::vector<int>& difference)
+{
+  // Find ids that are in one set but not the other
+  std::sort(ids1.begin(), ids1.end());
+  std::sort(ids2.begin(), ids2.end());
+  std::set_symmetric_difference(ids1.begin(), ids1.end(), ids2.begin(), ids2.end(), std::back_inserter(difference));
+}
+
+
+
+static int
+TestDynamicKdtree(R3Mesh *mesh, int noperations)
+{
+  // Check number of operations
+  if ((noperations <= 0) || (mesh->NVertices() == 0)) {
+    RNFail("Test needs a positive number of operations and a mesh with vertices: %d\n", noperations);
+    return 0;
+  }
+
+  // Get convenient variables
+  int nvertices = mesh->NVertices();
+  RNLength radius = 0.01 * mesh->BBox().DiagonalLength();
+  RNLength tolerance = 1.0E-5 * mesh->BBox().DiagonalLength();
+  const int k = 8;
+
+  // Create tree with first half of vertices (ids are indices into the array)
+  int ninitial = nvertices / 2;
+  std::vector<R3Point> positions(ninitial);
+  for (int i = 0; i < ninitial; i++) positions[i] = mesh->VertexPosition(mesh->Vertex(i));
+  R3DynamicKdtree kdtree(ninitial ? &positions[0] : NULL, ninitial);
+
+  // Remember which ids are in the tree
+  std::vector<int> live_ids;
+  std::vector<int> live_slots(ninitial);
+  for (int i = 0; i < ninitial; i++) { live_slots[i] = i; live_ids.push_back(i); }
+
+  // Apply random inserts, removes, and moves, checking queries against brute force
+  RNTime test_time;
+  test_time.Read();
+  int ninserts = 0, nremoves = 0, nmoves = 0, nqueries = 0, nmismatches = 0;
+  for (int op = 0; op < noperations; op++) {
+    R3Point position = mesh->VertexPosition(mesh->Vertex((int) (RNRandomScalar() * nvertices) % nvertices));
+    RNScalar r = RNRandomScalar();
+    if (live_ids.empty() || (r < 0.4)) {
+      // Insert point
+      int id = kdtree.InsertPoint(position);
+      if (id >= (int) positions.size()) { positions.resize(id + 1); live_slots.resize(id + 1, -1); }
+      positions[id] = position;
+      live_slots[id] = live_ids.size();
+      live_ids.push_back(id);
+      ninserts++;
+    }
+    else if (r < 0.7) {
+      // Remove point
+      int slot = (int) (RNRandomScalar() * live_ids.size()) % live_ids.size();
+      int id = live_ids[slot];
+      kdtree.RemovePoint(id);
+      live_ids[slot] = live_ids.back();
+      live_slots[live_ids[slot]] = slot;
+      live_ids.pop_back();
+      live_slots[id] = -1;
+      nremoves++;
+    }
+    else {
+      // Move point
+      int id = live_ids[(int) (RNRandomScalar() * live_ids.size()) % live_ids.size()];
+      kdtree.MovePoint(id, position);
+      positions[id] = position;
+      nmoves++;
+    }
+
+    // Check queries every so often
+    if ((op % 64) != 63) continue;
+    if (kdtree.NPoints() != (int) live_ids.size()) { nmismatches++; continue; }
+    R3Point query_position = mesh->VertexPosition(mesh->Vertex((int) (RNRandomScalar() * nvertices) % nvertices));
+    query_position += R3Vector(RNRandomScalar() - 0.5, RNRandomScalar() - 0.5, RNRandomScalar() - 0.5) * radius;
+    R3Box query_box(query_position - R3Vector(radius, radius, radius), query_position + R3Vector(radius, radius, radius));
+    nqueries++;
+
+    // Find neighbors by brute force
+    std::vector<RNLength> brute_distances;
+    std::vector<int> brute_sphere_ids, brute_box_ids;
+    for (unsigned int i = 0; i < live_ids.size(); i++) {
+      int id = live_ids[i];
+      RNLength distance = R3Distance(query_position, positions[id]);
+      brute_distances.push_back(distance);
+      if (distance <= radius) brute_sphere_ids.push_back(id);
+      if (R3Contains(query_box, positions[id])) brute_box_ids.push_back(id);
+    }
+    std::sort(brute_distances.begin(), brute_distances.end());
+    int brute_count = (brute_distances.size() < (unsigned int) k) ? brute_distances.size() : k;
+
+    // Check closest point
+    RNLength closest_distance = -1;
+    int closest_id = kdtree.FindClosest(query_position, 0, FLT_MAX, &closest_distance);
+    if ((closest_id < 0) || (live_slots[closest_id] < 0) || (fabs(closest_distance - brute_distances[0]) > tolerance)) {
+      nmismatches++;
+      continue;
+    }
+
+    // Check K closest points
+    int closest_ids[k];
+    RNLength closest_distances[k];
+    int count = kdtree.FindClosest(query_position, 0, FLT_MAX, k, closest_ids, closest_distances);
+    RNBoolean mismatch = (count != brute_count) ? TRUE : FALSE;
+    for (int j = 0; !mismatch && (j < count); j++) {
+      if (live_slots[closest_ids[j]] < 0) mismatch = TRUE;
+      else if (fabs(closest_distances[j] - brute_distances[j]) > tolerance) mismatch = TRUE;
+    }
+    if (mismatch) { nmismatches++; continue; }
+
+    // Check all points within radius (ignoring points on the boundary, since trees store float coordinates)
+    std::vector<int> sphere_ids, sphere_difference;
+    kdtree.FindAll(query_position, 0, radius, sphere_ids);
+    FindDifferentNeighbors(sphere_ids, brute_sphere_ids, sphere_difference);
+    for (unsigned int j = 0; !mismatch && (j < sphere_difference.size()); j++) {
+      RNLength distance = R3Distance(query_position, positions[sphere_difference[j]]);
+      if (fabs(distance - radius) > tolerance) mismatch = TRUE;
+    }
+    if (mismatch) { nmismatches++; continue; }
+
+    // Check all points inside box (ignoring points on the boundary)
+    std::vector<int> box_ids, box_difference;
+    kdtree.FindAll(query_box, box_ids);
+    FindDifferentNeighbors(box_ids, brute_box_ids, box_difference);
+    for (unsigned int j = 0; !mismatch && (j < box_difference.size()); j++) {
+      const R3Point& position = positions[box_difference[j]];
+      RNBoolean on_boundary = FALSE;
+      for (int dim = 0; dim < 3; dim++) {
+        if (fabs(position[dim] - query_box[RN_LO][dim]) <= tolerance) on_boundary = TRUE;
+        if (fabs(position[dim] - query_box[RN_HI][dim]) <= tolerance) on_boundary = TRUE;
+      }
+      if (!on_boundary) mismatch = TRUE;
+    }
+    if (mismatch) { nmismatches++; continue; }
+  }
+
+  // Print statistics
+  printf("Tested dynamic kdtree ...\n");
+  printf("  Time = %.2f seconds\n", test_time.Elapsed());
+  printf("  # Operations = %d (%d inserts, %d removes, %d moves)\n", noperations, ninserts, nremoves, nmoves);
+  printf("  # Points = %d\n", kdtree.NPoints());
+  printf("  # Trees = %d\n", kdtree.NTrees());
+  printf("  # Queries = %d\n", nqueries);
+  printf("  # Mismatched queries = %d\n", nmismatches);
+  fflush(stdout);
+
+  // Check that searches agree
+  if (nmismatches > 0) {
+    RNFail("Dynamic kdtree and brute force search disagreed for %d queries\n", nmismatches);
+    return 0;
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Program argument parsing
 ////////////////////////////////////////////////////////////////////////
@@ -1750,6 +2813,10 @@ ParseArgs (int argc, char **argv)
       else if (!strcmp(*argv, "-max_distance")) { argc--; argv++; max_distance = atof(*argv); }
       else if (!strcmp(*argv, "-curvature_exponent")) { argc--; argv++; curvature_exponent = atof(*argv); }
       else if (!strcmp(*argv, "-curvature_max")) { argc--; argv++; curvature_max = atof(*argv); }
+      else if (!strcmp(*argv, "-furthest_vertex_tolerance")) { argc--; argv++; furthest_vertex_tolerance = atof(*argv); }
+      else if (!strcmp(*argv, "-benchmark_neighbor_search")) { argc--; argv++; benchmark_radius = atof(*argv); }
+      else if (!strcmp(*argv, "-benchmark_knn")) { argc--; argv++; benchmark_knn = atoi(*argv); }
+      else if (!strcmp(*argv, "-test_dynamic_kdtree")) { argc--; argv++; test_dynamic_kdtree = atoi(*argv); }
       else if (!strcmp(*argv, "-near_surface_bias_exponent")) { argc--; argv++; near_surface_bias_exponent = atof(*argv); }
       else if (!strcmp(*argv, "-property")) { argc--; argv++;  property_name = *argv; }
       else if (!strcmp(*argv, "-selection_method")) { argc--; argv++; selection_method = atoi(*argv); }
@@ -1760,6 +2827,8 @@ ParseArgs (int argc, char **argv)
       else if (!strcmp(*argv, "-near_surface_points")) { selection_method = NEAR_SURFACE_POINTS; }
       else if (!strcmp(*argv, "-random_vertices")) { selection_method = RANDOM_VERTICES; }
       else if (!strcmp(*argv, "-iterative_furthest_vertex")) { selection_method = ITERATIVE_FURTHEST_VERTEX; }
+      else if (!strcmp(*argv, "-parallel_furthest_vertex")) { selection_method = PARALLEL_FURTHEST_VERTEX; }
+      else if (!strcmp(*argv, "-poisson_disk_surface_points")) { selection_method = POISSON_DISK_SURFACE_POINTS; }
       else if (!strcmp(*argv, "-center_of_mass")) { selection_method = CENTER_OF_MASS; }
       else if (!strcmp(*argv, "-vertex_closest_to_center_of_mass")) { selection_method = VERTEX_CLOSEST_TO_CENTER_OF_MASS; }
       else if (!strcmp(*argv, "-property_minima")) { selection_method = PROPERTY_MINIMA; }
@@ -1770,6 +2839,7 @@ ParseArgs (int argc, char **argv)
       else if (!strcmp(*argv, "-scale_space_extrema")) { selection_method = SCALE_SPACE_EXTREMA; }
       else if (!strcmp(*argv, "-uniform_in_bbox")) { selection_method = UNIFORM_IN_BBOX; }
       else if (!strcmp(*argv, "-binary_sdf")) { binary_sdf = TRUE; }
+      else if (!strcmp(*argv, "-stream")) { stream = TRUE; }
       else if (!strcmp(*argv, "-v")) { print_verbose = TRUE; }
       else if (!strcmp(*argv, "-debug")) { print_debug = TRUE; }
       else if (!strcmp(*argv, "-bbox")) {
@@ -1798,6 +2868,12 @@ ParseArgs (int argc, char **argv)
     return FALSE;
   }
 
+  // Check furthest vertex tolerance
+  if ((furthest_vertex_tolerance <= 0) || (furthest_vertex_tolerance > 1)) {
+    RNFail("Furthest vertex tolerance must be in (0,1]: %g\n", furthest_vertex_tolerance);
+    return FALSE;
+  }
+
   // Resolve binary sdf flag
   if (!strstr(points_name, ".sdf")) binary_sdf = TRUE;
 
@@ -1819,10 +2895,38 @@ main(int argc, char **argv)
   // Parse args
   if(!ParseArgs(argc, argv)) exit(-1);
 
+  // Sample points in bounded memory without building mesh
+  if (stream) {
+    if (!StreamPoints(mesh_name, points_name)) exit(-1);
+    if (print_verbose) {
+      fprintf(stdout, "Finished in %6.3f seconds.\n", start_time.Elapsed());
+      fflush(stdout);
+    }
+    return 0;
+  }
+
   // Read mesh
   R3Mesh *mesh = ReadMesh(mesh_name);
   if (!mesh) exit(-1);
 
+  // Compute normals (and curvatures if needed) of mesh in parallel
+  mesh->UpdateDerivedQuantities(curvature_exponent > 0);
+
+  // Compare kdtree and hash grid neighbor searches
+  if (benchmark_radius != 0) {
+    if (!BenchmarkNeighborSearch(mesh, benchmark_radius)) exit(-1);
+  }
+
+  // Compare pointer-based and static kdtree K nearest neighbor searches
+  if (benchmark_knn != 0) {
+    if (!BenchmarkKNearestNeighborSearch(mesh, benchmark_knn)) exit(-1);
+  }
+
+  // Check dynamic kdtree against brute force search
+  if (test_dynamic_kdtree != 0) {
+    if (!TestDynamicKdtree(mesh, test_dynamic_kdtree)) exit(-1);
+  }
+
   // Read property 
   R3MeshProperty *property = NULL;
   if (property_name) {
@@ -308,6 +308,122 @@ CreatePoints(R3Mesh *mesh, RNScalar *weights, int nweights, R3Point *points, int
 
 
 
+// Correspondence search structures (built on first use, then shared by all threads)
+
+static R3Kdtree<const R3Point *> *point_tree1 = NULL;
+static R3Kdtree<const R3Point *> *point_tree2 = NULL;
+static R3MeshSearchTree *mesh_tree1 = NULL;
+static R3MeshSearchTree *mesh_tree2 = NULL;
+
+// Number of points in each block of parallel correspondence searches
+static const int correspondence_block_size = 64;
+
+
+
+struct CorrespondenceData {
+  const R3Point *points1;
+  int npoints1;
+  const R3Point *points2;
+  int npoints2;
+  const R3Affine *affine12;
+  const R3Affine *affine21;
+  R3Point *correspondences1;
+  R3Point *correspondences2;
+};
+
+
+
+static void
+CreateSearchTrees(
+  R3Mesh *mesh1, const R3Point *points1, int npoints1,
+  R3Mesh *mesh2, const R3Point *points2, int npoints2)
+{
+  // Check method
+  if (correspondence_method == 0) {
+    // Build kdtree for points1
+    if (!point_tree1) {
+      RNArray<const R3Point *> array1;
+      for (int i = 0; i < npoints1; i++) array1.Insert(&points1[i]);
+      point_tree1 = new R3Kdtree<const R3Point *>(array1);
+    }
+
+    // Build kdtree for points2
+    if (!point_tree2) {
+      RNArray<const R3Point *> array2;
+      for (int i = 0; i < npoints2; i++) array2.Insert(&points2[i]);
+      point_tree2 = new R3Kdtree<const R3Point *>(array2);
+    }
+  }
+  else {
+    // Compute lazily updated mesh quantities before many threads query the meshes
+    if (!mesh_tree1) mesh1->UpdateDerivedQuantities(FALSE);
+    if (!mesh_tree2) mesh2->UpdateDerivedQuantities(FALSE);
+
+    // Build search trees for meshes
+    if (!mesh_tree1) mesh_tree1 = new R3MeshSearchTree(mesh1);
+    else assert(mesh1 == mesh_tree1->mesh);
+    if (!mesh_tree2) mesh_tree2 = new R3MeshSearchTree(mesh2);
+    else assert(mesh2 == mesh_tree2->mesh);
+  }
+}
+
+
+
+static void
+CreatePointPointCorrespondencesTask(int start, int end, void *data)
+{
+  // Compute correspondences for a range of points (points1 first, then points2)
+  CorrespondenceData *task = (CorrespondenceData *) data;
+  for (int i = start; i < end; i++) {
+    if (i < task->npoints1) {
+      // Compute correspondence for points1 -> mesh2
+      R3Point position1 = task->points1[i];
+      position1.Transform(*(task->affine12));
+      const R3Point *closest = point_tree2->FindClosest(position1);
+      task->correspondences1[i] = task->points1[i];
+      task->correspondences2[i] = *closest;
+    }
+    else {
+      // Compute correspondence for points2 -> mesh1
+      R3Point position2 = task->points2[i - task->npoints1];
+      position2.Transform(*(task->affine21));
+      const R3Point *closest = point_tree1->FindClosest(position2);
+      task->correspondences1[i] = *closest;
+      task->correspondences2[i] = task->points2[i - task->npoints1];
+    }
+  }
+}
+
+
+
+static void
+CreatePointSurfaceCorrespondencesTask(int start, int end, void *data)
+{
+  // Compute correspondences for a range of points (points1 first, then points2)
+  CorrespondenceData *task = (CorrespondenceData *) data;
+  for (int i = start; i < end; i++) {
+    R3MeshIntersection closest;
+    if (i < task->npoints1) {
+      // Compute correspondence for points1 -> mesh2
+      R3Point position1 = task->points1[i];
+      position1.Transform(*(task->affine12));
+      mesh_tree2->FindClosest(position1, closest);
+      task->correspondences1[i] = task->points1[i];
+      task->correspondences2[i] = closest.point;
+    }
+    else {
+      // Compute correspondence for points2 -> mesh1
+      R3Point position2 = task->points2[i - task->npoints1];
+      position2.Transform(*(task->affine21));
+      mesh_tree1->FindClosest(position2, closest);
+      task->correspondences1[i] = closest.point;
+      task->correspondences2[i] = task->points2[i - task->npoints1];
+    }
+  }
+}
+
+
+
 static int
 CreatePointPointCorrespondences(
   R3Mesh *mesh1, const R3Point *points1, int npoints1,
@@ -316,52 +432,24 @@ CreatePointPointCorrespondences(
   R3Point *correspondences1, R3Point *correspondences2, 
   int max_correspondences)
 {
-  // Build kdtree for points1
-  static R3Kdtree<const R3Point *> *tree1 = NULL;
-  if (!tree1) {
-    RNArray<const R3Point *> array1;
-    for (int i = 0; i < npoints1; i++) array1.Insert(&points1[i]);
-    tree1 = new R3Kdtree<const R3Point *>(array1);
-  }
+  // Build kdtrees for points
+  CreateSearchTrees(mesh1, points1, npoints1, mesh2, points2, npoints2);
 
-  // Build kdtree for points2
-  static R3Kdtree<const R3Point *> *tree2 = NULL;
-  if (!tree2) {
-    RNArray<const R3Point *> array2;
-    for (int i = 0; i < npoints2; i++) array2.Insert(&points2[i]);
-    tree2 = new R3Kdtree<const R3Point *>(array2);
-  }
-
-  // Initialize number of correspondences
+  // Compute correspondences for points1 -> mesh2 and points2 -> mesh1 in parallel
   assert(max_correspondences == npoints1 + npoints2);
-  int ncorrespondences = 0;
-
-  // Compute correspondences for points1 -> mesh2
-  for (int i = 0; i < npoints1; i++) {
-    R3Point position1 = points1[i];
-    position1.Transform(affine12);
-    const R3Point *closest = tree2->FindClosest(position1);
-    assert(ncorrespondences < max_correspondences);
-    correspondences1[ncorrespondences] = points1[i];
-    correspondences2[ncorrespondences] = *closest;
-    ncorrespondences++;
-  }
-
-  // Compute correspondences for points2 -> mesh1
-  for (int i = 0; i < npoints2; i++) {
-    R3Point position2 = points2[i];
-    position2.Transform(affine21);
-    const R3Point *closest = tree1->FindClosest(position2);
-    assert(ncorrespondences < max_correspondences);
-    correspondences1[ncorrespondences] = *closest;
-    correspondences2[ncorrespondences] = points2[i];
-    ncorrespondences++;
-  }
+  CorrespondenceData task;
+  task.points1 = points1;
+  task.npoints1 = npoints1;
+  task.points2 = points2;
+  task.npoints2 = npoints2;
+  task.affine12 = &affine12;
+  task.affine21 = &affine21;
+  task.correspondences1 = correspondences1;
+  task.correspondences2 = correspondences2;
+  RNParallelFor(0, npoints1 + npoints2, CreatePointPointCorrespondencesTask, &task, correspondence_block_size);
 
   // Return number of correspondences
-  assert(ncorrespondences == npoints1 + npoints2);
-  assert(ncorrespondences == max_correspondences);
-  return ncorrespondences;
+  return npoints1 + npoints2;
 }
 
 
@@ -374,44 +462,24 @@ CreatePointSurfaceCorrespondences(
   R3Point *correspondences1, R3Point *correspondences2, 
   int max_correspondences)
 {
-  // Initialize number of correspondences
-  assert(max_correspondences == npoints1 + npoints2);
-  int ncorrespondences = 0;
-
-  // Compute correspondences for points1 -> mesh2
-  static R3MeshSearchTree *tree2 = NULL;
-  if (!tree2) tree2 = new R3MeshSearchTree(mesh2);
-  else assert(mesh2 == tree2->mesh);
-  for (int i = 0; i < npoints1; i++) {
-    R3Point position1 = points1[i];
-    position1.Transform(affine12);
-    R3MeshIntersection closest;
-    tree2->FindClosest(position1, closest);
-    assert(ncorrespondences < max_correspondences);
-    correspondences1[ncorrespondences] = points1[i];
-    correspondences2[ncorrespondences] = closest.point;
-    ncorrespondences++;
-  }
+  // Build search trees for meshes
+  CreateSearchTrees(mesh1, points1, npoints1, mesh2, points2, npoints2);
 
-  // Compute correspondences for points2 -> mesh1
-  static R3MeshSearchTree *tree1 = NULL;
-  if (!tree1) tree1 = new R3MeshSearchTree(mesh1);
-  else assert(mesh1 == tree1->mesh);
-  for (int i = 0; i < npoints2; i++) {
-    R3Point position2 = points2[i];
-    position2.Transform(affine21);
-    R3MeshIntersection closest;
-    tree1->FindClosest(position2, closest);
-    assert(ncorrespondences < max_correspondences);
-    correspondences1[ncorrespondences] = closest.point;
-    correspondences2[ncorrespondences] = points2[i];
-    ncorrespondences++;
-  }
+  // Compute correspondences for points1 -> mesh2 and points2 -> mesh1 in parallel
+  assert(max_correspondences == npoints1 + npoints2);
+  CorrespondenceData task;
+  task.points1 = points1;
+  task.npoints1 = npoints1;
+  task.points2 = points2;
+  task.npoints2 = npoints2;
+  task.affine12 = &affine12;
+  task.affine21 = &affine21;
+  task.correspondences1 = correspondences1;
+  task.correspondences2 = correspondences2;
+  RNParallelFor(0, npoints1 + npoints2, CreatePointSurfaceCorrespondencesTask, &task, correspondence_block_size);
 
   // Return number of correspondences
-  assert(ncorrespondences == npoints1 + npoints2);
-  assert(ncorrespondences == max_correspondences);
-  return ncorrespondences;
+  return npoints1 + npoints2;
 }
 
 
@@ -544,6 +612,95 @@ ICPAlignmentTransformation(
 
 
 
+// Number of ransac hypotheses generated and then scored in parallel at a time
+static const int ransac_batch_size = 256;
+
+
+
+struct RansacHypothesis {
+  int indices1[3];
+  int indices2[3];
+  R3Affine affine21;
+  RNScalar support;
+};
+
+
+
+struct RansacData {
+  const R3Point *points1;
+  int npoints1;
+  const R3Point *points2;
+  int npoints2;
+  int translation, rotation, scale;
+  RNScalar support_factor;
+  RansacHypothesis *hypotheses;
+};
+
+
+
+static void
+ScoreRansacHypothesesTask(int start, int end, void *data)
+{
+  // Allocate correspondence buffers for this task
+  RansacData *task = (RansacData *) data;
+  int max_correspondences = task->npoints1 + task->npoints2;
+  R3Point *correspondences1 = new R3Point [ max_correspondences ];
+  R3Point *correspondences2 = new R3Point [ max_correspondences ];
+
+  // Score a range of hypotheses
+  for (int h = start; h < end; h++) {
+    RansacHypothesis& hypothesis = task->hypotheses[h];
+
+    // Create triplets of points
+    RNArray<R3Point *> triplet1; 
+    RNArray<R3Point *> triplet2;
+    for (int k = 0; k < 3; k++) {
+      triplet1.Insert((R3Point *) &(task->points1[hypothesis.indices1[k]]));
+      triplet2.Insert((R3Point *) &(task->points2[hypothesis.indices2[k]]));
+    }
+
+    // Compute transformation aligning triplet2 to triplet1
+    R4Matrix matrix21 = R3AlignPoints(triplet1, triplet2, NULL, task->translation, task->rotation, task->scale);
+    R3Affine aff21(matrix21);
+    R3Affine aff12 = aff21.Inverse();
+
+    // Compute correspondences (serially, since hypotheses are scored in parallel)
+    CorrespondenceData correspondence_data;
+    correspondence_data.points1 = task->points1;
+    correspondence_data.npoints1 = task->npoints1;
+    correspondence_data.points2 = task->points2;
+    correspondence_data.npoints2 = task->npoints2;
+    correspondence_data.affine12 = &aff12;
+    correspondence_data.affine21 = &aff21;
+    correspondence_data.correspondences1 = correspondences1;
+    correspondence_data.correspondences2 = correspondences2;
+    int ncorrespondences = task->npoints1 + task->npoints2;
+    if (correspondence_method == 0) CreatePointPointCorrespondencesTask(0, ncorrespondences, &correspondence_data);
+    else CreatePointSurfaceCorrespondencesTask(0, ncorrespondences, &correspondence_data);
+
+    // Compute support
+    RNScalar support = 0;
+    for (int i = 0; i < ncorrespondences; i++) {
+      R3Point& point1 = correspondences1[i];
+      R3Point point2 = correspondences2[i];
+      point2.Transform(aff21);
+      RNScalar dd = R3SquaredDistance(point1, point2);
+      RNScalar s = exp(task->support_factor * dd);
+      support += s;
+    }
+
+    // Remember transformation and support
+    hypothesis.affine21 = aff21;
+    hypothesis.support = support;
+  }
+
+  // Delete correspondence buffers
+  delete [] correspondences1;
+  delete [] correspondences2;
+}
+
+
+
 static int
 RansacAlignmentTransformation(
   R3Mesh *mesh1, const R3Point *points1, int npoints1,
@@ -564,64 +721,59 @@ RansacAlignmentTransformation(
   affine12 = R3identity_affine;
   affine21 = R3identity_affine;
 
+  // Build search trees before scoring hypotheses in parallel
+  CreateSearchTrees(mesh1, points1, npoints1, mesh2, points2, npoints2);
+
   // Create temporary memory
-  int max_correspondences = npoints1 + npoints2;
-  R3Point *correspondences1 = new R3Point [ max_correspondences ];
-  R3Point *correspondences2 = new R3Point [ max_correspondences ];
+  RansacHypothesis *hypotheses = new RansacHypothesis [ ransac_batch_size ];
 
   // Compute useful variables
   if (max_iterations == 0) max_iterations = 0.1 * npoints1 * npoints2; // should be n^3
   if (support_sigma <= 0) support_sigma = 0.5 * mesh1->AverageRadius();
   RNScalar support_factor = -1.0 / (2 * support_sigma * support_sigma);
 
+  // Initialize data for parallel tasks
+  RansacData task;
+  task.points1 = points1;
+  task.npoints1 = npoints1;
+  task.points2 = points2;
+  task.npoints2 = npoints2;
+  task.translation = translation;
+  task.rotation = rotation;
+  task.scale = scale;
+  task.support_factor = support_factor;
+  task.hypotheses = hypotheses;
+
   // Generate random alignments and keep the one with best support
   RNScalar best_support = 0;
   R3Affine best_affine21 = R3identity_affine;
-  for (int iteration = 0; iteration < max_iterations; iteration++) {
-    int a1, b1, c1, a2, b2, c2;
-    a1 = (int) (RNRandomScalar() * npoints1); 
-    do { b1 = (int) (RNRandomScalar() * npoints1); } while (b1 == a1);
-    do { c1 = (int) (RNRandomScalar() * npoints1); } while ((c1 == a1) || (c1 == b1));
-    a2 = (int) (RNRandomScalar() * npoints2); 
-    do { b2 = (int) (RNRandomScalar() * npoints2); } while (b2 == a2);
-    do { c2 = (int) (RNRandomScalar() * npoints2); } while ((c2 == a2) || (c2 == b2));
-
-    // Create triplets of points
-    static RNArray<R3Point *> triplet1; 
-    triplet1.Empty();
-    triplet1.Insert((R3Point *) &points1[a1]);
-    triplet1.Insert((R3Point *) &points1[b1]);
-    triplet1.Insert((R3Point *) &points1[c1]);
-    static RNArray<R3Point *> triplet2;
-    triplet2.Empty();
-    triplet2.Insert((R3Point *) &points2[a2]);
-    triplet2.Insert((R3Point *) &points2[b2]);
-    triplet2.Insert((R3Point *) &points2[c2]);
-
-    // Compute transformation aligning triplet2 to triplet1
-    R4Matrix matrix21 = R3AlignPoints(triplet1, triplet2, NULL, translation, rotation, scale);
-    R3Affine aff21(matrix21);
-    R3Affine aff12 = aff21.Inverse();
-
-    // Compute correspondences
-    int ncorrespondences = CreatePointCorrespondences(mesh1, points1, npoints1, mesh2, points2, npoints2, 
-      aff12, aff21, correspondences1, correspondences2, max_correspondences);
-
-    // Compute support
-    RNScalar support = 0;
-    for (int i = 0; i < ncorrespondences; i++) {
-      R3Point& point1 = correspondences1[i];
-      R3Point point2 = correspondences2[i];
-      point2.Transform(aff21);
-      RNScalar dd = R3SquaredDistance(point1, point2);
-      RNScalar s = exp(support_factor * dd);
-      support += s;
+  for (int iteration = 0; iteration < max_iterations; iteration += ransac_batch_size) {
+    int nhypotheses = max_iterations - iteration;
+    if (nhypotheses > ransac_batch_size) nhypotheses = ransac_batch_size;
+
+    // Choose random triplets of points (serially, so that the random sequence is always the same)
+    for (int h = 0; h < nhypotheses; h++) {
+      int a1, b1, c1, a2, b2, c2;
+      a1 = (int) (RNRandomScalar() * npoints1); 
+      do { b1 = (int) (RNRandomScalar() * npoints1); } while (b1 == a1);
+      do { c1 = (int) (RNRandomScalar() * npoints1); } while ((c1 == a1) || (c1 == b1));
+      a2 = (int) (RNRandomScalar() * npoints2); 
+      do { b2 = (int) (RNRandomScalar() * npoints2); } while (b2 == a2);
+      do { c2 = (int) (RNRandomScalar() * npoints2); } while ((c2 == a2) || (c2 == b2));
+      RansacHypothesis& hypothesis = hypotheses[h];
+      hypothesis.indices1[0] = a1; hypothesis.indices1[1] = b1; hypothesis.indices1[2] = c1;
+      hypothesis.indices2[0] = a2; hypothesis.indices2[1] = b2; hypothesis.indices2[2] = c2;
     }
 
-    // Check if best support so far
-    if (support > best_support) {
-      best_affine21 = aff21;
-      best_support = support;
+    // Score hypotheses in parallel
+    RNParallelFor(0, nhypotheses, ScoreRansacHypothesesTask, &task, 1);
+
+    // Check for best support so far (in order, so that ties are broken as before)
+    for (int h = 0; h < nhypotheses; h++) {
+      if (hypotheses[h].support > best_support) {
+        best_affine21 = hypotheses[h].affine21;
+        best_support = hypotheses[h].support;
+      }
     }
   }
 
@@ -630,8 +782,7 @@ RansacAlignmentTransformation(
   affine12 = best_affine21.Inverse();
   
   // Delete temporary data
-  delete [] correspondences1;
-  delete [] correspondences2;
+  delete [] hypotheses;
 
   // Return success
   return 1;
@@ -988,6 +1139,7 @@ ParseArgs(int argc, char **argv)
       else if (!strcmp(*argv, "-sample_faces")) sample_method = 0; 
       else if (!strcmp(*argv, "-sample_edges")) sample_method = 1; 
       else if (!strcmp(*argv, "-sample_vertices")) sample_method = 2; 
+      else if (!strcmp(*argv, "-threads")) { argc--; argv++; RNSetNumThreads(atoi(*argv)); }
       else { RNFail("Invalid program argument: %s", *argv); exit(1); }
       argv++; argc--;
     }
@@ -17,6 +17,8 @@ using namespace gaps;
 static char *input_mesh1_filename = NULL;
 static char *input_mesh2_filename = NULL;
 static char *output_property_filename = NULL;
+static int nface_samples = 0;
+static int print_statistics = 0;
 static int print_verbose = 0;
 
 
@@ -89,55 +91,25 @@ WriteProperties(R3MeshPropertySet *properties, char *filename)
 // Property computation
 ////////////////////////////////////////////////////////////////////////
 
-static R3MeshPropertySet *
-CreateMeshPropertySet(R3Mesh *mesh1, R3Mesh *mesh2)
-{
-  // Start statistics
-  RNTime start_time;
-  start_time.Read();
-  if (print_verbose) {
-    printf("Creating mesh properties ...\n");
-    fflush(stdout);
-  }
+struct VertexComparisonData {
+  R3Mesh *mesh1;
+  R3Mesh *mesh2;
+  const R3MeshIntersection *closest2;
+  int nvalues;
+  RNScalar *values;
+};
 
-  // Create property set
-  R3MeshPropertySet *properties = new R3MeshPropertySet(mesh1);
-  if (!properties) {
-    fprintf(stderr, "Unable to open allocate mesh property set\n");
-    return NULL;
-  }
 
-  // Create properties
-  R3MeshProperty *p;
-  p = new R3MeshProperty(mesh1, "distance"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "NdotN"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "type1"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "id1"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "category1"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "curvature1"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "boundary1"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "position1.x"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "position1.y"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "position1.z"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "normal1.x"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "normal1.y"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "normal1.z"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "type2"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "id2"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "category2"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "curvature2"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "boundary2"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "position2.x"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "position2.y"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "position2.z"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "normal2.x"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "normal2.y"); properties->Insert(p);
-  p = new R3MeshProperty(mesh1, "normal2.z"); properties->Insert(p);
-  
-  // Compute distances from vertices of mesh1 to closest face in mesh2
-  R3MeshIntersection closest2;
-  R3MeshSearchTree kdtree2(mesh2);
-  for (int i = 0; i < mesh1->NVertices(); i++) {
+
+static void
+ComputeVertexValuesTask(int start, int end, void *data)
+{
+  // Compute property values for a range of vertices of mesh1
+  VertexComparisonData *comparison = (VertexComparisonData *) data;
+  R3Mesh *mesh1 = comparison->mesh1;
+  R3Mesh *mesh2 = comparison->mesh2;
+  for (int i = start; i < end; i++) {
+    const R3MeshIntersection& closest2 = comparison->closest2[i];
     R3MeshVertex *vertex1 = mesh1->Vertex(i);
     R3MeshFace *face1 = mesh1->FaceOnVertex(vertex1);
     const R3Point& position1 = mesh1->VertexPosition(vertex1);
@@ -147,7 +119,6 @@ CreateMeshPropertySet(R3Mesh *mesh1, R3Mesh *mesh2)
     RNScalar curvature1 = mesh1->VertexMeanCurvature(vertex1);
     RNBoolean boundary1 = mesh1->IsVertexOnBoundary(vertex1);
     int category1 = (face1) ? mesh1->FaceCategory(face1) : -1;
-    kdtree2.FindClosest(position1, closest2);
     if (closest2.type == R3_MESH_NULL_TYPE) RNAbort("Error");
     R3MeshFace *face2 = closest2.face;
     int type2 = closest2.type;
@@ -187,35 +158,111 @@ CreateMeshPropertySet(R3Mesh *mesh1, R3Mesh *mesh2)
       boundary2 = FALSE;
     }
 
-    // Add entries to properties
+    // Fill values (in the order of the properties)
+    RNScalar *values = &comparison->values[i * comparison->nvalues];
     int cnt = 0;
-    properties->Property(cnt++)->SetVertexValue(i, distance);
-    properties->Property(cnt++)->SetVertexValue(i, normal1.Dot(normal2));
-    properties->Property(cnt++)->SetVertexValue(i, type1);
-    properties->Property(cnt++)->SetVertexValue(i, id1);
-    properties->Property(cnt++)->SetVertexValue(i, category1);
-    properties->Property(cnt++)->SetVertexValue(i, curvature1);
-    properties->Property(cnt++)->SetVertexValue(i, boundary1);
-    properties->Property(cnt++)->SetVertexValue(i, position1.X());
-    properties->Property(cnt++)->SetVertexValue(i, position1.Y());
-    properties->Property(cnt++)->SetVertexValue(i, position1.Z());
-    properties->Property(cnt++)->SetVertexValue(i, normal1.X());
-    properties->Property(cnt++)->SetVertexValue(i, normal1.Y());
-    properties->Property(cnt++)->SetVertexValue(i, normal1.Z());
-    properties->Property(cnt++)->SetVertexValue(i, type2);
-    properties->Property(cnt++)->SetVertexValue(i, id2);
-    properties->Property(cnt++)->SetVertexValue(i, category2);
-    properties->Property(cnt++)->SetVertexValue(i, curvature2);
-    properties->Property(cnt++)->SetVertexValue(i, boundary2);
-    properties->Property(cnt++)->SetVertexValue(i, position2.X());
-    properties->Property(cnt++)->SetVertexValue(i, position2.Y());
-    properties->Property(cnt++)->SetVertexValue(i, position2.Z());
-    properties->Property(cnt++)->SetVertexValue(i, normal2.X());
-    properties->Property(cnt++)->SetVertexValue(i, normal2.Y());
-    properties->Property(cnt++)->SetVertexValue(i, normal2.Z());
-    assert(cnt == properties->NProperties());
+    values[cnt++] = distance;
+    values[cnt++] = normal1.Dot(normal2);
+    values[cnt++] = type1;
+    values[cnt++] = id1;
+    values[cnt++] = category1;
+    values[cnt++] = curvature1;
+    values[cnt++] = boundary1;
+    values[cnt++] = position1.X();
+    values[cnt++] = position1.Y();
+    values[cnt++] = position1.Z();
+    values[cnt++] = normal1.X();
+    values[cnt++] = normal1.Y();
+    values[cnt++] = normal1.Z();
+    values[cnt++] = type2;
+    values[cnt++] = id2;
+    values[cnt++] = category2;
+    values[cnt++] = curvature2;
+    values[cnt++] = boundary2;
+    values[cnt++] = position2.X();
+    values[cnt++] = position2.Y();
+    values[cnt++] = position2.Z();
+    values[cnt++] = normal2.X();
+    values[cnt++] = normal2.Y();
+    values[cnt++] = normal2.Z();
+    assert(cnt == comparison->nvalues);
+  }
+}
+
+
+
+static R3MeshPropertySet *
+CreateMeshPropertySet(R3Mesh *mesh1, R3Mesh *mesh2, const R3MeshSearchTree& kdtree2)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+  if (print_verbose) {
+    printf("Creating mesh properties ...\n");
+    fflush(stdout);
+  }
+
+  // Create property set
+  R3MeshPropertySet *properties = new R3MeshPropertySet(mesh1);
+  if (!properties) {
+    fprintf(stderr, "Unable to open allocate mesh property set\n");
+    return NULL;
+  }
+
+  // Create properties
+  R3MeshProperty *p;
+  p = new R3MeshProperty(mesh1, "distance"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "NdotN"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "type1"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "id1"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "category1"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "curvature1"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "boundary1"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "position1.x"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "position1.y"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "position1.z"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "normal1.x"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "normal1.y"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "normal1.z"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "type2"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "id2"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "category2"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "curvature2"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "boundary2"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "position2.x"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "position2.y"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "position2.z"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "normal2.x"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "normal2.y"); properties->Insert(p);
+  p = new R3MeshProperty(mesh1, "normal2.z"); properties->Insert(p);
+  
+  // Find closest points in mesh2 to vertices of mesh1 in parallel
+  R3Point *positions1 = new R3Point [ mesh1->NVertices() ];
+  R3MeshIntersection *closest2 = new R3MeshIntersection [ mesh1->NVertices() ];
+  for (int i = 0; i < mesh1->NVertices(); i++) positions1[i] = mesh1->VertexPosition(mesh1->Vertex(i));
+  kdtree2.FindClosestBatch(positions1, mesh1->NVertices(), closest2);
+
+  // Compute property values for vertices of mesh1 in parallel
+  VertexComparisonData data;
+  data.mesh1 = mesh1;
+  data.mesh2 = mesh2;
+  data.closest2 = closest2;
+  data.nvalues = properties->NProperties();
+  data.values = new RNScalar [ mesh1->NVertices() * properties->NProperties() ];
+  RNParallelFor(0, mesh1->NVertices(), ComputeVertexValuesTask, &data, 256);
+
+  // Add entries to properties
+  for (int i = 0; i < mesh1->NVertices(); i++) {
+    for (int j = 0; j < properties->NProperties(); j++) {
+      properties->Property(j)->SetVertexValue(i, data.values[i * data.nvalues + j]);
+    }
   }
 
+  // Delete temporary memory
+  delete [] positions1;
+  delete [] closest2;
+  delete [] data.values;
+
   // Print statistics
   if (print_verbose) {
     printf("  Time = %.2f seconds\n", start_time.Elapsed());
@@ -230,6 +277,158 @@ CreateMeshPropertySet(R3Mesh *mesh1, R3Mesh *mesh2)
 
 
 
+////////////////////////////////////////////////////////////////////////
+// Distance statistics
+////////////////////////////////////////////////////////////////////////
+
+static int
+CreateSamples(R3Mesh *mesh, R3Point *samples, int nsamples)
+{
+  // Accumulate face areas
+  RNArea *cumulative_areas = new RNArea [ mesh->NFaces() + 1 ];
+  cumulative_areas[0] = 0;
+  for (int i = 0; i < mesh->NFaces(); i++) {
+    cumulative_areas[i+1] = cumulative_areas[i] + mesh->FaceArea(mesh->Face(i));
+  }
+
+  // Check total area
+  RNArea total_area = cumulative_areas[mesh->NFaces()];
+  if (total_area <= 0) { delete [] cumulative_areas; return 0; }
+
+  // Place samples at regular intervals of accumulated area (so that the
+  // distribution is uniform over the surface and the same on every run),
+  // at quasi-random barycentric coordinates within faces
+  int face_index = 0;
+  for (int k = 0; k < nsamples; k++) {
+    RNArea target_area = (k + 0.5) * total_area / nsamples;
+    while ((face_index < mesh->NFaces() - 1) && (cumulative_areas[face_index+1] < target_area)) face_index++;
+    R3MeshFace *face = mesh->Face(face_index);
+    const R3Point& p0 = mesh->VertexPosition(mesh->VertexOnFace(face, 0));
+    const R3Point& p1 = mesh->VertexPosition(mesh->VertexOnFace(face, 1));
+    const R3Point& p2 = mesh->VertexPosition(mesh->VertexOnFace(face, 2));
+    RNScalar u = 0.5 + 0.7548776662466927 * k; u -= floor(u);
+    RNScalar v = 0.5 + 0.5698402909980532 * k; v -= floor(v);
+    RNScalar r1 = sqrt(u);
+    RNScalar t0 = (1.0 - r1);
+    RNScalar t1 = r1 * (1.0 - v);
+    RNScalar t2 = r1 * v;
+    samples[k] = t0*p0 + t1*p1 + t2*p2;
+  }
+
+  // Delete temporary memory
+  delete [] cumulative_areas;
+
+  // Return number of samples
+  return nsamples;
+}
+
+
+
+static RNScalar *
+ComputeDistances(R3Mesh *mesh1, const R3MeshSearchTree& kdtree2, int& nsamples)
+{
+  // Get sample points (vertices, or points on faces)
+  R3Point *samples = NULL;
+  if (nface_samples > 0) {
+    samples = new R3Point [ nface_samples ];
+    nsamples = CreateSamples(mesh1, samples, nface_samples);
+  }
+  else {
+    nsamples = mesh1->NVertices();
+    samples = new R3Point [ nsamples ];
+    for (int i = 0; i < nsamples; i++) samples[i] = mesh1->VertexPosition(mesh1->Vertex(i));
+  }
+
+  // Find distances to closest points in parallel (in chunks to bound memory)
+  const int chunk_size = 65536;
+  RNScalar *distances = new RNScalar [ nsamples ];
+  R3MeshIntersection *closest = new R3MeshIntersection [ chunk_size ];
+  for (int start = 0; start < nsamples; start += chunk_size) {
+    int n = (nsamples - start < chunk_size) ? nsamples - start : chunk_size;
+    kdtree2.FindClosestBatch(&samples[start], n, closest);
+    for (int i = 0; i < n; i++) {
+      distances[start + i] = (closest[i].type != R3_MESH_NULL_TYPE) ? closest[i].t : RN_INFINITY;
+    }
+  }
+
+  // Delete temporary memory
+  delete [] samples;
+  delete [] closest;
+
+  // Return distances
+  return distances;
+}
+
+
+
+static void
+PrintDistanceStatistics(const char *name1, const char *name2, RNScalar *distances, int ndistances,
+  RNScalar& mean, RNScalar& max)
+{
+  // Sort distances
+  std::sort(distances, distances + ndistances);
+
+  // Compute mean, root mean square, and max
+  RNScalar sum = 0, sum_squared = 0;
+  for (int i = 0; i < ndistances; i++) {
+    sum += distances[i];
+    sum_squared += distances[i] * distances[i];
+  }
+  mean = (ndistances > 0) ? sum / ndistances : 0;
+  RNScalar rms = (ndistances > 0) ? sqrt(sum_squared / ndistances) : 0;
+  max = (ndistances > 0) ? distances[ndistances-1] : 0;
+
+  // Print statistics
+  static const RNScalar percentiles[] = { 0.5, 0.9, 0.95, 0.99 };
+  printf("Distances from %s to %s ...\n", name1, name2);
+  printf("  # Samples = %d\n", ndistances);
+  printf("  Mean = %g\n", mean);
+  printf("  RMS = %g\n", rms);
+  for (int i = 0; i < 4; i++) {
+    int index = (int) ceil(percentiles[i] * ndistances) - 1;
+    if (index < 0) index = 0;
+    RNScalar distance = (ndistances > 0) ? distances[index] : 0;
+    printf("  %gth percentile = %g\n", 100 * percentiles[i], distance);
+  }
+  printf("  Max = %g\n", max);
+  fflush(stdout);
+}
+
+
+
+static int
+PrintStatistics(R3Mesh *mesh1, R3Mesh *mesh2,
+  const R3MeshSearchTree& kdtree1, const R3MeshSearchTree& kdtree2)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+
+  // Compute and print distances in both directions
+  int nsamples1, nsamples2;
+  RNScalar mean12, max12, mean21, max21;
+  RNScalar *distances12 = ComputeDistances(mesh1, kdtree2, nsamples1);
+  PrintDistanceStatistics(input_mesh1_filename, input_mesh2_filename, distances12, nsamples1, mean12, max12);
+  RNScalar *distances21 = ComputeDistances(mesh2, kdtree1, nsamples2);
+  PrintDistanceStatistics(input_mesh2_filename, input_mesh1_filename, distances21, nsamples2, mean21, max21);
+
+  // Print symmetric distances (chamfer is the sum of the mean distances in both directions)
+  printf("Symmetric distances ...\n");
+  if (print_verbose) printf("  Time = %.2f seconds\n", start_time.Elapsed());
+  printf("  Hausdorff = %g\n", (max12 > max21) ? max12 : max21);
+  printf("  Chamfer = %g\n", mean12 + mean21);
+  fflush(stdout);
+
+  // Delete distances
+  delete [] distances12;
+  delete [] distances21;
+
+  // Return success
+  return 1;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Program argument parsing
 ////////////////////////////////////////////////////////////////////////
@@ -242,6 +441,9 @@ ParseArgs(int argc, char **argv)
   while (argc > 0) {
     if ((*argv)[0] == '-') {
       if (!strcmp(*argv, "-v")) print_verbose = 1; 
+      else if (!strcmp(*argv, "-print_statistics")) print_statistics = 1; 
+      else if (!strcmp(*argv, "-sample_faces")) { argv++; argc--; nface_samples = atoi(*argv); }
+      else if (!strcmp(*argv, "-threads")) { argv++; argc--; RNSetNumThreads(atoi(*argv)); }
       else { RNFail("Invalid program argument: %s", *argv); exit(1); }
     }
     else {
@@ -254,8 +456,8 @@ ParseArgs(int argc, char **argv)
   }
 
   // Check filenames
-  if (!input_mesh1_filename || !input_mesh2_filename || !output_property_filename) {
-    RNFail("Usage: mshcompare mesh1 mesh2 output [options]\n");
+  if (!input_mesh1_filename || !input_mesh2_filename || (!output_property_filename && !print_statistics)) {
+    RNFail("Usage: mshcompare mesh1 mesh2 [output] [-print_statistics] [-sample_faces n] [options]\n");
     return 0;
   }
 
@@ -283,15 +485,31 @@ main(int argc, char **argv)
   R3Mesh *mesh2 = ReadMesh(input_mesh2_filename);
   if (!mesh2) exit(-1);
 
-  // Create the output properties
-  R3MeshPropertySet *properties = CreateMeshPropertySet(mesh1, mesh2);
-  if (!properties) exit(-1);
+  // Compute derived quantities before meshes are searched in parallel
+  mesh1->UpdateDerivedQuantities();
+  mesh2->UpdateDerivedQuantities();
+
+  // Create search tree for the second mesh
+  R3MeshSearchTree kdtree2(mesh2);
 
-  // Write the properties to a file
-  if (!WriteProperties(properties, output_property_filename)) exit(-1);
+  // Compute properties of vertices of the first mesh
+  if (output_property_filename) {
+    // Create the output properties
+    R3MeshPropertySet *properties = CreateMeshPropertySet(mesh1, mesh2, kdtree2);
+    if (!properties) exit(-1);
 
-  // Delete the properties
-  delete properties;
+    // Write the properties to a file
+    if (!WriteProperties(properties, output_property_filename)) exit(-1);
+
+    // Delete the properties
+    delete properties;
+  }
+
+  // Print distance statistics in both directions
+  if (print_statistics) {
+    R3MeshSearchTree kdtree1(mesh1);
+    if (!PrintStatistics(mesh1, mesh2, kdtree1, kdtree2)) exit(-1);
+  }
   
   // Return success
   return 0;
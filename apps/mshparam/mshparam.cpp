@@ -6,7 +6,7 @@
 
 namespace gaps {}
 using namespace gaps;
-#include "R3Shapes/R3Shapes.h"
+#include "R3Utils/R3Utils.h"
 
 
 
@@ -22,6 +22,7 @@ static int separate_face_materials = 0;
 static double texel_spacing = 1;
 static int fit_in_zero_to_one = 0;
 static int flatten = 0;
+static int harmonic = 0;
 static int print_verbose = 0;
 
 
@@ -39,6 +40,7 @@ struct Segment {
   R2Box bbox;
   int id;
   int index;
+  RNBoolean harmonic;
 };
 
 
@@ -161,6 +163,7 @@ CreateSegments(R3Mesh *mesh, RNArray<Segment *>& segments)
       segment->bbox = R2null_box;
       segment->id = id;
       segment->index = segments.NEntries();
+      segment->harmonic = FALSE;
       segment_map.Insert(id, segment);
       segments.Insert(segment);
     }
@@ -270,6 +273,196 @@ DeleteSegments(R3Mesh *mesh, const RNArray<Segment *>& segments)
 // Parameterization stuff
 ////////////////////////////////////////////////////////////////////////
 
+static int
+FindLongestBoundaryLoop(R3Mesh *mesh, Segment *segment, RNBoolean *edge_visited,
+  RNArray<R3MeshVertex *>& loop)
+{
+  // Trace boundary loops of segment, remembering the longest one
+  RNLength max_length = 0;
+  loop.Empty();
+  for (int i = 0; i < segment->faces.NEntries(); i++) {
+    R3MeshFace *face = segment->faces.Kth(i);
+    for (int j = 0; j < 3; j++) {
+      R3MeshEdge *edge = mesh->EdgeOnFace(face, j);
+      if (edge_visited[mesh->EdgeID(edge)]) continue;
+      if (!mesh->IsEdgeOnBoundary(edge)) continue;
+
+      // Walk along unvisited boundary edges until the loop closes
+      RNArray<R3MeshVertex *> vertices;
+      RNLength length = 0;
+      R3MeshVertex *start_vertex = mesh->VertexOnEdge(edge, 0);
+      R3MeshVertex *vertex = start_vertex;
+      while (edge) {
+        edge_visited[mesh->EdgeID(edge)] = TRUE;
+        vertices.Insert(vertex);
+        length += mesh->EdgeLength(edge);
+        vertex = mesh->VertexAcrossEdge(edge, vertex);
+        if (vertex == start_vertex) break;
+        R3MeshEdge *next_edge = NULL;
+        for (int k = 0; k < mesh->VertexValence(vertex); k++) {
+          R3MeshEdge *candidate = mesh->EdgeOnVertex(vertex, k);
+          if (edge_visited[mesh->EdgeID(candidate)]) continue;
+          if (!mesh->IsEdgeOnBoundary(candidate)) continue;
+          next_edge = candidate;
+          break;
+        }
+        edge = next_edge;
+      }
+
+      // Remember longest loop
+      if ((vertices.NEntries() >= 3) && (length > max_length)) {
+        max_length = length;
+        loop = vertices;
+      }
+    }
+  }
+
+  // Return whether found a loop
+  return (loop.NEntries() >= 3) ? 1 : 0;
+}
+
+
+
+static int
+IsSegmentConnected(R3Mesh *mesh, Segment *segment, R3MeshVertex *seed, RNBoolean *vertex_reached)
+{
+  // Flood vertices of segment from seed
+  RNArray<R3MeshVertex *> stack;
+  vertex_reached[mesh->VertexID(seed)] = TRUE;
+  stack.Insert(seed);
+  int nreached = 1;
+  while (!stack.IsEmpty()) {
+    R3MeshVertex *vertex = stack.Tail();
+    stack.RemoveTail();
+    for (int k = 0; k < mesh->VertexValence(vertex); k++) {
+      R3MeshEdge *edge = mesh->EdgeOnVertex(vertex, k);
+      R3MeshVertex *neighbor = mesh->VertexAcrossEdge(edge, vertex);
+      if (vertex_reached[mesh->VertexID(neighbor)]) continue;
+      vertex_reached[mesh->VertexID(neighbor)] = TRUE;
+      stack.Insert(neighbor);
+      nreached++;
+    }
+  }
+
+  // Return whether reached every vertex of segment
+  return (nreached == segment->vertices.NEntries()) ? 1 : 0;
+}
+
+
+
+static int 
+ParameterizeSegmentsHarmonically(R3Mesh *mesh, RNArray<Segment *>& segments)
+{
+  // Allocate constraints and texture coordinates (u for all vertices, then v for all vertices)
+  int nvertices = mesh->NVertices();
+  RNBoolean *constrained = new RNBoolean [ nvertices ];
+  RNScalar *values = new RNScalar [ 2 * nvertices ];
+  RNBoolean *edge_visited = new RNBoolean [ mesh->NEdges() ];
+  RNBoolean *vertex_reached = new RNBoolean [ nvertices ];
+  for (int i = 0; i < nvertices; i++) constrained[i] = TRUE;
+  for (int i = 0; i < nvertices; i++) vertex_reached[i] = FALSE;
+  for (int i = 0; i < 2 * nvertices; i++) values[i] = 0;
+  for (int i = 0; i < mesh->NEdges(); i++) edge_visited[i] = FALSE;
+
+  // Map longest boundary loop of each connected segment to a circle by arc length
+  int nharmonic = 0;
+  for (int i = 0; i < segments.NEntries(); i++) {
+    Segment *segment = segments.Kth(i);
+    RNArray<R3MeshVertex *> loop;
+    if (!FindLongestBoundaryLoop(mesh, segment, edge_visited, loop)) continue;
+    if (!IsSegmentConnected(mesh, segment, loop.Head(), vertex_reached)) continue;
+
+    // Free interior vertices of segment
+    for (int j = 0; j < segment->vertices.NEntries(); j++) {
+      R3MeshVertex *vertex = segment->vertices.Kth(j);
+      constrained[mesh->VertexID(vertex)] = FALSE;
+    }
+
+    // Constrain loop vertices to unit circle
+    RNLength loop_length = 0;
+    for (int j = 0; j < loop.NEntries(); j++) {
+      R3MeshVertex *vertex0 = loop.Kth(j);
+      R3MeshVertex *vertex1 = loop.Kth((j + 1) % loop.NEntries());
+      loop_length += R3Distance(mesh->VertexPosition(vertex0), mesh->VertexPosition(vertex1));
+    }
+    RNLength arc_length = 0;
+    for (int j = 0; j < loop.NEntries(); j++) {
+      R3MeshVertex *vertex0 = loop.Kth(j);
+      R3MeshVertex *vertex1 = loop.Kth((j + 1) % loop.NEntries());
+      RNAngle angle = (loop_length > 0) ? RN_TWO_PI * arc_length / loop_length : RN_TWO_PI * j / loop.NEntries();
+      int index = mesh->VertexID(vertex0);
+      constrained[index] = TRUE;
+      values[index] = cos(angle);
+      values[nvertices + index] = sin(angle);
+      arc_length += R3Distance(mesh->VertexPosition(vertex0), mesh->VertexPosition(vertex1));
+    }
+
+    // Remember that segment is parameterized harmonically
+    segment->harmonic = TRUE;
+    nharmonic++;
+  }
+
+  // Solve for harmonic texture coordinates of interior vertices
+  if (nharmonic > 0) {
+    R3MeshLaplacian laplacian(mesh);
+    laplacian.SolveHarmonic(constrained, values, 2);
+  }
+
+  // Scale texture coordinates of each segment to match its surface area
+  for (int i = 0; i < segments.NEntries(); i++) {
+    Segment *segment = segments.Kth(i);
+    if (!segment->harmonic) continue;
+
+    // Compute area in 3D and signed area in texture coordinates
+    RNArea area = 0;
+    RNArea texcoords_area = 0;
+    for (int j = 0; j < segment->faces.NEntries(); j++) {
+      R3MeshFace *face = segment->faces.Kth(j);
+      int i0 = mesh->VertexID(mesh->VertexOnFace(face, 0));
+      int i1 = mesh->VertexID(mesh->VertexOnFace(face, 1));
+      int i2 = mesh->VertexID(mesh->VertexOnFace(face, 2));
+      R2Vector t1(values[i1] - values[i0], values[nvertices + i1] - values[nvertices + i0]);
+      R2Vector t2(values[i2] - values[i0], values[nvertices + i2] - values[nvertices + i0]);
+      texcoords_area += 0.5 * (t1[0] * t2[1] - t1[1] * t2[0]);
+      area += mesh->FaceArea(face);
+    }
+
+    // Flip u if faces are oriented backwards in texture coordinates
+    RNScalar flip = (texcoords_area < 0) ? -1 : 1;
+    RNScalar scale = (texcoords_area != 0) ? sqrt(area / fabs(texcoords_area)) : 1;
+
+    // Assign texture coordinates and determine extent
+    segment->bbox = R2null_box;
+    for (int j = 0; j < segment->vertices.NEntries(); j++) {
+      R3MeshVertex *vertex = segment->vertices.Kth(j);
+      int index = mesh->VertexID(vertex);
+      R2Point texcoords(flip * scale * values[index], scale * values[nvertices + index]);
+      mesh->SetVertexTextureCoords(vertex, texcoords);
+      segment->bbox.Union(texcoords);
+    }
+  }
+
+  // Sort segments by extent in texture coordinates
+  segments.Sort(CompareSegments);
+
+  // Delete temporary memory
+  delete [] constrained;
+  delete [] values;
+  delete [] edge_visited;
+  delete [] vertex_reached;
+
+  // Print statistics
+  if (print_verbose) {
+    printf("  # Harmonic Segments = %d\n", nharmonic);
+    fflush(stdout);
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
 static int 
 ParameterizeSegments(R3Mesh *mesh, const RNArray<Segment *>& segments)
 {
@@ -290,10 +483,19 @@ ParameterizeSegments(R3Mesh *mesh, const RNArray<Segment *>& segments)
     // Assign texture coordinates to vertices
     for (int j = 0; j < segment->vertices.NEntries(); j++) {
       R3MeshVertex *vertex = segment->vertices.Kth(j);
-      R3Point position = mesh->VertexPosition(vertex);
-      position = matrix * position;
-      R2Point texcoords(position.X(), position.Y());
-      mesh->SetVertexTextureCoords(vertex, texcoords);
+      if (segment->harmonic) {
+        // Translate harmonic texture coordinates
+        R2Point texcoords = mesh->VertexTextureCoords(vertex);
+        texcoords += origin - segment->bbox.Min();
+        mesh->SetVertexTextureCoords(vertex, texcoords);
+      }
+      else {
+        // Project position onto plane of segment
+        R3Point position = mesh->VertexPosition(vertex);
+        position = matrix * position;
+        R2Point texcoords(position.X(), position.Y());
+        mesh->SetVertexTextureCoords(vertex, texcoords);
+      }
     }
 
     // Update max xlength
@@ -325,6 +527,11 @@ ParameterizeMesh(R3Mesh *mesh)
   RNArray<Segment *> segments;
   if (!CreateSegments(mesh, segments)) return 0;
 
+  // Compute harmonic texture coordinates for segments with boundaries
+  if (harmonic) {
+    if (!ParameterizeSegmentsHarmonically(mesh, segments)) return 0;
+  }
+
   // Parameterize segments
   if (!ParameterizeSegments(mesh, segments)) return 0;
   
@@ -603,6 +810,7 @@ ParseArgs(int argc, char **argv)
       if (!strcmp(*argv, "-v")) print_verbose = 1;
       else if (!strcmp(*argv, "-fit_in_zero_to_one")) fit_in_zero_to_one = 1;
       else if (!strcmp(*argv, "-flatten")) flatten = 1;
+      else if (!strcmp(*argv, "-harmonic")) harmonic = 1;
       else if (!strcmp(*argv, "-separate_face_segments")) separate_face_segments = 1;
       else if (!strcmp(*argv, "-separate_face_materials")) separate_face_materials = 1;
       else if (!strcmp(*argv, "-output_textures")) { argc--; argv++; output_texture_directory = *argv; }
@@ -482,6 +482,9 @@ ParseArgs(int argc, char **argv)
       else if (!strcmp(*argv, "-min_area_per_segment")) {
         argc--; argv++; options.min_cluster_area = atof(*argv);
       }
+      else if (!strcmp(*argv, "-threads")) {
+        argc--; argv++; RNSetNumThreads(atoi(*argv));
+      }
       else if (!strcmp(*argv, "-output_json")) {
         argc--; argv++; output_json_name = *argv;
       }
@@ -514,6 +514,101 @@ LoadSurfelsList(R3SurfelScene *scene, const char *list_filename,
 
 
 
+static int
+IngestSurfelsList(R3SurfelScene *scene, const char *list_filename, 
+  const char *parent_node_name, RNLength tile_size)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+
+  // Check tile size
+  if (tile_size <= 0) {
+    RNFail("Tile size must be positive: %g\n", tile_size);
+    return 0;
+  }
+
+  // Find parent node
+  R3SurfelNode *parent_node = scene->Tree()->FindNodeByName(parent_node_name);
+  if (!parent_node) {
+    RNFail("Unable to find parent node with name %s\n", parent_node_name);
+    return 0;
+  }
+
+  // Open file
+  FILE *fp = fopen(list_filename, "r");
+  if (!fp) {
+    RNFail("Unable to open %s\n", list_filename);
+    return 0;
+  }
+
+  // Bin surfels from all files into tiles (one file in memory at a time)
+  R3SurfelIngester ingester(scene, parent_node, tile_size);
+  int count = 0;
+  char buffer[4096];
+  char surfels_filename[512];
+  while (fgets(buffer, 4096, fp)) {
+    if (buffer[0] == '#') continue;
+    if (sscanf(buffer, "%s", surfels_filename) != (unsigned int) 1) continue;
+
+    // Read block
+    R3SurfelBlock *block = new R3SurfelBlock();
+    if (!block->ReadFile(surfels_filename)) {
+      RNFail("Unable to read block from %s\n", surfels_filename);
+      delete block;
+      fclose(fp);
+      return 0;
+    }
+
+    // Insert surfels 
+    if (aerial_only || terrestrial_only) {
+      for (int i = 0; i < block->NSurfels(); i++) {
+        const R3Surfel *surfel = block->Surfel(i);
+        if (surfel->IsAerial() && terrestrial_only) continue;
+        if (!surfel->IsAerial() && aerial_only) continue;
+        if (!ingester.InsertSurfels(surfel, 1, block->PositionOrigin(), block->TimestampOrigin())) {
+          delete block;
+          fclose(fp);
+          return 0;
+        }
+      }
+    }
+    else {
+      if (!ingester.InsertBlock(block)) {
+        delete block;
+        fclose(fp);
+        return 0;
+      }
+    }
+
+    // Delete block
+    delete block;
+    count++;
+  }
+
+  // Close file
+  fclose(fp);
+
+  // Create nodes and blocks for tiles
+  int ntiles = ingester.NTiles();
+  if (!ingester.Finish()) return 0;
+
+  // Print statistics
+  if (print_verbose) {
+    printf("Ingested surfels from %s ...\n", list_filename);
+    printf("  Time = %.2f seconds\n", start_time.Elapsed());
+    printf("  # Files = %d\n", count);
+    printf("  # Tiles = %d\n", ntiles);
+    printf("  # Surfels = %llu\n", ingester.NSurfels());
+    fflush(stdout);
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
 static int
 LoadSurfelsFromMesh(R3SurfelScene *scene, const char *mesh_filename, 
   const char *parent_object_name, const char *parent_node_name,
@@ -2320,6 +2415,348 @@ CreatePlanarObjects(R3SurfelScene *scene,
 
 
 
+////////////////////////////////////////////////////////////////////////
+// QUERY FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+struct FindClosestSurfelsData {
+  R3SurfelQueryEngine *engine;
+  const RNArray<R3Point *> *query_positions;
+  R3Point *closest_positions;
+  RNLength *closest_distances;
+  RNLength max_distance;
+};
+
+
+
+static void
+FindClosestSurfelsTask(int start, int end, void *data)
+{
+  // Find closest surfel to each query position in range
+  FindClosestSurfelsData *d = (FindClosestSurfelsData *) data;
+  for (int i = start; i < end; i++) {
+    R3SurfelPoint closest_point;
+    RNLength closest_distance = -1;
+    const R3Point& query_position = *(d->query_positions->Kth(i));
+    if (d->engine->FindClosest(query_position, 0, d->max_distance, closest_point, &closest_distance)) {
+      d->closest_positions[i] = closest_point.Position();
+      d->closest_distances[i] = closest_distance;
+    }
+    else {
+      d->closest_positions[i] = query_position;
+      d->closest_distances[i] = -1;
+    }
+  }
+}
+
+
+
+static int
+FindClosestSurfels(R3SurfelScene *scene,
+  const char *input_filename, const char *output_filename,
+  RNLength max_distance, unsigned long long max_cached_surfels)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+  if (print_verbose) {
+    printf("Finding closest surfels ...\n");
+    fflush(stdout);
+  }
+
+  // Get convenient variables
+  R3SurfelTree *tree = scene->Tree();
+  if (!tree) return 0;
+
+  // Open input file
+  FILE *fp = fopen(input_filename, "r");
+  if (!fp) {
+    RNFail("Unable to open query positions file %s\n", input_filename);
+    return 0;
+  }
+
+  // Read query positions
+  RNArray<R3Point *> query_positions;
+  double x, y, z;
+  while (fscanf(fp, "%lf%lf%lf", &x, &y, &z) == (unsigned int) 3) {
+    query_positions.Insert(new R3Point(x, y, z));
+  }
+
+  // Close input file
+  fclose(fp);
+
+  // Find closest surfels (in parallel)
+  RNTime query_time;
+  query_time.Read();
+  R3SurfelQueryEngine engine(tree, NULL, max_cached_surfels);
+  FindClosestSurfelsData data;
+  data.engine = &engine;
+  data.query_positions = &query_positions;
+  data.closest_positions = new R3Point [ query_positions.NEntries() + 1 ];
+  data.closest_distances = new RNLength [ query_positions.NEntries() + 1 ];
+  data.max_distance = max_distance;
+  RNParallelFor(0, query_positions.NEntries(), FindClosestSurfelsTask, &data);
+  RNScalar query_seconds = query_time.Elapsed();
+
+  // Write closest positions and distances
+  int nfound = 0;
+  int status = 1;
+  fp = fopen(output_filename, "w");
+  if (fp) {
+    for (int i = 0; i < query_positions.NEntries(); i++) {
+      const R3Point& position = data.closest_positions[i];
+      fprintf(fp, "%g %g %g %g\n", position.X(), position.Y(), position.Z(), data.closest_distances[i]);
+      if (data.closest_distances[i] >= 0) nfound++;
+    }
+    fclose(fp);
+  }
+  else {
+    RNFail("Unable to open output file %s\n", output_filename);
+    status = 0;
+  }
+
+  // Print statistics
+  if (print_verbose) {
+    printf("  Time = %.2f seconds\n", start_time.Elapsed());
+    printf("  Query time = %.2f seconds\n", query_seconds);
+    printf("  # Queries = %d\n", query_positions.NEntries());
+    printf("  # Found = %d\n", nfound);
+    printf("  # Cached blocks = %d\n", engine.NCachedBlocks());
+    printf("  # Cached surfels = %llu\n", engine.NCachedSurfels());
+    fflush(stdout);
+  }
+
+  // Delete everything
+  for (int i = 0; i < query_positions.NEntries(); i++) delete query_positions[i];
+  delete [] data.closest_positions;
+  delete [] data.closest_distances;
+
+  // Return status
+  return status;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// TEST FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+static RNUInt64
+BlockChecksum(const R3SurfelBlock *block)
+{
+  // Hash bytes of surfels (FNV-1a)
+  RNUInt64 checksum = 14695981039346656037ULL;
+  const unsigned char *bytes = (const unsigned char *) block->Surfels();
+  unsigned long long nbytes = (unsigned long long) block->NSurfels() * sizeof(R3Surfel);
+  for (unsigned long long i = 0; i < nbytes; i++) {
+    checksum ^= bytes[i];
+    checksum *= 1099511628211ULL;
+  }
+  return checksum;
+}
+
+
+
+struct TestConcurrentReadsData {
+  R3SurfelDatabase *database;
+  const RNUInt64 *checksums;
+  int range_size;
+  std::atomic<int> nreads;
+  std::atomic<int> nerrors;
+};
+
+
+
+static void
+TestConcurrentReadsTask(int start, int end, void *data)
+{
+  // Read ranges of blocks (consecutive ranges overlap by half) and check them
+  TestConcurrentReadsData *d = (TestConcurrentReadsData *) data;
+  int nblocks = d->database->NBlocks();
+  for (int i = start; i < end; i++) {
+    int first = (int) (((long long) i * (d->range_size / 2 + 1)) % nblocks);
+    for (int j = 0; j < d->range_size; j++) {
+      int index = (first + j) % nblocks;
+      R3SurfelBlock *block = d->database->Block(index);
+      if (!d->database->ReadBlock(block)) { d->nerrors++; continue; }
+      if (BlockChecksum(block) != d->checksums[index]) d->nerrors++;
+      d->database->ReleaseBlock(block);
+      d->nreads++;
+    }
+  }
+}
+
+
+
+static int
+TestConcurrentReads(R3SurfelScene *scene, int nranges)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+  if (print_verbose) {
+    printf("Testing concurrent reads ...\n");
+    fflush(stdout);
+  }
+
+  // Get convenient variables
+  R3SurfelTree *tree = scene->Tree();
+  if (!tree) return 0;
+  R3SurfelDatabase *database = tree->Database();
+  if (!database) return 0;
+  int nblocks = database->NBlocks();
+  if (nblocks == 0) return 1;
+
+  // Compute checksums of blocks with serial reads
+  RNUInt64 *checksums = new RNUInt64 [ nblocks ];
+  for (int i = 0; i < nblocks; i++) {
+    R3SurfelBlock *block = database->Block(i);
+    database->ReadBlock(block);
+    checksums[i] = BlockChecksum(block);
+    database->ReleaseBlock(block);
+  }
+
+  // Read overlapping ranges of blocks with all threads
+  RNTime read_time;
+  read_time.Read();
+  TestConcurrentReadsData data;
+  data.database = database;
+  data.checksums = checksums;
+  data.range_size = nblocks / 4 + 1;
+  data.nreads = 0;
+  data.nerrors = 0;
+  RNParallelFor(0, nranges, TestConcurrentReadsTask, &data, 1);
+  RNScalar read_seconds = read_time.Elapsed();
+
+  // Print statistics
+  if (print_verbose) {
+    printf("  Time = %.2f seconds\n", start_time.Elapsed());
+    printf("  Read time = %.2f seconds\n", read_seconds);
+    printf("  # Threads = %d\n", RNNumThreads());
+    printf("  # Blocks = %d\n", nblocks);
+    printf("  # Reads = %d\n", data.nreads.load());
+    printf("  # Errors = %d\n", data.nerrors.load());
+    fflush(stdout);
+  }
+
+  // Delete checksums
+  delete [] checksums;
+
+  // Check errors
+  if (data.nerrors > 0) {
+    RNFail("%d of %d concurrent block reads did not match serial reads\n",
+      data.nerrors.load(), data.nreads.load());
+    return 0;
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+static int
+BenchmarkApproximateKNearestNeighborSearch(R3SurfelScene *scene,
+  int k, RNLength max_distance, RNScalar epsilon, int max_leaves)
+{
+  // Start statistics
+  RNTime start_time;
+  start_time.Read();
+  if (print_verbose) {
+    printf("Benchmarking approximate K nearest neighbor search ...\n");
+    fflush(stdout);
+  }
+
+  // Check arguments
+  if (k <= 0) {
+    RNFail("Benchmark number of neighbors must be positive: %d\n", k);
+    return 0;
+  }
+
+  // Get convenient variables
+  R3SurfelTree *tree = scene->Tree();
+  if (!tree) return 0;
+  R3SurfelDatabase *database = tree->Database();
+  if (!database) return 0;
+
+  // Gather positions of surfels in leaf nodes
+  std::vector<R3Point> positions;
+  for (int i = 0; i < tree->NNodes(); i++) {
+    R3SurfelNode *node = tree->Node(i);
+    if (node->NParts() > 0) continue;
+    for (int j = 0; j < node->NBlocks(); j++) {
+      R3SurfelBlock *block = node->Block(j);
+      database->ReadBlock(block);
+      for (int s = 0; s < block->NSurfels(); s++) {
+        positions.push_back(block->SurfelPosition(s));
+      }
+      database->ReleaseBlock(block);
+    }
+  }
+
+  // Build kdtree
+  int npoints = positions.size();
+  if (npoints == 0) return 1;
+  RNArray<R3Point *> array;
+  for (int i = 0; i < npoints; i++) array.Insert(&positions[i]);
+  R3Kdtree<R3Point *> kdtree(array);
+
+  // Find exact K closest to every surfel (in parallel)
+  R3Point **exact_points = new R3Point * [ npoints * k ];
+  int *exact_counts = new int [ npoints ];
+  RNTime exact_time;
+  exact_time.Read();
+  kdtree.FindClosestBatch(&positions[0], npoints, k, max_distance, exact_points, NULL, exact_counts);
+  RNScalar exact_seconds = exact_time.Elapsed();
+
+  // Find approximate K closest to every surfel (in parallel)
+  R3Point **approximate_points = new R3Point * [ npoints * k ];
+  int *approximate_counts = new int [ npoints ];
+  RNTime approximate_time;
+  approximate_time.Read();
+  kdtree.FindClosestBatch(&positions[0], npoints, k, max_distance, approximate_points, NULL, approximate_counts, epsilon, max_leaves);
+  RNScalar approximate_seconds = approximate_time.Elapsed();
+
+  // Compute recall (fraction of exact neighbors found by approximate search)
+  long long nexact = 0, nfound = 0;
+  for (int i = 0; i < npoints; i++) {
+    R3Point **exact = &exact_points[i*k];
+    R3Point **approximate = &approximate_points[i*k];
+    for (int j = 0; j < exact_counts[i]; j++) {
+      for (int m = 0; m < approximate_counts[i]; m++) {
+        if (approximate[m] == exact[j]) { nfound++; break; }
+      }
+    }
+    nexact += exact_counts[i];
+  }
+
+  // Print statistics
+  if (print_verbose) {
+    printf("  Time = %.2f seconds\n", start_time.Elapsed());
+    printf("  Exact query time = %.3f seconds\n", exact_seconds);
+    printf("  Approximate query time = %.3f seconds\n", approximate_seconds);
+    printf("  K = %d\n", k);
+    printf("  Max distance = %g\n", max_distance);
+    printf("  Epsilon = %g\n", epsilon);
+    printf("  Max leaves = %d\n", max_leaves);
+    printf("  # Threads = %d\n", RNNumThreads());
+    printf("  # Points = %d\n", npoints);
+    printf("  Recall@%d = %.4f\n", k, (nexact > 0) ? (double) nfound / nexact : 1.0);
+    fflush(stdout);
+  }
+
+  // Delete temporary memory
+  delete [] exact_points;
+  delete [] exact_counts;
+  delete [] approximate_points;
+  delete [] approximate_counts;
+
+  // Return success
+  return 1;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // OUTPUT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -2577,6 +3014,7 @@ int main(int argc, char **argv)
     else if (!strcmp(*argv, "-debug")) print_debug = 1;
     else if (!strcmp(*argv, "-aerial_only")) aerial_only = 1;
     else if (!strcmp(*argv, "-terrestrial_only")) terrestrial_only = 1;
+    else if (!strcmp(*argv, "-threads")) { argc--; argv++; RNSetNumThreads(atoi(*argv)); }
     else if (!strcmp(*argv, "-create_comment")) { 
       argc--; argv++; const char *comment = *argv; 
       scene->InsertComment(comment);
@@ -2616,6 +3054,14 @@ int main(int argc, char **argv)
         NULL, parent_node_name)) exit(-1);
       noperations++;
     }
+    else if (!strcmp(*argv, "-ingest_surfels_list")) { 
+      argc--; argv++; const char *list_filename = *argv; 
+      argc--; argv++; const char *parent_node_name = *argv; 
+      argc--; argv++; RNLength tile_size = atof(*argv); 
+      if (!IngestSurfelsList(scene, list_filename, 
+        parent_node_name, tile_size)) exit(-1);
+      noperations++;
+    }
     else if (!strcmp(*argv, "-load_object")) { 
       argc--; argv++; const char *surfels_filename = *argv; 
       argc--; argv++; const char *object_name = *argv; 
@@ -2898,6 +3344,28 @@ int main(int argc, char **argv)
         multiresolution_factor, max_node_complexity)) exit(-1);
       noperations++;
     }
+    else if (!strcmp(*argv, "-find_closest_surfels")) { 
+      argc--; argv++; const char *input_filename = *argv; 
+      argc--; argv++; const char *output_filename = *argv; 
+      argc--; argv++; double max_distance = atof(*argv); 
+      argc--; argv++; double max_cached_surfels = atof(*argv); 
+      if (!FindClosestSurfels(scene, input_filename, output_filename,
+        max_distance, (unsigned long long) max_cached_surfels)) exit(-1);
+      noperations++;
+    }
+    else if (!strcmp(*argv, "-benchmark_approximate_knn")) { 
+      argc--; argv++; int k = atoi(*argv); 
+      argc--; argv++; double max_distance = atof(*argv); 
+      argc--; argv++; double epsilon = atof(*argv); 
+      argc--; argv++; int max_leaves = atoi(*argv); 
+      if (!BenchmarkApproximateKNearestNeighborSearch(scene, k, max_distance, epsilon, max_leaves)) exit(-1);
+      noperations++;
+    }
+    else if (!strcmp(*argv, "-test_concurrent_reads")) { 
+      argc--; argv++; int nranges = atoi(*argv); 
+      if (!TestConcurrentReads(scene, nranges)) exit(-1);
+      noperations++;
+    }
     else if (!strcmp(*argv, "-output_blobs")) { 
       argc--; argv++; const char *blob_directory_name = *argv; 
       if (!OutputBlobs(scene, blob_directory_name)) exit(-1);
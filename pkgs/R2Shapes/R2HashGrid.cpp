@@ -0,0 +1,421 @@
+// Source file for R2HashGrid class
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Include files
+////////////////////////////////////////////////////////////////////////
+
+#include "R2Shapes.h"
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Namespace
+////////////////////////////////////////////////////////////////////////
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constant definitions
+////////////////////////////////////////////////////////////////////////
+
+static const int R2hash_grid_max_resolution = (1 << 30) - 1;
+static const RNScalar R2hash_grid_max_cells_per_spacing = 16;
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constructors/destructors
+////////////////////////////////////////////////////////////////////////
+
+R2HashGrid::
+R2HashGrid(const R2Point *positions, int npoints, RNLength cell_size)
+  : bbox(R2null_box),
+    cell_size(cell_size),
+    npoints(npoints),
+    nbuckets(1),
+    bucket_starts(NULL),
+    sorted_positions(NULL),
+    sorted_keys(NULL),
+    point_indices(NULL),
+    sorted_indices(NULL)
+{
+  // Check points
+  if (npoints < 0) this->npoints = npoints = 0;
+
+  // Compute bounding box
+  for (int i = 0; i < npoints; i++) bbox.Union(positions[i]);
+  if (npoints == 0) bbox = R2zero_box;
+
+  // Compute cell size giving about one point per cell
+  RNLength extent = bbox.LongestAxisLength();
+  RNLength spacing = 1;
+  if ((npoints > 0) && (extent > 0)) {
+    // Use cells spanning the whole width of thin sets
+    RNScalar area = bbox.Area();
+    spacing = sqrt(area / npoints);
+    if ((area == 0) || (bbox.ShortestAxisLength() < spacing)) spacing = extent / npoints;
+  }
+
+  // Choose cell size if none was given, and keep cells from being much smaller than the point spacing
+  if (this->cell_size <= 0) this->cell_size = spacing;
+  else if (this->cell_size < spacing / R2hash_grid_max_cells_per_spacing) {
+    this->cell_size = spacing / R2hash_grid_max_cells_per_spacing;
+  }
+
+  // Make sure cell coordinates fit in keys
+  if (extent / this->cell_size > R2hash_grid_max_resolution - 1) {
+    this->cell_size = extent / (R2hash_grid_max_resolution - 1);
+  }
+
+  // Compute grid resolution
+  for (int dim = 0; dim < 2; dim++) {
+    grid_resolution[dim] = (int) (bbox.AxisLength(dim) / this->cell_size) + 1;
+  }
+
+  // Compute number of buckets (power of two, about two per point)
+  while (nbuckets < 2 * npoints) nbuckets *= 2;
+
+  // Count points in each bucket
+  int *point_buckets = new int [ npoints ];
+  unsigned long long *point_keys = new unsigned long long [ npoints ];
+  bucket_starts = new int [ nbuckets + 1 ];
+  for (int i = 0; i <= nbuckets; i++) bucket_starts[i] = 0;
+  for (int i = 0; i < npoints; i++) {
+    int cell[2];
+    CellCoordinates(positions[i], cell);
+    point_buckets[i] = BucketIndex(cell[0], cell[1]);
+    point_keys[i] = CellKey(cell[0], cell[1]);
+    bucket_starts[point_buckets[i] + 1]++;
+  }
+
+  // Compute start of each bucket
+  for (int i = 0; i < nbuckets; i++) bucket_starts[i+1] += bucket_starts[i];
+
+  // Sort points into buckets (counting sort)
+  sorted_positions = new R2Point [ npoints ];
+  sorted_keys = new unsigned long long [ npoints ];
+  point_indices = new int [ npoints ];
+  sorted_indices = new int [ npoints ];
+  int *bucket_counts = new int [ nbuckets ];
+  for (int i = 0; i < nbuckets; i++) bucket_counts[i] = 0;
+  for (int i = 0; i < npoints; i++) {
+    int bucket = point_buckets[i];
+    int slot = bucket_starts[bucket] + bucket_counts[bucket]++;
+    sorted_positions[slot] = positions[i];
+    sorted_keys[slot] = point_keys[i];
+    point_indices[slot] = i;
+    sorted_indices[i] = slot;
+  }
+
+  // Delete temporary data
+  delete [] point_buckets;
+  delete [] point_keys;
+  delete [] bucket_counts;
+}
+
+
+
+R2HashGrid::
+R2HashGrid(const R2HashGrid& grid)
+  : bbox(grid.bbox),
+    cell_size(grid.cell_size),
+    npoints(grid.npoints),
+    nbuckets(grid.nbuckets),
+    bucket_starts(NULL),
+    sorted_positions(NULL),
+    sorted_keys(NULL),
+    point_indices(NULL),
+    sorted_indices(NULL)
+{
+  // Copy arrays
+  for (int dim = 0; dim < 2; dim++) grid_resolution[dim] = grid.grid_resolution[dim];
+  bucket_starts = new int [ nbuckets + 1 ];
+  sorted_positions = new R2Point [ npoints ];
+  sorted_keys = new unsigned long long [ npoints ];
+  point_indices = new int [ npoints ];
+  sorted_indices = new int [ npoints ];
+  memcpy(bucket_starts, grid.bucket_starts, (nbuckets + 1) * sizeof(int));
+  for (int i = 0; i < npoints; i++) sorted_positions[i] = grid.sorted_positions[i];
+  memcpy(sorted_keys, grid.sorted_keys, npoints * sizeof(unsigned long long));
+  memcpy(point_indices, grid.point_indices, npoints * sizeof(int));
+  memcpy(sorted_indices, grid.sorted_indices, npoints * sizeof(int));
+}
+
+
+
+R2HashGrid::
+~R2HashGrid(void)
+{
+  // Delete arrays
+  if (bucket_starts) delete [] bucket_starts;
+  if (sorted_positions) delete [] sorted_positions;
+  if (sorted_keys) delete [] sorted_keys;
+  if (point_indices) delete [] point_indices;
+  if (sorted_indices) delete [] sorted_indices;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding the closest K points to a query point
+////////////////////////////////////////////////////////////////////////
+
+static inline void
+InsertClosest(int index, RNLength distance_squared, int max_points,
+  int *indices, RNLength *distances_squared, int& npoints)
+{
+  // Find slot for point (points are sorted by distance)
+  int slot = npoints;
+  while ((slot > 0) && (distance_squared < distances_squared[slot-1])) slot--;
+  if (slot >= max_points) return;
+
+  // Insert point and distance into sorted arrays
+  int last = (npoints < max_points) ? npoints : max_points - 1;
+  for (int j = last; j > slot; j--) {
+    distances_squared[j] = distances_squared[j-1];
+    indices[j] = indices[j-1];
+  }
+  distances_squared[slot] = distance_squared;
+  indices[slot] = index;
+  if (npoints < max_points) npoints++;
+}
+
+
+
+int R2HashGrid::
+FindClosest(const R2Point& query_position,
+  RNLength min_distance, RNLength max_distance, int max_points,
+  int *indices, RNLength *distances) const
+{
+  // Check arguments
+  if (npoints == 0) return 0;
+  if (max_points <= 0) return 0;
+  if (max_distance < 0) return 0;
+  if (min_distance < 0) min_distance = 0;
+
+  // Use squared distances for efficiency
+  RNLength min_distance_squared = min_distance * min_distance;
+  RNLength max_distance_squared = (max_distance < FLT_MAX) ? max_distance * max_distance : FLT_MAX;
+
+  // Allocate temporary array of squared distances
+  RNLength distances_squared_buffer[64];
+  RNLength *distances_squared = distances_squared_buffer;
+  if (max_points > 64) distances_squared = new RNLength [ max_points ];
+
+  // Search rings of cells around query until none can contain closer points
+  int center[2];
+  CellCoordinates(query_position, center);
+  int max_ring = 0;
+  for (int dim = 0; dim < 2; dim++) {
+    if (center[dim] > max_ring) max_ring = center[dim];
+    if (grid_resolution[dim] - 1 - center[dim] > max_ring) max_ring = grid_resolution[dim] - 1 - center[dim];
+  }
+  int count = 0;
+  for (int ring = 0; ring <= max_ring; ring++) {
+    // Find range of cells on boundary of square with radius ring (clipped to grid)
+    int lo[2], hi[2];
+    RNBoolean sides_inside[2];
+    for (int dim = 0; dim < 2; dim++) {
+      lo[dim] = (center[dim] - ring > 0) ? center[dim] - ring : 0;
+      hi[dim] = (center[dim] + ring < grid_resolution[dim] - 1) ? center[dim] + ring : grid_resolution[dim] - 1;
+      sides_inside[dim] = (center[dim] - ring >= 0) || (center[dim] + ring < grid_resolution[dim]);
+    }
+
+    // Visit cells on boundary (skipping interior columns whose end cells are outside grid)
+    int ix_step = (sides_inside[1]) ? 1 : 2 * ring;
+    for (int ix = (ix_step == 1) ? lo[0] : center[0] - ring; ix <= hi[0]; ix += ix_step) {
+      if (ix < 0) continue;
+      RNBoolean x_on_boundary = (ix == center[0] - ring) || (ix == center[0] + ring);
+      int iy_step = (x_on_boundary) ? 1 : 2 * ring;
+      for (int iy = (iy_step == 1) ? lo[1] : center[1] - ring; iy <= hi[1]; iy += iy_step) {
+        if (iy < 0) continue;
+
+        // Check points in cell
+        int bucket = BucketIndex(ix, iy);
+        unsigned long long key = CellKey(ix, iy);
+        for (int slot = bucket_starts[bucket]; slot < bucket_starts[bucket+1]; slot++) {
+          if (sorted_keys[slot] != key) continue;
+          RNLength distance_squared = R2SquaredDistance(query_position, sorted_positions[slot]);
+          if (distance_squared < min_distance_squared) continue;
+          if (distance_squared > max_distance_squared) continue;
+          InsertClosest(point_indices[slot], distance_squared, max_points, indices, distances_squared, count);
+          if (count == max_points) max_distance_squared = distances_squared[max_points-1];
+        }
+      }
+    }
+
+    // Check if unvisited cells are all farther than max distance (the slabs of grid beyond each side of the ring)
+    RNLength unvisited_distance_squared = FLT_MAX;
+    for (int dim = 0; dim < 2; dim++) {
+      for (int side = 0; side < 2; side++) {
+        // Find slab of grid beyond side of ring
+        RNCoord slab_lo, slab_hi;
+        if (side == 0) {
+          if (center[dim] - ring <= 0) continue;
+          slab_lo = bbox[RN_LO][dim];
+          slab_hi = bbox[RN_LO][dim] + (center[dim] - ring) * cell_size;
+        }
+        else {
+          if (center[dim] + ring >= grid_resolution[dim] - 1) continue;
+          slab_lo = bbox[RN_LO][dim] + (center[dim] + ring + 1) * cell_size;
+          slab_hi = bbox[RN_HI][dim];
+        }
+
+        // Compute squared distance from query to slab
+        RNLength distance_squared = 0;
+        for (int k = 0; k < 2; k++) {
+          RNCoord lo = (k == dim) ? slab_lo : bbox[RN_LO][k];
+          RNCoord hi = (k == dim) ? slab_hi : bbox[RN_HI][k];
+          RNCoord delta = 0;
+          if (query_position[k] < lo) delta = lo - query_position[k];
+          else if (query_position[k] > hi) delta = query_position[k] - hi;
+          distance_squared += delta * delta;
+        }
+
+        // Remember closest slab
+        if (distance_squared < unvisited_distance_squared) unvisited_distance_squared = distance_squared;
+      }
+    }
+
+    // Stop if all cells have been visited or unvisited cells are too far
+    if (unvisited_distance_squared == FLT_MAX) break;
+    if (unvisited_distance_squared >= max_distance_squared) break;
+  }
+
+  // Return distances
+  if (distances) {
+    for (int i = 0; i < count; i++) {
+      distances[i] = sqrt(distances_squared[i]);
+    }
+  }
+
+  // Delete temporary array of squared distances
+  if (distances_squared != distances_squared_buffer) delete [] distances_squared;
+
+  // Return number of points found
+  return count;
+}
+
+
+
+int R2HashGrid::
+FindClosest(const R2Point& query_position,
+  RNLength min_distance, RNLength max_distance,
+  RNLength *closest_distance) const
+{
+  // Find closest point
+  int index = -1;
+  RNLength distance = 0;
+  if (!FindClosest(query_position, min_distance, max_distance, 1, &index, &distance)) return -1;
+
+  // Return closest point
+  if (closest_distance) *closest_distance = distance;
+  return index;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding all points within some distance
+////////////////////////////////////////////////////////////////////////
+
+int R2HashGrid::
+FindAll(const R2Point& query_position,
+  RNLength min_distance, RNLength max_distance,
+  std::vector<int>& result) const
+{
+  // Check arguments
+  int count = result.size();
+  if (npoints == 0) return 0;
+  if (max_distance < 0) return 0;
+  if (min_distance < 0) min_distance = 0;
+
+  // Use squared distances for efficiency
+  RNLength min_distance_squared = min_distance * min_distance;
+  RNLength max_distance_squared = max_distance * max_distance;
+
+  // Find range of cells overlapping circle
+  int lo[2], hi[2];
+  R2Vector offset(max_distance, max_distance);
+  CellCoordinates(query_position - offset, lo);
+  CellCoordinates(query_position + offset, hi);
+
+  // Check points in cells
+  for (int ix = lo[0]; ix <= hi[0]; ix++) {
+    for (int iy = lo[1]; iy <= hi[1]; iy++) {
+      int bucket = BucketIndex(ix, iy);
+      unsigned long long key = CellKey(ix, iy);
+      for (int slot = bucket_starts[bucket]; slot < bucket_starts[bucket+1]; slot++) {
+        if (sorted_keys[slot] != key) continue;
+        RNLength distance_squared = R2SquaredDistance(query_position, sorted_positions[slot]);
+        if (distance_squared < min_distance_squared) continue;
+        if (distance_squared > max_distance_squared) continue;
+        result.push_back(point_indices[slot]);
+      }
+    }
+  }
+
+  // Return number of points found
+  return result.size() - count;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding all pairs of points within some distance
+////////////////////////////////////////////////////////////////////////
+
+int R2HashGrid::
+FindAllPairs(RNLength max_distance,
+  void (*callback)(int index1, int index2, RNLength distance, void *data),
+  void *data) const
+{
+  // Check arguments
+  if (npoints == 0) return 0;
+  if (max_distance < 0) return 0;
+  RNLength max_distance_squared = max_distance * max_distance;
+  int ncells = (int) ceil(max_distance / cell_size);
+  int count = 0;
+
+  // Visit points in sorted order (so that points in the same cell are adjacent)
+  for (int slot1 = 0; slot1 < npoints; slot1++) {
+    const R2Point& position1 = sorted_positions[slot1];
+    unsigned long long key1 = sorted_keys[slot1];
+    int center[2];
+    center[0] = (int) (key1 >> 32);
+    center[1] = (int) (key1 & 0xFFFFFFFFULL);
+
+    // Visit neighbor cells
+    int lo[2], hi[2];
+    for (int dim = 0; dim < 2; dim++) {
+      lo[dim] = (center[dim] - ncells > 0) ? center[dim] - ncells : 0;
+      hi[dim] = (center[dim] + ncells < grid_resolution[dim] - 1) ? center[dim] + ncells : grid_resolution[dim] - 1;
+    }
+    for (int ix = lo[0]; ix <= hi[0]; ix++) {
+      for (int iy = lo[1]; iy <= hi[1]; iy++) {
+        // Check points in cell (each pair is reported from its first point in sorted order)
+        int bucket = BucketIndex(ix, iy);
+        unsigned long long key = CellKey(ix, iy);
+        int start = (bucket_starts[bucket] > slot1) ? bucket_starts[bucket] : slot1 + 1;
+        for (int slot2 = start; slot2 < bucket_starts[bucket+1]; slot2++) {
+          if (sorted_keys[slot2] != key) continue;
+          RNLength distance_squared = R2SquaredDistance(position1, sorted_positions[slot2]);
+          if (distance_squared > max_distance_squared) continue;
+          if (callback) (*callback)(point_indices[slot1], point_indices[slot2], sqrt(distance_squared), data);
+          count++;
+        }
+      }
+    }
+  }
+
+  // Return number of pairs found
+  return count;
+}
+
+
+
+} // namespace gaps
@@ -0,0 +1,175 @@
+// Include file for hash grid class
+#ifndef __R2__HASH__GRID__H__
+#define __R2__HASH__GRID__H__
+
+
+
+// Include files
+
+#include <vector>
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Class declaration
+
+// A uniform grid of square cells for fixed-radius neighbor queries on a
+// static set of positions.  Cells are hashed into a table with about two
+// buckets per point, and points are sorted into buckets with a counting
+// sort, so each bucket is one contiguous range of positions.  A cell
+// size of zero picks about one point per cell, and cells are never made
+// much smaller than that.  Queries return indices into the array the grid
+// was built from.
+
+class R2HashGrid {
+public:
+  // Constructor/destructors
+  R2HashGrid(const R2Point *positions, int npoints, RNLength cell_size);
+  R2HashGrid(const R2HashGrid& grid);
+  ~R2HashGrid(void);
+
+  // Property functions
+  const R2Box& BBox(void) const;
+  RNLength CellSize(void) const;
+  int NPoints(void) const;
+  int NBuckets(void) const;
+
+  // Point access functions
+  const R2Point& PointPosition(int index) const;
+
+  // Search for closest one (returns index, or -1 if none)
+  int FindClosest(const R2Point& query_position,
+    RNLength min_distance = 0, RNLength max_distance = FLT_MAX,
+    RNLength *closest_distance = NULL) const;
+
+  // Search for closest K (fills indices, returns how many)
+  int FindClosest(const R2Point& query_position,
+    RNLength min_distance, RNLength max_distance, int max_points,
+    int *indices, RNLength *distances = NULL) const;
+
+  // Search for all within some distance
+  int FindAll(const R2Point& query_position,
+    RNLength min_distance, RNLength max_distance,
+    std::vector<int>& indices) const;
+
+  // Visit every pair of points within some distance once (returns number of pairs)
+  int FindAllPairs(RNLength max_distance,
+    void (*callback)(int index1, int index2, RNLength distance, void *data),
+    void *data = NULL) const;
+
+public:
+  // Internal cell functions
+  void CellCoordinates(const R2Point& position, int cell[2]) const;
+  int BucketIndex(int ix, int iy) const;
+  unsigned long long CellKey(int ix, int iy) const;
+
+  // Not implemented
+  R2HashGrid& operator=(const R2HashGrid& grid);
+
+public:
+  // Internal data
+  R2Box bbox;
+  RNLength cell_size;
+  int grid_resolution[2];
+  int npoints;
+  int nbuckets;
+  int *bucket_starts;
+  R2Point *sorted_positions;
+  unsigned long long *sorted_keys;
+  int *point_indices;
+  int *sorted_indices;
+};
+
+
+
+// Inline functions
+
+inline const R2Box& R2HashGrid::
+BBox(void) const
+{
+  // Return bounding box of all points
+  return bbox;
+}
+
+
+
+inline RNLength R2HashGrid::
+CellSize(void) const
+{
+  // Return width of cells
+  return cell_size;
+}
+
+
+
+inline int R2HashGrid::
+NPoints(void) const
+{
+  // Return number of points
+  return npoints;
+}
+
+
+
+inline int R2HashGrid::
+NBuckets(void) const
+{
+  // Return number of hash buckets
+  return nbuckets;
+}
+
+
+
+inline const R2Point& R2HashGrid::
+PointPosition(int index) const
+{
+  // Return position of point with index in original array
+  return sorted_positions[sorted_indices[index]];
+}
+
+
+
+inline void R2HashGrid::
+CellCoordinates(const R2Point& position, int cell[2]) const
+{
+  // Compute coordinates of cell containing position (clamped to grid)
+  for (int dim = 0; dim < 2; dim++) {
+    RNScalar c = (position[dim] - bbox[RN_LO][dim]) / cell_size;
+    if (c <= 0) cell[dim] = 0;
+    else if (c >= grid_resolution[dim] - 1) cell[dim] = grid_resolution[dim] - 1;
+    else cell[dim] = (int) c;
+  }
+}
+
+
+
+inline int R2HashGrid::
+BucketIndex(int ix, int iy) const
+{
+  // Return index of hash bucket containing cell
+  unsigned int h = ((unsigned int) ix * 73856093U) ^ ((unsigned int) iy * 19349663U);
+  return (int) (h & (unsigned int) (nbuckets - 1));
+}
+
+
+
+inline unsigned long long R2HashGrid::
+CellKey(int ix, int iy) const
+{
+  // Return unique key for cell
+  return ((unsigned long long) ix << 32) | (unsigned long long) iy;
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
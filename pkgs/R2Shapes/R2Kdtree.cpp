@@ -355,6 +355,105 @@ FindClosest(PtrType point,
 
 
 
+template <class PtrType>
+void R2Kdtree<PtrType>::
+FindClosestApproximate(R2KdtreeNode<PtrType> *node, const R2Box& node_box, const R2Point& position, 
+  RNScalar min_distance_squared, RNScalar epsilon_factor, int max_leaves, int& nleaves, 
+  PtrType& closest_point, RNScalar& closest_distance_squared) const
+{
+  // Check leaf budget
+  if ((max_leaves > 0) && (nleaves >= max_leaves)) return;
+
+  // Check distance from point to node box (scaled by (1+epsilon)^2)
+  RNLength dx = 0, dy = 0;
+  if (position.X() > node_box.XMax()) dx = position.X() - node_box.XMax();
+  else if (position.X() < node_box.XMin()) dx = node_box.XMin() - position.X();
+  if (position.Y() > node_box.YMax()) dy = position.Y() - node_box.YMax();
+  else if (position.Y() < node_box.YMin()) dy = node_box.YMin() - position.Y();
+  if (epsilon_factor * (dx*dx + dy*dy) > closest_distance_squared) return;
+
+  // Check if node is interior
+  if (node->children[0]) {
+    assert(node->children[1]);
+
+    // Compute distance from point to split plane
+    RNLength side = position[node->split_dimension] - node->split_coordinate;
+    int near_child = (side <= 0) ? 0 : 1;
+    int far_child = 1 - near_child;
+
+    // Search near child first
+    R2Box near_box(node_box);
+    near_box[1-near_child][node->split_dimension] = node->split_coordinate;
+    FindClosestApproximate(node->children[near_child], near_box, position, 
+      min_distance_squared, epsilon_factor, max_leaves, nleaves, 
+      closest_point, closest_distance_squared);
+
+    // Search far child only if it could contain a significantly closer point
+    if (epsilon_factor * side * side <= closest_distance_squared) {
+      R2Box far_box(node_box);
+      far_box[1-far_child][node->split_dimension] = node->split_coordinate;
+      FindClosestApproximate(node->children[far_child], far_box, position, 
+        min_distance_squared, epsilon_factor, max_leaves, nleaves, 
+        closest_point, closest_distance_squared);
+    }
+  }
+  else {
+    // Count leaf
+    nleaves++;
+
+    // Search points
+    for (int i = 0; i < node->npoints; i++) {
+      PtrType point = node->points[i];
+      R2Vector v = position - Position(point);
+      RNLength distance_squared = v.Dot(v);
+      if ((distance_squared >= min_distance_squared) && 
+         (distance_squared <= closest_distance_squared)) {
+        closest_distance_squared = distance_squared;
+        closest_point = point;
+      }
+    }
+  }
+}
+
+
+
+template <class PtrType>
+PtrType R2Kdtree<PtrType>::
+FindClosestApproximate(const R2Point& position, 
+  RNScalar min_distance, RNScalar max_distance, 
+  RNScalar epsilon, int max_leaves, 
+  RNScalar *closest_distance) const
+{
+  // Check root
+  if (!root) return NULL;
+
+  // Use squared distances for efficiency
+  if (max_distance < 0) return NULL;
+  if (min_distance < 0) min_distance = 0;
+  if (epsilon < 0) epsilon = 0;
+  RNLength min_distance_squared = min_distance * min_distance;
+  RNLength max_distance_squared = max_distance * max_distance;
+  RNScalar epsilon_factor = (1.0 + epsilon) * (1.0 + epsilon);
+
+  // Initialize nearest point 
+  PtrType nearest_point = NULL;
+  RNLength nearest_distance_squared = max_distance_squared;
+
+  // Search nodes recursively (nearest child first)
+  int nleaves = 0;
+  FindClosestApproximate(root, bbox, position, 
+    min_distance_squared, epsilon_factor, max_leaves, nleaves, 
+    nearest_point, nearest_distance_squared);
+
+  // Return closest distance
+  if (closest_distance) *closest_distance = sqrt(nearest_distance_squared);
+
+  // Return closest point
+  return nearest_point;
+}
+
+
+
 template <class PtrType>
 void R2Kdtree<PtrType>::
 FindAll(R2KdtreeNode<PtrType> *node, const R2Box& node_box, const R2Point& position, 
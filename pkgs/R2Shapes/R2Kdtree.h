@@ -35,6 +35,11 @@ public:
   PtrType FindClosest(PtrType point, RNLength min_distance = 0, RNLength max_distance = RN_INFINITY, RNLength *closest_distance = NULL) const;
   PtrType FindClosest(const R2Point& position, RNLength min_distance = 0, RNLength max_distance = RN_INFINITY, RNLength *closest_distance = NULL) const;
 
+  // Search for approximately closest to a point (at most (1+epsilon) times farther than the closest,
+  // and the search stops after max_leaves leaf nodes if max_leaves > 0)
+  PtrType FindClosestApproximate(const R2Point& position, RNLength min_distance, RNLength max_distance, 
+    RNScalar epsilon, int max_leaves, RNLength *closest_distance = NULL) const;
+
   // Search for all within some distance to a point
   int FindAll(PtrType point, RNLength min_distance, RNLength max_distance, RNArray<PtrType>& points) const;
   int FindAll(const R2Point& position, RNLength min_distance, RNLength max_distance, RNArray<PtrType>& points) const;
@@ -44,6 +49,9 @@ public:
   void FindClosest(R2KdtreeNode<PtrType> *node, const R2Box& node_box, const R2Point& position, 
     RNLength min_distance_squared, RNLength max_distance_squared, 
     PtrType& closest_point, RNLength& closest_distance_squared) const;
+  void FindClosestApproximate(R2KdtreeNode<PtrType> *node, const R2Box& node_box, const R2Point& position, 
+    RNLength min_distance_squared, RNScalar epsilon_factor, int max_leaves, int& nleaves, 
+    PtrType& closest_point, RNLength& closest_distance_squared) const;
   void FindAll(R2KdtreeNode<PtrType> *node, const R2Box& node_box, const R2Point& position, 
     RNLength min_distance_squared, RNLength max_distance_squared, RNArray<PtrType>& points) const;
 
@@ -110,6 +110,7 @@ class R2PixelDatabase;
 /* Closest point search include files */
 
 #include "R2Kdtree.h"
+#include "R2HashGrid.h"
 
 
 
@@ -611,4 +611,216 @@ R3EstimatePlaneWithRansac(int npoints, const R3Point *points, const RNScalar *we
 
 
 
+static unsigned long long
+R3MortonBits(unsigned int x)
+{
+  // Spread 21 bits of x so that there are two zero bits between each
+  unsigned long long v = x & 0x1fffff;
+  v = (v | (v << 32)) & 0x1f00000000ffffULL;
+  v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+  v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+  v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+  v = (v | (v << 2)) & 0x1249249249249249ULL;
+  return v;
+}
+
+
+
+void
+R3SpaceFillingCurveOrder(int npoints, const R3Point *points, int *order)
+{
+  // Fill order with indices of points sorted along a Morton (Z-order) curve,
+  // so that points that are close in the order are usually close in space
+  if (npoints <= 0) return;
+  R3Box bbox = R3null_box;
+  for (int i = 0; i < npoints; i++) bbox.Union(points[i]);
+  RNLength size = bbox.LongestAxisLength();
+  RNScalar scale = (size > 0) ? 2097151.0 / size : 0;
+
+  // Compute Morton code of every point
+  std::vector<std::pair<unsigned long long, int> > codes(npoints);
+  for (int i = 0; i < npoints; i++) {
+    unsigned int ix = (unsigned int) (scale * (points[i].X() - bbox.XMin()));
+    unsigned int iy = (unsigned int) (scale * (points[i].Y() - bbox.YMin()));
+    unsigned int iz = (unsigned int) (scale * (points[i].Z() - bbox.ZMin()));
+    codes[i].first = R3MortonBits(ix) | (R3MortonBits(iy) << 1) | (R3MortonBits(iz) << 2);
+    codes[i].second = i;
+  }
+
+  // Sort points by Morton code
+  std::sort(codes.begin(), codes.end());
+  for (int i = 0; i < npoints; i++) order[i] = codes[i].second;
+}
+
+
+
+static int
+R3SymmetricEigenvector(const double a[6], double eigenvalue, double scale_squared, double v[3])
+{
+  // Compute eigenvector of symmetric 3x3 matrix (xx, xy, xz, yy, yz, zz)
+  // as the largest cross product of two rows of (A - eigenvalue*I)
+  double r0[3] = { a[0] - eigenvalue, a[1], a[2] };
+  double r1[3] = { a[1], a[3] - eigenvalue, a[4] };
+  double r2[3] = { a[2], a[4], a[5] - eigenvalue };
+  double c[3][3] = {
+    { r0[1]*r1[2] - r0[2]*r1[1], r0[2]*r1[0] - r0[0]*r1[2], r0[0]*r1[1] - r0[1]*r1[0] },
+    { r0[1]*r2[2] - r0[2]*r2[1], r0[2]*r2[0] - r0[0]*r2[2], r0[0]*r2[1] - r0[1]*r2[0] },
+    { r1[1]*r2[2] - r1[2]*r2[1], r1[2]*r2[0] - r1[0]*r2[2], r1[0]*r2[1] - r1[1]*r2[0] } };
+  double d[3];
+  for (int i = 0; i < 3; i++) d[i] = c[i][0]*c[i][0] + c[i][1]*c[i][1] + c[i][2]*c[i][2];
+  int best = (d[0] > d[1]) ? ((d[0] > d[2]) ? 0 : 2) : ((d[1] > d[2]) ? 1 : 2);
+
+  // Check if eigenvalue is repeated (no unique eigenvector)
+  if (d[best] <= 1E-12 * scale_squared * scale_squared) return 0;
+
+  // Return normalized eigenvector
+  double length = sqrt(d[best]);
+  v[0] = c[best][0] / length;
+  v[1] = c[best][1] / length;
+  v[2] = c[best][2] / length;
+  return 1;
+}
+
+
+
+static void
+R3PerpendicularVector(const double v[3], double p[3])
+{
+  // Compute unit vector perpendicular to unit vector v
+  double a[3] = { 0, 0, 0 };
+  int dim = (fabs(v[0]) < fabs(v[1])) ? ((fabs(v[0]) < fabs(v[2])) ? 0 : 2) : ((fabs(v[1]) < fabs(v[2])) ? 1 : 2);
+  a[dim] = 1;
+  p[0] = v[1]*a[2] - v[2]*a[1];
+  p[1] = v[2]*a[0] - v[0]*a[2];
+  p[2] = v[0]*a[1] - v[1]*a[0];
+  double length = sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+  p[0] /= length; p[1] /= length; p[2] /= length;
+}
+
+
+
+struct R3EstimateNormalsTask {
+  const R3Point *points;
+  const int *neighbor_offsets;
+  const int *neighbor_indices;
+  R3Vector *normals;
+  R3Vector *tangents;
+  RNScalar *variances;
+};
+
+
+
+static void
+R3EstimateNormalsTaskFunction(int start, int end, void *data)
+{
+  // Get task data
+  R3EstimateNormalsTask *task = (R3EstimateNormalsTask *) data;
+  std::vector<double> x, y, z;
+
+  // Estimate normal of each neighborhood
+  for (int i = start; i < end; i++) {
+    // Gather coordinates of neighborhood (relative to points[i])
+    const R3Point& origin = task->points[i];
+    int first = task->neighbor_offsets[i];
+    int n = task->neighbor_offsets[i+1] - first + 1;
+    x.resize(n); y.resize(n); z.resize(n);
+    x[0] = y[0] = z[0] = 0;
+    for (int j = 1; j < n; j++) {
+      const R3Point& point = task->points[task->neighbor_indices[first + j - 1]];
+      x[j] = point.X() - origin.X();
+      y[j] = point.Y() - origin.Y();
+      z[j] = point.Z() - origin.Z();
+    }
+
+    // Check number of points
+    if (n < 3) {
+      task->normals[i] = R3zero_vector;
+      if (task->tangents) task->tangents[i] = R3zero_vector;
+      if (task->variances) task->variances[3*i+0] = task->variances[3*i+1] = task->variances[3*i+2] = 0;
+      continue;
+    }
+
+    // Compute centroid
+    double cx = 0, cy = 0, cz = 0;
+    for (int j = 0; j < n; j++) { cx += x[j]; cy += y[j]; cz += z[j]; }
+    cx /= n; cy /= n; cz /= n;
+
+    // Compute covariance matrix (xx, xy, xz, yy, yz, zz)
+    double a[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int j = 0; j < n; j++) {
+      double dx = x[j] - cx, dy = y[j] - cy, dz = z[j] - cz;
+      a[0] += dx*dx; a[1] += dx*dy; a[2] += dx*dz;
+      a[3] += dy*dy; a[4] += dy*dz; a[5] += dz*dz;
+    }
+    for (int k = 0; k < 6; k++) a[k] /= n;
+
+    // Compute eigenvalues in closed form
+    double q = (a[0] + a[3] + a[5]) / 3.0;
+    double p1 = a[1]*a[1] + a[2]*a[2] + a[4]*a[4];
+    double p2 = (a[0]-q)*(a[0]-q) + (a[3]-q)*(a[3]-q) + (a[5]-q)*(a[5]-q) + 2*p1;
+    double p = sqrt(p2 / 6.0);
+    double eigenvalues[3] = { q, q, q };
+    if (p > 0) {
+      double b[6] = { (a[0]-q)/p, a[1]/p, a[2]/p, (a[3]-q)/p, a[4]/p, (a[5]-q)/p };
+      double r = 0.5 * (b[0]*(b[3]*b[5] - b[4]*b[4]) - b[1]*(b[1]*b[5] - b[4]*b[2]) + b[2]*(b[1]*b[4] - b[3]*b[2]));
+      if (r < -1) r = -1;
+      else if (r > 1) r = 1;
+      double phi = acos(r) / 3.0;
+      eigenvalues[0] = q + 2*p*cos(phi);
+      eigenvalues[2] = q + 2*p*cos(phi + 2.0*RN_PI/3.0);
+      eigenvalues[1] = 3*q - eigenvalues[0] - eigenvalues[2];
+    }
+
+    // Compute eigenvectors for smallest and largest eigenvalues
+    double normal[3], tangent[3];
+    double scale_squared = p2 + q*q;
+    int has_normal = R3SymmetricEigenvector(a, eigenvalues[2], scale_squared, normal);
+    int has_tangent = R3SymmetricEigenvector(a, eigenvalues[0], scale_squared, tangent);
+    if (!has_normal && !has_tangent) {
+      normal[0] = 0; normal[1] = 0; normal[2] = 1;
+      R3PerpendicularVector(normal, tangent);
+    }
+    else if (!has_normal) {
+      R3PerpendicularVector(tangent, normal);
+    }
+    else {
+      // Make tangent perpendicular to normal
+      if (!has_tangent) R3PerpendicularVector(normal, tangent);
+      double dot = tangent[0]*normal[0] + tangent[1]*normal[1] + tangent[2]*normal[2];
+      for (int k = 0; k < 3; k++) tangent[k] -= dot * normal[k];
+      double length = sqrt(tangent[0]*tangent[0] + tangent[1]*tangent[1] + tangent[2]*tangent[2]);
+      if (length > 0) { for (int k = 0; k < 3; k++) tangent[k] /= length; }
+      else R3PerpendicularVector(normal, tangent);
+    }
+
+    // Fill results
+    task->normals[i].Reset(normal[0], normal[1], normal[2]);
+    if (task->tangents) task->tangents[i].Reset(tangent[0], tangent[1], tangent[2]);
+    if (task->variances) {
+      for (int k = 0; k < 3; k++) {
+        task->variances[3*i+k] = (eigenvalues[k] > 0) ? eigenvalues[k] : 0;
+      }
+    }
+  }
+}
+
+
+
+void
+R3EstimateNormals(int npoints, const R3Point *points,
+  const int *neighbor_offsets, const int *neighbor_indices,
+  R3Vector *normals, R3Vector *tangents, RNScalar *variances)
+{
+  // Estimate normals of neighborhoods with closed-form 3x3 eigen decompositions (in parallel)
+  R3EstimateNormalsTask task;
+  task.points = points;
+  task.neighbor_offsets = neighbor_offsets;
+  task.neighbor_indices = neighbor_indices;
+  task.normals = normals;
+  task.tangents = tangents;
+  task.variances = variances;
+  RNParallelFor(0, npoints, R3EstimateNormalsTaskFunction, &task, 1024);
+}
+
+
 } // namespace gaps
@@ -44,6 +44,23 @@ R3Plane R3EstimatePlaneWithRansac(int npoints, const R3Point *points, const RNSc
 
 
 
+// Functions to order C array of points
+
+void R3SpaceFillingCurveOrder(int npoints, const R3Point *points, int *order);
+
+
+
+// Functions to estimate normals of many neighborhoods in C array of points (in parallel)
+// Neighborhood i is points[i] plus points[neighbor_indices[neighbor_offsets[i] ... neighbor_offsets[i+1]-1]]
+// Normals are smallest principle axes (arbitrary sign, zero if fewer than 3 points),
+// tangents are largest principle axes, and variances are three per point (largest first)
+
+void R3EstimateNormals(int npoints, const R3Point *points,
+  const int *neighbor_offsets, const int *neighbor_indices,
+  R3Vector *normals, R3Vector *tangents = NULL, RNScalar *variances = NULL);
+
+
+
 // End namespace
 }
 
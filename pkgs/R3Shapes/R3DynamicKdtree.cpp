@@ -0,0 +1,493 @@
+// Source file for R3DynamicKdtree class
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Include files
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Shapes.h"
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constant definitions
+////////////////////////////////////////////////////////////////////////
+
+static const int R3dynamic_kdtree_max_points_per_buffer = 64;
+
+
+
+static int
+R3DynamicKdtreeCapacity(int level)
+{
+  // Return maximum number of points in tree at level
+  return R3dynamic_kdtree_max_points_per_buffer << (level + 1);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constructors/destructors
+////////////////////////////////////////////////////////////////////////
+
+R3DynamicKdtree::
+R3DynamicKdtree(void)
+  : positions(),
+    point_levels(),
+    point_slots(),
+    free_ids(),
+    buffer(),
+    trees(),
+    tree_ids(),
+    npoints(0)
+{
+}
+
+
+
+R3DynamicKdtree::
+R3DynamicKdtree(const R3Point *input_positions, int input_npoints)
+  : positions(),
+    point_levels(),
+    point_slots(),
+    free_ids(),
+    buffer(),
+    trees(),
+    tree_ids(),
+    npoints(0)
+{
+  // Check points
+  if (input_npoints <= 0) return;
+
+  // Assign ids 0 ... npoints-1
+  positions.assign(input_positions, input_positions + input_npoints);
+  point_levels.assign(input_npoints, -1);
+  point_slots.assign(input_npoints, 0);
+  npoints = input_npoints;
+
+  // Build one tree with all points
+  for (int i = 0; i < input_npoints; i++) {
+    point_slots[i] = i;
+    buffer.push_back(i);
+  }
+  Rebuild();
+}
+
+
+
+R3DynamicKdtree::
+~R3DynamicKdtree(void)
+{
+  // Delete trees
+  for (unsigned int i = 0; i < trees.size(); i++) {
+    if (trees[i]) delete trees[i];
+  }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Property functions
+////////////////////////////////////////////////////////////////////////
+
+int R3DynamicKdtree::
+NTrees(void) const
+{
+  // Return number of static trees in forest
+  int count = 0;
+  for (unsigned int i = 0; i < trees.size(); i++) {
+    if (trees[i]) count++;
+  }
+  return count;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Manipulation functions
+////////////////////////////////////////////////////////////////////////
+
+int R3DynamicKdtree::
+InsertPoint(const R3Point& position)
+{
+  // Get id for point (reuse ids of removed points)
+  int id = positions.size();
+  if (!free_ids.empty()) {
+    id = free_ids.back();
+    free_ids.pop_back();
+    positions[id] = position;
+  }
+  else {
+    positions.push_back(position);
+    point_levels.push_back(-1);
+    point_slots.push_back(0);
+  }
+
+  // Insert point into buffer
+  InsertIntoBuffer(id);
+  npoints++;
+
+  // Return id
+  return id;
+}
+
+
+
+void R3DynamicKdtree::
+RemovePoint(int id)
+{
+  // Check point
+  if (!IsPoint(id)) return;
+  int level = point_levels[id];
+  int slot = point_slots[id];
+
+  // Remove point from buffer or tree
+  if (level < 0) {
+    // Replace point in buffer with last one
+    int last_id = buffer.back();
+    buffer[slot] = last_id;
+    point_slots[last_id] = slot;
+    buffer.pop_back();
+  }
+  else {
+    // Flag point in tree, and rebuild tree if half of its points were removed
+    R3StaticKdtree *tree = trees[level];
+    tree->RemovePoint(slot);
+    if (2 * tree->NRemovedPoints() > tree->NPoints()) RebuildTree(level);
+  }
+
+  // Free id
+  point_levels[id] = -2;
+  free_ids.push_back(id);
+  npoints--;
+}
+
+
+
+void R3DynamicKdtree::
+MovePoint(int id, const R3Point& position)
+{
+  // Check point
+  if (!IsPoint(id)) return;
+
+  // Update position in place if point is in buffer
+  if (point_levels[id] < 0) {
+    positions[id] = position;
+    return;
+  }
+
+  // Otherwise, remove point from its tree and reinsert it into buffer
+  RemovePoint(id);
+  assert(free_ids.back() == id);
+  free_ids.pop_back();
+  positions[id] = position;
+  InsertIntoBuffer(id);
+  npoints++;
+}
+
+
+
+void R3DynamicKdtree::
+Rebuild(void)
+{
+  // Gather all points
+  std::vector<int> ids(buffer);
+  buffer.clear();
+  for (unsigned int level = 0; level < trees.size(); level++) {
+    if (!trees[level]) continue;
+    GatherTreePoints(level, ids);
+    delete trees[level];
+    trees[level] = NULL;
+    tree_ids[level].clear();
+  }
+
+  // Build one tree with all points
+  int level = 0;
+  while (R3DynamicKdtreeCapacity(level) < (int) ids.size()) level++;
+  BuildTree(level, ids);
+}
+
+
+
+void R3DynamicKdtree::
+InsertIntoBuffer(int id)
+{
+  // Insert point into buffer
+  point_levels[id] = -1;
+  point_slots[id] = buffer.size();
+  buffer.push_back(id);
+
+  // Merge buffer into trees if it is full
+  if ((int) buffer.size() >= R3dynamic_kdtree_max_points_per_buffer) MergeBuffer();
+}
+
+
+
+void R3DynamicKdtree::
+MergeBuffer(void)
+{
+  // Gather points from buffer and smaller trees until they fit at some level
+  std::vector<int> ids(buffer);
+  buffer.clear();
+  int level = 0;
+  while (TRUE) {
+    if (level == (int) trees.size()) {
+      trees.push_back(NULL);
+      tree_ids.push_back(std::vector<int>());
+    }
+    if (trees[level]) {
+      GatherTreePoints(level, ids);
+      delete trees[level];
+      trees[level] = NULL;
+      tree_ids[level].clear();
+    }
+    if ((int) ids.size() <= R3DynamicKdtreeCapacity(level)) break;
+    level++;
+  }
+
+  // Build tree with gathered points
+  BuildTree(level, ids);
+}
+
+
+
+void R3DynamicKdtree::
+BuildTree(int level, const std::vector<int>& ids)
+{
+  // Make sure there is a slot for level
+  while (level >= (int) trees.size()) {
+    trees.push_back(NULL);
+    tree_ids.push_back(std::vector<int>());
+  }
+
+  // Check points
+  assert(!trees[level]);
+  if (ids.empty()) return;
+
+  // Build static tree
+  R3Point *tree_positions = new R3Point [ ids.size() ];
+  for (unsigned int i = 0; i < ids.size(); i++) tree_positions[i] = positions[ids[i]];
+  trees[level] = new R3StaticKdtree(tree_positions, ids.size());
+  delete [] tree_positions;
+
+  // Remember where points are
+  tree_ids[level] = ids;
+  for (unsigned int i = 0; i < ids.size(); i++) {
+    point_levels[ids[i]] = level;
+    point_slots[ids[i]] = i;
+  }
+}
+
+
+
+void R3DynamicKdtree::
+RebuildTree(int level)
+{
+  // Gather points that have not been removed
+  std::vector<int> ids;
+  GatherTreePoints(level, ids);
+
+  // Replace tree
+  delete trees[level];
+  trees[level] = NULL;
+  tree_ids[level].clear();
+  BuildTree(level, ids);
+}
+
+
+
+void R3DynamicKdtree::
+GatherTreePoints(int level, std::vector<int>& ids) const
+{
+  // Append ids of points in tree that have not been removed
+  const R3StaticKdtree *tree = trees[level];
+  const std::vector<int>& level_ids = tree_ids[level];
+  for (unsigned int i = 0; i < level_ids.size(); i++) {
+    if (tree->IsPointRemoved(i)) continue;
+    ids.push_back(level_ids[i]);
+  }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding the closest K points to a query point
+////////////////////////////////////////////////////////////////////////
+
+static inline void
+InsertClosest(int id, RNLength distance, int max_points,
+  int *ids, RNLength *distances, int& npoints)
+{
+  // Find slot for point (points are sorted by distance)
+  int slot = npoints;
+  while ((slot > 0) && (distance < distances[slot-1])) slot--;
+  if (slot >= max_points) return;
+
+  // Insert point and distance into sorted arrays
+  int last = (npoints < max_points) ? npoints : max_points - 1;
+  for (int j = last; j > slot; j--) {
+    distances[j] = distances[j-1];
+    ids[j] = ids[j-1];
+  }
+  distances[slot] = distance;
+  ids[slot] = id;
+  if (npoints < max_points) npoints++;
+}
+
+
+
+int R3DynamicKdtree::
+FindClosest(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance, int max_points,
+  int *ids, RNLength *distances) const
+{
+  // Check arguments
+  if (npoints == 0) return 0;
+  if (max_points <= 0) return 0;
+  if (max_distance < 0) return 0;
+  if (min_distance < 0) min_distance = 0;
+
+  // Allocate temporary arrays
+  RNLength distances_buffer[64];
+  int tree_ids_buffer[64];
+  RNLength tree_distances_buffer[64];
+  RNLength *result_distances = (distances) ? distances : distances_buffer;
+  int *tree_result_ids = tree_ids_buffer;
+  RNLength *tree_result_distances = tree_distances_buffer;
+  if (max_points > 64) {
+    if (!distances) result_distances = new RNLength [ max_points ];
+    tree_result_ids = new int [ max_points ];
+    tree_result_distances = new RNLength [ max_points ];
+  }
+
+  // Check points in buffer
+  int count = 0;
+  for (unsigned int i = 0; i < buffer.size(); i++) {
+    int id = buffer[i];
+    RNLength distance = R3Distance(query_position, positions[id]);
+    if ((distance < min_distance) || (distance > max_distance)) continue;
+    InsertClosest(id, distance, max_points, ids, result_distances, count);
+  }
+
+  // Search trees (with max distance shrunk to Kth closest found so far)
+  for (unsigned int level = 0; level < trees.size(); level++) {
+    if (!trees[level]) continue;
+    RNLength bound = (count == max_points) ? result_distances[max_points-1] : max_distance;
+    int n = trees[level]->FindClosest(query_position, min_distance, bound, max_points,
+      tree_result_ids, tree_result_distances);
+    for (int i = 0; i < n; i++) {
+      int id = tree_ids[level][tree_result_ids[i]];
+      InsertClosest(id, tree_result_distances[i], max_points, ids, result_distances, count);
+    }
+  }
+
+  // Delete temporary arrays
+  if (result_distances != distances && result_distances != distances_buffer) delete [] result_distances;
+  if (tree_result_ids != tree_ids_buffer) delete [] tree_result_ids;
+  if (tree_result_distances != tree_distances_buffer) delete [] tree_result_distances;
+
+  // Return number of points found
+  return count;
+}
+
+
+
+int R3DynamicKdtree::
+FindClosest(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance,
+  RNLength *closest_distance) const
+{
+  // Find closest point
+  int id = -1;
+  RNLength distance = 0;
+  if (!FindClosest(query_position, min_distance, max_distance, 1, &id, &distance)) return -1;
+
+  // Return closest point
+  if (closest_distance) *closest_distance = distance;
+  return id;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding all points within some distance or box
+////////////////////////////////////////////////////////////////////////
+
+int R3DynamicKdtree::
+FindAll(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance,
+  std::vector<int>& ids) const
+{
+  // Check arguments
+  int count = ids.size();
+  if (npoints == 0) return 0;
+  if (max_distance < 0) return 0;
+
+  // Check points in buffer
+  for (unsigned int i = 0; i < buffer.size(); i++) {
+    int id = buffer[i];
+    RNLength distance = R3Distance(query_position, positions[id]);
+    if ((distance < min_distance) || (distance > max_distance)) continue;
+    ids.push_back(id);
+  }
+
+  // Search trees
+  std::vector<int> tree_result;
+  for (unsigned int level = 0; level < trees.size(); level++) {
+    if (!trees[level]) continue;
+    tree_result.clear();
+    trees[level]->FindAll(query_position, min_distance, max_distance, tree_result);
+    for (unsigned int i = 0; i < tree_result.size(); i++) {
+      ids.push_back(tree_ids[level][tree_result[i]]);
+    }
+  }
+
+  // Return number of points found
+  return ids.size() - count;
+}
+
+
+
+int R3DynamicKdtree::
+FindAll(const R3Box& query_box, std::vector<int>& ids) const
+{
+  // Check arguments
+  int count = ids.size();
+  if (npoints == 0) return 0;
+  if (query_box.IsEmpty()) return 0;
+
+  // Check points in buffer
+  for (unsigned int i = 0; i < buffer.size(); i++) {
+    int id = buffer[i];
+    const R3Point& position = positions[id];
+    if ((position.X() < query_box.XMin()) || (position.X() > query_box.XMax())) continue;
+    if ((position.Y() < query_box.YMin()) || (position.Y() > query_box.YMax())) continue;
+    if ((position.Z() < query_box.ZMin()) || (position.Z() > query_box.ZMax())) continue;
+    ids.push_back(id);
+  }
+
+  // Search trees
+  std::vector<int> tree_result;
+  for (unsigned int level = 0; level < trees.size(); level++) {
+    if (!trees[level]) continue;
+    tree_result.clear();
+    trees[level]->FindAll(query_box, tree_result);
+    for (unsigned int i = 0; i < tree_result.size(); i++) {
+      ids.push_back(tree_ids[level][tree_result[i]]);
+    }
+  }
+
+  // Return number of points found
+  return ids.size() - count;
+}
+
+
+
+} // namespace gaps
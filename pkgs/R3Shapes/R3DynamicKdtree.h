@@ -0,0 +1,131 @@
+// Include file for dynamic KDTree class
+#ifndef __R3__DYNAMIC__KDTREE__H__
+#define __R3__DYNAMIC__KDTREE__H__
+
+
+
+// Include files
+
+#include <vector>
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Class declaration
+
+// A kd tree that supports inserting, removing, and moving points.  Points
+// are kept in a small unsorted buffer plus a forest of static kd trees
+// whose capacities grow by factors of two.  When the buffer fills, it is
+// merged with the smaller trees into one new tree, so each point is
+// rebuilt O(log n) times.  Removed points are flagged in their trees
+// (searches skip them), and a tree is rebuilt when half of its points
+// have been removed.  Points are identified by the integer returned by
+// InsertPoint, which stays valid until the point is removed.
+
+class R3DynamicKdtree {
+public:
+  // Constructor/destructors
+  R3DynamicKdtree(void);
+  R3DynamicKdtree(const R3Point *positions, int npoints);
+  ~R3DynamicKdtree(void);
+
+  // Property functions
+  int NPoints(void) const;
+  int NTrees(void) const;
+
+  // Point access functions
+  RNBoolean IsPoint(int id) const;
+  const R3Point& PointPosition(int id) const;
+
+  // Manipulation functions
+  int InsertPoint(const R3Point& position);
+  void RemovePoint(int id);
+  void MovePoint(int id, const R3Point& position);
+  void Rebuild(void);
+
+  // Search for closest one (returns id, or -1 if none)
+  int FindClosest(const R3Point& query_position,
+    RNLength min_distance = 0, RNLength max_distance = FLT_MAX,
+    RNLength *closest_distance = NULL) const;
+
+  // Search for closest K (fills ids, returns how many)
+  int FindClosest(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance, int max_points,
+    int *ids, RNLength *distances = NULL) const;
+
+  // Search for all within some distance
+  int FindAll(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance,
+    std::vector<int>& ids) const;
+
+  // Search for all inside box
+  int FindAll(const R3Box& query_box,
+    std::vector<int>& ids) const;
+
+public:
+  // Internal manipulation functions
+  void InsertIntoBuffer(int id);
+  void MergeBuffer(void);
+  void BuildTree(int level, const std::vector<int>& ids);
+  void RebuildTree(int level);
+  void GatherTreePoints(int level, std::vector<int>& ids) const;
+
+  // Not implemented
+  R3DynamicKdtree(const R3DynamicKdtree& kdtree);
+  R3DynamicKdtree& operator=(const R3DynamicKdtree& kdtree);
+
+public:
+  // Internal data
+  std::vector<R3Point> positions;
+  std::vector<int> point_levels;
+  std::vector<int> point_slots;
+  std::vector<int> free_ids;
+  std::vector<int> buffer;
+  std::vector<R3StaticKdtree *> trees;
+  std::vector<std::vector<int> > tree_ids;
+  int npoints;
+};
+
+
+
+// Inline functions
+
+inline int R3DynamicKdtree::
+NPoints(void) const
+{
+  // Return number of points
+  return npoints;
+}
+
+
+
+inline RNBoolean R3DynamicKdtree::
+IsPoint(int id) const
+{
+  // Return whether id refers to a point currently in the tree
+  if ((id < 0) || (id >= (int) point_levels.size())) return FALSE;
+  return (point_levels[id] >= -1) ? TRUE : FALSE;
+}
+
+
+
+inline const R3Point& R3DynamicKdtree::
+PointPosition(int id) const
+{
+  // Return position of point
+  return positions[id];
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
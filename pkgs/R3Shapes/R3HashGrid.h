@@ -0,0 +1,180 @@
+// Include file for hash grid class
+#ifndef __R3__HASH__GRID__H__
+#define __R3__HASH__GRID__H__
+
+
+
+// Include files
+
+#include <vector>
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Class declaration
+
+// A uniform grid of cubic cells for fixed-radius neighbor queries on a
+// static set of positions.  Cells are hashed into a table with about two
+// buckets per point, and points are sorted into buckets with a counting
+// sort, so each bucket is one contiguous range of positions.  Queries are
+// fastest when the search radius is close to the cell size.  A cell size
+// of zero picks about one point per cell, and cells are never made much
+// smaller than that.  Queries return indices into the array the grid was
+// built from.
+
+class R3HashGrid {
+public:
+  // Constructor/destructors
+  R3HashGrid(const R3Point *positions, int npoints, RNLength cell_size);
+  R3HashGrid(const R3HashGrid& grid);
+  ~R3HashGrid(void);
+
+  // Property functions
+  const R3Box& BBox(void) const;
+  RNLength CellSize(void) const;
+  int NPoints(void) const;
+  int NBuckets(void) const;
+
+  // Point access functions
+  const R3Point& PointPosition(int index) const;
+
+  // Search for closest one (returns index, or -1 if none)
+  int FindClosest(const R3Point& query_position,
+    RNLength min_distance = 0, RNLength max_distance = FLT_MAX,
+    RNLength *closest_distance = NULL) const;
+
+  // Search for closest K (fills indices, returns how many)
+  int FindClosest(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance, int max_points,
+    int *indices, RNLength *distances = NULL) const;
+
+  // Search for all within some distance
+  int FindAll(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance,
+    std::vector<int>& indices) const;
+
+  // Search for all inside box
+  int FindAll(const R3Box& query_box,
+    std::vector<int>& indices) const;
+
+  // Visit every pair of points within some distance once (returns number of pairs)
+  int FindAllPairs(RNLength max_distance,
+    void (*callback)(int index1, int index2, RNLength distance, void *data),
+    void *data = NULL) const;
+
+public:
+  // Internal cell functions
+  void CellCoordinates(const R3Point& position, int cell[3]) const;
+  int BucketIndex(int ix, int iy, int iz) const;
+  unsigned long long CellKey(int ix, int iy, int iz) const;
+
+  // Not implemented
+  R3HashGrid& operator=(const R3HashGrid& grid);
+
+public:
+  // Internal data
+  R3Box bbox;
+  RNLength cell_size;
+  int grid_resolution[3];
+  int npoints;
+  int nbuckets;
+  int *bucket_starts;
+  R3Point *sorted_positions;
+  unsigned long long *sorted_keys;
+  int *point_indices;
+  int *sorted_indices;
+};
+
+
+
+// Inline functions
+
+inline const R3Box& R3HashGrid::
+BBox(void) const
+{
+  // Return bounding box of all points
+  return bbox;
+}
+
+
+
+inline RNLength R3HashGrid::
+CellSize(void) const
+{
+  // Return width of cells
+  return cell_size;
+}
+
+
+
+inline int R3HashGrid::
+NPoints(void) const
+{
+  // Return number of points
+  return npoints;
+}
+
+
+
+inline int R3HashGrid::
+NBuckets(void) const
+{
+  // Return number of hash buckets
+  return nbuckets;
+}
+
+
+
+inline const R3Point& R3HashGrid::
+PointPosition(int index) const
+{
+  // Return position of point with index in original array
+  return sorted_positions[sorted_indices[index]];
+}
+
+
+
+inline void R3HashGrid::
+CellCoordinates(const R3Point& position, int cell[3]) const
+{
+  // Compute coordinates of cell containing position (clamped to grid)
+  for (int dim = 0; dim < 3; dim++) {
+    RNScalar c = (position[dim] - bbox[RN_LO][dim]) / cell_size;
+    if (c <= 0) cell[dim] = 0;
+    else if (c >= grid_resolution[dim] - 1) cell[dim] = grid_resolution[dim] - 1;
+    else cell[dim] = (int) c;
+  }
+}
+
+
+
+inline int R3HashGrid::
+BucketIndex(int ix, int iy, int iz) const
+{
+  // Return index of hash bucket containing cell
+  unsigned int h = ((unsigned int) ix * 73856093U) ^ ((unsigned int) iy * 19349663U) ^ ((unsigned int) iz * 83492791U);
+  return (int) (h & (unsigned int) (nbuckets - 1));
+}
+
+
+
+inline unsigned long long R3HashGrid::
+CellKey(int ix, int iy, int iz) const
+{
+  // Return unique key for cell (21 bits per dimension)
+  return ((unsigned long long) ix << 42) | ((unsigned long long) iy << 21) | (unsigned long long) iz;
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
@@ -27,6 +27,7 @@ namespace gaps {
 ////////////////////////////////////////////////////////////////////////
 
 static const int R3kdtree_max_points_per_node = 32;
+static const int R3kdtree_min_points_per_task = 16384;
 
 
 
@@ -54,6 +55,34 @@ public:
 
 
 
+// Parallel task declarations
+
+template <class PtrType>
+struct R3KdtreeInsertTask {
+  R3Kdtree<PtrType> *tree;
+  R3KdtreeNode<PtrType> *node;
+  R3Box node_box;
+  PtrType *points;
+  int npoints;
+};
+
+template <class PtrType>
+struct R3KdtreeBatchTask {
+  const R3Kdtree<PtrType> *tree;
+  const R3Point *query_positions;
+  const int *order;
+  int max_points;
+  RNLength max_distance;
+  PtrType *points;
+  RNLength *distances;
+  int *counts;
+  RNScalar epsilon;
+  int max_leaves;
+  std::atomic<int> total;
+};
+
+
+
 // Node constructor
 
 template <class PtrType>
@@ -700,6 +729,265 @@ FindClosest(const R3Point& query_position, RNScalar min_distance, RNScalar max_d
 
 
 
+////////////////////////////////////////////////////////////////////////
+// Finding approximately the closest K points to a query point
+////////////////////////////////////////////////////////////////////////
+
+template <class PtrType>
+void R3Kdtree<PtrType>::
+FindClosestApproximate(R3KdtreeNode<PtrType> *node, const R3Box& node_box, 
+  const R3Point& query_position, 
+  RNScalar min_distance_squared, RNScalar max_distance_squared, int max_points,
+  RNScalar epsilon_factor, int max_leaves, int& nleaves, 
+  RNArray<PtrType>& points, RNLength *distances_squared) const
+{
+  // Check leaf budget
+  if ((max_leaves > 0) && (nleaves >= max_leaves)) return;
+
+  // Update max distance squared
+  if (points.NEntries() == max_points) {
+    max_distance_squared = distances_squared[max_points-1];
+  }
+
+  // Check distance from point to node box (scaled by (1+epsilon)^2)
+  RNLength distance_squared = 0;
+  for (int dim = RN_X; dim <= RN_Z; dim++) {
+    RNLength d = 0;
+    if (query_position[dim] > node_box[RN_HI][dim]) d = query_position[dim] - node_box[RN_HI][dim];
+    else if (query_position[dim] < node_box[RN_LO][dim]) d = node_box[RN_LO][dim] - query_position[dim];
+    distance_squared += d * d;
+  }
+  if (epsilon_factor * distance_squared > max_distance_squared) return;
+
+  // Check if node is interior
+  if (node->children[0]) {
+    assert(node->children[1]);
+
+    // Compute distance from point to split plane
+    RNLength side = query_position[node->split_dimension] - node->split_coordinate;
+    int near_child = (side <= 0) ? 0 : 1;
+    int far_child = 1 - near_child;
+
+    // Search near child first
+    R3Box near_box(node_box);
+    near_box[1-near_child][node->split_dimension] = node->split_coordinate;
+    FindClosestApproximate(node->children[near_child], near_box, query_position, 
+      min_distance_squared, max_distance_squared, max_points, 
+      epsilon_factor, max_leaves, nleaves, points, distances_squared);
+
+    // Search far child only if it could contain significantly closer points
+    if (points.NEntries() == max_points) max_distance_squared = distances_squared[max_points-1];
+    if (epsilon_factor * side * side <= max_distance_squared) {
+      R3Box far_box(node_box);
+      far_box[1-far_child][node->split_dimension] = node->split_coordinate;
+      FindClosestApproximate(node->children[far_child], far_box, query_position, 
+        min_distance_squared, max_distance_squared, max_points, 
+        epsilon_factor, max_leaves, nleaves, points, distances_squared);
+    }
+  }
+  else {
+    // Count leaf
+    nleaves++;
+
+    // Search points
+    for (int i = 0; i < node->npoints; i++) {
+      PtrType point = node->points[i];
+      RNLength distance_squared = R3SquaredDistance(query_position, Position(point));
+      if ((distance_squared >= min_distance_squared) && 
+          (distance_squared <= max_distance_squared)) {
+
+        // Find slot for point (points are sorted by distance)
+        int slot = 0;
+        while (slot < points.NEntries()) {
+          if (distance_squared < distances_squared[slot]) break;
+          slot++;
+        }
+          
+        // Insert point and distance into sorted arrays
+        if (slot < max_points) {
+          int first = points.NEntries();
+          if (first >= max_points) first = max_points-1;
+          for (int j = first; j > slot; j--) distances_squared[j] = distances_squared[j-1];
+          distances_squared[slot] = distance_squared;
+          points.InsertKth(point, slot);
+          points.Truncate(max_points);
+          if (points.NEntries() == max_points) max_distance_squared = distances_squared[max_points-1];
+        }
+      }
+    }
+  }
+}
+
+
+
+template <class PtrType>
+int R3Kdtree<PtrType>::
+FindClosestApproximate(const R3Point& query_position, 
+  RNScalar min_distance, RNScalar max_distance, int max_points, 
+  RNScalar epsilon, int max_leaves, 
+  RNArray<PtrType>& points, RNLength *distances) const
+{
+  // Check root
+  if (!root) return 0;
+  if (max_points <= 0) return 0;
+
+  // Use squared distances for efficiency
+  if (max_distance < 0) return 0;
+  if (min_distance < 0) min_distance = 0;
+  if (epsilon < 0) epsilon = 0;
+  RNLength min_distance_squared = min_distance * min_distance;
+  RNLength max_distance_squared = max_distance * max_distance;
+  RNScalar epsilon_factor = (1.0 + epsilon) * (1.0 + epsilon);
+
+  // Allocate temporary array of squared distances to max_points closest points
+  RNLength *distances_squared = new RNLength [ max_points ];
+
+  // Search nodes recursively (nearest child first)
+  int nleaves = 0;
+  FindClosestApproximate(root, bbox, query_position, 
+    min_distance_squared, max_distance_squared, max_points, 
+    epsilon_factor, max_leaves, nleaves, 
+    points, distances_squared);
+
+  // Update return distances
+  if (distances) {
+    for (int i = 0; i < points.NEntries(); i++) {
+      distances[i] = sqrt(distances_squared[i]);
+    }
+  }
+
+  // Delete temporary array of squared distances
+  delete [] distances_squared;
+
+  // Return number of points
+  return points.NEntries();
+}
+
+
+
+template <class PtrType>
+PtrType R3Kdtree<PtrType>::
+FindClosestApproximate(const R3Point& query_position, 
+  RNScalar min_distance, RNScalar max_distance, 
+  RNScalar epsilon, int max_leaves, 
+  RNScalar *closest_distance) const
+{
+  // Search for approximately closest one point
+  RNArray<PtrType> points;
+  RNLength distance = max_distance;
+  if (!FindClosestApproximate(query_position, min_distance, max_distance, 1, 
+    epsilon, max_leaves, points, &distance)) return NULL;
+
+  // Return closest distance
+  if (closest_distance) *closest_distance = distance;
+
+  // Return closest point
+  return points.Head();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding the closest K points to many query points
+////////////////////////////////////////////////////////////////////////
+
+template <class PtrType>
+void R3Kdtree<PtrType>::
+FindClosestBatchTask(int start, int end, void *data)
+{
+  // Get task data
+  R3KdtreeBatchTask<PtrType> *task = (R3KdtreeBatchTask<PtrType> *) data;
+  const R3Kdtree<PtrType> *tree = task->tree;
+  int max_points = task->max_points;
+  RNLength max_distance_squared = task->max_distance * task->max_distance;
+  RNScalar epsilon = (task->epsilon > 0) ? task->epsilon : 0;
+  RNScalar epsilon_factor = (1.0 + epsilon) * (1.0 + epsilon);
+  RNBoolean approximate = (task->epsilon > 0) || (task->max_leaves > 0);
+
+  // Allocate temporary array of squared distances (once for all queries)
+  RNLength *distances_squared = new RNLength [ max_points ];
+  RNArray<PtrType> points;
+  int total = 0;
+
+  // Search for closest points to each query
+  for (int i = start; i < end; i++) {
+    int query_index = task->order[i];
+    const R3Point& query_position = task->query_positions[query_index];
+    points.Empty();
+    if (approximate) {
+      int nleaves = 0;
+      tree->FindClosestApproximate(tree->root, tree->bbox, query_position,
+        0, max_distance_squared, max_points, epsilon_factor, task->max_leaves, nleaves,
+        points, distances_squared);
+    }
+    else {
+      tree->FindClosest(tree->root, tree->bbox, NULL, query_position,
+        0, max_distance_squared, max_points, NULL, NULL,
+        points, distances_squared);
+    }
+
+    // Copy results into flat arrays
+    int n = points.NEntries();
+    PtrType *query_points = &task->points[query_index * max_points];
+    for (int j = 0; j < max_points; j++) query_points[j] = (j < n) ? points[j] : NULL;
+    if (task->distances) {
+      RNLength *query_distances = &task->distances[query_index * max_points];
+      for (int j = 0; j < max_points; j++) query_distances[j] = (j < n) ? sqrt(distances_squared[j]) : -1;
+    }
+    if (task->counts) task->counts[query_index] = n;
+    total += n;
+  }
+
+  // Update total number of points found
+  task->total += total;
+
+  // Delete temporary array of squared distances
+  delete [] distances_squared;
+}
+
+
+
+template <class PtrType>
+int R3Kdtree<PtrType>::
+FindClosestBatch(const R3Point *query_positions, int nqueries,
+  int max_points, RNLength max_distance,
+  PtrType *points, RNLength *distances, int *counts,
+  RNScalar epsilon, int max_leaves) const
+{
+  // Check arguments
+  if (!root) return 0;
+  if (nqueries <= 0) return 0;
+  if (max_points <= 0) return 0;
+  if (max_distance < 0) return 0;
+
+  // Visit queries in order along a space-filling curve (for locality)
+  int *order = new int [ nqueries ];
+  R3SpaceFillingCurveOrder(nqueries, query_positions, order);
+
+  // Search for closest points in parallel
+  R3KdtreeBatchTask<PtrType> task;
+  task.tree = this;
+  task.query_positions = query_positions;
+  task.order = order;
+  task.max_points = max_points;
+  task.max_distance = max_distance;
+  task.points = points;
+  task.distances = distances;
+  task.counts = counts;
+  task.epsilon = epsilon;
+  task.max_leaves = max_leaves;
+  task.total = 0;
+  RNParallelFor(0, nqueries, FindClosestBatchTask, &task, 256);
+
+  // Delete order
+  delete [] order;
+
+  // Return total number of points found
+  return task.total;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Finding all points within some distance to a query point
 ////////////////////////////////////////////////////////////////////////
@@ -1437,8 +1725,11 @@ PartitionPoints(PtrType *points, int npoints, RNDimension dim, int imin, int ima
   assert(imax < npoints);
   if (imin == imax) return imin;
 
-  // Choose a coordinate at random to split upon
-  int irand = (int) (imin + RNRandomScalar() * (imax - imin + 1));
+  // Choose a coordinate pseudo-randomly to split upon
+  // (hashed from the range, so that trees built in parallel are deterministic)
+  unsigned int hash = (unsigned int) imin * 2654435761U ^ (unsigned int) imax * 2246822519U;
+  hash ^= hash >> 15;
+  int irand = (int) (imin + hash % (unsigned int) (imax - imin + 1));
   if (irand < imin) irand = imin;
   if (irand > imax) irand = imax;
   RNCoord split_coord = Position(points[irand])[dim];
@@ -1538,8 +1829,23 @@ InsertPoints(R3KdtreeNode<PtrType> *node, const R3Box& node_box, PtrType *points
     node->children[1] = new R3KdtreeNode<PtrType>(node);
 
     // Insert points into children
-    InsertPoints(node->children[0], node0_box, points, split_index);
-    InsertPoints(node->children[1], node1_box, &points[split_index], npoints - split_index);
+    if ((npoints >= 2 * R3kdtree_min_points_per_task) && (RNNumThreads() > 1)) {
+      // Insert points into first child in another thread
+      R3KdtreeInsertTask<PtrType> task;
+      task.tree = this;
+      task.node = node->children[0];
+      task.node_box = node0_box;
+      task.points = points;
+      task.npoints = split_index;
+      RNTaskGroup group;
+      group.Insert(InsertPointsTask, &task);
+      InsertPoints(node->children[1], node1_box, &points[split_index], npoints - split_index);
+      group.Wait();
+    }
+    else {
+      InsertPoints(node->children[0], node0_box, points, split_index);
+      InsertPoints(node->children[1], node1_box, &points[split_index], npoints - split_index);
+    }
 
     // Increment number of nodes
     nnodes += 2;
@@ -1548,6 +1854,17 @@ InsertPoints(R3KdtreeNode<PtrType> *node, const R3Box& node_box, PtrType *points
 
 
 
+template <class PtrType>
+void R3Kdtree<PtrType>::
+InsertPointsTask(void *data)
+{
+  // Insert points into subtree
+  R3KdtreeInsertTask<PtrType> *task = (R3KdtreeInsertTask<PtrType> *) data;
+  task->tree->InsertPoints(task->node, task->node_box, task->points, task->npoints);
+}
+
+
+
 template <class PtrType>
 void R3Kdtree<PtrType>::
 InsertPoint(R3KdtreeNode<PtrType> *node, const R3Box& node_box, PtrType point) 
@@ -79,6 +79,26 @@ public:
     RNLength min_distance, RNLength max_distance, int max_points, 
     RNArray<PtrType>& points, RNLength *distances = NULL) const;
 
+  // Search for approximately closest one or K (returned points are at most
+  // (1+epsilon) times farther than the true ones, and the search stops after
+  // max_leaves leaf nodes if max_leaves > 0, so the guarantee is then lost)
+  PtrType FindClosestApproximate(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance,
+    RNScalar epsilon, int max_leaves,
+    RNLength *closest_distance = NULL) const;
+  int FindClosestApproximate(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance, int max_points,
+    RNScalar epsilon, int max_leaves,
+    RNArray<PtrType>& points, RNLength *distances = NULL) const;
+
+  // Search for closest K to each of many query positions (in parallel)
+  // Results for query i are in points[i*max_points ...] (padded with NULL)
+  // The search is approximate if epsilon or max_leaves is positive
+  int FindClosestBatch(const R3Point *query_positions, int nqueries,
+    int max_points, RNLength max_distance,
+    PtrType *points, RNLength *distances = NULL, int *counts = NULL,
+    RNScalar epsilon = 0, int max_leaves = 0) const;
+
   // Search for all within some distance 
   int FindAll(PtrType query_point, 
     RNLength min_distance, RNLength max_distance, 
@@ -124,6 +144,11 @@ public:
     RNLength min_distance_squared, RNLength max_distance_squared, int max_points, 
     int (*IsCompatible)(PtrType, PtrType, void *), void *compatible_data, 
     RNArray<PtrType>& points, RNLength *distances_squared) const;
+  void FindClosestApproximate(R3KdtreeNode<PtrType> *node, const R3Box& node_box, 
+    const R3Point& query_position, 
+    RNLength min_distance_squared, RNLength max_distance_squared, int max_points, 
+    RNScalar epsilon_factor, int max_leaves, int& nleaves, 
+    RNArray<PtrType>& points, RNLength *distances_squared) const;
   void FindAll(R3KdtreeNode<PtrType> *node, const R3Box& node_box, 
     PtrType query_point, const R3Point& position, 
     RNLength min_distance_squared, RNLength max_distance_squared, 
@@ -157,6 +182,10 @@ public:
   int PartitionPoints(PtrType *points, int npoints, RNDimension dim, int imin, int imax);
   void SplitNode(R3KdtreeNode<PtrType> *node, const R3Box& node_box);
 
+  // Internal parallel task functions
+  static void InsertPointsTask(void *data);
+  static void FindClosestBatchTask(int start, int end, void *data);
+
   // Internal visualization functions
   void Outline(R3KdtreeNode<PtrType> *node, const R3Box& bbox) const;
 
@@ -202,7 +231,7 @@ public:
   void *position_callback_data;
   R3KdtreeNode<PtrType> *root;
   int npoints;
-  int nnodes;
+  std::atomic<int> nnodes;
 };
 
 
@@ -7,6 +7,7 @@
 
 #include "R3Shapes.h"
 #include "ply.h"
+#include <typeinfo>
 
 
 
@@ -530,6 +531,76 @@ ConnectedComponents(void) const
 
  
 
+struct R3MeshUpdateTaskData {
+  const R3Mesh *mesh;
+  RNBoolean vertex_curvatures;
+};
+
+
+
+void R3Mesh::
+UpdateFaceQuantitiesTask(int start, int end, void *data)
+{
+  // Update properties of a range of faces
+  R3MeshUpdateTaskData *task = (R3MeshUpdateTaskData *) data;
+  const R3Mesh *mesh = task->mesh;
+  for (int i = start; i < end; i++) {
+    R3MeshFace *f = mesh->faces.Kth(i);
+    if (!(f->flags[R3_MESH_FACE_AREA_UPTODATE])) mesh->UpdateFaceArea(f);
+    if (!(f->flags[R3_MESH_FACE_PLANE_UPTODATE])) mesh->UpdateFacePlane(f);
+    if (!(f->flags[R3_MESH_FACE_BBOX_UPTODATE])) mesh->UpdateFaceBBox(f);
+  }
+}
+
+
+
+void R3Mesh::
+UpdateEdgeQuantitiesTask(int start, int end, void *data)
+{
+  // Update properties of a range of edges
+  R3MeshUpdateTaskData *task = (R3MeshUpdateTaskData *) data;
+  const R3Mesh *mesh = task->mesh;
+  for (int i = start; i < end; i++) {
+    R3MeshEdge *e = mesh->edges.Kth(i);
+    if (!(e->flags[R3_MESH_EDGE_LENGTH_UPTODATE])) mesh->UpdateEdgeLength(e);
+  }
+}
+
+
+
+void R3Mesh::
+UpdateVertexQuantitiesTask(int start, int end, void *data)
+{
+  // Update properties of a range of vertices (only writes to the vertex itself,
+  // since properties of faces have already been computed)
+  R3MeshUpdateTaskData *task = (R3MeshUpdateTaskData *) data;
+  const R3Mesh *mesh = task->mesh;
+  for (int i = start; i < end; i++) {
+    R3MeshVertex *v = mesh->vertices.Kth(i);
+    if (!(v->flags[R3_MESH_VERTEX_NORMAL_UPTODATE])) mesh->UpdateVertexNormal(v);
+    if (!task->vertex_curvatures) continue;
+    if (!(v->flags[R3_MESH_VERTEX_CURVATURE_UPTODATE])) mesh->UpdateVertexCurvature(v);
+  }
+}
+
+
+
+void R3Mesh::
+UpdateDerivedQuantities(RNBoolean vertex_curvatures) const
+{
+  // Vertex properties are computed from face properties,
+  // so faces are updated in a separate pass before vertices
+  R3MeshUpdateTaskData task;
+  task.mesh = this;
+  task.vertex_curvatures = vertex_curvatures;
+  RNParallelFor(0, NFaces(), UpdateFaceQuantitiesTask, &task, 1024);
+  RNParallelFor(0, NEdges(), UpdateEdgeQuantitiesTask, &task, 1024);
+  RNParallelFor(0, NVertices(), UpdateVertexQuantitiesTask, &task, 1024);
+}
+
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // VERTEX, EDGE, FACE PROPERTY FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -537,15 +608,12 @@ ConnectedComponents(void) const
 RNArea R3Mesh::
 VertexArea(const R3MeshVertex *v) const
 {
+  // Update the vertex area
+  if (!(v->flags[R3_MESH_VERTEX_CURVATURE_UPTODATE]))
+    UpdateVertexCurvature((R3MeshVertex *) v);
+
   // Return 1/3 the sum of areas of attached faces
-  RNLength sum = 0;
-  for (int i = 0; i < VertexValence(v); i++) {
-    R3MeshEdge *e = EdgeOnVertex(v, i);
-    R3MeshFace *f = FaceOnEdge(e, v, RN_CCW);
-    if (!f) continue;
-    sum += FaceArea(f);
-  }
-  return sum / 3;
+  return v->area;
 }
 
 
@@ -571,30 +639,12 @@ VertexAverageEdgeLength(const R3MeshVertex *v) const
 RNScalar R3Mesh::
 VertexGaussCurvature(const R3MeshVertex *v) const
 {
-  // Sum areas and interior angles of adjacent faces
-  RNArea area = 0;
-  RNAngle angle = 0;
-  const R3Point& p = VertexPosition(v);
-  for (int i = 0; i < VertexValence(v); i++) {
-    R3MeshEdge *e1 = EdgeOnVertex(v, i);
-    if (!e1) { angle = 0; area = 0; break; }
-    R3MeshVertex *v1 = VertexAcrossEdge(e1, v);
-    R3MeshEdge *e2 = EdgeOnVertex(v, e1, RN_CCW);
-    if (!e2) { angle = 0; area = 0; break; }
-    R3MeshVertex *v2 = VertexAcrossEdge(e2, v);
-    R3MeshFace *f = FaceOnVertex(v, e1, RN_CCW);
-    if (!f) { angle = 0; area = 0; break; }
-    const R3Point& p1 = VertexPosition(v1);
-    const R3Point& p2 = VertexPosition(v2);
-    angle += R3InteriorAngle(p1 - p, p2 - p);
-    area += FaceArea(f);
-  }
-
-  // Compute curvature using Gauss-Bonet
-  RNScalar curvature = (area > 0) ? 3  * (RN_TWO_PI - angle) / area : 0;
+  // Update the vertex curvature
+  if (!(v->flags[R3_MESH_VERTEX_CURVATURE_UPTODATE]))
+    UpdateVertexCurvature((R3MeshVertex *) v);
 
   // Return Gauss curvature
-  return curvature;
+  return v->gauss_curvature;
 }
 
 
@@ -602,35 +652,35 @@ VertexGaussCurvature(const R3MeshVertex *v) const
 RNScalar R3Mesh::
 VertexMeanCurvature(const R3MeshVertex *v) const
 {
-  // Compute signed length of laplacian vector projected onto normal
-  RNArea area = VertexArea(v);
-  if (area == 0) return 0;
-  R3Vector laplacian = VertexLaplacianVector(v);
-  RNScalar curvature = -1 * laplacian.Dot(VertexNormal(v));
-  return curvature;
+  // Update the vertex curvature
+  if (!(v->flags[R3_MESH_VERTEX_CURVATURE_UPTODATE]))
+    UpdateVertexCurvature((R3MeshVertex *) v);
+
+  // Return mean curvature
+  return v->mean_curvature;
 }
 
 
 
-R3Vector R3Mesh::
-VertexLaplacianVector(const R3MeshVertex *v1) const
+static R3Vector
+CotanWeightedLaplacianSum(const R3Mesh *mesh, const R3MeshVertex *v1)
 {
-  // Compute vector from vertex to cotan weighed average of neighbors 
+  // Compute sum of cotan weighted vectors from vertex to neighbors
   // From http://www.mpi-inf.mpg.de/~ag4-gm/handouts/06gm_surf3.pdf
   R3Vector laplacian = R3zero_vector;
-  const R3Point& p1 = VertexPosition(v1);
-  for (int j = 0; j < VertexValence(v1); j++) {
-    R3MeshEdge *e = EdgeOnVertex(v1, j);
-    R3MeshVertex *v2 = VertexAcrossEdge(e, v1);
-    const R3Point& p2 = VertexPosition(v2);
+  const R3Point& p1 = mesh->VertexPosition(v1);
+  for (int j = 0; j < mesh->VertexValence(v1); j++) {
+    R3MeshEdge *e = mesh->EdgeOnVertex(v1, j);
+    R3MeshVertex *v2 = mesh->VertexAcrossEdge(e, v1);
+    const R3Point& p2 = mesh->VertexPosition(v2);
 
     // Compute cotan weight
     double weight = 0;
     for (int k = 0; k < 2; k++) {
-      R3MeshFace *f = FaceOnEdge(e, k);
+      R3MeshFace *f = mesh->FaceOnEdge(e, k);
       if (!f) continue;
-      R3MeshVertex *v3 = VertexAcrossFace(f, e);
-      const R3Point& p3 = VertexPosition(v3);
+      R3MeshVertex *v3 = mesh->VertexAcrossFace(f, e);
+      const R3Point& p3 = mesh->VertexPosition(v3);
       R3Vector vec1 = p1 - p3; vec1.Normalize();
       R3Vector vec2 = p2 - p3; vec2.Normalize();
       RNAngle angle = R3InteriorAngle(vec1, vec2);
@@ -644,6 +694,18 @@ VertexLaplacianVector(const R3MeshVertex *v1) const
     laplacian += weight * (p2 - p1);
   }
 
+  // Return sum
+  return laplacian;
+}
+
+
+
+R3Vector R3Mesh::
+VertexLaplacianVector(const R3MeshVertex *v1) const
+{
+  // Compute vector from vertex to cotan weighed average of neighbors 
+  R3Vector laplacian = CotanWeightedLaplacianSum(this, v1);
+
   // Normalize by area (maybe should be 3X -- i.e., for face areas, not vertex area)
   laplacian /= 4 * VertexArea(v1);
 
@@ -858,19 +920,19 @@ SetVertexPosition(R3MeshVertex *v, const R3Point& position)
   // Set vertex position
   v->position = position;
 
-  // Mark vertex in need of update to normal 
-  v->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE);
+  // Mark vertex in need of update to normal and curvature
+  v->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
 
   // Mark edges/faces in need of update
   for (int i = 0; i < v->edges.NEntries(); i++) {
     R3MeshEdge *e = v->edges[i];
     e->flags.Remove(R3_MESH_EDGE_LENGTH_UPTODATE);
     R3MeshVertex *neighbor = VertexAcrossEdge(e, v);
-    neighbor->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE);
+    neighbor->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
     R3MeshFace *f0 = e->face[0];
-    if (f0) f0->flags.Remove(R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
+    if (f0) f0->flags.Remove(R3_MESH_FACE_AREA_UPTODATE | R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
     R3MeshFace *f1 = e->face[1];
-    if (f1) f1->flags.Remove(R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
+    if (f1) f1->flags.Remove(R3_MESH_FACE_AREA_UPTODATE | R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
   }
 
   // Update bounding box
@@ -1243,7 +1305,7 @@ AddRandomNoise(RNScalar factor)
     RNLength max_distance = factor * VertexAverageEdgeLength(vertex);
     R3Vector random_vector(RNRandomScalar(), RNRandomScalar(), RNRandomScalar());
     vertex->position += max_distance * random_vector;
-    vertex->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE);
+    vertex->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
     bbox.Union(vertex->position);
   }
 
@@ -1256,7 +1318,7 @@ AddRandomNoise(RNScalar factor)
   // Mark every face out of date
   for (int i = 0; i < NFaces(); i++) {
     R3MeshFace *face = Face(i);
-    face->flags.Remove(R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
+    face->flags.Remove(R3_MESH_FACE_AREA_UPTODATE | R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
   }
 
   // Invalidate GL buffer objects
@@ -1275,7 +1337,7 @@ Inflate(RNScalar factor)
     RNLength distance = factor * VertexAverageEdgeLength(vertex);
     R3Vector normal_vector = VertexNormal(vertex);
     vertex->position += distance * normal_vector;
-    vertex->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE);
+    vertex->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
     bbox.Union(vertex->position);
   }
 
@@ -1288,7 +1350,7 @@ Inflate(RNScalar factor)
   // Mark every face out of date
   for (int i = 0; i < NFaces(); i++) {
     R3MeshFace *face = Face(i);
-    face->flags.Remove(R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
+    face->flags.Remove(R3_MESH_FACE_AREA_UPTODATE | R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
   }
 
   // Invalidate GL buffer objects
@@ -1305,7 +1367,7 @@ Transform(const R3Transformation& transformation)
   for (int i = 0; i < NVertices(); i++) {
     R3MeshVertex *vertex = Vertex(i);
     vertex->position.Transform(transformation);
-    vertex->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE);
+    vertex->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
     bbox.Union(vertex->position);
   }
 
@@ -1318,7 +1380,7 @@ Transform(const R3Transformation& transformation)
   // Mark every face out of date
   for (int i = 0; i < NFaces(); i++) {
     R3MeshFace *face = Face(i);
-    face->flags.Remove(R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
+    face->flags.Remove(R3_MESH_FACE_AREA_UPTODATE | R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
   }
 
   // Invalidate GL buffer objects
@@ -1694,6 +1756,11 @@ DeleteFace(R3MeshFace *f)
   if (f->edge[2]->face[0] == f) f->edge[2]->face[0] = NULL;
   if (f->edge[2]->face[1] == f) f->edge[2]->face[1] = NULL;
 
+  // Invalidate vertex properties
+  f->vertex[0]->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
+  f->vertex[1]->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
+  f->vertex[2]->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
+
   // Deallocate face
   DeallocateFace(f);
 }
@@ -3180,6 +3247,235 @@ FillHoles(RNLength max_perimeter, RNLength max_planar_deviation)
 
 
 
+struct R3MeshSortKey {
+  unsigned long long key;
+  int index;
+};
+
+
+
+static bool
+CompareSortKeys(const R3MeshSortKey& a, const R3MeshSortKey& b)
+{
+  // Sort by key, and then by index (so that order is deterministic)
+  if (a.key != b.key) return a.key < b.key;
+  return a.index < b.index;
+}
+
+
+
+static unsigned long long
+HilbertCurveKey(unsigned int x, unsigned int y, unsigned int z, int nbits)
+{
+  // Convert grid coordinates to transposed hilbert index (Skilling, 2004)
+  unsigned int c[3] = { x, y, z };
+  unsigned int m = 1U << (nbits - 1);
+  for (unsigned int q = m; q > 1; q >>= 1) {
+    unsigned int p = q - 1;
+    for (int i = 0; i < 3; i++) {
+      if (c[i] & q) c[0] ^= p;
+      else { unsigned int t = (c[0] ^ c[i]) & p; c[0] ^= t; c[i] ^= t; }
+    }
+  }
+
+  // Gray encode
+  for (int i = 1; i < 3; i++) c[i] ^= c[i-1];
+  unsigned int t = 0;
+  for (unsigned int q = m; q > 1; q >>= 1) if (c[2] & q) t ^= q - 1;
+  for (int i = 0; i < 3; i++) c[i] ^= t;
+
+  // Interleave bits
+  unsigned long long key = 0;
+  for (int b = nbits - 1; b >= 0; b--) {
+    for (int i = 0; i < 3; i++) key = (key << 1) | ((c[i] >> b) & 1);
+  }
+
+  // Return key
+  return key;
+}
+
+
+
+int R3Mesh::
+Reorder(void)
+{
+  // Get convenient variables
+  int nvertices = NVertices();
+  int nedges = NEdges();
+  int nfaces = NFaces();
+  if (nvertices == 0) return 1;
+
+  // Check for elements of derived types (they would be sliced when reallocated)
+  for (int i = 0; i < nvertices; i++) {
+    if (typeid(*vertices[i]) == typeid(R3MeshVertex)) continue;
+    RNFail("Unable to reorder mesh with vertices of a derived type\n");
+    return 0;
+  }
+  for (int i = 0; i < nedges; i++) {
+    if (typeid(*edges[i]) == typeid(R3MeshEdge)) continue;
+    RNFail("Unable to reorder mesh with edges of a derived type\n");
+    return 0;
+  }
+  for (int i = 0; i < nfaces; i++) {
+    if (typeid(*faces[i]) == typeid(R3MeshFace)) continue;
+    RNFail("Unable to reorder mesh with faces of a derived type\n");
+    return 0;
+  }
+
+  // Sort vertices along hilbert curve through grid in bounding box
+  const int nbits = 21;
+  const R3Box& box = BBox();
+  RNLength max_length = box.LongestAxisLength();
+  RNScalar scale = (max_length > 0) ? ((1 << nbits) - 1) / max_length : 0;
+  std::vector<R3MeshSortKey> vertex_keys(nvertices);
+  for (int i = 0; i < nvertices; i++) {
+    const R3Point& position = vertices[i]->position;
+    unsigned int x = (unsigned int) (scale * (position.X() - box.XMin()));
+    unsigned int y = (unsigned int) (scale * (position.Y() - box.YMin()));
+    unsigned int z = (unsigned int) (scale * (position.Z() - box.ZMin()));
+    vertex_keys[i].key = HilbertCurveKey(x, y, z, nbits);
+    vertex_keys[i].index = i;
+  }
+  std::sort(vertex_keys.begin(), vertex_keys.end(), CompareSortKeys);
+
+  // Compute new vertex ids
+  int *vertex_ids = new int [ nvertices ];
+  for (int i = 0; i < nvertices; i++) vertex_ids[vertex_keys[i].index] = i;
+
+  // Sort edges and faces by their first vertex in the new order
+  std::vector<R3MeshSortKey> edge_keys(nedges);
+  for (int i = 0; i < nedges; i++) {
+    R3MeshEdge *e = edges[i];
+    int id0 = vertex_ids[e->vertex[0]->id];
+    int id1 = vertex_ids[e->vertex[1]->id];
+    edge_keys[i].key = (id0 < id1) ? id0 : id1;
+    edge_keys[i].index = i;
+  }
+  std::sort(edge_keys.begin(), edge_keys.end(), CompareSortKeys);
+  std::vector<R3MeshSortKey> face_keys(nfaces);
+  for (int i = 0; i < nfaces; i++) {
+    R3MeshFace *f = faces[i];
+    int id = vertex_ids[f->vertex[0]->id];
+    if (vertex_ids[f->vertex[1]->id] < id) id = vertex_ids[f->vertex[1]->id];
+    if (vertex_ids[f->vertex[2]->id] < id) id = vertex_ids[f->vertex[2]->id];
+    face_keys[i].key = id;
+    face_keys[i].index = i;
+  }
+  std::sort(face_keys.begin(), face_keys.end(), CompareSortKeys);
+
+  // Remember old vertices, edges, and faces
+  RNArray<R3MeshVertex *> old_vertices = vertices;
+  RNArray<R3MeshEdge *> old_edges = edges;
+  RNArray<R3MeshFace *> old_faces = faces;
+  R3MeshVertex *old_vertex_block = vertex_block;
+  R3MeshEdge *old_edge_block = edge_block;
+  R3MeshFace *old_face_block = face_block;
+
+  // Allocate new vertices, edges, and faces in blocks
+  vertex_block = new R3MeshVertex [ nvertices ];
+  edge_block = new R3MeshEdge [ nedges ];
+  face_block = new R3MeshFace [ nfaces ];
+  R3MeshVertex **new_vertices = new R3MeshVertex * [ nvertices ];
+  R3MeshEdge **new_edges = new R3MeshEdge * [ nedges ];
+  R3MeshFace **new_faces = new R3MeshFace * [ nfaces ];
+  for (int i = 0; i < nvertices; i++) new_vertices[vertex_keys[i].index] = &vertex_block[i];
+  for (int i = 0; i < nedges; i++) new_edges[edge_keys[i].index] = &edge_block[i];
+  for (int i = 0; i < nfaces; i++) new_faces[face_keys[i].index] = &face_block[i];
+
+  // Copy vertices in new order
+  vertices.Empty();
+  for (int i = 0; i < nvertices; i++) {
+    R3MeshVertex *old_v = old_vertices[vertex_keys[i].index];
+    R3MeshVertex *v = &vertex_block[i];
+    for (int j = 0; j < old_v->edges.NEntries(); j++) v->edges.Insert(new_edges[old_v->edges[j]->id]);
+    v->position = old_v->position;
+    v->normal = old_v->normal;
+    v->texcoords = old_v->texcoords;
+    v->color = old_v->color;
+    v->area = old_v->area;
+    v->gauss_curvature = old_v->gauss_curvature;
+    v->mean_curvature = old_v->mean_curvature;
+    v->flags = old_v->flags;
+    v->flags.Remove(R3_MESH_VERTEX_ALLOCATED);
+    v->value = old_v->value;
+    v->mark = old_v->mark;
+    v->data = old_v->data;
+    v->id = i;
+    vertices.Insert(v);
+  }
+
+  // Copy edges in new order
+  edges.Empty();
+  for (int i = 0; i < nedges; i++) {
+    R3MeshEdge *old_e = old_edges[edge_keys[i].index];
+    R3MeshEdge *e = &edge_block[i];
+    for (int j = 0; j < 2; j++) {
+      e->vertex[j] = new_vertices[old_e->vertex[j]->id];
+      e->face[j] = (old_e->face[j]) ? new_faces[old_e->face[j]->id] : NULL;
+    }
+    e->length = old_e->length;
+    e->flags = old_e->flags;
+    e->flags.Remove(R3_MESH_EDGE_ALLOCATED);
+    e->value = old_e->value;
+    e->mark = old_e->mark;
+    e->data = old_e->data;
+    e->id = i;
+    edges.Insert(e);
+  }
+
+  // Copy faces in new order
+  faces.Empty();
+  for (int i = 0; i < nfaces; i++) {
+    R3MeshFace *old_f = old_faces[face_keys[i].index];
+    R3MeshFace *f = &face_block[i];
+    for (int j = 0; j < 3; j++) {
+      f->vertex[j] = new_vertices[old_f->vertex[j]->id];
+      f->edge[j] = new_edges[old_f->edge[j]->id];
+    }
+    f->plane = old_f->plane;
+    f->bbox = old_f->bbox;
+    f->area = old_f->area;
+    f->material = old_f->material;
+    f->segment = old_f->segment;
+    f->category = old_f->category;
+    f->flags = old_f->flags;
+    f->flags.Remove(R3_MESH_FACE_ALLOCATED);
+    f->value = old_f->value;
+    f->mark = old_f->mark;
+    f->data = old_f->data;
+    f->id = i;
+    faces.Insert(f);
+  }
+
+  // Delete old vertices, edges, and faces
+  for (int i = 0; i < nvertices; i++) {
+    if (old_vertices[i]->flags[R3_MESH_VERTEX_ALLOCATED]) delete old_vertices[i];
+  }
+  for (int i = 0; i < nedges; i++) {
+    if (old_edges[i]->flags[R3_MESH_EDGE_ALLOCATED]) delete old_edges[i];
+  }
+  for (int i = 0; i < nfaces; i++) {
+    if (old_faces[i]->flags[R3_MESH_FACE_ALLOCATED]) delete old_faces[i];
+  }
+  if (old_vertex_block) delete [] old_vertex_block;
+  if (old_edge_block) delete [] old_edge_block;
+  if (old_face_block) delete [] old_face_block;
+
+  // Delete temporary memory
+  delete [] vertex_ids;
+  delete [] new_vertices;
+  delete [] new_edges;
+  delete [] new_faces;
+
+  // Invalidate GL buffer objects
+  InvalidateGLBufferObjects();
+
+  // Return success
+  return 1;
+}
+
+
+
 R3Mesh& R3Mesh::
 operator=(const R3Mesh& mesh)
 {
@@ -3292,6 +3588,7 @@ GLFaceNormalBufferObject(void) const
   if (vbo_face_normal_buffer == 0) {
     glGenBuffers(1, (GLuint *) &vbo_face_normal_buffer);
     if (vbo_face_normal_buffer > 0) {
+      UpdateDerivedQuantities(FALSE);
       std::vector<GLfloat> normals;
       for (int i = 0; i < NFaces(); i++) {
         R3MeshFace *face = Face(i);
@@ -3454,6 +3751,7 @@ GLVertexNormalBufferObject(void) const
   if (vbo_vertex_normal_buffer == 0) {
     glGenBuffers(1, (GLuint *) &vbo_vertex_normal_buffer);
     if (vbo_vertex_normal_buffer > 0) {
+      UpdateDerivedQuantities(FALSE);
       std::vector<GLfloat> normals;
       for (int i = 0; i < NVertices(); i++) {
         R3MeshVertex *vertex = Vertex(i);
@@ -4195,6 +4493,53 @@ ClosestPoint(const R3Point& point, R3MeshIntersection *closest_point) const
 
 
 
+////////////////////////////////////////////////////////////////////////
+// WINDING NUMBER FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+RNAngle R3Mesh::
+FaceSolidAngle(const R3MeshFace *face, const R3Point& point) const
+{
+  // Get vectors from point to vertices
+  R3Vector a = VertexPosition(VertexOnFace(face, 0)) - point;
+  R3Vector b = VertexPosition(VertexOnFace(face, 1)) - point;
+  R3Vector c = VertexPosition(VertexOnFace(face, 2)) - point;
+  RNLength la = a.Length();
+  RNLength lb = b.Length();
+  RNLength lc = c.Length();
+
+  // Return signed solid angle (van Oosterom and Strackee)
+  RNScalar numerator = a.Dot(b % c);
+  RNScalar denominator = la*lb*lc + a.Dot(b)*lc + b.Dot(c)*la + c.Dot(a)*lb;
+  return 2 * atan2(numerator, denominator);
+}
+
+
+
+RNScalar R3Mesh::
+WindingNumber(const R3Point& point) const
+{
+  // Sum solid angles of all faces
+  RNAngle solid_angle = 0;
+  for (int i = 0; i < faces.NEntries(); i++) {
+    solid_angle += FaceSolidAngle(faces[i], point);
+  }
+
+  // Return winding number
+  return solid_angle / (4.0 * RN_PI);
+}
+
+
+
+RNBoolean R3Mesh::
+IsInside(const R3Point& point) const
+{
+  // Return whether winding number is above one half
+  return (WindingNumber(point) > 0.5) ? TRUE : FALSE;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // POINT SAMPLING STUFF
 ////////////////////////////////////////////////////////////////////////
@@ -7498,6 +7843,55 @@ UpdateVertexNormal(R3MeshVertex *v) const
 
 
 
+void R3Mesh::
+UpdateVertexCurvature(R3MeshVertex *v) const
+{
+  // Compute 1/3 the sum of areas of attached faces
+  RNArea sum = 0;
+  for (int i = 0; i < VertexValence(v); i++) {
+    R3MeshEdge *e = EdgeOnVertex(v, i);
+    R3MeshFace *f = FaceOnEdge(e, v, RN_CCW);
+    if (!f) continue;
+    sum += FaceArea(f);
+  }
+  v->area = sum / 3;
+
+  // Sum areas and interior angles of adjacent faces
+  RNArea area = 0;
+  RNAngle angle = 0;
+  const R3Point& p = VertexPosition(v);
+  for (int i = 0; i < VertexValence(v); i++) {
+    R3MeshEdge *e1 = EdgeOnVertex(v, i);
+    if (!e1) { angle = 0; area = 0; break; }
+    R3MeshVertex *v1 = VertexAcrossEdge(e1, v);
+    R3MeshEdge *e2 = EdgeOnVertex(v, e1, RN_CCW);
+    if (!e2) { angle = 0; area = 0; break; }
+    R3MeshVertex *v2 = VertexAcrossEdge(e2, v);
+    R3MeshFace *f = FaceOnVertex(v, e1, RN_CCW);
+    if (!f) { angle = 0; area = 0; break; }
+    const R3Point& p1 = VertexPosition(v1);
+    const R3Point& p2 = VertexPosition(v2);
+    angle += R3InteriorAngle(p1 - p, p2 - p);
+    area += FaceArea(f);
+  }
+
+  // Compute Gauss curvature using Gauss-Bonet
+  v->gauss_curvature = (area > 0) ? 3  * (RN_TWO_PI - angle) / area : 0;
+
+  // Compute mean curvature (signed length of laplacian vector projected onto normal)
+  v->mean_curvature = 0;
+  if (v->area != 0) {
+    R3Vector laplacian = CotanWeightedLaplacianSum(this, v);
+    laplacian /= 4 * v->area;
+    v->mean_curvature = -1 * laplacian.Dot(VertexNormal(v));
+  }
+
+  // Update flags
+  v->flags.Add(R3_MESH_VERTEX_CURVATURE_UPTODATE);
+}
+
+
+
 void R3Mesh::
 UpdateEdgeLength(R3MeshEdge *e) const
 {
@@ -7579,9 +7973,9 @@ UpdateFaceRefs(R3MeshFace *f,
   f->flags.Remove(R3_MESH_FACE_AREA_UPTODATE | R3_MESH_FACE_PLANE_UPTODATE | R3_MESH_FACE_BBOX_UPTODATE);
 
   // Invalidate vertex properties
-  v1->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE);
-  v2->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE);
-  v3->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE);
+  v1->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
+  v2->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
+  v3->flags.Remove(R3_MESH_VERTEX_NORMAL_UPTODATE | R3_MESH_VERTEX_CURVATURE_UPTODATE);
 }
  
    
@@ -7714,6 +8108,9 @@ R3MeshVertex(void)
     normal(0.0, 0.0, 0.0),
     texcoords(0.0, 0.0),
     color(0.0, 0.0, 0.0),
+    area(0.0),
+    gauss_curvature(0.0),
+    mean_curvature(0.0),
     id(-1),
     flags(0),
     value(0.0),
@@ -41,6 +41,9 @@ class R3MeshVertex {
     R3Vector normal;
     R2Point texcoords;
     RNRgb color;
+    RNArea area;
+    RNScalar gauss_curvature;
+    RNScalar mean_curvature;
     int id;
     RNFlags flags;
     RNScalar value;
@@ -171,6 +174,10 @@ class R3Mesh {
       // Return number of connected components
     void *Data(void) const;
      // Return user data associated with mesh
+    void UpdateDerivedQuantities(RNBoolean vertex_curvatures = TRUE) const;
+     // Compute out-of-date face areas/planes/boxes, edge lengths, vertex normals, and
+     // (optionally) vertex areas/curvatures in parallel, so that later queries of them
+     // just read cached values (and can be made from multiple threads)
 
     // VERTEX PROPERTIES
     const R3Point& VertexPosition(const R3MeshVertex *vertex) const;
@@ -516,6 +523,10 @@ class R3Mesh {
     void FillHoles(
       RNLength max_perimeter = 0, RNLength max_planar_deviation = 0);
      // Fill all holes in mesh
+    int Reorder(void);
+     // Sort vertices along a space filling curve, and edges and faces by their vertices,
+     // then reallocate them contiguously in that order (ids and element pointers change).
+     // Fails (returning 0) if the mesh has elements of derived types, since they cannot be copied
     R3Mesh& operator=(const R3Mesh& mesh);
      // Copy mesh
   
@@ -595,6 +606,15 @@ class R3Mesh {
     R3Point ClosestPointOnFace(const R3MeshFace *face, const R3Point& point, R3MeshIntersection *closest_point = NULL) const;
       // Returns closest point on face
 
+    // WINDING NUMBER FUNCTIONS
+    RNAngle FaceSolidAngle(const R3MeshFace *face, const R3Point& point) const;
+      // Returns signed solid angle subtended by face at point (positive on back side)
+    RNScalar WindingNumber(const R3Point& point) const;
+      // Returns generalized winding number of mesh at point (about 1 inside, 0 outside, fractional near holes)
+      // This visits every face -- use R3MeshWindingTree for many queries
+    RNBoolean IsInside(const R3Point& point) const;
+      // Returns whether point is inside mesh (winding number above one half)
+
     // SURFACE DISTANCE FUNCTIONS
     RNLength *GeodesicDistances(const R3MeshVertex *source_vertex, RNLength max_distance = 0) const;
       // Returns array of geodesic distances from source vertex to all other vertices (return array is indexed by VertexID).
@@ -708,6 +728,7 @@ class R3Mesh {
 
     // INTERNAL UPDATE FUNCTIONS
     virtual void UpdateVertexNormal(R3MeshVertex *v) const;  
+    virtual void UpdateVertexCurvature(R3MeshVertex *v) const;  
     virtual void UpdateEdgeLength(R3MeshEdge *e) const;  
     virtual void UpdateFaceArea(R3MeshFace *f) const;
     virtual void UpdateFacePlane(R3MeshFace *f) const;  
@@ -716,6 +737,11 @@ class R3Mesh {
       R3MeshVertex *v1, R3MeshVertex *v2, R3MeshVertex *v3,
       R3MeshEdge *e1, R3MeshEdge *e2, R3MeshEdge *e3);
 
+    // INTERNAL PARALLEL TASK FUNCTIONS
+    static void UpdateFaceQuantitiesTask(int start, int end, void *data);
+    static void UpdateEdgeQuantitiesTask(int start, int end, void *data);
+    static void UpdateVertexQuantitiesTask(int start, int end, void *data);
+
   protected:
     // Arrays of all vertices, edges, faces
     RNArray<R3MeshVertex *> vertices;
@@ -754,6 +780,7 @@ class R3Mesh {
 #define R3_MESH_BBOX_UPTODATE             1
 #define R3_MESH_VERTEX_ALLOCATED          1
 #define R3_MESH_VERTEX_NORMAL_UPTODATE    2
+#define R3_MESH_VERTEX_CURVATURE_UPTODATE 4
 #define R3_MESH_VERTEX_USER_FLAG          8
 #define R3_MESH_EDGE_ALLOCATED            1
 #define R3_MESH_EDGE_LENGTH_UPTODATE      2
@@ -1226,6 +1253,9 @@ SetVertexNormal(R3MeshVertex *v, const R3Vector& normal)
 
   // Remember that vertex normal is up-to-date
   v->flags.Add(R3_MESH_VERTEX_NORMAL_UPTODATE);
+
+  // Mean curvature depends on vertex normal
+  v->flags.Remove(R3_MESH_VERTEX_CURVATURE_UPTODATE);
 }
 
 
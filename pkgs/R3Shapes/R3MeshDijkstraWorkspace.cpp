@@ -0,0 +1,343 @@
+// Source file for mesh dijkstra workspace class
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Include files
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Shapes.h"
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constant definitions
+////////////////////////////////////////////////////////////////////////
+
+// Values of heap_positions for vertices not in the heap
+static const int untouched = -1;
+static const int settled = -2;
+static const int unsettled = -3;
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constructor/destructor functions
+////////////////////////////////////////////////////////////////////////
+
+R3MeshDijkstraWorkspace::
+R3MeshDijkstraWorkspace(R3Mesh *mesh)
+  : mesh(mesh),
+    nvertices(0),
+    distances(NULL),
+    edges(NULL),
+    heap_positions(NULL),
+    heap(NULL),
+    nheap(0),
+    reached(NULL),
+    nreached(0),
+    touched(NULL),
+    ntouched(0)
+{
+  // Allocate arrays
+  nvertices = mesh->NVertices();
+  distances = new RNLength [ nvertices ];
+  edges = new R3MeshEdge * [ nvertices ];
+  heap_positions = new int [ nvertices ];
+  heap = new int [ nvertices ];
+  reached = new int [ nvertices ];
+  touched = new int [ nvertices ];
+
+  // Initialize arrays
+  for (int i = 0; i < nvertices; i++) {
+    distances[i] = FLT_MAX;
+    edges[i] = NULL;
+    heap_positions[i] = untouched;
+  }
+
+  // Cache edge lengths in mesh (so that searches do not update mesh)
+  for (int i = 0; i < mesh->NEdges(); i++) {
+    mesh->EdgeLength(mesh->Edge(i));
+  }
+}
+
+
+
+R3MeshDijkstraWorkspace::
+~R3MeshDijkstraWorkspace(void)
+{
+  // Delete arrays
+  if (distances) delete [] distances;
+  if (edges) delete [] edges;
+  if (heap_positions) delete [] heap_positions;
+  if (heap) delete [] heap;
+  if (reached) delete [] reached;
+  if (touched) delete [] touched;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Search functions
+////////////////////////////////////////////////////////////////////////
+
+int R3MeshDijkstraWorkspace::
+Search(const R3MeshVertex *source_vertex, RNLength max_distance)
+{
+  // Search from one source vertex
+  RNArray<R3MeshVertex *> source_vertices;
+  source_vertices.Insert((R3MeshVertex *) source_vertex);
+  return Search(source_vertices, max_distance);
+}
+
+
+
+int R3MeshDijkstraWorkspace::
+Search(const RNArray<R3MeshVertex *>& source_vertices, RNLength max_distance)
+{
+  // Reset vertices touched by previous search
+  for (int i = 0; i < ntouched; i++) {
+    int vertex_index = touched[i];
+    distances[vertex_index] = FLT_MAX;
+    edges[vertex_index] = NULL;
+    heap_positions[vertex_index] = untouched;
+  }
+  ntouched = 0;
+  nreached = 0;
+  nheap = 0;
+
+  // Push source vertices
+  for (int i = 0; i < source_vertices.NEntries(); i++) {
+    int vertex_index = mesh->VertexID(source_vertices[i]);
+    if (heap_positions[vertex_index] != untouched) continue;
+    touched[ntouched++] = vertex_index;
+    distances[vertex_index] = 0;
+    HeapPush(vertex_index);
+  }
+
+  // Visit vertices in order of distance to closest source vertex
+  while (nheap > 0) {
+    int vertex_index = HeapPop();
+    RNLength distance = distances[vertex_index];
+    if ((max_distance > 0) && (distance > max_distance)) {
+      heap_positions[vertex_index] = unsettled;
+      break;
+    }
+
+    // Mark vertex reached
+    heap_positions[vertex_index] = settled;
+    reached[nreached++] = vertex_index;
+
+    // Relax edges to neighbor vertices
+    R3MeshVertex *vertex = mesh->Vertex(vertex_index);
+    for (int i = 0; i < mesh->VertexValence(vertex); i++) {
+      R3MeshEdge *edge = mesh->EdgeOnVertex(vertex, i);
+      R3MeshVertex *neighbor_vertex = mesh->VertexAcrossEdge(edge, vertex);
+      int neighbor_index = mesh->VertexID(neighbor_vertex);
+      int neighbor_position = heap_positions[neighbor_index];
+      if (neighbor_position == settled) continue;
+      RNLength new_distance = mesh->EdgeLength(edge) + distance;
+      if (new_distance < distances[neighbor_index]) {
+        distances[neighbor_index] = new_distance;
+        edges[neighbor_index] = edge;
+        if (neighbor_position >= 0) HeapUpdate(neighbor_index);
+        else { touched[ntouched++] = neighbor_index; HeapPush(neighbor_index); }
+      }
+    }
+  }
+
+  // Clear vertices left in heap (beyond max_distance)
+  for (int i = 0; i < nheap; i++) heap_positions[heap[i]] = unsettled;
+  nheap = 0;
+  if (nreached < ntouched) {
+    for (int i = 0; i < ntouched; i++) {
+      int vertex_index = touched[i];
+      if (heap_positions[vertex_index] == settled) continue;
+      distances[vertex_index] = FLT_MAX;
+      edges[vertex_index] = NULL;
+    }
+  }
+
+  // Return number of vertices reached
+  return nreached;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Heap functions
+////////////////////////////////////////////////////////////////////////
+
+void R3MeshDijkstraWorkspace::
+HeapPush(int vertex_index)
+{
+  // Insert vertex at bottom of heap and sift it up
+  heap[nheap] = vertex_index;
+  heap_positions[vertex_index] = nheap;
+  HeapSiftUp(nheap++);
+}
+
+
+
+int R3MeshDijkstraWorkspace::
+HeapPop(void)
+{
+  // Remove vertex from top of heap
+  assert(nheap > 0);
+  int vertex_index = heap[0];
+  if (--nheap > 0) {
+    heap[0] = heap[nheap];
+    heap_positions[heap[0]] = 0;
+    HeapSiftDown(0);
+  }
+
+  // Return vertex
+  return vertex_index;
+}
+
+
+
+void R3MeshDijkstraWorkspace::
+HeapUpdate(int vertex_index)
+{
+  // Restore heap order after decreasing distance of vertex
+  HeapSiftUp(heap_positions[vertex_index]);
+}
+
+
+
+void R3MeshDijkstraWorkspace::
+HeapSiftUp(int position)
+{
+  // Move entry up until its parent is smaller
+  int vertex_index = heap[position];
+  while (position > 0) {
+    int parent = (position - 1) / 2;
+    int parent_index = heap[parent];
+    if (!HeapLess(vertex_index, parent_index)) break;
+    heap[position] = parent_index;
+    heap_positions[parent_index] = position;
+    position = parent;
+  }
+  heap[position] = vertex_index;
+  heap_positions[vertex_index] = position;
+}
+
+
+
+void R3MeshDijkstraWorkspace::
+HeapSiftDown(int position)
+{
+  // Move entry down until its children are larger
+  int vertex_index = heap[position];
+  while (TRUE) {
+    int child = 2 * position + 1;
+    if (child >= nheap) break;
+    if ((child + 1 < nheap) && HeapLess(heap[child + 1], heap[child])) child++;
+    int child_index = heap[child];
+    if (!HeapLess(child_index, vertex_index)) break;
+    heap[position] = child_index;
+    heap_positions[child_index] = position;
+    position = child;
+  }
+  heap[position] = vertex_index;
+  heap_positions[vertex_index] = position;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Parallel search functions
+////////////////////////////////////////////////////////////////////////
+
+struct R3MeshDijkstraSearchFromEachData {
+  R3Mesh *mesh;
+  RNMutex *mutex;
+  std::vector<R3MeshDijkstraWorkspace *> *workspaces;
+  std::vector<R3MeshDijkstraWorkspace *> *free_workspaces;
+  const RNArray<R3MeshVertex *> *source_vertices;
+  RNLength max_distance;
+  void (*callback)(const R3MeshDijkstraWorkspace *, int, void *);
+  void *data;
+};
+
+
+
+void R3MeshDijkstraWorkspace::
+SearchFromEachTask(int start, int end, void *data)
+{
+  // Take a workspace that is not in use (rather than one per thread index,
+  // since a callback may wait in a nested parallel loop and run another task)
+  R3MeshDijkstraSearchFromEachData *task = (R3MeshDijkstraSearchFromEachData *) data;
+  R3MeshDijkstraWorkspace *workspace = NULL;
+  task->mutex->Lock();
+  if (!task->free_workspaces->empty()) {
+    workspace = task->free_workspaces->back();
+    task->free_workspaces->pop_back();
+  }
+  task->mutex->Unlock();
+
+  // Create workspace if none is free
+  if (!workspace) {
+    workspace = new R3MeshDijkstraWorkspace(task->mesh);
+    task->mutex->Lock();
+    task->workspaces->push_back(workspace);
+    task->mutex->Unlock();
+  }
+
+  // Search from range of source vertices
+  for (int i = start; i < end; i++) {
+    workspace->Search(task->source_vertices->Kth(i), task->max_distance);
+    (*task->callback)(workspace, i, task->data);
+  }
+
+  // Return workspace to free list
+  task->mutex->Lock();
+  task->free_workspaces->push_back(workspace);
+  task->mutex->Unlock();
+}
+
+
+
+void R3MeshDijkstraWorkspace::
+SearchFromEach(R3Mesh *mesh, const RNArray<R3MeshVertex *>& source_vertices, RNLength max_distance,
+  void (*callback)(const R3MeshDijkstraWorkspace *workspace, int source_index, void *data), void *data)
+{
+  // Check source vertices
+  if (source_vertices.IsEmpty()) return;
+
+  // Cache edge lengths in mesh (serially, so that workspaces can be created in parallel)
+  for (int i = 0; i < mesh->NEdges(); i++) {
+    mesh->EdgeLength(mesh->Edge(i));
+  }
+
+  // Workspaces are created as needed (one per task running at once) and reused
+  RNMutex mutex;
+  std::vector<R3MeshDijkstraWorkspace *> workspaces;
+  std::vector<R3MeshDijkstraWorkspace *> free_workspaces;
+
+  // Search from source vertices in parallel
+  R3MeshDijkstraSearchFromEachData task;
+  task.mesh = mesh;
+  task.mutex = &mutex;
+  task.workspaces = &workspaces;
+  task.free_workspaces = &free_workspaces;
+  task.source_vertices = &source_vertices;
+  task.max_distance = max_distance;
+  task.callback = callback;
+  task.data = data;
+  RNParallelFor(0, source_vertices.NEntries(), SearchFromEachTask, &task, 1);
+
+  // Delete workspaces
+  for (unsigned int i = 0; i < workspaces.size(); i++) delete workspaces[i];
+}
+
+
+
+} // namespace gaps
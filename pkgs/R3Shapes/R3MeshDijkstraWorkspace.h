@@ -0,0 +1,172 @@
+// Include file for mesh dijkstra workspace class
+#ifndef __R3__MESH__DIJKSTRA__WORKSPACE__H__
+#define __R3__MESH__DIJKSTRA__WORKSPACE__H__
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Class declaration
+
+// Reusable state for computing dijkstra distances along the edges of a mesh.
+// R3Mesh::DijkstraDistances allocates and initializes arrays of size
+// NVertices for every query, which dominates the cost of small bounded
+// searches.  A workspace allocates its arrays once, and each search resets
+// only the vertices touched by the previous search, so a bounded search
+// costs time proportional to the size of the region it visits.  A workspace
+// must be used by only one task at a time -- use one per running task (e.g.,
+// via SearchFromEach) for parallel queries.  Edge lengths are cached in the mesh
+// when the workspace is constructed, so the mesh must not be modified while
+// the workspace is in use.
+
+class R3MeshDijkstraWorkspace {
+public:
+  // Constructor/destructors
+  R3MeshDijkstraWorkspace(R3Mesh *mesh);
+  ~R3MeshDijkstraWorkspace(void);
+
+  // Property functions
+  R3Mesh *Mesh(void) const;
+
+  // Search functions (return the number of vertices reached)
+  int Search(const R3MeshVertex *source_vertex, RNLength max_distance = 0);
+  int Search(const RNArray<R3MeshVertex *>& source_vertices, RNLength max_distance = 0);
+    // If max_distance is non-zero, only vertices within that distance of a source are reached
+
+  // Result access functions (valid until the next search)
+  int NReachedVertices(void) const;
+  R3MeshVertex *ReachedVertex(int k) const;
+    // Returns kth reached vertex in order of increasing distance
+  RNLength VertexDistance(const R3MeshVertex *vertex) const;
+  RNLength VertexDistance(int vertex_index) const;
+    // Returns distance to closest source vertex (FLT_MAX if not reached)
+  R3MeshEdge *VertexEdge(const R3MeshVertex *vertex) const;
+    // Returns edge to ancestor in shortest path tree (NULL for sources and vertices not reached)
+  const RNLength *Distances(void) const;
+    // Returns array of distances indexed by VertexID (FLT_MAX for vertices not reached)
+
+  // Parallel search functions
+  static void SearchFromEach(R3Mesh *mesh, const RNArray<R3MeshVertex *>& source_vertices, RNLength max_distance,
+    void (*callback)(const R3MeshDijkstraWorkspace *workspace, int source_index, void *data), void *data);
+    // Runs a separate search from every source vertex in parallel (one workspace per running task),
+    // calling callback with the results of each search -- the callback must be safe to call from many threads
+
+public:
+  // Internal heap functions
+  void HeapPush(int vertex_index);
+  int HeapPop(void);
+  void HeapUpdate(int vertex_index);
+  void HeapSiftUp(int position);
+  void HeapSiftDown(int position);
+  RNBoolean HeapLess(int vertex_index1, int vertex_index2) const;
+
+  // Internal parallel task functions
+  static void SearchFromEachTask(int start, int end, void *data);
+
+  // Not implemented
+  R3MeshDijkstraWorkspace(const R3MeshDijkstraWorkspace& workspace);
+  R3MeshDijkstraWorkspace& operator=(const R3MeshDijkstraWorkspace& workspace);
+
+public:
+  // Internal data
+  R3Mesh *mesh;
+  int nvertices;
+  RNLength *distances;
+  R3MeshEdge **edges;
+  int *heap_positions;
+  int *heap;
+  int nheap;
+  int *reached;
+  int nreached;
+  int *touched;
+  int ntouched;
+};
+
+
+
+// Inline functions
+
+inline R3Mesh *R3MeshDijkstraWorkspace::
+Mesh(void) const
+{
+  // Return mesh
+  return mesh;
+}
+
+
+
+inline int R3MeshDijkstraWorkspace::
+NReachedVertices(void) const
+{
+  // Return number of vertices reached by last search
+  return nreached;
+}
+
+
+
+inline R3MeshVertex *R3MeshDijkstraWorkspace::
+ReachedVertex(int k) const
+{
+  // Return kth reached vertex
+  return mesh->Vertex(reached[k]);
+}
+
+
+
+inline RNLength R3MeshDijkstraWorkspace::
+VertexDistance(int vertex_index) const
+{
+  // Return distance to closest source vertex
+  return distances[vertex_index];
+}
+
+
+
+inline RNLength R3MeshDijkstraWorkspace::
+VertexDistance(const R3MeshVertex *vertex) const
+{
+  // Return distance to closest source vertex
+  return VertexDistance(mesh->VertexID(vertex));
+}
+
+
+
+inline R3MeshEdge *R3MeshDijkstraWorkspace::
+VertexEdge(const R3MeshVertex *vertex) const
+{
+  // Return edge to ancestor in shortest path tree
+  return edges[mesh->VertexID(vertex)];
+}
+
+
+
+inline const RNLength *R3MeshDijkstraWorkspace::
+Distances(void) const
+{
+  // Return array of distances
+  return distances;
+}
+
+
+
+inline RNBoolean R3MeshDijkstraWorkspace::
+HeapLess(int vertex_index1, int vertex_index2) const
+{
+  // Order by distance, breaking ties by index so that results are deterministic
+  if (distances[vertex_index1] < distances[vertex_index2]) return TRUE;
+  if (distances[vertex_index1] > distances[vertex_index2]) return FALSE;
+  return (vertex_index1 < vertex_index2) ? TRUE : FALSE;
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
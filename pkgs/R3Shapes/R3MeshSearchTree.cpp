@@ -173,6 +173,9 @@ R3Intersects(R3Mesh *mesh, R3MeshFace *face, const R3Box& box)
 void R3MeshSearchTree::
 InsertFace(R3MeshFace *face)
 {
+  // Update face plane (so that queries never update the mesh)
+  mesh->FacePlane(face);
+
   // Check if face intersects box
   if (!R3Intersects(mesh, face, BBox())) return;
 
@@ -512,12 +515,10 @@ FindClosest(const R3Point& query_position, const R3Vector& query_normal, R3MeshI
   RNScalar distance_squared = DistanceSquared(query_position, node_box, max_distance_squared);
   if (distance_squared >= max_distance_squared) return;
 
-  // Update based on distance to each big face
+  // Update based on distance to each big face (faces seen twice are not closer the second time)
   for (int i = 0; i < node->big_faces.NEntries(); i++) {
-    // Get face container and check mark
+    // Get face container
     R3MeshSearchTreeFace *face_container = node->big_faces[i];
-    if (face_container->mark == mark) continue;
-    face_container->mark = mark;
   
     // Find closest point in mesh face
     FindClosest(query_position, query_normal, closest, 
@@ -568,10 +569,8 @@ FindClosest(const R3Point& query_position, const R3Vector& query_normal, R3MeshI
   else {
     // Update based on distance to each small face
     for (int i = 0; i < node->small_faces.NEntries(); i++) {
-      // Get face container and check mark
+      // Get face container
       R3MeshSearchTreeFace *face_container = node->small_faces[i];
-      if (face_container->mark == mark) continue;
-      face_container->mark = mark;
 
       // Find closest point in mesh face
       FindClosest(query_position, query_normal, closest, 
@@ -586,7 +585,7 @@ FindClosest(const R3Point& query_position, const R3Vector& query_normal, R3MeshI
 void R3MeshSearchTree::
 FindClosest(const R3Point& query_position, const R3Vector& query_normal, R3MeshIntersection& closest,
   RNScalar min_distance, RNScalar max_distance, 
-  int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *), void *compatible_data)
+  int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *), void *compatible_data) const
 {
   // Initialize result
   closest.type = R3_MESH_NULL_TYPE;
@@ -599,9 +598,6 @@ FindClosest(const R3Point& query_position, const R3Vector& query_normal, R3MeshI
   // Check root
   if (!root) return;
 
-  // Update mark (used to avoid checking same face twice)
-  mark++;
-
   // Use squared distances for efficiency
   RNScalar min_distance_squared = min_distance * min_distance;
   RNScalar closest_distance_squared = max_distance * max_distance;
@@ -651,7 +647,7 @@ FindClosest(const R3Point& query_position, const R3Vector& query_normal, R3MeshI
 void R3MeshSearchTree::
 FindClosest(const R3Point& query_position, R3MeshIntersection& closest,
   RNScalar min_distance, RNScalar max_distance,
-  int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *), void *compatible_data)
+  int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *), void *compatible_data) const
 {
   // Find closest point, ignoring normal
   FindClosest(query_position, R3zero_vector, closest, min_distance, max_distance, IsCompatible, compatible_data);
@@ -659,6 +655,47 @@ FindClosest(const R3Point& query_position, R3MeshIntersection& closest,
 
 
 
+struct R3MeshSearchTreeBatchData {
+  const R3MeshSearchTree *tree;
+  const R3Point *query_positions;
+  R3MeshIntersection *closest;
+  RNScalar min_distance;
+  RNScalar max_distance;
+  const RNScalar *max_distances;
+};
+
+
+
+void R3MeshSearchTree::
+FindClosestBatchTask(int start, int end, void *data)
+{
+  // Find closest point for each query in range
+  R3MeshSearchTreeBatchData *batch = (R3MeshSearchTreeBatchData *) data;
+  for (int i = start; i < end; i++) {
+    RNScalar max_distance = (batch->max_distances) ? batch->max_distances[i] : batch->max_distance;
+    batch->tree->FindClosest(batch->query_positions[i], batch->closest[i], batch->min_distance, max_distance);
+  }
+}
+
+
+
+void R3MeshSearchTree::
+FindClosestBatch(const R3Point *query_positions, int nqueries, R3MeshIntersection *closest,
+  RNScalar min_distance, RNScalar max_distance, const RNScalar *max_distances) const
+{
+  // Find closest points in parallel (closest point searches do not modify the tree)
+  R3MeshSearchTreeBatchData data;
+  data.tree = this;
+  data.query_positions = query_positions;
+  data.closest = closest;
+  data.min_distance = min_distance;
+  data.max_distance = max_distance;
+  data.max_distances = max_distances;
+  RNParallelFor(0, nqueries, FindClosestBatchTask, &data, 64);
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // Find all search functions (up to distance cutoff) 
 ////////////////////////////////////////////////////////////////////////
@@ -1161,12 +1198,10 @@ FindIntersection(const R3Ray& ray, R3MeshIntersection& closest,
   if (!R3Intersects(ray, node_box, NULL, NULL, &node_box_t)) return;
   if (node_box_t > max_t) return;
 
-  // Update based on closest intersection to each big face
+  // Update based on closest intersection to each big face (faces seen twice are not closer the second time)
   for (int i = 0; i < node->big_faces.NEntries(); i++) {
-    // Get face container and check mark
+    // Get face container
     R3MeshSearchTreeFace *face_container = node->big_faces[i];
-    if (face_container->mark == mark) continue;
-    face_container->mark = mark;
 
     // Find closest point in mesh face
     FindIntersection(ray, closest, min_t, max_t, 
@@ -1218,10 +1253,8 @@ FindIntersection(const R3Ray& ray, R3MeshIntersection& closest,
   else {
     // Update based on distance to each small face
     for (int i = 0; i < node->small_faces.NEntries(); i++) {
-      // Get face container and check mark
+      // Get face container
       R3MeshSearchTreeFace *face_container = node->small_faces[i];
-      if (face_container->mark == mark) continue;
-      face_container->mark = mark;
 
       // Find closest point in mesh face
       FindIntersection(ray, closest, min_t, max_t,
@@ -1235,7 +1268,7 @@ FindIntersection(const R3Ray& ray, R3MeshIntersection& closest,
 void R3MeshSearchTree::
 FindIntersection(const R3Ray& ray, R3MeshIntersection& closest,
   RNScalar min_t, RNScalar max_t, 
-  int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *), void *compatible_data)
+  int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *), void *compatible_data) const
 {
   // Initialize result
   closest.type = R3_MESH_NULL_TYPE;
@@ -1248,9 +1281,6 @@ FindIntersection(const R3Ray& ray, R3MeshIntersection& closest,
   // Check root
   if (!root) return;
 
-  // Update mark (used to avoid checking same face twice)
-  mark++;
-
   // Search nodes recursively
   FindIntersection(ray, closest,
     min_t, max_t,
@@ -33,16 +33,24 @@ public:
   void Empty(void);
 
   // Find mesh feature closest to a query point
+  // (safe to call from many threads, as long as the mesh is not modified)
   void FindClosest(const R3Point& query, R3MeshIntersection& closest,
     RNScalar min_distance = 0, RNScalar max_distance = RN_INFINITY,
     int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *) = NULL, 
-    void *compatible_data = NULL);
+    void *compatible_data = NULL) const;
 
   // Find mesh feature closest to a query point and normal
+  // (safe to call from many threads, as long as the mesh is not modified)
   void FindClosest(const R3Point& query, const R3Vector& normal, R3MeshIntersection& closest,
     RNScalar min_distance = 0, RNScalar max_distance = RN_INFINITY, 
     int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *) = NULL, 
-    void *compatible_data = NULL);
+    void *compatible_data = NULL) const;
+
+  // Find mesh features closest to many query points in parallel
+  // (max_distances, if not NULL, gives a separate max_distance for each query)
+  void FindClosestBatch(const R3Point *queries, int nqueries, R3MeshIntersection *closest,
+    RNScalar min_distance = 0, RNScalar max_distance = RN_INFINITY,
+    const RNScalar *max_distances = NULL) const;
 
   // Find all mesh features with distance from a query point
   void FindAll(const R3Point& query, RNArray<R3MeshIntersection *>& hits,
@@ -56,11 +64,11 @@ public:
     int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *) = NULL, 
     void *compatible_data = NULL);
 
-  // Find first ray intersection
+  // Find first ray intersection (safe to call from many threads)
   void FindIntersection(const R3Ray& ray, R3MeshIntersection& closest,
     RNScalar min_t = 0, RNScalar max_t = RN_INFINITY,
     int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *) = NULL, 
-    void *compatible_data = NULL);
+    void *compatible_data = NULL) const;
 
   // Find all mesh faces intersecting shape
   void FindAll(const R3Shape& shape, RNArray<R3MeshIntersection *>& hits);
@@ -87,6 +95,9 @@ public:
     int (*IsCompatible)(const R3Point&, const R3Vector&, R3Mesh *, R3MeshFace *, void *), void *compatible_data,
     R3MeshFace *face) const;
 
+  // Internal parallel task functions
+  static void FindClosestBatchTask(int start, int end, void *data);
+
   // Internal all point search functions
   void FindAll(const R3Point& query, const R3Vector& normal, RNArray<R3MeshIntersection *>& hits,
     RNScalar min_distance_squared, RNScalar max_distance_squared, 
@@ -0,0 +1,675 @@
+// Source file for mesh simplifier class
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Include files
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Shapes.h"
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constant definitions
+////////////////////////////////////////////////////////////////////////
+
+// Smallest number of faces per partition worth simplifying in parallel
+static const int min_faces_per_partition = 1024;
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Structure definitions
+////////////////////////////////////////////////////////////////////////
+
+struct R3MeshSimplifierVertex {
+  // Quadric (a2, ab, ac, ad, b2, bc, bd, c2, cd, d2) of weighted plane equations
+  RNScalar quadric[10];
+  R3MeshVertex *vertex;
+  void *data;
+  int stamp;
+  RNBoolean locked;
+};
+
+struct R3MeshSimplifierCandidate {
+  RNScalar cost;
+  int slots[2];
+  int stamps[2];
+  R3Point position;
+};
+
+struct R3MeshSimplifierCollapse {
+  int slots[2];
+  R3Point position;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Utility functions
+////////////////////////////////////////////////////////////////////////
+
+static void
+AddPlaneToQuadric(RNScalar *quadric, const R3Vector& normal, RNScalar d, RNScalar weight)
+{
+  // Add weighted outer product of plane equation to quadric
+  RNScalar a = normal.X(), b = normal.Y(), c = normal.Z();
+  quadric[0] += weight * a * a;
+  quadric[1] += weight * a * b;
+  quadric[2] += weight * a * c;
+  quadric[3] += weight * a * d;
+  quadric[4] += weight * b * b;
+  quadric[5] += weight * b * c;
+  quadric[6] += weight * b * d;
+  quadric[7] += weight * c * c;
+  quadric[8] += weight * c * d;
+  quadric[9] += weight * d * d;
+}
+
+
+
+static RNScalar
+QuadricError(const RNScalar *q, const R3Point& p)
+{
+  // Return sum of weighted squared distances from point to planes of quadric
+  RNScalar x = p.X(), y = p.Y(), z = p.Z();
+  RNScalar error =
+    q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x +
+    q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y +
+    q[7]*z*z + 2*q[8]*z + q[9];
+  return (error > 0) ? error : 0;
+}
+
+
+
+static RNBoolean
+QuadricMinimum(const RNScalar *q, R3Point& p)
+{
+  // Solve for point minimizing quadric error (A p = -b), unless A is near singular
+  RNScalar c00 = q[4]*q[7] - q[5]*q[5];
+  RNScalar c01 = q[2]*q[5] - q[1]*q[7];
+  RNScalar c02 = q[1]*q[5] - q[2]*q[4];
+  RNScalar det = q[0]*c00 + q[1]*c01 + q[2]*c02;
+  RNScalar trace = q[0] + q[4] + q[7];
+  if (fabs(det) <= 1.0E-9 * trace * trace * trace) return FALSE;
+  RNScalar c11 = q[0]*q[7] - q[2]*q[2];
+  RNScalar c12 = q[1]*q[2] - q[0]*q[5];
+  RNScalar c22 = q[0]*q[4] - q[1]*q[1];
+  p[0] = -(c00*q[3] + c01*q[6] + c02*q[8]) / det;
+  p[1] = -(c01*q[3] + c11*q[6] + c12*q[8]) / det;
+  p[2] = -(c02*q[3] + c12*q[6] + c22*q[8]) / det;
+  return TRUE;
+}
+
+
+
+struct R3MeshSimplifierCandidateGreater {
+  bool operator()(const R3MeshSimplifierCandidate& a, const R3MeshSimplifierCandidate& b) const {
+    // Order by cost, breaking ties by slots so that results are deterministic
+    if (a.cost != b.cost) return a.cost > b.cost;
+    if (a.slots[0] != b.slots[0]) return a.slots[0] > b.slots[0];
+    return a.slots[1] > b.slots[1];
+  };
+};
+
+
+
+struct R3MeshSimplifierCentroidCompare {
+  R3MeshSimplifierCentroidCompare(const R3Point *centroids, int dim) : centroids(centroids), dim(dim) {};
+  bool operator()(int a, int b) const { return centroids[a][dim] < centroids[b][dim]; };
+  const R3Point *centroids;
+  int dim;
+};
+
+
+
+static void
+PartitionFaces(int *face_indices, const R3Point *face_centroids, int start, int end,
+  int npartitions, int *partition_starts)
+{
+  // Check if one partition
+  partition_starts[0] = start;
+  if (npartitions == 1) return;
+
+  // Split faces along longest axis of centroid bounding box, in proportion to partitions on each side
+  R3Box centroid_bbox = R3null_box;
+  for (int i = start; i < end; i++) centroid_bbox.Union(face_centroids[face_indices[i]]);
+  int dim = centroid_bbox.LongestAxis();
+  int npartitions0 = npartitions / 2;
+  int middle = start + (int) ((double) (end - start) * npartitions0 / npartitions);
+  std::nth_element(face_indices + start, face_indices + middle, face_indices + end,
+    R3MeshSimplifierCentroidCompare(face_centroids, dim));
+
+  // Partition each side
+  PartitionFaces(face_indices, face_centroids, start, middle, npartitions0, partition_starts);
+  PartitionFaces(face_indices, face_centroids, middle, end, npartitions - npartitions0, partition_starts + npartitions0);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constructor/destructor functions
+////////////////////////////////////////////////////////////////////////
+
+R3MeshSimplifier::
+R3MeshSimplifier(R3Mesh *mesh)
+  : mesh(mesh),
+    boundary_weight(1000),
+    locked_vertices(),
+    vertices(NULL),
+    nvertices(0),
+    heap(),
+    collapses(NULL)
+{
+}
+
+
+
+R3MeshSimplifier::
+~R3MeshSimplifier(void)
+{
+  // Delete vertices
+  if (vertices) delete [] vertices;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Manipulation functions
+////////////////////////////////////////////////////////////////////////
+
+void R3MeshSimplifier::
+LockVertex(R3MeshVertex *vertex)
+{
+  // Remember vertex, so that edges attached to it are not collapsed
+  locked_vertices.Insert(vertex);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Simplification functions
+////////////////////////////////////////////////////////////////////////
+
+int R3MeshSimplifier::
+Simplify(int target_nfaces, RNLength max_error)
+{
+  // Check number of faces
+  if (mesh->NFaces() <= target_nfaces) return 0;
+
+  // Compute quadrics of vertices
+  InitializeQuadrics();
+
+  // Collapse edges
+  int ncollapses = CollapseEdges(target_nfaces, max_error);
+
+  // Delete quadrics of vertices
+  DeleteQuadrics();
+
+  // Return number of edges collapsed
+  return ncollapses;
+}
+
+
+
+int R3MeshSimplifier::
+CollapseEdges(int target_nfaces, RNLength max_error)
+{
+  // Create heap of candidate collapses for all edges
+  heap.clear();
+  heap.reserve(2 * mesh->NEdges());
+  for (int i = 0; i < mesh->NEdges(); i++) {
+    AddCandidate(mesh->Edge(i));
+  }
+
+  // Collapse edges in order of increasing error
+  int ncollapses = 0;
+  RNScalar max_cost = max_error * max_error;
+  while ((mesh->NFaces() > target_nfaces) && !heap.empty()) {
+    // Pop candidate with smallest error
+    std::pop_heap(heap.begin(), heap.end(), R3MeshSimplifierCandidateGreater());
+    R3MeshSimplifierCandidate candidate = heap.back();
+    heap.pop_back();
+
+    // Check if candidate is stale (one of its vertices has changed since it was pushed)
+    R3MeshEdge *edge = CandidateEdge(candidate);
+    if (!edge) continue;
+
+    // Check error
+    if ((max_error > 0) && (candidate.cost > max_cost)) break;
+
+    // Check if collapse would flip faces or pinch mesh
+    if (!IsCollapseValid(edge, candidate.position)) continue;
+
+    // Collapse edge
+    R3MeshVertex *v0 = mesh->VertexOnEdge(edge, 0);
+    R3MeshVertex *vertex = mesh->CollapseEdge(edge, candidate.position);
+    if (!vertex) continue;
+    ncollapses++;
+
+    // Merge quadrics into slot of remaining vertex
+    int kept = (vertex == v0) ? candidate.slots[0] : candidate.slots[1];
+    int removed = (vertex == v0) ? candidate.slots[1] : candidate.slots[0];
+    R3MeshSimplifierVertex& kept_slot = vertices[kept];
+    R3MeshSimplifierVertex& removed_slot = vertices[removed];
+    for (int i = 0; i < 10; i++) kept_slot.quadric[i] += removed_slot.quadric[i];
+    kept_slot.stamp++;
+    removed_slot.vertex = NULL;
+
+    // Remember collapse
+    if (collapses) {
+      R3MeshSimplifierCollapse collapse;
+      collapse.slots[0] = kept;
+      collapse.slots[1] = removed;
+      collapse.position = candidate.position;
+      collapses->push_back(collapse);
+    }
+
+    // Add candidates for edges attached to remaining vertex
+    for (int i = 0; i < mesh->VertexValence(vertex); i++) {
+      AddCandidate(mesh->EdgeOnVertex(vertex, i));
+    }
+  }
+
+  // Delete heap
+  std::vector<R3MeshSimplifierCandidate>().swap(heap);
+
+  // Return number of edges collapsed
+  return ncollapses;
+}
+
+
+
+struct R3MeshSimplifierPartitionData {
+  R3Mesh *mesh;
+  const R3MeshSimplifierVertex *vertices;
+  RNScalar boundary_weight;
+  const int *face_indices;
+  const int *partition_starts;
+  const int *vertex_partitions;
+  int target_nfaces;
+  RNLength max_error;
+  std::vector<int> *partition_vertices;
+  std::vector<R3MeshSimplifierCollapse> *partition_collapses;
+};
+
+
+
+void R3MeshSimplifier::
+SimplifyPartitionTask(int start, int end, void *data)
+{
+  // Simplify copies of partitions, remembering collapses
+  R3MeshSimplifierPartitionData *task = (R3MeshSimplifierPartitionData *) data;
+  R3Mesh *mesh = task->mesh;
+  for (int p = start; p < end; p++) {
+    int face_start = task->partition_starts[p];
+    int face_end = task->partition_starts[p+1];
+
+    // Find vertices of partition (in order of ID)
+    std::vector<int>& partition_vertices = task->partition_vertices[p];
+    for (int i = face_start; i < face_end; i++) {
+      R3MeshFace *face = mesh->Face(task->face_indices[i]);
+      for (int j = 0; j < 3; j++) {
+        partition_vertices.push_back(mesh->VertexID(mesh->VertexOnFace(face, j)));
+      }
+    }
+    std::sort(partition_vertices.begin(), partition_vertices.end());
+    partition_vertices.erase(std::unique(partition_vertices.begin(), partition_vertices.end()), partition_vertices.end());
+
+    // Create copy of partition
+    R3Mesh partition_mesh;
+    R3MeshSimplifier partition_simplifier(&partition_mesh);
+    partition_simplifier.SetBoundaryWeight(task->boundary_weight);
+    for (int i = 0; i < (int) partition_vertices.size(); i++) {
+      R3MeshVertex *vertex = mesh->Vertex(partition_vertices[i]);
+      R3MeshVertex *partition_vertex = partition_mesh.CreateVertex(mesh->VertexPosition(vertex));
+      if (task->vertex_partitions[partition_vertices[i]] < 0) partition_simplifier.LockVertex(partition_vertex);
+    }
+    int nlocked_faces = 0;
+    for (int i = face_start; i < face_end; i++) {
+      R3MeshFace *face = mesh->Face(task->face_indices[i]);
+      R3MeshVertex *partition_face_vertices[3];
+      RNBoolean locked = FALSE;
+      for (int j = 0; j < 3; j++) {
+        int vertex_index = mesh->VertexID(mesh->VertexOnFace(face, j));
+        int k = std::lower_bound(partition_vertices.begin(), partition_vertices.end(), vertex_index) - partition_vertices.begin();
+        partition_face_vertices[j] = partition_mesh.Vertex(k);
+        if (task->vertex_partitions[vertex_index] < 0) locked = TRUE;
+      }
+      if (locked) nlocked_faces++;
+      R3MeshFace *partition_face = partition_mesh.CreateFace(partition_face_vertices[0], partition_face_vertices[1], partition_face_vertices[2]);
+      if (partition_face) {
+        partition_mesh.SetFaceSegment(partition_face, mesh->FaceSegment(face));
+        partition_mesh.SetFaceCategory(partition_face, mesh->FaceCategory(face));
+        partition_mesh.SetFaceMaterial(partition_face, mesh->FaceMaterial(face));
+      }
+      else {
+        // Lock vertices of face that could not be copied, so that the copy stays consistent with mesh
+        for (int j = 0; j < 3; j++) partition_simplifier.LockVertex(partition_face_vertices[j]);
+      }
+    }
+
+    // Replace quadrics of copy with quadrics computed for whole mesh
+    partition_simplifier.InitializeQuadrics();
+    for (int i = 0; i < (int) partition_vertices.size(); i++) {
+      const R3MeshSimplifierVertex& mesh_slot = task->vertices[partition_vertices[i]];
+      R3MeshSimplifierVertex& partition_slot = partition_simplifier.vertices[i];
+      for (int j = 0; j < 10; j++) partition_slot.quadric[j] = mesh_slot.quadric[j];
+    }
+
+    // Simplify copy of partition (faces attached to locked vertices are left for the serial pass,
+    // so the rest of the partition is simplified only as much as the whole mesh will be)
+    int nfree_faces = face_end - face_start - nlocked_faces;
+    int partition_target_nfaces = nlocked_faces + (int) ((double) task->target_nfaces * nfree_faces / mesh->NFaces());
+    partition_simplifier.collapses = &task->partition_collapses[p];
+    partition_simplifier.CollapseEdges(partition_target_nfaces, task->max_error);
+    partition_simplifier.DeleteQuadrics();
+  }
+}
+
+
+
+int R3MeshSimplifier::
+SimplifyInParallel(int target_nfaces, RNLength max_error, int npartitions)
+{
+  // Check number of faces
+  int nfaces = mesh->NFaces();
+  if (nfaces <= target_nfaces) return 0;
+
+  // Determine number of partitions
+  if (npartitions <= 0) npartitions = 4 * RNNumThreads();
+  if (npartitions > nfaces / min_faces_per_partition) npartitions = nfaces / min_faces_per_partition;
+  if (npartitions < 2) return Simplify(target_nfaces, max_error);
+
+  // Partition faces spatially
+  int *face_indices = new int [ nfaces ];
+  R3Point *face_centroids = new R3Point [ nfaces ];
+  for (int i = 0; i < nfaces; i++) {
+    face_indices[i] = i;
+    face_centroids[i] = mesh->FaceCentroid(mesh->Face(i));
+  }
+  int *partition_starts = new int [ npartitions + 1 ];
+  PartitionFaces(face_indices, face_centroids, 0, nfaces, npartitions, partition_starts);
+  partition_starts[npartitions] = nfaces;
+  delete [] face_centroids;
+
+  // Assign vertices to partitions (-1 for vertices on borders between partitions or locked)
+  int nvertices = mesh->NVertices();
+  int *vertex_partitions = new int [ nvertices ];
+  for (int i = 0; i < nvertices; i++) vertex_partitions[i] = -2;
+  for (int p = 0; p < npartitions; p++) {
+    for (int i = partition_starts[p]; i < partition_starts[p+1]; i++) {
+      R3MeshFace *face = mesh->Face(face_indices[i]);
+      for (int j = 0; j < 3; j++) {
+        int vertex_index = mesh->VertexID(mesh->VertexOnFace(face, j));
+        if (vertex_partitions[vertex_index] == -2) vertex_partitions[vertex_index] = p;
+        else if (vertex_partitions[vertex_index] != p) vertex_partitions[vertex_index] = -1;
+      }
+    }
+  }
+  for (int i = 0; i < locked_vertices.NEntries(); i++) {
+    vertex_partitions[mesh->VertexID(locked_vertices[i])] = -1;
+  }
+
+  // Compute quadrics of vertices (slots are indexed by vertex ID until edges are collapsed)
+  InitializeQuadrics();
+
+  // Simplify copies of partitions in parallel
+  std::vector<int> *partition_vertices = new std::vector<int> [ npartitions ];
+  std::vector<R3MeshSimplifierCollapse> *partition_collapses = new std::vector<R3MeshSimplifierCollapse> [ npartitions ];
+  R3MeshSimplifierPartitionData task;
+  task.mesh = mesh;
+  task.vertices = vertices;
+  task.boundary_weight = boundary_weight;
+  task.face_indices = face_indices;
+  task.partition_starts = partition_starts;
+  task.vertex_partitions = vertex_partitions;
+  task.target_nfaces = target_nfaces;
+  task.max_error = max_error;
+  task.partition_vertices = partition_vertices;
+  task.partition_collapses = partition_collapses;
+  RNParallelFor(0, npartitions, SimplifyPartitionTask, &task, 1);
+
+  // Replay collapses of partitions on mesh (partitions share only locked vertices, so collapses are independent)
+  int ncollapses = 0;
+  for (int p = 0; p < npartitions; p++) {
+    const std::vector<int>& vertex_indices = partition_vertices[p];
+    const std::vector<R3MeshSimplifierCollapse>& collapses = partition_collapses[p];
+    for (int i = 0; i < (int) collapses.size(); i++) {
+      const R3MeshSimplifierCollapse& collapse = collapses[i];
+      R3MeshSimplifierVertex& kept_slot = vertices[vertex_indices[collapse.slots[0]]];
+      R3MeshSimplifierVertex& removed_slot = vertices[vertex_indices[collapse.slots[1]]];
+      R3MeshEdge *edge = mesh->EdgeBetweenVertices(kept_slot.vertex, removed_slot.vertex);
+      R3MeshVertex *vertex = (edge) ? mesh->CollapseEdge(edge, collapse.position) : NULL;
+      if (!vertex) { RNFail("Unable to replay collapse %d of partition %d\n", i, p); break; }
+      ncollapses++;
+
+      // Merge quadrics into slot of collapse's remaining vertex (which may be the other vertex in mesh)
+      for (int j = 0; j < 10; j++) kept_slot.quadric[j] += removed_slot.quadric[j];
+      if (vertex != kept_slot.vertex) {
+        kept_slot.vertex = vertex;
+        kept_slot.data = removed_slot.data;
+        mesh->SetVertexData(vertex, &kept_slot);
+      }
+      removed_slot.vertex = NULL;
+    }
+  }
+
+  // Delete temporary data
+  delete [] face_indices;
+  delete [] partition_starts;
+  delete [] vertex_partitions;
+  delete [] partition_vertices;
+  delete [] partition_collapses;
+
+  // Finish serially (including vertices on borders between partitions)
+  ncollapses += CollapseEdges(target_nfaces, max_error);
+
+  // Delete quadrics of vertices
+  DeleteQuadrics();
+
+  // Return number of edges collapsed
+  return ncollapses;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Internal simplification functions
+////////////////////////////////////////////////////////////////////////
+
+void R3MeshSimplifier::
+InitializeQuadrics(void)
+{
+  // Allocate vertices (and temporarily point vertex data at them)
+  if (vertices) delete [] vertices;
+  nvertices = mesh->NVertices();
+  vertices = new R3MeshSimplifierVertex [ nvertices ];
+  for (int i = 0; i < nvertices; i++) {
+    R3MeshSimplifierVertex& slot = vertices[i];
+    R3MeshVertex *vertex = mesh->Vertex(i);
+    for (int j = 0; j < 10; j++) slot.quadric[j] = 0;
+    slot.vertex = vertex;
+    slot.data = mesh->VertexData(vertex);
+    slot.stamp = 0;
+    slot.locked = FALSE;
+    mesh->SetVertexData(vertex, &slot);
+  }
+
+  // Add planes of faces
+  for (int i = 0; i < mesh->NFaces(); i++) {
+    R3MeshFace *face = mesh->Face(i);
+    const R3Plane& plane = mesh->FacePlane(face);
+    for (int j = 0; j < 3; j++) {
+      R3MeshSimplifierVertex *slot = (R3MeshSimplifierVertex *) mesh->VertexData(mesh->VertexOnFace(face, j));
+      AddPlaneToQuadric(slot->quadric, plane.Normal(), plane.D(), 1);
+    }
+  }
+
+  // Add planes perpendicular to boundary edges and edges between faces with different attributes
+  for (int i = 0; i < mesh->NEdges(); i++) {
+    R3MeshEdge *edge = mesh->Edge(i);
+    R3MeshFace *face0 = mesh->FaceOnEdge(edge, 0);
+    R3MeshFace *face1 = mesh->FaceOnEdge(edge, 1);
+    if (face0 && face1 &&
+        (mesh->FaceSegment(face0) == mesh->FaceSegment(face1)) &&
+        (mesh->FaceCategory(face0) == mesh->FaceCategory(face1)) &&
+        (mesh->FaceMaterial(face0) == mesh->FaceMaterial(face1))) continue;
+    R3MeshVertex *v0 = mesh->VertexOnEdge(edge, 0);
+    R3MeshVertex *v1 = mesh->VertexOnEdge(edge, 1);
+    const R3Point& p0 = mesh->VertexPosition(v0);
+    R3Vector direction = mesh->VertexPosition(v1) - p0;
+    for (int j = 0; j < 2; j++) {
+      R3MeshFace *face = mesh->FaceOnEdge(edge, j);
+      if (!face) continue;
+      R3Vector normal = direction % mesh->FaceNormal(face);
+      RNLength length = normal.Length();
+      if (RNIsZero(length)) continue;
+      normal /= length;
+      RNScalar d = -normal.Dot(p0.Vector());
+      AddPlaneToQuadric(((R3MeshSimplifierVertex *) mesh->VertexData(v0))->quadric, normal, d, boundary_weight);
+      AddPlaneToQuadric(((R3MeshSimplifierVertex *) mesh->VertexData(v1))->quadric, normal, d, boundary_weight);
+    }
+  }
+
+  // Lock vertices
+  for (int i = 0; i < locked_vertices.NEntries(); i++) {
+    R3MeshSimplifierVertex *slot = (R3MeshSimplifierVertex *) mesh->VertexData(locked_vertices[i]);
+    slot->locked = TRUE;
+  }
+}
+
+
+
+void R3MeshSimplifier::
+DeleteQuadrics(void)
+{
+  // Restore data of remaining vertices
+  for (int i = 0; i < nvertices; i++) {
+    R3MeshSimplifierVertex& slot = vertices[i];
+    if (slot.vertex) mesh->SetVertexData(slot.vertex, slot.data);
+  }
+
+  // Delete vertices
+  if (vertices) delete [] vertices;
+  vertices = NULL;
+  nvertices = 0;
+}
+
+
+
+void R3MeshSimplifier::
+AddCandidate(R3MeshEdge *edge)
+{
+  // Get vertex slots
+  R3MeshVertex *v0 = mesh->VertexOnEdge(edge, 0);
+  R3MeshVertex *v1 = mesh->VertexOnEdge(edge, 1);
+  R3MeshSimplifierVertex *slot0 = (R3MeshSimplifierVertex *) mesh->VertexData(v0);
+  R3MeshSimplifierVertex *slot1 = (R3MeshSimplifierVertex *) mesh->VertexData(v1);
+  if (slot0->locked || slot1->locked) return;
+
+  // Sum quadrics
+  RNScalar quadric[10];
+  for (int i = 0; i < 10; i++) quadric[i] = slot0->quadric[i] + slot1->quadric[i];
+
+  // Find position minimizing error (or best of endpoints and midpoint if ill-conditioned or far from edge)
+  const R3Point& p0 = mesh->VertexPosition(v0);
+  const R3Point& p1 = mesh->VertexPosition(v1);
+  R3Point midpoint = 0.5 * (p0 + p1);
+  R3Point position;
+  RNScalar cost;
+  if (QuadricMinimum(quadric, position) &&
+      (R3SquaredDistance(position, midpoint) <= R3SquaredDistance(p0, p1))) {
+    cost = QuadricError(quadric, position);
+  }
+  else {
+    position = midpoint;
+    cost = QuadricError(quadric, midpoint);
+    RNScalar cost0 = QuadricError(quadric, p0);
+    if (cost0 < cost) { position = p0; cost = cost0; }
+    RNScalar cost1 = QuadricError(quadric, p1);
+    if (cost1 < cost) { position = p1; cost = cost1; }
+  }
+
+  // Push candidate
+  R3MeshSimplifierCandidate candidate;
+  candidate.cost = cost;
+  candidate.slots[0] = slot0 - vertices;
+  candidate.slots[1] = slot1 - vertices;
+  candidate.stamps[0] = slot0->stamp;
+  candidate.stamps[1] = slot1->stamp;
+  candidate.position = position;
+  heap.push_back(candidate);
+  std::push_heap(heap.begin(), heap.end(), R3MeshSimplifierCandidateGreater());
+}
+
+
+
+R3MeshEdge *R3MeshSimplifier::
+CandidateEdge(const R3MeshSimplifierCandidate& candidate) const
+{
+  // Return edge of candidate, or NULL if either vertex has been removed or changed
+  const R3MeshSimplifierVertex& slot0 = vertices[candidate.slots[0]];
+  const R3MeshSimplifierVertex& slot1 = vertices[candidate.slots[1]];
+  if (!slot0.vertex || !slot1.vertex) return NULL;
+  if (slot0.stamp != candidate.stamps[0]) return NULL;
+  if (slot1.stamp != candidate.stamps[1]) return NULL;
+  return mesh->EdgeBetweenVertices(slot0.vertex, slot1.vertex);
+}
+
+
+
+RNBoolean R3MeshSimplifier::
+IsCollapseValid(R3MeshEdge *edge, const R3Point& position) const
+{
+  // Check if collapse would join two boundaries through interior edge
+  R3MeshVertex *v[2];
+  v[0] = mesh->VertexOnEdge(edge, 0);
+  v[1] = mesh->VertexOnEdge(edge, 1);
+  if (!mesh->IsEdgeOnBoundary(edge) && mesh->IsVertexOnBoundary(v[0]) && mesh->IsVertexOnBoundary(v[1])) return FALSE;
+
+  // Check if collapse would leave an edge without faces
+  for (int i = 0; i < 2; i++) {
+    R3MeshFace *face = mesh->FaceOnEdge(edge, i);
+    if (!face) continue;
+    R3MeshEdge *e0 = mesh->EdgeAcrossVertex(v[0], edge, face);
+    R3MeshEdge *e1 = mesh->EdgeAcrossVertex(v[1], edge, face);
+    if (mesh->IsEdgeOnBoundary(e0) && mesh->IsEdgeOnBoundary(e1)) return FALSE;
+  }
+
+  // Check if collapse would flip or degenerate any remaining face
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < mesh->VertexValence(v[i]); j++) {
+      R3MeshEdge *vertex_edge = mesh->EdgeOnVertex(v[i], j);
+      for (int k = 0; k < 2; k++) {
+        R3MeshFace *face = mesh->FaceOnEdge(vertex_edge, k);
+        if (!face) continue;
+        if (mesh->IsEdgeOnFace(edge, face)) continue;
+        R3Point p[3];
+        for (int m = 0; m < 3; m++) {
+          R3MeshVertex *face_vertex = mesh->VertexOnFace(face, m);
+          p[m] = (face_vertex == v[i]) ? position : mesh->VertexPosition(face_vertex);
+        }
+        R3Vector normal = (p[1] - p[0]) % (p[2] - p[0]);
+        if (normal.IsZero()) return FALSE;
+        const R3Vector& face_normal = mesh->FaceNormal(face);
+        if (face_normal.IsZero()) continue;
+        if (normal.Dot(face_normal) <= 0) return FALSE;
+      }
+    }
+  }
+
+  // Passed all tests
+  return TRUE;
+}
+
+
+
+} // namespace gaps
@@ -0,0 +1,127 @@
+// Include file for mesh simplifier class
+#ifndef __R3__MESH__SIMPLIFIER__H__
+#define __R3__MESH__SIMPLIFIER__H__
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Structure declarations
+
+struct R3MeshSimplifierVertex;
+struct R3MeshSimplifierCandidate;
+struct R3MeshSimplifierCollapse;
+
+
+
+// Class declaration
+
+// Decimates a mesh by collapsing edges in order of quadric error (Garland
+// and Heckbert).  Every vertex carries the sum of the squared distances to
+// the planes of its original faces, plus heavily weighted planes
+// perpendicular to boundary edges and to edges between faces with different
+// segments, categories, or materials, so that those curves are preserved.
+// Candidates are kept in a lazy heap -- a collapse does not update the heap,
+// instead stale candidates are discarded when they are popped.  Collapses
+// that would flip a face or pinch the mesh are skipped.  The parallel mode
+// simplifies spatial partitions of the faces independently (with vertices
+// on partition borders locked), replays their collapses on the mesh, and
+// then finishes with a serial pass that is free to simplify the borders.
+// Surviving vertices and faces are the original ones, so their properties
+// (including segment, category, and material of faces) are preserved.
+// The simplifier borrows the data pointers of vertices while it runs, and
+// restores them when it is done.
+
+class R3MeshSimplifier {
+public:
+  // Constructor/destructors
+  R3MeshSimplifier(R3Mesh *mesh);
+  ~R3MeshSimplifier(void);
+
+  // Property functions
+  R3Mesh *Mesh(void) const;
+  RNScalar BoundaryWeight(void) const;
+
+  // Manipulation functions
+  void SetBoundaryWeight(RNScalar weight);
+    // Sets weight of planes constraining boundaries and face attribute borders (default 1000)
+  void LockVertex(R3MeshVertex *vertex);
+    // Prevents vertex from being moved or removed
+
+  // Simplification functions (return the number of edges collapsed)
+  int Simplify(int target_nfaces, RNLength max_error = 0);
+    // Collapses edges until the mesh has at most target_nfaces faces,
+    // or (if max_error is non-zero) the error of every remaining collapse
+    // is greater than max_error (which is roughly a distance)
+  int SimplifyInParallel(int target_nfaces, RNLength max_error = 0, int npartitions = 0);
+    // Same, but simplifies npartitions spatial partitions of the mesh in parallel
+    // first (default is 4 partitions per thread)
+
+public:
+  // Internal simplification functions
+  void InitializeQuadrics(void);
+  void DeleteQuadrics(void);
+  int CollapseEdges(int target_nfaces, RNLength max_error);
+  void AddCandidate(R3MeshEdge *edge);
+  R3MeshEdge *CandidateEdge(const R3MeshSimplifierCandidate& candidate) const;
+  RNBoolean IsCollapseValid(R3MeshEdge *edge, const R3Point& position) const;
+
+  // Internal parallel task functions
+  static void SimplifyPartitionTask(int start, int end, void *data);
+
+  // Not implemented
+  R3MeshSimplifier(const R3MeshSimplifier& simplifier);
+  R3MeshSimplifier& operator=(const R3MeshSimplifier& simplifier);
+
+public:
+  // Internal data
+  R3Mesh *mesh;
+  RNScalar boundary_weight;
+  RNArray<R3MeshVertex *> locked_vertices;
+  R3MeshSimplifierVertex *vertices;
+  int nvertices;
+  std::vector<R3MeshSimplifierCandidate> heap;
+  std::vector<R3MeshSimplifierCollapse> *collapses;
+};
+
+
+
+// Inline functions
+
+inline R3Mesh *R3MeshSimplifier::
+Mesh(void) const
+{
+  // Return mesh
+  return mesh;
+}
+
+
+
+inline RNScalar R3MeshSimplifier::
+BoundaryWeight(void) const
+{
+  // Return weight of planes constraining boundaries
+  return boundary_weight;
+}
+
+
+
+inline void R3MeshSimplifier::
+SetBoundaryWeight(RNScalar weight)
+{
+  // Set weight of planes constraining boundaries
+  boundary_weight = weight;
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
@@ -0,0 +1,801 @@
+// Source file for streaming mesh reader and writer classes
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Include files
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Shapes.h"
+#include "ply.h"
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constant definitions
+////////////////////////////////////////////////////////////////////////
+
+enum {
+  R3_MESH_STREAM_NO_FORMAT,
+  R3_MESH_STREAM_PSM_FORMAT,
+  R3_MESH_STREAM_OFF_FORMAT,
+  R3_MESH_STREAM_PLY_FORMAT
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Utility functions
+////////////////////////////////////////////////////////////////////////
+
+static int
+StreamFormat(const char *filename)
+{
+  // Parse filename extension
+  const char *extension = strrchr(filename, '.');
+  if (!extension) {
+    RNFail("Filename %s has no extension (e.g., .psm)\n", filename);
+    return R3_MESH_STREAM_NO_FORMAT;
+  }
+
+  // Return format
+  if (!strncmp(extension, ".psm", 4)) return R3_MESH_STREAM_PSM_FORMAT;
+  else if (!strncmp(extension, ".off", 4)) return R3_MESH_STREAM_OFF_FORMAT;
+  else if (!strncmp(extension, ".ply", 4)) return R3_MESH_STREAM_PLY_FORMAT;
+  RNFail("Unable to stream mesh file %s (format must be .psm, .off, or .ply)\n", filename);
+  return R3_MESH_STREAM_NO_FORMAT;
+}
+
+
+
+static char *
+ReadLine(char *buffer, int buffer_size, FILE *fp, int *line_count)
+{
+  // Return next line that is not blank or a comment (with leading white space skipped)
+  while (fgets(buffer, buffer_size, fp)) {
+    (*line_count)++;
+    char *bufferp = buffer;
+    while (isspace(*bufferp)) bufferp++;
+    if (*bufferp == '#') continue;
+    if (*bufferp == '\0') continue;
+    return bufferp;
+  }
+
+  // End of file
+  return NULL;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// PLY definitions
+////////////////////////////////////////////////////////////////////////
+
+struct R3MeshStreamPlyVertex {
+  float x, y, z;
+};
+
+struct R3MeshStreamPlyFace {
+  unsigned char nverts;
+  int *verts;
+};
+
+static PlyProperty stream_vertex_props[] = {
+  {(char *) "x", PLY_FLOAT, PLY_FLOAT, offsetof(R3MeshStreamPlyVertex,x), 0, 0, 0, 0},
+  {(char *) "y", PLY_FLOAT, PLY_FLOAT, offsetof(R3MeshStreamPlyVertex,y), 0, 0, 0, 0},
+  {(char *) "z", PLY_FLOAT, PLY_FLOAT, offsetof(R3MeshStreamPlyVertex,z), 0, 0, 0, 0}
+};
+
+static PlyProperty stream_face_props[] = {
+  {(char *) "vertex_indices", PLY_INT, PLY_INT, offsetof(R3MeshStreamPlyFace,verts), 1, PLY_UCHAR, PLY_UCHAR, offsetof(R3MeshStreamPlyFace,nverts)},
+  {(char *) "vertex_index", PLY_INT, PLY_INT, offsetof(R3MeshStreamPlyFace,verts), 1, PLY_UCHAR, PLY_UCHAR, offsetof(R3MeshStreamPlyFace,nverts)}
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Reader constructor/destructor functions
+////////////////////////////////////////////////////////////////////////
+
+R3MeshStreamReader::
+R3MeshStreamReader(void)
+  : filename(NULL),
+    format(R3_MESH_STREAM_NO_FORMAT),
+    fp(NULL),
+    ply(NULL),
+    line_count(0),
+    positions(),
+    last_triangles(),
+    active_vertices(),
+    nvertices(0),
+    max_active_vertices(0),
+    nfaces(0),
+    face_count(0),
+    polygon(),
+    polygon_corner(0),
+    npending_finalizations(0),
+    ntriangles(0),
+    bbox(R3null_box),
+    area(0),
+    weighted_centroid(0,0,0)
+{
+}
+
+
+
+R3MeshStreamReader::
+~R3MeshStreamReader(void)
+{
+  // Close file
+  Close();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Reader file functions
+////////////////////////////////////////////////////////////////////////
+
+int R3MeshStreamReader::
+Open(const char *filename, RNBoolean finalize_vertices)
+{
+  // Close previous file
+  Close();
+
+  // Determine format
+  format = StreamFormat(filename);
+  if (format == R3_MESH_STREAM_NO_FORMAT) return 0;
+  this->filename = RNStrdup(filename);
+
+  // Reset statistics
+  nvertices = 0;
+  max_active_vertices = 0;
+  ntriangles = 0;
+  bbox = R3null_box;
+  area = 0;
+  weighted_centroid = R3zero_vector;
+
+  // Open file
+  if (!OpenFile(TRUE)) { Close(); return 0; }
+
+  // Find last triangle referencing each vertex
+  if (finalize_vertices && (format != R3_MESH_STREAM_PSM_FORMAT)) {
+    last_triangles.assign(positions.size(), -1);
+    int vertex_indices[3], status, count = 0;
+    while ((status = ReadFileTriangle(vertex_indices)) > 0) {
+      for (int k = 0; k < 3; k++) last_triangles[vertex_indices[k]] = count;
+      count++;
+    }
+    if (status < 0) { Close(); return 0; }
+
+    // Reopen file at start of faces
+    CloseFile();
+    if (!OpenFile(FALSE)) { Close(); return 0; }
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+int R3MeshStreamReader::
+Close(void)
+{
+  // Close file
+  CloseFile();
+
+  // Delete filename
+  if (filename) free(filename);
+  filename = NULL;
+  format = R3_MESH_STREAM_NO_FORMAT;
+
+  // Release memory (statistics are kept until the next file is opened)
+  std::vector<R3Point>().swap(positions);
+  std::vector<int>().swap(last_triangles);
+  active_vertices.clear();
+  polygon.clear();
+
+  // Return success
+  return 1;
+}
+
+
+
+int R3MeshStreamReader::
+OpenFile(RNBoolean read_positions)
+{
+  // Initialize face data
+  line_count = 0;
+  nfaces = 0;
+  face_count = 0;
+  polygon.clear();
+  polygon_corner = 0;
+  npending_finalizations = 0;
+
+  // Open file
+  fp = fopen(filename, (format == R3_MESH_STREAM_PLY_FORMAT) ? "rb" : "r");
+  if (!fp) {
+    RNFail("Unable to open file %s\n", filename);
+    return 0;
+  }
+
+  // Read header and vertices
+  if (format == R3_MESH_STREAM_PSM_FORMAT) {
+    // Vertices are interleaved with faces
+    active_vertices.clear();
+    nvertices = 0;
+  }
+  else if (format == R3_MESH_STREAM_OFF_FORMAT) {
+    // Read counts (either on line with header keyword, or on next line)
+    char buffer[1024], header[64];
+    int nverts = -1;
+    char *bufferp;
+    while ((bufferp = ReadLine(buffer, 1023, fp, &line_count))) {
+      if (strstr(bufferp, "OFF")) {
+        if (sscanf(bufferp, "%s%d%d", header, &nverts, &nfaces) == 3) break;
+      }
+      else {
+        if (sscanf(bufferp, "%d%d", &nverts, &nfaces) != 2) nverts = -1;
+        break;
+      }
+    }
+    if ((nverts < 0) || (nfaces < 0)) {
+      RNFail("Syntax error reading header on line %d in file %s\n", line_count, filename);
+      return 0;
+    }
+
+    // Read vertices
+    if (read_positions) positions.reserve(nverts);
+    for (int i = 0; i < nverts; i++) {
+      double x, y, z;
+      bufferp = ReadLine(buffer, 1023, fp, &line_count);
+      if (!bufferp || (sscanf(bufferp, "%lf%lf%lf", &x, &y, &z) != 3)) {
+        RNFail("Syntax error with vertex coordinates on line %d in file %s\n", line_count, filename);
+        return 0;
+      }
+      if (read_positions) positions.push_back(R3Point(x, y, z));
+    }
+
+    // Remember number of vertices
+    nvertices = max_active_vertices = nverts;
+  }
+  else if (format == R3_MESH_STREAM_PLY_FORMAT) {
+    // Read header
+    int nelems;
+    char **elist;
+    PlyFile *plyfile = ply_read(fp, &nelems, &elist);
+    if (!plyfile) {
+      RNFail("Unable to read ply file header in %s\n", filename);
+      fclose(fp);
+      fp = NULL;
+      return 0;
+    }
+
+    // Read elements until faces
+    ply = plyfile;
+    for (int i = 0; i < nelems; i++) {
+      int num_elems, nprops;
+      char *elem_name = elist[i];
+      PlyProperty **plist = ply_get_element_description(plyfile, elem_name, &num_elems, &nprops);
+      if (equal_strings("vertex", elem_name)) {
+        // Read vertex positions
+        for (int j = 0; j < nprops; j++) {
+          if (equal_strings("x", plist[j]->name)) ply_get_property(plyfile, elem_name, &stream_vertex_props[0]);
+          else if (equal_strings("y", plist[j]->name)) ply_get_property(plyfile, elem_name, &stream_vertex_props[1]);
+          else if (equal_strings("z", plist[j]->name)) ply_get_property(plyfile, elem_name, &stream_vertex_props[2]);
+        }
+        if (read_positions) positions.reserve(num_elems);
+        for (int j = 0; j < num_elems; j++) {
+          R3MeshStreamPlyVertex plyvertex;
+          ply_get_element(plyfile, (void *) &plyvertex);
+          if (read_positions) positions.push_back(R3Point(plyvertex.x, plyvertex.y, plyvertex.z));
+        }
+        nvertices = max_active_vertices = num_elems;
+      }
+      else if (equal_strings("face", elem_name)) {
+        // Set up for streaming faces
+        for (int j = 0; j < nprops; j++) {
+          if (equal_strings("vertex_indices", plist[j]->name)) ply_get_property(plyfile, elem_name, &stream_face_props[0]);
+          else if (equal_strings("vertex_index", plist[j]->name)) ply_get_property(plyfile, elem_name, &stream_face_props[1]);
+        }
+        nfaces = num_elems;
+        break;
+      }
+      else {
+        // Skip other elements
+        char buffer[1024];
+        for (int j = 0; j < num_elems; j++) ply_get_element(plyfile, (void *) buffer);
+      }
+    }
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+void R3MeshStreamReader::
+CloseFile(void)
+{
+  // Close file
+  if (ply) ply_close((PlyFile *) ply);
+  else if (fp) fclose(fp);
+  ply = NULL;
+  fp = NULL;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Reader element functions
+////////////////////////////////////////////////////////////////////////
+
+int R3MeshStreamReader::
+ReadElement(R3MeshStreamElement *element)
+{
+  // Check file
+  if (!fp) {
+    RNFail("Mesh stream is not open for reading\n");
+    return R3_MESH_STREAM_ERROR;
+  }
+
+  // Read element from processing sequence
+  if (format == R3_MESH_STREAM_PSM_FORMAT) {
+    int type = ReadPsmElement(element);
+    if (type == R3_MESH_STREAM_TRIANGLE) UpdateStatistics(*element);
+    return type;
+  }
+
+  // Return finalizations for previous triangle
+  if (npending_finalizations > 0) {
+    element->type = R3_MESH_STREAM_FINALIZE;
+    element->vertex_indices[0] = pending_finalizations[--npending_finalizations];
+    return R3_MESH_STREAM_FINALIZE;
+  }
+
+  // Read triangle
+  int status = ReadFileTriangle(element->vertex_indices);
+  if (status == 0) return R3_MESH_STREAM_END_OF_FILE;
+  else if (status < 0) return R3_MESH_STREAM_ERROR;
+  element->type = R3_MESH_STREAM_TRIANGLE;
+  for (int k = 0; k < 3; k++) {
+    int vertex_index = element->vertex_indices[k];
+    element->positions[k] = positions[vertex_index];
+    if (last_triangles.empty()) continue;
+    if (last_triangles[vertex_index] != ntriangles) continue;
+    pending_finalizations[npending_finalizations++] = vertex_index;
+  }
+
+  // Update statistics
+  UpdateStatistics(*element);
+
+  // Return type
+  return R3_MESH_STREAM_TRIANGLE;
+}
+
+
+
+int R3MeshStreamReader::
+ReadPsmElement(R3MeshStreamElement *element)
+{
+  // Read lines until an element is complete
+  char buffer[4096];
+  while (TRUE) {
+    // Return next triangle of current polygon
+    while (polygon_corner < (int) polygon.size()) {
+      int *vertex_indices = element->vertex_indices;
+      vertex_indices[0] = polygon[0];
+      vertex_indices[1] = polygon[polygon_corner-1];
+      vertex_indices[2] = polygon[polygon_corner];
+      polygon_corner++;
+      if (vertex_indices[0] == vertex_indices[1]) continue;
+      if (vertex_indices[1] == vertex_indices[2]) continue;
+      if (vertex_indices[0] == vertex_indices[2]) continue;
+      for (int k = 0; k < 3; k++) element->positions[k] = active_vertices[vertex_indices[k]];
+      element->type = R3_MESH_STREAM_TRIANGLE;
+      return R3_MESH_STREAM_TRIANGLE;
+    }
+
+    // Read next line
+    char *bufferp = ReadLine(buffer, 4095, fp, &line_count);
+    if (!bufferp) return R3_MESH_STREAM_END_OF_FILE;
+
+    // Parse line
+    if (bufferp[0] == 'v') {
+      // Add vertex
+      double x, y, z;
+      if (sscanf(&bufferp[1], "%lf%lf%lf", &x, &y, &z) != 3) {
+        RNFail("Syntax error with vertex on line %d in file %s\n", line_count, filename);
+        return R3_MESH_STREAM_ERROR;
+      }
+      active_vertices[nvertices++] = R3Point(x, y, z);
+      if ((int) active_vertices.size() > max_active_vertices) {
+        max_active_vertices = active_vertices.size();
+      }
+    }
+    else if (bufferp[0] == 'f') {
+      // Read vertex indices of face
+      polygon.clear();
+      char *token = strtok(&bufferp[1], " \t\r\n");
+      while (token) {
+        int vertex_index = atoi(token);
+        if (active_vertices.find(vertex_index) == active_vertices.end()) {
+          RNFail("Face references inactive vertex %d on line %d in file %s\n", vertex_index, line_count, filename);
+          return R3_MESH_STREAM_ERROR;
+        }
+        polygon.push_back(vertex_index);
+        token = strtok(NULL, " \t\r\n");
+      }
+      polygon_corner = 2;
+    }
+    else if (bufferp[0] == 'x') {
+      // Finalize vertex
+      int vertex_index = atoi(&bufferp[1]);
+      std::map<int, R3Point>::iterator it = active_vertices.find(vertex_index);
+      if (it == active_vertices.end()) {
+        RNFail("Finalized inactive vertex %d on line %d in file %s\n", vertex_index, line_count, filename);
+        return R3_MESH_STREAM_ERROR;
+      }
+      active_vertices.erase(it);
+      element->type = R3_MESH_STREAM_FINALIZE;
+      element->vertex_indices[0] = vertex_index;
+      return R3_MESH_STREAM_FINALIZE;
+    }
+    else {
+      RNFail("Unrecognized element on line %d in file %s\n", line_count, filename);
+      return R3_MESH_STREAM_ERROR;
+    }
+  }
+}
+
+
+
+int R3MeshStreamReader::
+ReadFileTriangle(int vertex_indices[3])
+{
+  // Return next triangle with three different vertices from .off or .ply file
+  while (TRUE) {
+    // Read next polygon
+    while (polygon_corner >= (int) polygon.size()) {
+      int status = ReadFilePolygon();
+      if (status <= 0) return status;
+    }
+
+    // Get triangle of fan
+    vertex_indices[0] = polygon[0];
+    vertex_indices[1] = polygon[polygon_corner-1];
+    vertex_indices[2] = polygon[polygon_corner];
+    polygon_corner++;
+
+    // Check vertices
+    if (vertex_indices[0] == vertex_indices[1]) continue;
+    if (vertex_indices[1] == vertex_indices[2]) continue;
+    if (vertex_indices[0] == vertex_indices[2]) continue;
+
+    // Return success
+    return 1;
+  }
+}
+
+
+
+int R3MeshStreamReader::
+ReadFilePolygon(void)
+{
+  // Check if all faces have been read
+  if (face_count >= nfaces) return 0;
+
+  // Read vertex indices of next face
+  polygon.clear();
+  if (format == R3_MESH_STREAM_OFF_FORMAT) {
+    char buffer[4096];
+    char *bufferp = ReadLine(buffer, 4095, fp, &line_count);
+    char *token = (bufferp) ? strtok(bufferp, " \t\r\n") : NULL;
+    if (!token) {
+      RNFail("Syntax error with face on line %d in file %s\n", line_count, filename);
+      return -1;
+    }
+    int face_nverts = atoi(token);
+    for (int i = 0; i < face_nverts; i++) {
+      token = strtok(NULL, " \t\r\n");
+      if (!token) {
+        RNFail("Syntax error with face on line %d in file %s\n", line_count, filename);
+        return -1;
+      }
+      polygon.push_back(atoi(token));
+    }
+  }
+  else if (format == R3_MESH_STREAM_PLY_FORMAT) {
+    R3MeshStreamPlyFace plyface;
+    plyface.nverts = 0;
+    plyface.verts = NULL;
+    ply_get_element((PlyFile *) ply, (void *) &plyface);
+    for (int i = 0; i < plyface.nverts; i++) polygon.push_back(plyface.verts[i]);
+    if (plyface.verts) free(plyface.verts);
+  }
+
+  // Check vertex indices
+  for (int i = 0; i < (int) polygon.size(); i++) {
+    if ((polygon[i] < 0) || (polygon[i] >= nvertices)) {
+      RNFail("Invalid vertex index %d in face %d of file %s\n", polygon[i], face_count, filename);
+      return -1;
+    }
+  }
+
+  // Update face counter
+  face_count++;
+  polygon_corner = 2;
+
+  // Return success
+  return 1;
+}
+
+
+
+void R3MeshStreamReader::
+UpdateStatistics(const R3MeshStreamElement& element)
+{
+  // Update statistics with triangle
+  const R3Point& p0 = element.positions[0];
+  const R3Point& p1 = element.positions[1];
+  const R3Point& p2 = element.positions[2];
+  RNArea triangle_area = 0.5 * ((p1 - p0) % (p2 - p0)).Length();
+  weighted_centroid += triangle_area * (p0.Vector() + p1.Vector() + p2.Vector()) / 3.0;
+  area += triangle_area;
+  bbox.Union(p0);
+  bbox.Union(p1);
+  bbox.Union(p2);
+  ntriangles++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Writer constructor/destructor functions
+////////////////////////////////////////////////////////////////////////
+
+R3MeshStreamWriter::
+R3MeshStreamWriter(void)
+  : filename(NULL),
+    format(R3_MESH_STREAM_NO_FORMAT),
+    fp(NULL),
+    face_fp(NULL),
+    vertex_count_offset(0),
+    face_count_offset(0),
+    active_vertices(),
+    max_active_vertices(0),
+    nvertices(0),
+    ntriangles(0)
+{
+}
+
+
+
+R3MeshStreamWriter::
+~R3MeshStreamWriter(void)
+{
+  // Close file
+  if (fp) Close();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Writer file functions
+////////////////////////////////////////////////////////////////////////
+
+int R3MeshStreamWriter::
+Open(const char *filename)
+{
+  // Close previous file
+  if (fp) Close();
+
+  // Determine format
+  format = StreamFormat(filename);
+  if (format == R3_MESH_STREAM_NO_FORMAT) return 0;
+
+  // Open file
+  fp = fopen(filename, (format == R3_MESH_STREAM_PLY_FORMAT) ? "wb" : "w");
+  if (!fp) {
+    RNFail("Unable to open file %s\n", filename);
+    return 0;
+  }
+
+  // Open temporary file for faces (vertex count must be written before faces)
+  if (format != R3_MESH_STREAM_PSM_FORMAT) {
+    face_fp = tmpfile();
+    if (!face_fp) {
+      RNFail("Unable to open temporary file for faces of %s\n", filename);
+      fclose(fp);
+      fp = NULL;
+      return 0;
+    }
+  }
+
+  // Write header (counts are filled in when the file is closed)
+  if (format == R3_MESH_STREAM_OFF_FORMAT) {
+    fprintf(fp, "OFF\n");
+    vertex_count_offset = ftell(fp);
+    fprintf(fp, "%10d %10d %10d\n", 0, 0, 0);
+  }
+  else if (format == R3_MESH_STREAM_PLY_FORMAT) {
+    unsigned short endian_test = 1;
+    RNBoolean little_endian = (*((unsigned char *) &endian_test) == 1);
+    fprintf(fp, "ply\n");
+    fprintf(fp, "format %s 1.0\n", (little_endian) ? "binary_little_endian" : "binary_big_endian");
+    fprintf(fp, "element vertex ");
+    vertex_count_offset = ftell(fp);
+    fprintf(fp, "%10d\n", 0);
+    fprintf(fp, "property float x\n");
+    fprintf(fp, "property float y\n");
+    fprintf(fp, "property float z\n");
+    fprintf(fp, "element face ");
+    face_count_offset = ftell(fp);
+    fprintf(fp, "%10d\n", 0);
+    fprintf(fp, "property list uchar int vertex_indices\n");
+    fprintf(fp, "end_header\n");
+  }
+
+  // Initialize statistics
+  this->filename = RNStrdup(filename);
+  active_vertices.clear();
+  max_active_vertices = 0;
+  nvertices = 0;
+  ntriangles = 0;
+
+  // Return success
+  return 1;
+}
+
+
+
+int R3MeshStreamWriter::
+Close(void)
+{
+  // Check file
+  if (!fp) return 0;
+  int status = 1;
+
+  // Append faces and fill in counts
+  if (face_fp) {
+    // Copy faces
+    int buffer[3 * 1024];
+    rewind(face_fp);
+    int n = 0;
+    while ((n = fread(buffer, 3 * sizeof(int), 1024, face_fp)) > 0) {
+      for (int i = 0; i < n; i++) {
+        int *vertex_indices = &buffer[3*i];
+        if (format == R3_MESH_STREAM_OFF_FORMAT) {
+          fprintf(fp, "3 %d %d %d\n", vertex_indices[0], vertex_indices[1], vertex_indices[2]);
+        }
+        else {
+          unsigned char nverts = 3;
+          fwrite(&nverts, sizeof(unsigned char), 1, fp);
+          fwrite(vertex_indices, sizeof(int), 3, fp);
+        }
+      }
+    }
+    fclose(face_fp);
+    face_fp = NULL;
+
+    // Fill in counts
+    if (format == R3_MESH_STREAM_OFF_FORMAT) {
+      fseek(fp, vertex_count_offset, SEEK_SET);
+      fprintf(fp, "%10d %10d %10d", nvertices, ntriangles, 0);
+    }
+    else {
+      fseek(fp, vertex_count_offset, SEEK_SET);
+      fprintf(fp, "%10d", nvertices);
+      fseek(fp, face_count_offset, SEEK_SET);
+      fprintf(fp, "%10d", ntriangles);
+    }
+  }
+
+  // Close file
+  if (ferror(fp)) {
+    RNFail("Unable to write mesh stream to %s\n", filename);
+    status = 0;
+  }
+  fclose(fp);
+  fp = NULL;
+
+  // Delete filename
+  if (filename) free(filename);
+  filename = NULL;
+
+  // Release memory
+  active_vertices.clear();
+
+  // Return status
+  return status;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Writer element functions
+////////////////////////////////////////////////////////////////////////
+
+int R3MeshStreamWriter::
+WriteElement(const R3MeshStreamElement& element)
+{
+  // Check file
+  if (!fp) {
+    RNFail("Mesh stream is not open for writing\n");
+    return 0;
+  }
+
+  // Check element type
+  if (element.type == R3_MESH_STREAM_TRIANGLE) {
+    // Write vertices referenced for the first time
+    int vertex_indices[3];
+    for (int k = 0; k < 3; k++) {
+      std::map<int, int>::iterator it = active_vertices.find(element.vertex_indices[k]);
+      if (it != active_vertices.end()) {
+        vertex_indices[k] = it->second;
+        continue;
+      }
+
+      // Write vertex
+      const R3Point& position = element.positions[k];
+      if (format == R3_MESH_STREAM_PSM_FORMAT) {
+        fprintf(fp, "v %.9g %.9g %.9g\n", position.X(), position.Y(), position.Z());
+      }
+      else if (format == R3_MESH_STREAM_OFF_FORMAT) {
+        fprintf(fp, "%g %g %g\n", position.X(), position.Y(), position.Z());
+      }
+      else {
+        float coordinates[3];
+        coordinates[0] = position.X();
+        coordinates[1] = position.Y();
+        coordinates[2] = position.Z();
+        fwrite(coordinates, sizeof(float), 3, fp);
+      }
+
+      // Remember vertex index in output
+      vertex_indices[k] = nvertices++;
+      active_vertices[element.vertex_indices[k]] = vertex_indices[k];
+      if ((int) active_vertices.size() > max_active_vertices) {
+        max_active_vertices = active_vertices.size();
+      }
+    }
+
+    // Write triangle
+    if (format == R3_MESH_STREAM_PSM_FORMAT) {
+      fprintf(fp, "f %d %d %d\n", vertex_indices[0], vertex_indices[1], vertex_indices[2]);
+    }
+    else {
+      if (fwrite(vertex_indices, sizeof(int), 3, face_fp) != 3) {
+        RNFail("Unable to write face to temporary file for %s\n", filename);
+        return 0;
+      }
+    }
+
+    // Update statistics
+    ntriangles++;
+  }
+  else if (element.type == R3_MESH_STREAM_FINALIZE) {
+    // Forget vertex (if it was ever written)
+    std::map<int, int>::iterator it = active_vertices.find(element.vertex_indices[0]);
+    if (it != active_vertices.end()) {
+      if (format == R3_MESH_STREAM_PSM_FORMAT) fprintf(fp, "x %d\n", it->second);
+      active_vertices.erase(it);
+    }
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+// End namespace
+}
@@ -0,0 +1,263 @@
+// Include file for streaming mesh reader and writer classes
+#ifndef __R3__MESH__STREAM__H__
+#define __R3__MESH__STREAM__H__
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Element types
+
+#define R3_MESH_STREAM_ERROR        -1
+#define R3_MESH_STREAM_END_OF_FILE   0
+#define R3_MESH_STREAM_TRIANGLE      1
+#define R3_MESH_STREAM_FINALIZE      2
+
+
+
+// Element definition
+
+struct R3MeshStreamElement {
+  int type;
+  int vertex_indices[3];
+  R3Point positions[3];
+};
+
+
+
+// Class declarations
+
+// Streaming meshes are read and written as a sequence of elements without
+// ever building an R3Mesh.  A triangle element has the indices (in the input
+// file) and positions of its vertices.  A finalize element (with the vertex
+// index in vertex_indices[0]) says that no later triangle references the
+// vertex, so readers, writers, and operators can forget about it.  When
+// vertices are introduced just before their first triangle and finalized
+// just after their last one (a processing sequence), only the vertices on
+// the front between processed and unprocessed triangles are held in memory.
+//
+// The processing sequence format (.psm) is ASCII, with one element per line:
+//   v x y z        -- adds a vertex (numbered consecutively from 0)
+//   f i j k ...    -- adds a face (polygons are split into triangle fans)
+//   x i            -- finalizes vertex i
+// Lines starting with # are comments.  Meshes can also be streamed from and
+// to .off and .ply files, but those store all vertices before all faces, so
+// the reader keeps the positions of all vertices in memory (while the faces
+// are still streamed).  Triangles with repeated vertices are skipped.
+
+class R3MeshStreamReader {
+public:
+  // Constructor/destructors
+  R3MeshStreamReader(void);
+  ~R3MeshStreamReader(void);
+
+  // File functions
+  int Open(const char *filename, RNBoolean finalize_vertices = FALSE);
+    // Opens file for reading.  Only .psm files store finalize elements.
+    // For .off and .ply files, finalize elements are generated if finalize_vertices
+    // is set (this takes an extra pass over the faces of the file)
+  int Close(void);
+    // Closes file
+
+  // Read functions
+  int ReadElement(R3MeshStreamElement *element);
+    // Reads next element, and returns its type (R3_MESH_STREAM_END_OF_FILE after the last one)
+
+  // Statistics of triangles read so far
+  int NTriangles(void) const;
+  int NVertices(void) const;
+    // Returns number of vertices introduced by the file
+  int MaxActiveVertices(void) const;
+    // Returns largest number of vertices held in memory at once
+  const R3Box& BBox(void) const;
+  RNArea Area(void) const;
+  R3Point Centroid(void) const;
+    // Returns area weighted centroid of triangles
+
+public:
+  // Internal read functions
+  int OpenFile(RNBoolean read_positions);
+  void CloseFile(void);
+  int ReadPsmElement(R3MeshStreamElement *element);
+  int ReadFileTriangle(int vertex_indices[3]);
+  int ReadFilePolygon(void);
+  void UpdateStatistics(const R3MeshStreamElement& element);
+
+  // Not implemented
+  R3MeshStreamReader(const R3MeshStreamReader& reader);
+  R3MeshStreamReader& operator=(const R3MeshStreamReader& reader);
+
+public:
+  // File data
+  char *filename;
+  int format;
+  FILE *fp;
+  void *ply;
+  int line_count;
+
+  // Vertex data
+  std::vector<R3Point> positions;
+  std::vector<int> last_triangles;
+  std::map<int, R3Point> active_vertices;
+  int nvertices;
+  int max_active_vertices;
+
+  // Face data
+  int nfaces;
+  int face_count;
+  std::vector<int> polygon;
+  int polygon_corner;
+  int pending_finalizations[3];
+  int npending_finalizations;
+
+  // Statistics
+  int ntriangles;
+  R3Box bbox;
+  RNArea area;
+  R3Vector weighted_centroid;
+};
+
+
+
+class R3MeshStreamWriter {
+public:
+  // Constructor/destructors
+  R3MeshStreamWriter(void);
+  ~R3MeshStreamWriter(void);
+
+  // File functions
+  int Open(const char *filename);
+    // Opens .psm, .off, or .ply file for writing
+  int Close(void);
+    // Completes and closes file
+
+  // Write functions
+  int WriteElement(const R3MeshStreamElement& element);
+    // Writes triangle (along with vertices referenced for the first time) or finalizes vertex.
+    // Vertices are numbered in the order of their first triangle (unreferenced vertices are dropped)
+
+  // Statistics of elements written so far
+  int NTriangles(void) const;
+  int NVertices(void) const;
+  int MaxActiveVertices(void) const;
+    // Returns largest number of vertices remembered at once
+
+public:
+  // Not implemented
+  R3MeshStreamWriter(const R3MeshStreamWriter& writer);
+  R3MeshStreamWriter& operator=(const R3MeshStreamWriter& writer);
+
+public:
+  // File data
+  char *filename;
+  int format;
+  FILE *fp;
+  FILE *face_fp;
+  long vertex_count_offset;
+  long face_count_offset;
+
+  // Vertex data
+  std::map<int, int> active_vertices;
+  int max_active_vertices;
+
+  // Statistics
+  int nvertices;
+  int ntriangles;
+};
+
+
+
+// Inline functions
+
+inline int R3MeshStreamReader::
+NTriangles(void) const
+{
+  // Return number of triangles read so far
+  return ntriangles;
+}
+
+
+
+inline int R3MeshStreamReader::
+NVertices(void) const
+{
+  // Return number of vertices introduced so far
+  return nvertices;
+}
+
+
+
+inline int R3MeshStreamReader::
+MaxActiveVertices(void) const
+{
+  // Return largest number of vertices held in memory at once
+  return max_active_vertices;
+}
+
+
+
+inline const R3Box& R3MeshStreamReader::
+BBox(void) const
+{
+  // Return bounding box of triangles read so far
+  return bbox;
+}
+
+
+
+inline RNArea R3MeshStreamReader::
+Area(void) const
+{
+  // Return area of triangles read so far
+  return area;
+}
+
+
+
+inline R3Point R3MeshStreamReader::
+Centroid(void) const
+{
+  // Return area weighted centroid of triangles read so far
+  if (area == 0) return bbox.Centroid();
+  return R3zero_point + weighted_centroid / area;
+}
+
+
+
+inline int R3MeshStreamWriter::
+NTriangles(void) const
+{
+  // Return number of triangles written so far
+  return ntriangles;
+}
+
+
+
+inline int R3MeshStreamWriter::
+NVertices(void) const
+{
+  // Return number of vertices written so far
+  return nvertices;
+}
+
+
+
+inline int R3MeshStreamWriter::
+MaxActiveVertices(void) const
+{
+  // Return largest number of vertices remembered at once
+  return max_active_vertices;
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
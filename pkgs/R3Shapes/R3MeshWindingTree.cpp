@@ -0,0 +1,313 @@
+// Source file for mesh winding number tree class
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Include files
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Shapes.h"
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constant definitions
+////////////////////////////////////////////////////////////////////////
+
+static const int max_faces_per_leaf = 8;
+static const int max_stack_size = 256;
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Node definition
+////////////////////////////////////////////////////////////////////////
+
+struct R3MeshWindingTreeNode {
+  R3Box bbox;
+  R3Point center;
+  R3Vector dipole;
+  RNArea area;
+  RNLength radius;
+  int children[2];
+  int start, end;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Utility functions
+////////////////////////////////////////////////////////////////////////
+
+static RNAngle
+SolidAngle(const R3Point& query, const R3Point& p0, const R3Point& p1, const R3Point& p2)
+{
+  // Compute signed solid angle of triangle at query (van Oosterom and Strackee)
+  R3Vector a = p0 - query;
+  R3Vector b = p1 - query;
+  R3Vector c = p2 - query;
+  RNLength la = a.Length();
+  RNLength lb = b.Length();
+  RNLength lc = c.Length();
+  RNScalar numerator = a.Dot(b % c);
+  RNScalar denominator = la*lb*lc + a.Dot(b)*lc + b.Dot(c)*la + c.Dot(a)*lb;
+  return 2 * atan2(numerator, denominator);
+}
+
+
+
+static int
+CountNodes(int nfaces)
+{
+  // Return number of nodes in tree built over nfaces faces
+  if (nfaces <= max_faces_per_leaf) return 1;
+  int middle = nfaces / 2;
+  return 1 + CountNodes(middle) + CountNodes(nfaces - middle);
+}
+
+
+
+struct FaceCentroidCompare {
+  FaceCentroidCompare(const R3Point *centroids, int dim) : centroids(centroids), dim(dim) {};
+  bool operator()(int a, int b) const { return centroids[a][dim] < centroids[b][dim]; };
+  const R3Point *centroids;
+  int dim;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constructor/destructor functions
+////////////////////////////////////////////////////////////////////////
+
+R3MeshWindingTree::
+R3MeshWindingTree(R3Mesh *mesh, RNScalar accuracy)
+  : mesh(mesh),
+    accuracy(accuracy),
+    nodes(NULL),
+    nnodes(0),
+    face_positions(NULL),
+    nfaces(0)
+{
+  // Check mesh
+  nfaces = mesh->NFaces();
+  if (nfaces == 0) return;
+
+  // Compute face centroids
+  int *face_indices = new int [ nfaces ];
+  R3Point *face_centroids = new R3Point [ nfaces ];
+  for (int i = 0; i < nfaces; i++) {
+    R3MeshFace *face = mesh->Face(i);
+    face_indices[i] = i;
+    face_centroids[i] = mesh->FaceCentroid(face);
+  }
+
+  // Create nodes
+  nodes = new R3MeshWindingTreeNode [ CountNodes(nfaces) ];
+  CreateNode(face_indices, face_centroids, 0, nfaces);
+
+  // Copy face positions in tree order
+  face_positions = new R3Point [ 3 * nfaces ];
+  for (int i = 0; i < nfaces; i++) {
+    R3MeshFace *face = mesh->Face(face_indices[i]);
+    for (int j = 0; j < 3; j++) {
+      face_positions[3*i+j] = mesh->VertexPosition(mesh->VertexOnFace(face, j));
+    }
+  }
+
+  // Delete temporary data
+  delete [] face_indices;
+  delete [] face_centroids;
+}
+
+
+
+R3MeshWindingTree::
+~R3MeshWindingTree(void)
+{
+  // Delete nodes and face positions
+  if (nodes) delete [] nodes;
+  if (face_positions) delete [] face_positions;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Property functions
+////////////////////////////////////////////////////////////////////////
+
+const R3Box& R3MeshWindingTree::
+BBox(void) const
+{
+  // Return bounding box of all faces
+  if (nnodes == 0) return R3null_box;
+  return nodes[0].bbox;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Build functions
+////////////////////////////////////////////////////////////////////////
+
+int R3MeshWindingTree::
+CreateNode(int *face_indices, const R3Point *face_centroids, int start, int end)
+{
+  // Allocate node
+  int index = nnodes++;
+  R3MeshWindingTreeNode& node = nodes[index];
+  node.children[0] = -1;
+  node.children[1] = -1;
+  node.start = start;
+  node.end = end;
+
+  // Check if leaf
+  if (end - start <= max_faces_per_leaf) {
+    // Compute bounding box, area, center, and dipole (sum of area weighted normals) of faces
+    node.bbox = R3null_box;
+    node.dipole = R3zero_vector;
+    node.area = 0;
+    R3Point weighted_center_sum = R3zero_point;
+    for (int i = start; i < end; i++) {
+      R3MeshFace *face = mesh->Face(face_indices[i]);
+      const R3Point& p0 = mesh->VertexPosition(mesh->VertexOnFace(face, 0));
+      const R3Point& p1 = mesh->VertexPosition(mesh->VertexOnFace(face, 1));
+      const R3Point& p2 = mesh->VertexPosition(mesh->VertexOnFace(face, 2));
+      R3Vector area_vector = 0.5 * ((p1 - p0) % (p2 - p0));
+      RNArea area = area_vector.Length();
+      node.bbox.Union(p0);
+      node.bbox.Union(p1);
+      node.bbox.Union(p2);
+      node.dipole += area_vector;
+      weighted_center_sum += area * face_centroids[face_indices[i]].Vector();
+      node.area += area;
+    }
+    if (node.area > 0) node.center = weighted_center_sum / node.area;
+    else node.center = node.bbox.Centroid();
+  }
+  else {
+    // Split faces at median centroid along longest axis of centroid bounding box
+    R3Box centroid_bbox = R3null_box;
+    for (int i = start; i < end; i++) centroid_bbox.Union(face_centroids[face_indices[i]]);
+    int dim = centroid_bbox.LongestAxis();
+    int middle = start + (end - start) / 2;
+    std::nth_element(face_indices + start, face_indices + middle, face_indices + end,
+      FaceCentroidCompare(face_centroids, dim));
+
+    // Create children
+    int child0 = CreateNode(face_indices, face_centroids, start, middle);
+    int child1 = CreateNode(face_indices, face_centroids, middle, end);
+    const R3MeshWindingTreeNode& node0 = nodes[child0];
+    const R3MeshWindingTreeNode& node1 = nodes[child1];
+    node.children[0] = child0;
+    node.children[1] = child1;
+
+    // Combine bounding boxes, areas, centers, and dipoles of children
+    node.bbox = node0.bbox;
+    node.bbox.Union(node1.bbox);
+    node.dipole = node0.dipole + node1.dipole;
+    node.area = node0.area + node1.area;
+    if (node.area > 0) node.center = R3zero_point + (node0.area * node0.center.Vector() + node1.area * node1.center.Vector()) / node.area;
+    else node.center = node.bbox.Centroid();
+  }
+
+  // Compute radius of sphere around center containing bounding box
+  node.radius = 0;
+  for (int octant = 0; octant < 8; octant++) {
+    RNLength d = R3Distance(node.center, node.bbox.Corner(octant));
+    if (d > node.radius) node.radius = d;
+  }
+
+  // Return index of node
+  return index;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Winding number functions
+////////////////////////////////////////////////////////////////////////
+
+RNScalar R3MeshWindingTree::
+WindingNumber(const R3Point& query) const
+{
+  // Check nodes
+  if (nnodes == 0) return 0;
+
+  // Sum solid angles of faces, approximating distant nodes by their dipoles
+  RNAngle solid_angle = 0;
+  int stack[max_stack_size];
+  int stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    const R3MeshWindingTreeNode& node = nodes[stack[--stack_size]];
+
+    // Check if node is far enough away to approximate
+    R3Vector v = node.center - query;
+    RNScalar d2 = v.Dot(v);
+    RNScalar r = accuracy * node.radius;
+    if (d2 > r * r) {
+      solid_angle += v.Dot(node.dipole) / (d2 * sqrt(d2));
+      continue;
+    }
+
+    // Visit faces or children
+    if (node.children[0] < 0) {
+      for (int i = node.start; i < node.end; i++) {
+        const R3Point *p = &face_positions[3*i];
+        solid_angle += SolidAngle(query, p[0], p[1], p[2]);
+      }
+    }
+    else {
+      assert(stack_size + 2 <= max_stack_size);
+      stack[stack_size++] = node.children[1];
+      stack[stack_size++] = node.children[0];
+    }
+  }
+
+  // Return winding number
+  return solid_angle / (4.0 * RN_PI);
+}
+
+
+
+struct R3MeshWindingTreeBatchData {
+  const R3MeshWindingTree *tree;
+  const R3Point *queries;
+  RNScalar *winding_numbers;
+};
+
+
+
+void R3MeshWindingTree::
+WindingNumbersTask(int start, int end, void *data)
+{
+  // Compute winding numbers for range of queries
+  R3MeshWindingTreeBatchData *batch = (R3MeshWindingTreeBatchData *) data;
+  for (int i = start; i < end; i++) {
+    batch->winding_numbers[i] = batch->tree->WindingNumber(batch->queries[i]);
+  }
+}
+
+
+
+void R3MeshWindingTree::
+WindingNumbers(const R3Point *queries, int nqueries, RNScalar *winding_numbers) const
+{
+  // Compute winding numbers in parallel
+  R3MeshWindingTreeBatchData data;
+  data.tree = this;
+  data.queries = queries;
+  data.winding_numbers = winding_numbers;
+  RNParallelFor(0, nqueries, WindingNumbersTask, &data, 64);
+}
+
+
+
+} // namespace gaps
@@ -0,0 +1,115 @@
+// Include file for mesh winding number tree class
+#ifndef __R3__MESH__WINDING__TREE__H__
+#define __R3__MESH__WINDING__TREE__H__
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Node declaration
+
+struct R3MeshWindingTreeNode;
+
+
+
+// Class declaration
+
+// A bounding volume hierarchy over the faces of a mesh for evaluating
+// generalized winding numbers.  Nodes far from a query point (relative to
+// their size) are approximated by a dipole at the node center, Barnes-Hut
+// style, so a query visits about log(n) nodes plus the faces nearby.  The
+// winding number is about 1 inside and 0 outside a closed mesh, and varies
+// smoothly across holes, so thresholding at 1/2 gives a plausible inside
+// for meshes that are not watertight.  The tree copies face positions when
+// it is built, so it must be rebuilt if the mesh changes.
+
+class R3MeshWindingTree {
+public:
+  // Constructor/destructors
+  R3MeshWindingTree(R3Mesh *mesh, RNScalar accuracy = 2);
+  ~R3MeshWindingTree(void);
+
+  // Property functions
+  R3Mesh *Mesh(void) const;
+  const R3Box& BBox(void) const;
+  RNScalar Accuracy(void) const;
+  int NNodes(void) const;
+
+  // Winding number functions (safe to call from many threads)
+  RNScalar WindingNumber(const R3Point& query) const;
+  RNBoolean IsInside(const R3Point& query) const;
+
+  // Compute winding numbers for many query points in parallel
+  void WindingNumbers(const R3Point *queries, int nqueries, RNScalar *winding_numbers) const;
+
+public:
+  // Internal build functions
+  int CreateNode(int *face_indices, const R3Point *face_centroids, int start, int end);
+
+  // Internal parallel task functions
+  static void WindingNumbersTask(int start, int end, void *data);
+
+  // Not implemented
+  R3MeshWindingTree(const R3MeshWindingTree& tree);
+  R3MeshWindingTree& operator=(const R3MeshWindingTree& tree);
+
+public:
+  // Internal data
+  R3Mesh *mesh;
+  RNScalar accuracy;
+  R3MeshWindingTreeNode *nodes;
+  int nnodes;
+  R3Point *face_positions;
+  int nfaces;
+};
+
+
+
+// Inline functions
+
+inline R3Mesh *R3MeshWindingTree::
+Mesh(void) const
+{
+  // Return mesh
+  return mesh;
+}
+
+
+
+inline RNScalar R3MeshWindingTree::
+Accuracy(void) const
+{
+  // Return ratio of distance to node size beyond which nodes are approximated
+  return accuracy;
+}
+
+
+
+inline int R3MeshWindingTree::
+NNodes(void) const
+{
+  // Return number of nodes
+  return nnodes;
+}
+
+
+
+inline RNBoolean R3MeshWindingTree::
+IsInside(const R3Point& query) const
+{
+  // Return whether query point is inside mesh
+  return (WindingNumber(query) > 0.5) ? TRUE : FALSE;
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
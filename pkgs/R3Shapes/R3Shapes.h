@@ -148,11 +148,18 @@ class R3Grid;
 #include "R3Relate.h"
 #include "R3Align.h"
 #include "R3Kdtree.h"
+#include "R3StaticKdtree.h"
+#include "R3DynamicKdtree.h"
+#include "R3HashGrid.h"
 
 
 /* Mesh utility include files */
 
 #include "R3MeshSearchTree.h"
+#include "R3MeshWindingTree.h"
+#include "R3MeshDijkstraWorkspace.h"
+#include "R3MeshSimplifier.h"
+#include "R3MeshStream.h"
 #include "R3MeshProperty.h"
 #include "R3MeshPropertySet.h"
 
@@ -0,0 +1,638 @@
+// Source file for R3StaticKdtree class
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Include files
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Shapes.h"
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constant definitions
+////////////////////////////////////////////////////////////////////////
+
+static const int R3static_kdtree_max_points_per_leaf = 16;
+static const int R3static_kdtree_min_points_per_task = 16384;
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Parallel task definitions
+////////////////////////////////////////////////////////////////////////
+
+struct R3StaticKdtreeBuildTask {
+  R3StaticKdtree *tree;
+  const float *unsorted_coordinates;
+  int *order;
+  int start, end;
+};
+
+struct R3StaticKdtreeBatchTask {
+  const R3StaticKdtree *tree;
+  const R3Point *query_positions;
+  const int *order;
+  int max_points;
+  RNLength max_distance;
+  int *indices;
+  RNLength *distances;
+  int *counts;
+  std::atomic<int> total;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constructors/destructors
+////////////////////////////////////////////////////////////////////////
+
+R3StaticKdtree::
+R3StaticKdtree(const R3Point *positions, int npoints)
+  : bbox(R3null_box),
+    origin(0, 0, 0),
+    npoints(npoints),
+    nnodes(0),
+    coordinates(NULL),
+    point_indices(NULL),
+    tree_indices(NULL),
+    split_dimensions(NULL),
+    removed_flags(NULL),
+    nremoved(0)
+{
+  // Build tree
+  Build(positions, NULL);
+}
+
+
+
+R3StaticKdtree::
+R3StaticKdtree(const float *coordinates, int npoints)
+  : bbox(R3null_box),
+    origin(0, 0, 0),
+    npoints(npoints),
+    nnodes(0),
+    coordinates(NULL),
+    point_indices(NULL),
+    tree_indices(NULL),
+    split_dimensions(NULL),
+    removed_flags(NULL),
+    nremoved(0)
+{
+  // Build tree
+  Build(NULL, coordinates);
+}
+
+
+
+R3StaticKdtree::
+R3StaticKdtree(const R3StaticKdtree& kdtree)
+  : bbox(kdtree.bbox),
+    origin(kdtree.origin),
+    npoints(kdtree.npoints),
+    nnodes(kdtree.nnodes.load()),
+    coordinates(NULL),
+    point_indices(NULL),
+    tree_indices(NULL),
+    split_dimensions(NULL),
+    removed_flags(NULL),
+    nremoved(0)
+{
+  // Copy arrays
+  if (npoints > 0) {
+    coordinates = new float [ 3 * npoints ];
+    point_indices = new int [ npoints ];
+    tree_indices = new int [ npoints ];
+    split_dimensions = new unsigned char [ npoints ];
+    memcpy(coordinates, kdtree.coordinates, 3 * npoints * sizeof(float));
+    memcpy(point_indices, kdtree.point_indices, npoints * sizeof(int));
+    memcpy(tree_indices, kdtree.tree_indices, npoints * sizeof(int));
+    memcpy(split_dimensions, kdtree.split_dimensions, npoints * sizeof(unsigned char));
+  }
+
+  // Copy removed flags
+  nremoved = kdtree.nremoved;
+  if (kdtree.removed_flags) {
+    removed_flags = new unsigned char [ npoints ];
+    memcpy(removed_flags, kdtree.removed_flags, npoints * sizeof(unsigned char));
+  }
+}
+
+
+
+R3StaticKdtree::
+~R3StaticKdtree(void)
+{
+  // Delete arrays
+  if (coordinates) delete [] coordinates;
+  if (point_indices) delete [] point_indices;
+  if (tree_indices) delete [] tree_indices;
+  if (split_dimensions) delete [] split_dimensions;
+  if (removed_flags) delete [] removed_flags;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Construction functions
+////////////////////////////////////////////////////////////////////////
+
+struct R3StaticKdtreeCompare {
+  const float *coordinates;
+  int dim;
+  bool operator()(int a, int b) const { return coordinates[3*a+dim] < coordinates[3*b+dim]; }
+};
+
+
+
+void R3StaticKdtree::
+BuildNode(const float *unsorted_coordinates, int *order, int start, int end)
+{
+  // Count node
+  nnodes++;
+
+  // Check if leaf node
+  if (end - start <= R3static_kdtree_max_points_per_leaf) return;
+
+  // Find longest dimension of points in range
+  float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for (int i = start; i < end; i++) {
+    const float *c = &unsorted_coordinates[3*order[i]];
+    for (int dim = 0; dim < 3; dim++) {
+      if (c[dim] < lo[dim]) lo[dim] = c[dim];
+      if (c[dim] > hi[dim]) hi[dim] = c[dim];
+    }
+  }
+  int split_dimension = RN_X;
+  if (hi[RN_Y] - lo[RN_Y] > hi[split_dimension] - lo[split_dimension]) split_dimension = RN_Y;
+  if (hi[RN_Z] - lo[RN_Z] > hi[split_dimension] - lo[split_dimension]) split_dimension = RN_Z;
+
+  // Partition points at median (the median point stays at mid)
+  int mid = (start + end) / 2;
+  R3StaticKdtreeCompare compare;
+  compare.coordinates = unsorted_coordinates;
+  compare.dim = split_dimension;
+  std::nth_element(order + start, order + mid, order + end, compare);
+  split_dimensions[mid] = (unsigned char) split_dimension;
+
+  // Build children on either side of median
+  if ((end - start >= 2 * R3static_kdtree_min_points_per_task) && (RNNumThreads() > 1)) {
+    // Build first child in another thread
+    R3StaticKdtreeBuildTask task;
+    task.tree = this;
+    task.unsorted_coordinates = unsorted_coordinates;
+    task.order = order;
+    task.start = start;
+    task.end = mid;
+    RNTaskGroup group;
+    group.Insert(BuildNodeTask, &task);
+    BuildNode(unsorted_coordinates, order, mid + 1, end);
+    group.Wait();
+  }
+  else {
+    BuildNode(unsorted_coordinates, order, start, mid);
+    BuildNode(unsorted_coordinates, order, mid + 1, end);
+  }
+}
+
+
+
+void R3StaticKdtree::
+BuildNodeTask(void *data)
+{
+  // Build subtree
+  R3StaticKdtreeBuildTask *task = (R3StaticKdtreeBuildTask *) data;
+  task->tree->BuildNode(task->unsorted_coordinates, task->order, task->start, task->end);
+}
+
+
+
+void R3StaticKdtree::
+Build(const R3Point *positions, const float *input_coordinates)
+{
+  // Check points
+  if (npoints <= 0) { npoints = 0; return; }
+
+  // Compute bounding box
+  for (int i = 0; i < npoints; i++) {
+    if (positions) bbox.Union(positions[i]);
+    else bbox.Union(R3Point(input_coordinates[3*i+0], input_coordinates[3*i+1], input_coordinates[3*i+2]));
+  }
+
+  // Store coordinates relative to center of bounding box (for precision)
+  origin = bbox.Centroid();
+  float *unsorted_coordinates = new float [ 3 * npoints ];
+  for (int i = 0; i < npoints; i++) {
+    for (int dim = 0; dim < 3; dim++) {
+      RNCoord c = (positions) ? positions[i][dim] : input_coordinates[3*i+dim];
+      unsorted_coordinates[3*i+dim] = (float) (c - origin[dim]);
+    }
+  }
+
+  // Allocate arrays
+  coordinates = new float [ 3 * npoints ];
+  point_indices = new int [ npoints ];
+  tree_indices = new int [ npoints ];
+  split_dimensions = new unsigned char [ npoints ];
+
+  // Sort point indices into tree order
+  for (int i = 0; i < npoints; i++) point_indices[i] = i;
+  memset(split_dimensions, 0, npoints * sizeof(unsigned char));
+  BuildNode(unsorted_coordinates, point_indices, 0, npoints);
+
+  // Permute coordinates into tree order
+  for (int i = 0; i < npoints; i++) {
+    int index = point_indices[i];
+    coordinates[3*i+0] = unsorted_coordinates[3*index+0];
+    coordinates[3*i+1] = unsorted_coordinates[3*index+1];
+    coordinates[3*i+2] = unsorted_coordinates[3*index+2];
+    tree_indices[index] = i;
+  }
+
+  // Delete temporary coordinates
+  delete [] unsorted_coordinates;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Manipulation functions
+////////////////////////////////////////////////////////////////////////
+
+void R3StaticKdtree::
+RemovePoint(int index)
+{
+  // Allocate removed flags
+  if (!removed_flags) {
+    removed_flags = new unsigned char [ npoints ];
+    memset(removed_flags, 0, npoints * sizeof(unsigned char));
+  }
+
+  // Mark point as removed (it stays in the tree so that splits are unchanged)
+  int slot = tree_indices[index];
+  if (removed_flags[slot]) return;
+  removed_flags[slot] = 1;
+  nremoved++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding the closest K points to a query point
+////////////////////////////////////////////////////////////////////////
+
+static inline void
+InsertClosest(int index, float distance_squared, float min_distance_squared,
+  float& max_distance_squared, int max_points,
+  int *indices, float *distances_squared, int& npoints)
+{
+  // Check distance
+  if (distance_squared < min_distance_squared) return;
+  if (distance_squared > max_distance_squared) return;
+
+  // Find slot for point (points are sorted by distance)
+  int slot = npoints;
+  while ((slot > 0) && (distance_squared < distances_squared[slot-1])) slot--;
+  if (slot >= max_points) return;
+
+  // Insert point and distance into sorted arrays
+  int last = (npoints < max_points) ? npoints : max_points - 1;
+  for (int j = last; j > slot; j--) {
+    distances_squared[j] = distances_squared[j-1];
+    indices[j] = indices[j-1];
+  }
+  distances_squared[slot] = distance_squared;
+  indices[slot] = index;
+  if (npoints < max_points) npoints++;
+
+  // Update max distance once max_points have been found
+  if (npoints == max_points) max_distance_squared = distances_squared[max_points-1];
+}
+
+
+
+void R3StaticKdtree::
+FindClosest(int start, int end, const float *query, float *offsets, float box_distance_squared,
+  float min_distance_squared, float& max_distance_squared, int max_points,
+  int *indices, float *distances_squared, int& npoints) const
+{
+  // Check if leaf node
+  if (end - start <= R3static_kdtree_max_points_per_leaf) {
+    for (int i = start; i < end; i++) {
+      if (removed_flags && removed_flags[i]) continue;
+      const float *c = &coordinates[3*i];
+      float dx = c[0] - query[0];
+      float dy = c[1] - query[1];
+      float dz = c[2] - query[2];
+      float distance_squared = dx*dx + dy*dy + dz*dz;
+      InsertClosest(point_indices[i], distance_squared, min_distance_squared,
+        max_distance_squared, max_points, indices, distances_squared, npoints);
+    }
+    return;
+  }
+
+  // Compute distance from query to split plane
+  int mid = (start + end) / 2;
+  int dim = split_dimensions[mid];
+  float side = query[dim] - coordinates[3*mid+dim];
+
+  // Search child on same side as query first
+  if (side <= 0) FindClosest(start, mid, query, offsets, box_distance_squared,
+    min_distance_squared, max_distance_squared, max_points, indices, distances_squared, npoints);
+  else FindClosest(mid + 1, end, query, offsets, box_distance_squared,
+    min_distance_squared, max_distance_squared, max_points, indices, distances_squared, npoints);
+
+  // Update distance from query to other child's box (incrementally)
+  float offset = offsets[dim];
+  float far_distance_squared = box_distance_squared - offset*offset + side*side;
+  if (far_distance_squared > max_distance_squared) return;
+
+  // Check median point (it lies on the split plane)
+  if (!removed_flags || !removed_flags[mid]) {
+    const float *c = &coordinates[3*mid];
+    float dx = c[0] - query[0];
+    float dy = c[1] - query[1];
+    float dz = c[2] - query[2];
+    InsertClosest(point_indices[mid], dx*dx + dy*dy + dz*dz, min_distance_squared,
+      max_distance_squared, max_points, indices, distances_squared, npoints);
+  }
+
+  // Search child on other side
+  offsets[dim] = side;
+  if (side <= 0) FindClosest(mid + 1, end, query, offsets, far_distance_squared,
+    min_distance_squared, max_distance_squared, max_points, indices, distances_squared, npoints);
+  else FindClosest(start, mid, query, offsets, far_distance_squared,
+    min_distance_squared, max_distance_squared, max_points, indices, distances_squared, npoints);
+  offsets[dim] = offset;
+}
+
+
+
+int R3StaticKdtree::
+FindClosest(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance, int max_points,
+  int *indices, RNLength *distances) const
+{
+  // Check arguments
+  if (npoints == 0) return 0;
+  if (max_points <= 0) return 0;
+  if (max_distance < 0) return 0;
+  if (min_distance < 0) min_distance = 0;
+
+  // Use squared distances for efficiency
+  float min_distance_squared = (float) (min_distance * min_distance);
+  float max_distance_squared = (max_distance < FLT_MAX) ? (float) (max_distance * max_distance) : FLT_MAX;
+
+  // Transform query into coordinate system of tree
+  float query[3];
+  query[0] = (float) (query_position.X() - origin.X());
+  query[1] = (float) (query_position.Y() - origin.Y());
+  query[2] = (float) (query_position.Z() - origin.Z());
+
+  // Allocate temporary array of squared distances
+  float distances_squared_buffer[64];
+  float *distances_squared = distances_squared_buffer;
+  if (max_points > 64) distances_squared = new float [ max_points ];
+
+  // Search nodes recursively
+  int count = 0;
+  float offsets[3] = { 0, 0, 0 };
+  FindClosest(0, npoints, query, offsets, 0,
+    min_distance_squared, max_distance_squared, max_points,
+    indices, distances_squared, count);
+
+  // Return distances
+  if (distances) {
+    for (int i = 0; i < count; i++) {
+      distances[i] = sqrt(distances_squared[i]);
+    }
+  }
+
+  // Delete temporary array of squared distances
+  if (distances_squared != distances_squared_buffer) delete [] distances_squared;
+
+  // Return number of points found
+  return count;
+}
+
+
+
+int R3StaticKdtree::
+FindClosest(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance,
+  RNLength *closest_distance) const
+{
+  // Find closest point
+  int index = -1;
+  RNLength distance = 0;
+  if (!FindClosest(query_position, min_distance, max_distance, 1, &index, &distance)) return -1;
+
+  // Return closest point
+  if (closest_distance) *closest_distance = distance;
+  return index;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding the closest K points to many query points
+////////////////////////////////////////////////////////////////////////
+
+void R3StaticKdtree::
+FindClosestBatchTask(int start, int end, void *data)
+{
+  // Search for closest points to each query
+  R3StaticKdtreeBatchTask *task = (R3StaticKdtreeBatchTask *) data;
+  int max_points = task->max_points;
+  int total = 0;
+  for (int i = start; i < end; i++) {
+    int query_index = task->order[i];
+    int *query_indices = &task->indices[query_index * max_points];
+    RNLength *query_distances = (task->distances) ? &task->distances[query_index * max_points] : NULL;
+    int n = task->tree->FindClosest(task->query_positions[query_index],
+      0, task->max_distance, max_points, query_indices, query_distances);
+
+    // Pad results
+    for (int j = n; j < max_points; j++) {
+      query_indices[j] = -1;
+      if (query_distances) query_distances[j] = -1;
+    }
+    if (task->counts) task->counts[query_index] = n;
+    total += n;
+  }
+
+  // Update total number of points found
+  task->total += total;
+}
+
+
+
+int R3StaticKdtree::
+FindClosestBatch(const R3Point *query_positions, int nqueries,
+  int max_points, RNLength max_distance,
+  int *indices, RNLength *distances, int *counts) const
+{
+  // Check arguments
+  if (npoints == 0) return 0;
+  if (nqueries <= 0) return 0;
+  if (max_points <= 0) return 0;
+
+  // Visit queries in order along a space-filling curve (for locality)
+  int *order = new int [ nqueries ];
+  R3SpaceFillingCurveOrder(nqueries, query_positions, order);
+
+  // Search for closest points in parallel
+  R3StaticKdtreeBatchTask task;
+  task.tree = this;
+  task.query_positions = query_positions;
+  task.order = order;
+  task.max_points = max_points;
+  task.max_distance = max_distance;
+  task.indices = indices;
+  task.distances = distances;
+  task.counts = counts;
+  task.total = 0;
+  RNParallelFor(0, nqueries, FindClosestBatchTask, &task, 256);
+
+  // Delete order
+  delete [] order;
+
+  // Return total number of points found
+  return task.total;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Finding all points within some distance or box
+////////////////////////////////////////////////////////////////////////
+
+void R3StaticKdtree::
+FindAll(int start, int end, const float *query,
+  float min_distance_squared, float max_distance_squared,
+  std::vector<int>& result) const
+{
+  // Determine which points to check and which children to search
+  int check_start = start, check_end = end;
+  if (end - start > R3static_kdtree_max_points_per_leaf) {
+    int mid = (start + end) / 2;
+    int dim = split_dimensions[mid];
+    float side = query[dim] - coordinates[3*mid+dim];
+    if ((side <= 0) || (side*side <= max_distance_squared))
+      FindAll(start, mid, query, min_distance_squared, max_distance_squared, result);
+    if ((side >= 0) || (side*side <= max_distance_squared))
+      FindAll(mid + 1, end, query, min_distance_squared, max_distance_squared, result);
+    if (side*side > max_distance_squared) return;
+    check_start = mid;
+    check_end = mid + 1;
+  }
+
+  // Check points in leaf node (or median point of interior node)
+  for (int i = check_start; i < check_end; i++) {
+    if (removed_flags && removed_flags[i]) continue;
+    const float *c = &coordinates[3*i];
+    float dx = c[0] - query[0];
+    float dy = c[1] - query[1];
+    float dz = c[2] - query[2];
+    float distance_squared = dx*dx + dy*dy + dz*dz;
+    if (distance_squared < min_distance_squared) continue;
+    if (distance_squared > max_distance_squared) continue;
+    result.push_back(point_indices[i]);
+  }
+}
+
+
+
+int R3StaticKdtree::
+FindAll(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance,
+  std::vector<int>& result) const
+{
+  // Check arguments
+  int count = result.size();
+  if (npoints == 0) return 0;
+  if (max_distance < 0) return 0;
+  if (min_distance < 0) min_distance = 0;
+
+  // Use squared distances for efficiency
+  float min_distance_squared = (float) (min_distance * min_distance);
+  float max_distance_squared = (max_distance < FLT_MAX) ? (float) (max_distance * max_distance) : FLT_MAX;
+
+  // Transform query into coordinate system of tree
+  float query[3];
+  query[0] = (float) (query_position.X() - origin.X());
+  query[1] = (float) (query_position.Y() - origin.Y());
+  query[2] = (float) (query_position.Z() - origin.Z());
+
+  // Search nodes recursively
+  FindAll(0, npoints, query, min_distance_squared, max_distance_squared, result);
+
+  // Return number of points found
+  return result.size() - count;
+}
+
+
+
+void R3StaticKdtree::
+FindAll(int start, int end, const float *lo, const float *hi,
+  std::vector<int>& result) const
+{
+  // Determine which points to check and which children to search
+  int check_start = start, check_end = end;
+  if (end - start > R3static_kdtree_max_points_per_leaf) {
+    int mid = (start + end) / 2;
+    int dim = split_dimensions[mid];
+    float split = coordinates[3*mid+dim];
+    if (lo[dim] <= split) FindAll(start, mid, lo, hi, result);
+    if (hi[dim] >= split) FindAll(mid + 1, end, lo, hi, result);
+    if ((lo[dim] > split) || (hi[dim] < split)) return;
+    check_start = mid;
+    check_end = mid + 1;
+  }
+
+  // Check points in leaf node (or median point of interior node)
+  for (int i = check_start; i < check_end; i++) {
+    if (removed_flags && removed_flags[i]) continue;
+    const float *c = &coordinates[3*i];
+    if ((c[0] < lo[0]) || (c[0] > hi[0])) continue;
+    if ((c[1] < lo[1]) || (c[1] > hi[1])) continue;
+    if ((c[2] < lo[2]) || (c[2] > hi[2])) continue;
+    result.push_back(point_indices[i]);
+  }
+}
+
+
+
+int R3StaticKdtree::
+FindAll(const R3Box& query_box, std::vector<int>& result) const
+{
+  // Check arguments
+  int count = result.size();
+  if (npoints == 0) return 0;
+  if (query_box.IsEmpty()) return 0;
+
+  // Transform box into coordinate system of tree
+  float lo[3], hi[3];
+  for (int dim = 0; dim < 3; dim++) {
+    lo[dim] = (float) (query_box[RN_LO][dim] - origin[dim]);
+    hi[dim] = (float) (query_box[RN_HI][dim] - origin[dim]);
+  }
+
+  // Search nodes recursively
+  FindAll(0, npoints, lo, hi, result);
+
+  // Return number of points found
+  return result.size() - count;
+}
+
+
+
+} // namespace gaps
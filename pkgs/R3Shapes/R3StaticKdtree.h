@@ -0,0 +1,172 @@
+// Include file for static KDTree class
+#ifndef __R3__STATIC__KDTREE__H__
+#define __R3__STATIC__KDTREE__H__
+
+
+
+// Include files
+
+#include <vector>
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Class declaration
+
+// A kd tree that is built once from an array of positions.  Coordinates
+// are stored (as floats relative to the center of the bounding box) in
+// one contiguous array permuted into tree order, and nodes are implicit
+// (the median of each index range is the split point), so searches do
+// not dereference any pointers or call any callbacks.  Queries return
+// indices into the array the tree was built from.
+
+class R3StaticKdtree {
+public:
+  // Constructor/destructors
+  R3StaticKdtree(const R3Point *positions, int npoints);
+  R3StaticKdtree(const float *coordinates, int npoints);
+  R3StaticKdtree(const R3StaticKdtree& kdtree);
+  ~R3StaticKdtree(void);
+
+  // Property functions
+  const R3Box& BBox(void) const;
+  int NPoints(void) const;
+  int NNodes(void) const;
+  int NRemovedPoints(void) const;
+
+  // Point access functions
+  R3Point PointPosition(int index) const;
+  RNBoolean IsPointRemoved(int index) const;
+
+  // Manipulation functions (removed points are skipped by searches)
+  void RemovePoint(int index);
+
+  // Search for closest one (returns index, or -1 if none)
+  int FindClosest(const R3Point& query_position,
+    RNLength min_distance = 0, RNLength max_distance = FLT_MAX,
+    RNLength *closest_distance = NULL) const;
+
+  // Search for closest K (fills indices, returns how many)
+  int FindClosest(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance, int max_points,
+    int *indices, RNLength *distances = NULL) const;
+
+  // Search for closest K to each of many query positions (in parallel)
+  // Results for query i are in indices[i*max_points ...] (padded with -1)
+  int FindClosestBatch(const R3Point *query_positions, int nqueries,
+    int max_points, RNLength max_distance,
+    int *indices, RNLength *distances = NULL, int *counts = NULL) const;
+
+  // Search for all within some distance
+  int FindAll(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance,
+    std::vector<int>& indices) const;
+
+  // Search for all inside box
+  int FindAll(const R3Box& query_box,
+    std::vector<int>& indices) const;
+
+public:
+  // Internal build functions
+  void Build(const R3Point *positions, const float *coordinates);
+  void BuildNode(const float *unsorted_coordinates, int *order, int start, int end);
+  static void BuildNodeTask(void *data);
+  static void FindClosestBatchTask(int start, int end, void *data);
+
+  // Internal search functions
+  void FindClosest(int start, int end, const float *query, float *offsets, float box_distance_squared,
+    float min_distance_squared, float& max_distance_squared, int max_points,
+    int *indices, float *distances_squared, int& npoints) const;
+  void FindAll(int start, int end, const float *query,
+    float min_distance_squared, float max_distance_squared,
+    std::vector<int>& indices) const;
+  void FindAll(int start, int end, const float *lo, const float *hi,
+    std::vector<int>& indices) const;
+
+  // Not implemented
+  R3StaticKdtree& operator=(const R3StaticKdtree& kdtree);
+
+public:
+  // Internal data
+  R3Box bbox;
+  R3Point origin;
+  int npoints;
+  std::atomic<int> nnodes;
+  float *coordinates;
+  int *point_indices;
+  int *tree_indices;
+  unsigned char *split_dimensions;
+  unsigned char *removed_flags;
+  int nremoved;
+};
+
+
+
+// Inline functions
+
+inline const R3Box& R3StaticKdtree::
+BBox(void) const
+{
+  // Return bounding box of all points
+  return bbox;
+}
+
+
+
+inline int R3StaticKdtree::
+NPoints(void) const
+{
+  // Return number of points
+  return npoints;
+}
+
+
+
+inline int R3StaticKdtree::
+NNodes(void) const
+{
+  // Return number of (implicit) nodes
+  return nnodes;
+}
+
+
+
+inline int R3StaticKdtree::
+NRemovedPoints(void) const
+{
+  // Return number of points removed since the tree was built
+  return nremoved;
+}
+
+
+
+inline R3Point R3StaticKdtree::
+PointPosition(int index) const
+{
+  // Return position of point with index in original array
+  const float *c = &coordinates[3*tree_indices[index]];
+  return R3Point(origin.X() + c[0], origin.Y() + c[1], origin.Z() + c[2]);
+}
+
+
+
+inline RNBoolean R3StaticKdtree::
+IsPointRemoved(int index) const
+{
+  // Return whether point with index in original array has been removed
+  return (removed_flags && removed_flags[tree_indices[index]]) ? TRUE : FALSE;
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
@@ -269,7 +269,7 @@ private:
   int database_index;
   unsigned long long file_surfels_offset;
   unsigned int file_surfels_count;
-  unsigned int file_read_count;
+  std::atomic<unsigned int> file_read_count;
 
   // Node data
   friend class R3SurfelNode;
@@ -18,6 +18,44 @@ namespace gaps {
 
 
 
+////////////////////////////////////////////////////////////////////////
+// BATCH CHECK UTILITY FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+// Number of surfels whose attributes are gathered at once for batch checks
+static const int R3surfel_constraint_batch_size = 64;
+
+
+
+static void
+LoadSurfelPositions(const R3SurfelBlock *block, int start, int n,
+  RNCoord *x, RNCoord *y, RNCoord *z)
+{
+  // Gather world positions of surfels into separate arrays
+  const R3Point& origin = block->PositionOrigin();
+  const R3Surfel *surfels = block->Surfels() + start;
+  for (int k = 0; k < n; k++) {
+    x[k] = origin.X() + surfels[k].PX();
+    y[k] = origin.Y() + surfels[k].PY();
+    z[k] = origin.Z() + surfels[k].PZ();
+  }
+}
+
+
+
+static int
+CountSurfelMask(const unsigned char *surfel_mask, int nsurfels)
+{
+  // Return number of entries set in mask
+  int count = 0;
+  for (int i = 0; i < nsurfels; i++) {
+    if (surfel_mask[i]) count++;
+  }
+  return count;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // BASE CONSTRAINT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -101,6 +139,23 @@ Check(const R3Point& point) const
 
 
 
+int R3SurfelConstraint::
+CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const
+{
+  // Check surfels one at a time (derived classes can do better)
+  int count = 0;
+  for (int i = 0; i < block->NSurfels(); i++) {
+    if (!surfel_mask[i]) continue;
+    if (Check(block, block->Surfel(i))) count++;
+    else surfel_mask[i] = 0;
+  }
+
+  // Return number of surfels that pass
+  return count;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // TIMESTAMP CONSTRAINT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -170,6 +225,29 @@ Check(const R3SurfelBlock *block, const R3Surfel *surfel) const
 
 
 
+int R3SurfelTimestampConstraint::
+CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const
+{
+  // Check if all surfels pass
+  int nsurfels = block->NSurfels();
+  if (timestamp_range.IsEmpty()) return CountSurfelMask(surfel_mask, nsurfels);
+
+  // Check surfel timestamps
+  const R3Surfel *surfels = block->Surfels();
+  RNScalar timestamp_origin = block->TimestampOrigin();
+  RNScalar tmin = timestamp_range.Min();
+  RNScalar tmax = timestamp_range.Max();
+  for (int i = 0; i < nsurfels; i++) {
+    RNScalar t = timestamp_origin + surfels[i].Timestamp();
+    surfel_mask[i] &= (unsigned char) ((t >= tmin) & (t <= tmax));
+  }
+
+  // Return number of surfels that pass
+  return CountSurfelMask(surfel_mask, nsurfels);
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // COORDINATE CONSTRAINT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -204,6 +282,26 @@ Check(const R3Point& point) const
 
 
 
+int R3SurfelCoordinateConstraint::
+CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const
+{
+  // Check surfel coordinates
+  int nsurfels = block->NSurfels();
+  const R3Surfel *surfels = block->Surfels();
+  RNCoord origin = block->PositionOrigin().Coord(dimension);
+  RNCoord lo = interval.Min();
+  RNCoord hi = interval.Max();
+  for (int i = 0; i < nsurfels; i++) {
+    RNCoord c = origin + surfels[i].PositionCoord(dimension);
+    surfel_mask[i] &= (unsigned char) ((c >= lo) & (c <= hi));
+  }
+
+  // Return number of surfels that pass
+  return CountSurfelMask(surfel_mask, nsurfels);
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // NORMAL CONSTRAINT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -236,6 +334,26 @@ Check(const R3SurfelBlock *block, const R3Surfel *surfel) const
 
 
 
+int R3SurfelNormalConstraint::
+CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const
+{
+  // Check surfel normals
+  int nsurfels = block->NSurfels();
+  const R3Surfel *surfels = block->Surfels();
+  for (int i = 0; i < nsurfels; i++) {
+    RNScalar dot = 0.0;
+    dot += surfels[i].NX() * direction[0];
+    dot += surfels[i].NY() * direction[1];
+    dot += surfels[i].NZ() * direction[2];
+    surfel_mask[i] &= (unsigned char) (dot >= min_dot);
+  }
+
+  // Return number of surfels that pass
+  return CountSurfelMask(surfel_mask, nsurfels);
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // BOX CONSTRAINT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -269,6 +387,35 @@ Check(const R3Point& point) const
 
 
 
+int R3SurfelBoxConstraint::
+CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const
+{
+  // Check if all surfels fail
+  int nsurfels = block->NSurfels();
+  if (box.IsEmpty()) { memset(surfel_mask, 0, nsurfels); return 0; }
+
+  // Check surfel positions in batches (with same tolerance as R3Contains)
+  RNCoord x[R3surfel_constraint_batch_size];
+  RNCoord y[R3surfel_constraint_batch_size];
+  RNCoord z[R3surfel_constraint_batch_size];
+  for (int start = 0; start < nsurfels; start += R3surfel_constraint_batch_size) {
+    int n = nsurfels - start;
+    if (n > R3surfel_constraint_batch_size) n = R3surfel_constraint_batch_size;
+    LoadSurfelPositions(block, start, n, x, y, z);
+    for (int k = 0; k < n; k++) {
+      int pass = (x[k] - box.XMin() >= -RN_EPSILON) & (x[k] - box.XMax() <= RN_EPSILON) &
+                 (y[k] - box.YMin() >= -RN_EPSILON) & (y[k] - box.YMax() <= RN_EPSILON) &
+                 (z[k] - box.ZMin() >= -RN_EPSILON) & (z[k] - box.ZMax() <= RN_EPSILON);
+      surfel_mask[start + k] &= (unsigned char) pass;
+    }
+  }
+
+  // Return number of surfels that pass
+  return CountSurfelMask(surfel_mask, nsurfels);
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // ORIENTED BOX CONSTRAINT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -353,6 +500,33 @@ Check(const R3Point& point) const
 
 
 
+int R3SurfelCylinderConstraint::
+CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const
+{
+  // Check surfel positions in batches
+  int nsurfels = block->NSurfels();
+  RNCoord x[R3surfel_constraint_batch_size];
+  RNCoord y[R3surfel_constraint_batch_size];
+  RNCoord z[R3surfel_constraint_batch_size];
+  for (int start = 0; start < nsurfels; start += R3surfel_constraint_batch_size) {
+    int n = nsurfels - start;
+    if (n > R3surfel_constraint_batch_size) n = R3surfel_constraint_batch_size;
+    LoadSurfelPositions(block, start, n, x, y, z);
+    for (int k = 0; k < n; k++) {
+      RNScalar dx = x[k] - center.X();
+      RNScalar dy = y[k] - center.Y();
+      RNScalar d_squared = dx*dx + dy*dy;
+      int pass = (d_squared <= radius_squared) & (z[k] >= zmin) & (z[k] <= zmax);
+      surfel_mask[start + k] &= (unsigned char) pass;
+    }
+  }
+
+  // Return number of surfels that pass
+  return CountSurfelMask(surfel_mask, nsurfels);
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // SPHERE CONSTRAINT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -386,6 +560,35 @@ Check(const R3Point& point) const
 
 
 
+int R3SurfelSphereConstraint::
+CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const
+{
+  // Check surfel positions in batches (with same tolerance as R3Contains)
+  int nsurfels = block->NSurfels();
+  const R3Point& center = sphere.Center();
+  RNScalar radius_squared = sphere.Radius() * sphere.Radius();
+  RNCoord x[R3surfel_constraint_batch_size];
+  RNCoord y[R3surfel_constraint_batch_size];
+  RNCoord z[R3surfel_constraint_batch_size];
+  for (int start = 0; start < nsurfels; start += R3surfel_constraint_batch_size) {
+    int n = nsurfels - start;
+    if (n > R3surfel_constraint_batch_size) n = R3surfel_constraint_batch_size;
+    LoadSurfelPositions(block, start, n, x, y, z);
+    for (int k = 0; k < n; k++) {
+      RNScalar dx = center.X() - x[k];
+      RNScalar dy = center.Y() - y[k];
+      RNScalar dz = center.Z() - z[k];
+      RNScalar d_squared = dx*dx + dy*dy + dz*dz;
+      surfel_mask[start + k] &= (unsigned char) (d_squared - radius_squared <= RN_EPSILON);
+    }
+  }
+
+  // Return number of surfels that pass
+  return CountSurfelMask(surfel_mask, nsurfels);
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // HALFSPACE CONSTRAINT FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
@@ -1348,4 +1551,21 @@ Check(const R3Point& point) const
 
 
 
+int R3SurfelMultiConstraint::
+CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const
+{
+  // Check constraints one after another (each only clears entries)
+  int count = CountSurfelMask(surfel_mask, block->NSurfels());
+  for (int i = 0; i < constraints.NEntries(); i++) {
+    if (count == 0) break;
+    const R3SurfelConstraint *constraint = constraints.Kth(i);
+    count = constraint->CheckSurfels(block, surfel_mask);
+  }
+
+  // Return number of surfels that pass all constraints
+  return count;
+}
+
+
+
 } // namespace gaps
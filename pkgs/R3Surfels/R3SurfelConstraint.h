@@ -29,6 +29,11 @@ public:
   virtual int Check(const R3SurfelBlock *block, const R3Surfel *surfel) const;
   virtual int Check(const R3Box& box) const;
   virtual int Check(const R3Point& point) const;
+
+  // Batch surfel check functions
+  // Clears entries of surfel_mask (one per surfel of block) for surfels
+  // that fail the constraint and returns the number of entries still set
+  virtual int CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const;
 };
 
 
@@ -90,6 +95,9 @@ public:
   virtual int Check(const R3SurfelBlock *block) const;
   virtual int Check(const R3SurfelBlock *block, const R3Surfel *surfel) const;
 
+  // Batch surfel check functions
+  virtual int CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const;
+
 private:
   RNInterval timestamp_range;
 };
@@ -105,6 +113,9 @@ public:
   virtual int Check(const R3Point& point) const;
   virtual int Check(const R3Box& box) const;
 
+  // Batch surfel check functions
+  virtual int CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const;
+
 private:
   RNDimension dimension;
   RNInterval interval;
@@ -120,6 +131,9 @@ public:
   // Surfel check functions
   virtual int Check(const R3SurfelBlock *block, const R3Surfel *surfel) const;
 
+  // Batch surfel check functions
+  virtual int CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const;
+
 private:
   float direction[3];
   float min_dot;
@@ -136,6 +150,9 @@ public:
   virtual int Check(const R3Point& point) const;
   virtual int Check(const R3Box& box) const;
 
+  // Batch surfel check functions
+  virtual int CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const;
+
 private:
   R3Box box;
 };
@@ -166,6 +183,9 @@ public:
   virtual int Check(const R3Point& point) const;
   virtual int Check(const R3Box& box) const;
 
+  // Batch surfel check functions
+  virtual int CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const;
+
 private:
   R3Point center;
   RNLength radius_squared;
@@ -183,6 +203,9 @@ public:
   virtual int Check(const R3Point& point) const;
   virtual int Check(const R3Box& box) const;
 
+  // Batch surfel check functions
+  virtual int CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const;
+
 private:
   R3Sphere sphere;
 };
@@ -501,6 +524,9 @@ public:
   virtual int Check(const R3Box& box) const;
   virtual int Check(const R3Point& point) const;
 
+  // Batch surfel check functions
+  virtual int CheckSurfels(const R3SurfelBlock *block, unsigned char *surfel_mask) const;
+
 private:
   RNArray<const R3SurfelConstraint *> constraints;
 };
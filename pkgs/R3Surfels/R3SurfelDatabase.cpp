@@ -56,7 +56,8 @@ R3SurfelDatabase(void)
     max_identifier(0),
     name(NULL),
     tree(NULL),
-    resident_surfels(0)
+    resident_surfels(0),
+    file_dirty(0)
 {
 }
 
@@ -79,7 +80,8 @@ R3SurfelDatabase(const R3SurfelDatabase& database)
     max_identifier(0),
     name(RNStrdup(database.name)),
     tree(NULL),
-    resident_surfels(0)
+    resident_surfels(0),
+    file_dirty(0)
 {
   RNAbort("Not implemented");
 }
@@ -160,6 +162,14 @@ InsertBlock(R3SurfelBlock *block)
   assert(block->file_surfels_count == 0);
   assert(block->file_read_count == 0);
 
+  // Compute block properties (before locking, since this may read the block)
+  R3Box block_bbox = block->BBox();
+  RNInterval block_timestamp_range = block->TimestampRange();
+  unsigned int block_max_identifier = block->MaxIdentifier();
+
+  // Lock database
+  mutex.Lock();
+
   // Update block database info
   block->database = this;
   block->database_index = blocks.NEntries();
@@ -172,14 +182,14 @@ InsertBlock(R3SurfelBlock *block)
   blocks.Insert(block);
 
   // Update bounding box
-  bbox.Union(block->BBox());
+  bbox.Union(block_bbox);
 
   // Update timestamp range
-  timestamp_range.Union(block->TimestampRange());
+  timestamp_range.Union(block_timestamp_range);
 
   // Update max identifier
-  if (block->MaxIdentifier() > max_identifier)
-    max_identifier = block->MaxIdentifier();
+  if (block_max_identifier > max_identifier)
+    max_identifier = block_max_identifier;
 
   // Update number of surfels
   nsurfels += block->NSurfels();
@@ -190,10 +200,13 @@ InsertBlock(R3SurfelBlock *block)
   // Update resident surfels
   if (block->surfels) resident_surfels += block->NSurfels();
 
+  // Unlock database
+  mutex.Unlock();
+
 #ifdef PRINT_DEBUG
   // Print debug message
   printf("Inserted Block %6d : %6d %9ld : %9.3f %9.3f %9.3f\n", 
-    block->database_index, block->nsurfels, resident_surfels,
+    block->database_index, block->nsurfels, ResidentSurfels(),
     block->Centroid().X(), block->Centroid().Y(), block->Centroid().Z()); 
   fflush(stdout);
 #endif
@@ -209,6 +222,9 @@ RemoveBlock(R3SurfelBlock *block)
   assert(block->database == this);
   assert(block->node == NULL);
     
+  // Lock database
+  mutex.Lock();
+
   // Update resident surfels
   if (block->surfels) resident_surfels -= block->NSurfels();
   assert(resident_surfels >= 0);
@@ -218,7 +234,7 @@ RemoveBlock(R3SurfelBlock *block)
     
   // Find block
   RNArrayEntry *entry = blocks.KthEntry(block->database_index);
-  if (!entry) return;
+  if (!entry) { mutex.Unlock(); return; }
   R3SurfelBlock *tail = blocks.Tail();
   blocks.EntryContents(entry) = tail;
   tail->database_index = block->database_index;
@@ -236,13 +252,16 @@ RemoveBlock(R3SurfelBlock *block)
   nsurfels -= block->NSurfels();
   assert(nsurfels >= 0);
 
+  // Unlock database
+  mutex.Unlock();
+
   // Does not update bounding box
   // XXX
 
 #ifdef PRINT_DEBUG
   // Print debug message
   printf("Removed Block  %6d : %6d %9ld : %9.3f %9.3f %9.3f\n", 
-         block->database_index, block->nsurfels, resident_surfels,
+         block->database_index, block->nsurfels, ResidentSurfels(),
          block->Centroid().X(), block->Centroid().Y(), block->Centroid().Z()); 
   fflush(stdout);
 #endif
@@ -254,15 +273,20 @@ void R3SurfelDatabase::
 RemoveAndDeleteBlock(R3SurfelBlock *block)
 {
   // Check if still referenced
-  if (block->file_read_count == 0) {
-    // Block is not referenced, can simply delete it
-    RemoveBlock(block);
-    delete block;
-  }
-  else {
+  RNMutex& block_mutex = BlockMutex(block);
+  block_mutex.Lock();
+  RNBoolean referenced = (block->file_read_count > 0) ? TRUE : FALSE;
+  if (referenced) {
     // Block is referenced, mark for delete later
     block->flags.Add(R3_SURFEL_BLOCK_DELETE_PENDING_FLAG);
   }
+  block_mutex.Unlock();
+
+  // Block is not referenced, can simply delete it
+  if (!referenced) {
+    RemoveBlock(block);
+    delete block;
+  }
 }
 
 
@@ -313,8 +337,8 @@ InsertSubsetBlocks(R3SurfelBlock *block,
 
   // Update file read counts ???
   if (block->file_read_count > 0) {
-    block1->file_read_count = block->file_read_count;
-    block2->file_read_count = block->file_read_count;
+    block1->file_read_count = block->file_read_count.load();
+    block2->file_read_count = block->file_read_count.load();
   }
     
   // Update block properties
@@ -761,8 +785,25 @@ InternalReadBlock(R3SurfelBlock *block, FILE *fp, int swap_endian)
   }
   
   // Read surfels
-  RNFileSeek(fp, block->file_surfels_offset, RN_FILE_SEEK_SET);
-  if (!ReadSurfel(fp, block->surfels, block->nsurfels, swap_endian, major_version, minor_version)) return 0;
+  if ((major_version == current_major_version) && (minor_version == current_minor_version) && !swap_endian) {
+    // Read at offset without moving the shared file cursor (safe for concurrent reads)
+    unsigned long long nbytes = (unsigned long long) block->nsurfels * sizeof(R3Surfel);
+    if (file_dirty) {
+      // Flush buffered writes (so that positional reads see them)
+      file_mutex.Lock();
+      if (file_dirty) { fflush(fp); file_dirty = 0; }
+      file_mutex.Unlock();
+    }
+    if (!RNFileReadAt(fp, block->surfels, nbytes, block->file_surfels_offset)) return 0;
+  }
+  else {
+    // Seek and read older file versions one thread at a time
+    file_mutex.Lock();
+    RNFileSeek(fp, block->file_surfels_offset, RN_FILE_SEEK_SET);
+    int status = ReadSurfel(fp, block->surfels, block->nsurfels, swap_endian, major_version, minor_version);
+    file_mutex.Unlock();
+    if (!status) return 0;
+  }
   
   // Update resident surfels
   resident_surfels += block->NSurfels();
@@ -770,7 +811,7 @@ InternalReadBlock(R3SurfelBlock *block, FILE *fp, int swap_endian)
 #ifdef PRINT_DEBUG
   // Print debug message
   printf("Read Block     %6d : %6d %9ld : %9.3f %9.3f %9.3f\n", 
-         block->database_index, block->nsurfels, resident_surfels,
+         block->database_index, block->nsurfels, ResidentSurfels(),
          block->Centroid().X(), block->Centroid().Y(), block->Centroid().Z()); 
   fflush(stdout);
 #endif
@@ -817,7 +858,7 @@ InternalReleaseBlock(R3SurfelBlock *block, FILE *fp, int swap_endian)
 #ifdef PRINT_DEBUG
   // Print debug message
   printf("Released Block %6d : %6d %9ld : %9.3f %9.3f %9.3f\n", 
-         block->database_index, block->nsurfels, resident_surfels,
+         block->database_index, block->nsurfels, ResidentSurfels(),
          block->Centroid().X(), block->Centroid().Y(), block->Centroid().Z()); 
   fflush(stdout);
 #endif
@@ -854,6 +895,9 @@ InternalSyncBlock(R3SurfelBlock *block, FILE *fp, int swap_endian)
   // Just checking
   assert(block->database == this);
 
+  // Lock file (the file cursor is shared by all threads)
+  file_mutex.Lock();
+
   // Check if surfels can be put at original offset in file
   if ((block->file_surfels_offset > 0) && ((unsigned int) block->nsurfels <= block->file_surfels_count)) {
     // Surfels fit at original offset in file
@@ -867,12 +911,19 @@ InternalSyncBlock(R3SurfelBlock *block, FILE *fp, int swap_endian)
   }
 
   // Write surfels to file
-  if (!WriteSurfel(fp, block->surfels, block->nsurfels, swap_endian, major_version, minor_version)) return 0;
+  int status = WriteSurfel(fp, block->surfels, block->nsurfels, swap_endian, major_version, minor_version);
+
+  // Remember to flush before the next positional read
+  file_dirty = 1;
+
+  // Unlock file
+  file_mutex.Unlock();
+  if (!status) return 0;
 
 #ifdef PRINT_DEBUG
   // Print debug message
   printf("Synced Block %6d : %6d %9ld : %9.3f %9.3f %9.3f\n", 
-         block->database_index, block->nsurfels, resident_surfels,
+         block->database_index, block->nsurfels, ResidentSurfels(),
          block->Centroid().X(), block->Centroid().Y(), block->Centroid().Z()); 
   fflush(stdout);
 #endif
@@ -1093,6 +1144,36 @@ PurgeDeletedBlocks(void)
 
 
 
+void R3SurfelDatabase::
+ReorderBlocks(const RNArray<R3SurfelBlock *>& ordered_blocks)
+{
+  // Lock database
+  mutex.Lock();
+
+  // Gather indices of blocks (sorted)
+  std::vector<int> indices;
+  for (int i = 0; i < ordered_blocks.NEntries(); i++) {
+    R3SurfelBlock *block = ordered_blocks.Kth(i);
+    if (block->database != this) continue;
+    indices.push_back(block->database_index);
+  }
+  std::sort(indices.begin(), indices.end());
+
+  // Put blocks at those indices in the given order
+  int k = 0;
+  for (int i = 0; i < ordered_blocks.NEntries(); i++) {
+    R3SurfelBlock *block = ordered_blocks.Kth(i);
+    if (block->database != this) continue;
+    blocks.EntryContents(blocks.KthEntry(indices[k])) = block;
+    block->database_index = indices[k++];
+  }
+
+  // Unlock database
+  mutex.Unlock();
+}
+
+
+
 int R3SurfelDatabase::
 OpenFile(const char *filename, const char *rwaccess)
 {
@@ -1196,6 +1277,7 @@ CloseFile(void)
   if (!SyncFile()) return 0;
 
   // Close file
+  RNFileCloseReadAt(fp);
   fclose(fp);
   fp = NULL;
 
@@ -12,6 +12,15 @@ namespace gaps {
 
 
 
+////////////////////////////////////////////////////////////////////////
+// CONSTANTS
+////////////////////////////////////////////////////////////////////////
+
+// Number of locks guarding block residency (blocks hash into them)
+#define R3_SURFEL_DATABASE_BLOCK_MUTEXES 64
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // CLASS DEFINITION
 ////////////////////////////////////////////////////////////////////////
@@ -149,11 +158,15 @@ public:
 
   // Internal block manipulation functions
   virtual int PurgeDeletedBlocks(void);
+  void ReorderBlocks(const RNArray<R3SurfelBlock *>& ordered_blocks);
 
   // Internal surfel size functions
   int NBytesPerSurfel(void) const;
 
 protected:
+  // Internal block residency functions
+  RNMutex& BlockMutex(R3SurfelBlock *block);
+
   // Internal block I/O functions
   virtual int InternalReadBlock(R3SurfelBlock *block, FILE *fp, int swap_endian);
   virtual int InternalReleaseBlock(R3SurfelBlock *block, FILE *fp, int swap_endian);
@@ -192,7 +205,11 @@ protected:
   char *name;
   friend class R3SurfelTree;
   R3SurfelTree *tree;
-  unsigned long resident_surfels;
+  std::atomic<unsigned long> resident_surfels;
+  std::atomic<int> file_dirty;
+  RNMutex block_mutexes[R3_SURFEL_DATABASE_BLOCK_MUTEXES];
+  RNMutex file_mutex;
+  RNMutex mutex;
 };
 
 
@@ -335,17 +352,40 @@ SetMaxIdentifier(unsigned int identifier)
 
 
 
+inline RNMutex& R3SurfelDatabase::
+BlockMutex(R3SurfelBlock *block)
+{
+  // Return lock guarding residency of block (shared by blocks with same hash)
+  unsigned long long key = (unsigned long long) block;
+  return block_mutexes[(key >> 6) % R3_SURFEL_DATABASE_BLOCK_MUTEXES];
+}
+
+
+
 inline int R3SurfelDatabase::
 ReadBlock(R3SurfelBlock *block)
 {
+  // Increment reference count without locking if block is already resident
+  unsigned int count = block->file_read_count;
+  while (count > 0) {
+    if (block->file_read_count.compare_exchange_weak(count, count + 1)) return 1;
+  }
+
+  // Lock residency of block
+  RNMutex& block_mutex = BlockMutex(block);
+  block_mutex.Lock();
+
   // Check whether block needs to be read
   if (block->file_read_count == 0) {
-    if (!InternalReadBlock(block, fp, swap_endian)) return 0;
+    if (!InternalReadBlock(block, fp, swap_endian)) { block_mutex.Unlock(); return 0; }
   }
 
   // Increment reference count
   block->file_read_count++;
 
+  // Unlock residency of block
+  block_mutex.Unlock();
+
   // Return success
   return 1;
 }
@@ -355,22 +395,42 @@ ReadBlock(R3SurfelBlock *block)
 inline int R3SurfelDatabase::
 ReleaseBlock(R3SurfelBlock *block)
 {
-  // Check whether block needs to be written
-  if (block->file_read_count == 1) {
-    if (!InternalReleaseBlock(block, fp, swap_endian)) return 0;
+  // Decrement reference count without locking if other references remain
+  unsigned int count = block->file_read_count;
+  while (count > 1) {
+    if (block->file_read_count.compare_exchange_weak(count, count - 1)) return 1;
   }
 
+  // Lock residency of block
+  RNMutex& block_mutex = BlockMutex(block);
+  block_mutex.Lock();
+
   // Decrement reference count
-  block->file_read_count--;
+  // (once it is zero, other threads must wait on the lock to read the block)
+  RNBoolean delete_pending = FALSE;
+  if (--block->file_read_count == 0) {
+    // Write block and free surfels
+    if (!InternalReleaseBlock(block, fp, swap_endian)) {
+      block->file_read_count++;
+      block_mutex.Unlock();
+      return 0;
+    }
 
-  // Check if delete pending
-  if (block->file_read_count == 0) {
+    // Check if delete pending
     if (block->flags[R3_SURFEL_BLOCK_DELETE_PENDING_FLAG]) {
-      RemoveBlock(block);
-      delete block;
+      delete_pending = TRUE;
     }
   }
 
+  // Unlock residency of block
+  block_mutex.Unlock();
+
+  // Execute pending delete
+  if (delete_pending) {
+    RemoveBlock(block);
+    delete block;
+  }
+
   // Return success
   return 1;
 }
@@ -0,0 +1,582 @@
+/* Source file for the R3 surfel ingester class */
+
+
+
+////////////////////////////////////////////////////////////////////////
+// INCLUDE FILES
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Surfels.h"
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Namespace
+////////////////////////////////////////////////////////////////////////
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// CONSTRUCTORS/DESTRUCTORS
+////////////////////////////////////////////////////////////////////////
+
+R3SurfelIngester::
+R3SurfelIngester(R3SurfelScene *scene, R3SurfelNode *parent_node,
+  RNLength tile_size, const char *tile_prefix)
+  : scene(scene),
+    parent_node(parent_node),
+    tile_size(tile_size),
+    tile_prefix(NULL),
+    tiles(),
+    last_tile(NULL),
+    nsurfels(0),
+    nbuffered_surfels(0),
+    max_buffered_surfels(16 * 1024 * 1024),
+    max_tile_surfels(4 * 1024 * 1024),
+    max_block_surfels(4096),
+    npieces(0)
+{
+  // Determine prefix for temporary tile files
+  if (tile_prefix) {
+    this->tile_prefix = RNStrdup(tile_prefix);
+  }
+  else {
+    const char *database_filename = scene->Tree()->Database()->Filename();
+    this->tile_prefix = RNStrdup((database_filename) ? database_filename : "surfels");
+  }
+}
+
+
+
+R3SurfelIngester::
+~R3SurfelIngester(void)
+{
+  // Delete tiles (and their temporary files)
+  std::map<std::pair<int, int>, Tile *>::iterator it;
+  for (it = tiles.begin(); it != tiles.end(); it++) {
+    Tile *tile = it->second;
+    if ((tile->nfile_surfels > 0) && tile->remove_file) remove(tile->filename);
+    for (int i = 0; i < tile->blocks.NEntries(); i++) delete tile->blocks.Kth(i);
+    delete tile;
+  }
+
+  // Delete tile prefix
+  if (tile_prefix) free(tile_prefix);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// SURFEL INSERTION FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+int R3SurfelIngester::
+InsertSurfels(const R3Surfel *surfels, int nsurfels,
+  const R3Point& position_origin, RNScalar timestamp_origin)
+{
+  // Check tile size
+  if (tile_size <= 0) {
+    RNFail("Invalid tile size for surfel ingestion: %g\n", tile_size);
+    return 0;
+  }
+
+  // Bin surfels into tiles
+  for (int i = 0; i < nsurfels; i++) {
+    const R3Surfel& surfel = surfels[i];
+
+    // Find tile
+    RNCoord x = position_origin.X() + surfel.X();
+    RNCoord y = position_origin.Y() + surfel.Y();
+    RNCoord z = position_origin.Z() + surfel.Z();
+    int ix = (int) floor(x / tile_size);
+    int iy = (int) floor(y / tile_size);
+    Tile *tile = FindTile(ix, iy, timestamp_origin);
+    if (!tile) return 0;
+
+    // Insert copy of surfel relative to tile origin
+    R3Surfel copy = surfel;
+    copy.SetPosition(x - tile->position_origin.X(),
+      y - tile->position_origin.Y(), z - tile->position_origin.Z());
+    copy.SetTimestamp(timestamp_origin + surfel.Timestamp() - tile->timestamp_origin);
+    tile->buffer.push_back(copy);
+  }
+
+  // Update statistics
+  this->nsurfels += nsurfels;
+  this->nbuffered_surfels += nsurfels;
+
+  // Spill tiles to disk if buffered too many surfels
+  if (nbuffered_surfels > max_buffered_surfels) {
+    if (!FlushTiles()) return 0;
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+int R3SurfelIngester::
+InsertBlock(const R3SurfelBlock *block)
+{
+  // Insert surfels of block
+  return InsertSurfels(block->Surfels(), block->NSurfels(),
+    block->PositionOrigin(), block->TimestampOrigin());
+}
+
+
+
+int R3SurfelIngester::
+InsertFile(const char *filename)
+{
+  // Read block from file
+  R3SurfelBlock block;
+  if (!block.ReadFile(filename)) return 0;
+
+  // Insert surfels of block
+  return InsertBlock(&block);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// FINISH FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+static void
+DeletePieces(std::vector<R3SurfelIngester::Tile *>& pieces)
+{
+  // Delete pieces of split tiles (and their temporary files)
+  for (unsigned int i = 0; i < pieces.size(); i++) {
+    R3SurfelIngester::Tile *piece = pieces[i];
+    if ((piece->nfile_surfels > 0) && piece->remove_file) remove(piece->filename);
+    for (int j = 0; j < piece->blocks.NEntries(); j++) delete piece->blocks.Kth(j);
+    delete piece;
+  }
+
+  // Empty array of pieces
+  pieces.clear();
+}
+
+
+
+int R3SurfelIngester::
+Finish(void)
+{
+  // Process tiles (or pieces of split tiles) in batches holding
+  // at most max_buffered_surfels, so that memory use is bounded
+  std::vector<Tile *> pieces;
+  RNArray<Tile *> batch;
+  unsigned long long batch_nsurfels = 0;
+  std::map<std::pair<int, int>, Tile *>::iterator it;
+  for (it = tiles.begin(); it != tiles.end(); it++) {
+    // Split tile with too many surfels into pieces
+    Tile *tile = it->second;
+    unsigned int first_piece = pieces.size();
+    if (!SplitTile(tile, pieces)) { DeletePieces(pieces); return 0; }
+    RNArray<Tile *> tile_pieces;
+    if (pieces.size() == first_piece) tile_pieces.Insert(tile);
+    for (unsigned int i = first_piece; i < pieces.size(); i++) tile_pieces.Insert(pieces[i]);
+
+    // Insert tile pieces into batches
+    for (int i = 0; i < tile_pieces.NEntries(); i++) {
+      Tile *piece = tile_pieces.Kth(i);
+      unsigned long long piece_nsurfels = piece->nfile_surfels + piece->buffer.size();
+      if (!batch.IsEmpty() && (batch_nsurfels + piece_nsurfels > max_buffered_surfels)) {
+        if (!FinishTiles(batch)) { DeletePieces(pieces); return 0; }
+        batch.Empty();
+        batch_nsurfels = 0;
+      }
+      batch.Insert(piece);
+      batch_nsurfels += piece_nsurfels;
+    }
+  }
+
+  // Process last batch
+  if (!batch.IsEmpty()) {
+    if (!FinishTiles(batch)) { DeletePieces(pieces); return 0; }
+  }
+
+  // Delete pieces of split tiles
+  DeletePieces(pieces);
+
+  // Delete tiles
+  for (it = tiles.begin(); it != tiles.end(); it++) delete it->second;
+  tiles.clear();
+  last_tile = NULL;
+  nbuffered_surfels = 0;
+
+  // Return success
+  return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// INTERNAL TILE FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+R3SurfelIngester::Tile *R3SurfelIngester::
+FindTile(int ix, int iy, RNScalar timestamp_origin)
+{
+  // Check most recent tile (consecutive surfels are usually nearby)
+  if (last_tile && (last_tile->ix == ix) && (last_tile->iy == iy)) return last_tile;
+
+  // Find existing tile
+  std::pair<int, int> key(ix, iy);
+  std::map<std::pair<int, int>, Tile *>::iterator it = tiles.find(key);
+  if (it != tiles.end()) { last_tile = it->second; return last_tile; }
+
+  // Create new tile
+  Tile *tile = new Tile();
+  if (!tile) {
+    RNFail("Unable to allocate tile\n");
+    return NULL;
+  }
+
+  // Initialize tile
+  tile->ix = ix;
+  tile->iy = iy;
+  tile->position_origin.Reset(ix * tile_size, iy * tile_size, 0);
+  tile->timestamp_origin = timestamp_origin;
+  tile->nfile_surfels = 0;
+  tile->file_offset = 0;
+  tile->max_block_surfels = max_block_surfels;
+  tile->remove_file = TRUE;
+  tile->region_x = 0;
+  tile->region_y = 0;
+  tile->region_size = tile_size;
+  tile->depth = 0;
+  tile->root = tile;
+  tile->node = NULL;
+  tile->status = 1;
+  snprintf(tile->filename, sizeof(tile->filename), "%s.%d_%d.tile", tile_prefix, ix, iy);
+
+  // Insert tile
+  tiles[key] = tile;
+  last_tile = tile;
+
+  // Return tile
+  return tile;
+}
+
+
+
+int R3SurfelIngester::
+FlushTile(Tile *tile)
+{
+  // Check buffer
+  if (tile->buffer.empty()) return 1;
+
+  // Open file
+  FILE *fp = fopen(tile->filename, (tile->nfile_surfels > 0) ? "ab" : "wb");
+  if (!fp) {
+    RNFail("Unable to open tile file %s\n", tile->filename);
+    return 0;
+  }
+
+  // Write surfels
+  size_t count = tile->buffer.size();
+  if (fwrite(&tile->buffer[0], sizeof(R3Surfel), count, fp) != count) {
+    RNFail("Unable to write tile file %s\n", tile->filename);
+    fclose(fp);
+    return 0;
+  }
+
+  // Close file
+  fclose(fp);
+
+  // Release buffer memory
+  tile->nfile_surfels += count;
+  std::vector<R3Surfel>().swap(tile->buffer);
+
+  // Return success
+  return 1;
+}
+
+
+
+int R3SurfelIngester::
+FlushTiles(void)
+{
+  // Append buffered surfels of every tile to its temporary file
+  std::map<std::pair<int, int>, Tile *>::iterator it;
+  for (it = tiles.begin(); it != tiles.end(); it++) {
+    if (!FlushTile(it->second)) return 0;
+  }
+
+  // Reset number of buffered surfels
+  nbuffered_surfels = 0;
+
+  // Return success
+  return 1;
+}
+
+
+
+int R3SurfelIngester::
+SplitTile(Tile *tile, std::vector<Tile *>& pieces)
+{
+  // Check if tile is small enough to sort in memory
+  unsigned long long max_piece_surfels = max_tile_surfels;
+  if (max_piece_surfels > max_buffered_surfels) max_piece_surfels = max_buffered_surfels;
+  if (max_piece_surfels < 1) max_piece_surfels = 1;
+  if (tile->nfile_surfels + tile->buffer.size() <= max_piece_surfels) return 1;
+
+  // Move all surfels to file
+  if (!FlushTile(tile)) return 0;
+  unsigned long long nsurfels = tile->nfile_surfels;
+
+  // Split into consecutive chunks if quadrants are too small to help
+  const int max_depth = 8;
+  if (tile->depth >= max_depth) {
+    for (unsigned long long start = 0; start < nsurfels; start += max_piece_surfels) {
+      Tile *chunk = new Tile(*tile);
+      chunk->file_offset = tile->file_offset + start;
+      chunk->nfile_surfels = nsurfels - start;
+      if (chunk->nfile_surfels > max_piece_surfels) chunk->nfile_surfels = max_piece_surfels;
+      chunk->remove_file = (start + chunk->nfile_surfels == nsurfels) ? tile->remove_file : FALSE;
+      pieces.push_back(chunk);
+    }
+    tile->nfile_surfels = 0;
+    return 1;
+  }
+
+  // Create quadrants
+  Tile *quadrants[4];
+  RNCoord half_size = 0.5 * tile->region_size;
+  for (int i = 0; i < 4; i++) {
+    Tile *quadrant = new Tile(*tile);
+    quadrant->nfile_surfels = 0;
+    quadrant->file_offset = 0;
+    quadrant->remove_file = TRUE;
+    quadrant->region_x = tile->region_x + ((i & 1) ? half_size : 0);
+    quadrant->region_y = tile->region_y + ((i & 2) ? half_size : 0);
+    quadrant->region_size = half_size;
+    quadrant->depth = tile->depth + 1;
+    snprintf(quadrant->filename, sizeof(quadrant->filename), "%s.%d_%d.%d.tile",
+      tile_prefix, tile->ix, tile->iy, npieces++);
+    quadrants[i] = quadrant;
+  }
+
+  // Distribute surfels to quadrants in chunks
+  int status = 1;
+  FILE *fp = fopen(tile->filename, "rb");
+  if (!fp) {
+    RNFail("Unable to open tile file %s\n", tile->filename);
+    status = 0;
+  }
+  else {
+    const unsigned long long chunk_size = 64 * 1024;
+    std::vector<R3Surfel> chunk(chunk_size);
+    RNFileSeek(fp, tile->file_offset * sizeof(R3Surfel), RN_FILE_SEEK_SET);
+    for (unsigned long long start = 0; status && (start < nsurfels); start += chunk_size) {
+      size_t count = (nsurfels - start < chunk_size) ? (size_t) (nsurfels - start) : (size_t) chunk_size;
+      if (fread(&chunk[0], sizeof(R3Surfel), count, fp) != count) {
+        RNFail("Unable to read tile file %s\n", tile->filename);
+        status = 0;
+        break;
+      }
+      for (size_t i = 0; i < count; i++) {
+        int qx = (chunk[i].X() >= tile->region_x + half_size) ? 1 : 0;
+        int qy = (chunk[i].Y() >= tile->region_y + half_size) ? 2 : 0;
+        quadrants[qx + qy]->buffer.push_back(chunk[i]);
+      }
+      for (int i = 0; i < 4; i++) {
+        if (!FlushTile(quadrants[i])) { status = 0; break; }
+      }
+    }
+    fclose(fp);
+  }
+
+  // Remove tile file (its surfels are now in the quadrant files)
+  if (status && tile->remove_file) remove(tile->filename);
+  if (status) tile->nfile_surfels = 0;
+
+  // Split quadrants recursively
+  for (int i = 0; i < 4; i++) {
+    Tile *quadrant = quadrants[i];
+    if (status && (quadrant->nfile_surfels > 0)) {
+      unsigned int first_piece = pieces.size();
+      if (!SplitTile(quadrant, pieces)) status = 0;
+      else if (pieces.size() == first_piece) { pieces.push_back(quadrant); continue; }
+    }
+    if (quadrant->nfile_surfels > 0) remove(quadrant->filename);
+    delete quadrant;
+  }
+
+  // Return status
+  return status;
+}
+
+
+
+struct R3SurfelIngesterSortEntry {
+  RNUInt64 key;
+  unsigned long long index;
+  bool operator<(const R3SurfelIngesterSortEntry& entry) const { return key < entry.key; }
+};
+
+
+
+static RNUInt64
+R3SurfelIngesterSpreadBits(RNUInt64 v)
+{
+  // Spread lower 21 bits of v so that there are two zeros between each bit
+  v &= 0x1FFFFF;
+  v = (v | (v << 32)) & 0x1F00000000FFFFULL;
+  v = (v | (v << 16)) & 0x1F0000FF0000FFULL;
+  v = (v | (v << 8)) & 0x100F00F00F00F00FULL;
+  v = (v | (v << 4)) & 0x10C30C30C30C30C3ULL;
+  v = (v | (v << 2)) & 0x1249249249249249ULL;
+  return v;
+}
+
+
+
+static void
+R3SurfelIngesterFinishTile(void *data)
+{
+  // Get tile
+  R3SurfelIngester::Tile *tile = (R3SurfelIngester::Tile *) data;
+  unsigned long long nsurfels = tile->nfile_surfels + tile->buffer.size();
+  if (nsurfels == 0) return;
+
+  // Allocate surfels
+  R3Surfel *surfels = new R3Surfel [ nsurfels ];
+
+  // Read surfels spilled to file (file is removed after all tiles of batch are finished)
+  if (tile->nfile_surfels > 0) {
+    FILE *fp = fopen(tile->filename, "rb");
+    if (!fp) {
+      RNFail("Unable to open tile file %s\n", tile->filename);
+      tile->status = 0;
+      delete [] surfels;
+      return;
+    }
+    RNFileSeek(fp, tile->file_offset * sizeof(R3Surfel), RN_FILE_SEEK_SET);
+    if (fread(surfels, sizeof(R3Surfel), tile->nfile_surfels, fp) != tile->nfile_surfels) {
+      RNFail("Unable to read tile file %s\n", tile->filename);
+      tile->status = 0;
+    }
+    fclose(fp);
+  }
+
+  // Copy surfels still buffered in memory
+  for (unsigned int i = 0; i < tile->buffer.size(); i++) {
+    surfels[tile->nfile_surfels + i] = tile->buffer[i];
+  }
+  std::vector<R3Surfel>().swap(tile->buffer);
+  if (!tile->status) { delete [] surfels; return; }
+
+  // Compute bounding box of surfels
+  R3Box bbox = R3null_box;
+  for (unsigned long long i = 0; i < nsurfels; i++) {
+    bbox.Union(R3Point(surfels[i].X(), surfels[i].Y(), surfels[i].Z()));
+  }
+
+  // Sort surfels along a Z-order curve (so that blocks are spatially compact)
+  RNLength extent = bbox.LongestAxisLength();
+  RNScalar scale = (extent > 0) ? 2097151.0 / extent : 0;
+  std::vector<R3SurfelIngesterSortEntry> entries(nsurfels);
+  for (unsigned long long i = 0; i < nsurfels; i++) {
+    RNUInt64 qx = (RNUInt64) (scale * (surfels[i].X() - bbox.XMin()));
+    RNUInt64 qy = (RNUInt64) (scale * (surfels[i].Y() - bbox.YMin()));
+    RNUInt64 qz = (RNUInt64) (scale * (surfels[i].Z() - bbox.ZMin()));
+    entries[i].key = R3SurfelIngesterSpreadBits(qx) |
+      (R3SurfelIngesterSpreadBits(qy) << 1) | (R3SurfelIngesterSpreadBits(qz) << 2);
+    entries[i].index = i;
+  }
+  std::stable_sort(entries.begin(), entries.end());
+
+  // Create blocks from consecutive runs of sorted surfels
+  unsigned long long max_block_surfels = nsurfels;
+  if ((tile->max_block_surfels > 0) && ((unsigned long long) tile->max_block_surfels < max_block_surfels)) max_block_surfels = tile->max_block_surfels;
+  if (max_block_surfels > INT_MAX) max_block_surfels = INT_MAX;
+  R3Surfel *block_surfels = new R3Surfel [ max_block_surfels ];
+  for (unsigned long long start = 0; start < nsurfels; start += max_block_surfels) {
+    int count = (int) max_block_surfels;
+    if (start + count > nsurfels) count = (int) (nsurfels - start);
+    for (int i = 0; i < count; i++) block_surfels[i] = surfels[entries[start + i].index];
+    R3SurfelBlock *block = new R3SurfelBlock(block_surfels, count, tile->position_origin, tile->timestamp_origin);
+    block->UpdateProperties();
+    tile->blocks.Insert(block);
+  }
+
+  // Delete temporary memory
+  delete [] block_surfels;
+  delete [] surfels;
+}
+
+
+
+int R3SurfelIngester::
+FinishTiles(const RNArray<Tile *>& batch)
+{
+  // Get convenient variables
+  R3SurfelTree *tree = scene->Tree();
+  R3SurfelDatabase *database = tree->Database();
+
+  // Read, sort, and split tiles into blocks in parallel
+  RNTaskGroup group;
+  for (int i = 0; i < batch.NEntries(); i++) {
+    group.Insert(R3SurfelIngesterFinishTile, batch.Kth(i));
+  }
+  group.Wait();
+
+  // Remove temporary files
+  for (int i = 0; i < batch.NEntries(); i++) {
+    Tile *tile = batch.Kth(i);
+    if ((tile->nfile_surfels > 0) && tile->remove_file) remove(tile->filename);
+    tile->nfile_surfels = 0;
+  }
+
+  // Check status
+  for (int i = 0; i < batch.NEntries(); i++) {
+    if (!batch.Kth(i)->status) return 0;
+  }
+
+  // Create nodes and write blocks sequentially
+  for (int i = 0; i < batch.NEntries(); i++) {
+    Tile *tile = batch.Kth(i);
+    if (tile->blocks.IsEmpty()) continue;
+
+    // Create node (pieces of a split tile share the node of their root tile)
+    Tile *root = (tile->root) ? tile->root : tile;
+    if (!root->node) {
+      char node_name[1024];
+      snprintf(node_name, sizeof(node_name), "%s_%d_%d", (parent_node->Name()) ? parent_node->Name() : "TILE", root->ix, root->iy);
+      root->node = new R3SurfelNode(node_name);
+      tree->InsertNode(root->node, parent_node);
+    }
+    R3SurfelNode *node = root->node;
+
+    // Insert blocks
+    for (int j = 0; j < tile->blocks.NEntries(); j++) {
+      R3SurfelBlock *block = tile->blocks.Kth(j);
+      database->InsertBlock(block);
+      node->InsertBlock(block);
+    }
+
+    // Update node properties
+    node->UpdateProperties();
+
+    // Release blocks (writes them to the database file and frees surfels)
+    for (int j = 0; j < tile->blocks.NEntries(); j++) {
+      R3SurfelBlock *block = tile->blocks.Kth(j);
+      database->ReleaseBlock(block);
+    }
+
+    // Empty array of blocks (now owned by database)
+    tile->blocks.Empty();
+  }
+
+  // Return success
+  return 1;
+}
+
+
+
+} // namespace gaps
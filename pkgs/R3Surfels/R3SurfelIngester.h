@@ -0,0 +1,249 @@
+/* Include file for the R3 surfel ingester class */
+#ifndef __R3__SURFEL__INGESTER__H__
+#define __R3__SURFEL__INGESTER__H__
+
+
+
+////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+////////////////////////////////////////////////////////////////////////
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// CLASS DEFINITION
+////////////////////////////////////////////////////////////////////////
+
+// Streams surfels into a scene with bounded memory:
+// surfels are binned into square tiles (in XY) that are spilled to
+// temporary files on disk, and then Finish sorts the tiles in parallel,
+// splits them into blocks, and writes one node per tile sequentially.
+// Tiles with more than MaxTileSurfels surfels are split into quadrants
+// on disk (or into consecutive chunks if that fails to divide them), and
+// tiles are sorted in parallel only while the total number of surfels
+// they hold stays under MaxBufferedSurfels.
+
+class R3SurfelIngester {
+public:
+  //////////////////////////////////////////
+  //// CONSTRUCTOR/DESTRUCTOR FUNCTIONS ////
+  //////////////////////////////////////////
+
+  // Constructor functions
+  R3SurfelIngester(R3SurfelScene *scene, R3SurfelNode *parent_node,
+    RNLength tile_size = 32, const char *tile_prefix = NULL);
+
+  // Destructor function
+  ~R3SurfelIngester(void);
+
+
+  ////////////////////////////
+  //// PROPERTY FUNCTIONS ////
+  ////////////////////////////
+
+  // Scene access functions
+  R3SurfelScene *Scene(void) const;
+  R3SurfelNode *ParentNode(void) const;
+
+  // Tile property functions
+  RNLength TileSize(void) const;
+  int NTiles(void) const;
+
+  // Statistics functions
+  unsigned long long NSurfels(void) const;
+  unsigned long long NBufferedSurfels(void) const;
+
+  // Parameter functions
+  int MaxBlockSurfels(void) const;
+  unsigned long long MaxTileSurfels(void) const;
+  unsigned long long MaxBufferedSurfels(void) const;
+
+
+  ////////////////////////////////
+  //// MANIPULATION FUNCTIONS ////
+  ////////////////////////////////
+
+  // Parameter manipulation functions
+  void SetMaxBlockSurfels(int max_block_surfels);
+  void SetMaxTileSurfels(unsigned long long max_tile_surfels);
+  void SetMaxBufferedSurfels(unsigned long long max_buffered_surfels);
+
+  // Surfel insertion functions
+  int InsertSurfels(const R3Surfel *surfels, int nsurfels,
+    const R3Point& position_origin = R3zero_point, RNScalar timestamp_origin = 0);
+  int InsertBlock(const R3SurfelBlock *block);
+  int InsertFile(const char *filename);
+
+  // Create nodes and blocks for all inserted surfels
+  int Finish(void);
+
+
+  ////////////////////////////////////////////////////////////////////////
+  // INTERNAL STUFF BELOW HERE
+  ////////////////////////////////////////////////////////////////////////
+
+public:
+  // Internal tile type (also used for pieces of split tiles)
+  struct Tile {
+    int ix, iy;
+    R3Point position_origin;
+    RNScalar timestamp_origin;
+    std::vector<R3Surfel> buffer;
+    unsigned long long nfile_surfels;
+    unsigned long long file_offset;
+    RNArray<R3SurfelBlock *> blocks;
+    int max_block_surfels;
+    char filename[1024];
+    RNBoolean remove_file;
+    RNCoord region_x, region_y, region_size;
+    int depth;
+    Tile *root;
+    R3SurfelNode *node;
+    int status;
+  };
+
+protected:
+  // Internal tile functions
+  Tile *FindTile(int ix, int iy, RNScalar timestamp_origin);
+  int FlushTile(Tile *tile);
+  int FlushTiles(void);
+  int SplitTile(Tile *tile, std::vector<Tile *>& pieces);
+  int FinishTiles(const RNArray<Tile *>& tiles);
+
+private:
+  R3SurfelScene *scene;
+  R3SurfelNode *parent_node;
+  RNLength tile_size;
+  char *tile_prefix;
+  std::map<std::pair<int, int>, Tile *> tiles;
+  Tile *last_tile;
+  unsigned long long nsurfels;
+  unsigned long long nbuffered_surfels;
+  unsigned long long max_buffered_surfels;
+  unsigned long long max_tile_surfels;
+  int max_block_surfels;
+  int npieces;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// INLINE FUNCTION DEFINITIONS
+////////////////////////////////////////////////////////////////////////
+
+inline R3SurfelScene *R3SurfelIngester::
+Scene(void) const
+{
+  // Return scene
+  return scene;
+}
+
+
+
+inline R3SurfelNode *R3SurfelIngester::
+ParentNode(void) const
+{
+  // Return node under which tile nodes are created
+  return parent_node;
+}
+
+
+
+inline RNLength R3SurfelIngester::
+TileSize(void) const
+{
+  // Return width of tiles in X and Y
+  return tile_size;
+}
+
+
+
+inline int R3SurfelIngester::
+NTiles(void) const
+{
+  // Return number of tiles with surfels
+  return (int) tiles.size();
+}
+
+
+
+inline unsigned long long R3SurfelIngester::
+NSurfels(void) const
+{
+  // Return number of surfels inserted
+  return nsurfels;
+}
+
+
+
+inline unsigned long long R3SurfelIngester::
+NBufferedSurfels(void) const
+{
+  // Return number of surfels currently buffered in memory
+  return nbuffered_surfels;
+}
+
+
+
+inline int R3SurfelIngester::
+MaxBlockSurfels(void) const
+{
+  // Return maximum number of surfels per block
+  return max_block_surfels;
+}
+
+
+
+inline unsigned long long R3SurfelIngester::
+MaxTileSurfels(void) const
+{
+  // Return maximum number of surfels sorted at once for one tile
+  return max_tile_surfels;
+}
+
+
+
+inline unsigned long long R3SurfelIngester::
+MaxBufferedSurfels(void) const
+{
+  // Return maximum number of surfels buffered before spilling tiles to disk
+  return max_buffered_surfels;
+}
+
+
+
+inline void R3SurfelIngester::
+SetMaxBlockSurfels(int max_block_surfels)
+{
+  // Set maximum number of surfels per block
+  this->max_block_surfels = max_block_surfels;
+}
+
+
+
+inline void R3SurfelIngester::
+SetMaxTileSurfels(unsigned long long max_tile_surfels)
+{
+  // Set maximum number of surfels sorted at once for one tile
+  this->max_tile_surfels = max_tile_surfels;
+}
+
+
+
+inline void R3SurfelIngester::
+SetMaxBufferedSurfels(unsigned long long max_buffered_surfels)
+{
+  // Set maximum number of surfels buffered before spilling tiles to disk
+  this->max_buffered_surfels = max_buffered_surfels;
+}
+
+
+
+// End namespace
+}
+
+
+// End include guard
+#endif
@@ -25,10 +25,14 @@ namespace gaps {
 R3SurfelPointGraph::
 R3SurfelPointGraph(void)
   : set(),
-    neighbors(NULL),
+    neighbor_offsets(NULL),
+    neighbor_indices(NULL),
     max_neighbors(0),
     max_distance(-1)
 {
+  // Initialize neighbor offsets
+  neighbor_offsets = new int [ 1 ];
+  neighbor_offsets[0] = 0;
 }
 
 
@@ -36,17 +40,18 @@ R3SurfelPointGraph(void)
 R3SurfelPointGraph::
 R3SurfelPointGraph(const R3SurfelPointGraph& graph)
   : set(graph.set),
-    neighbors(NULL),
+    neighbor_offsets(NULL),
+    neighbor_indices(NULL),
     max_neighbors(graph.max_neighbors),
     max_distance(graph.max_distance)
 {
   // Copy neighbors
-  neighbors = new RNArray<R3SurfelPoint *> [ NPoints() ];
-  for (int i = 0; i < NPoints(); i++) {
-    neighbors[i].Resize(graph.neighbors[i].NEntries());
-    for (int j = 0; j < graph.neighbors[i].NEntries(); j++) {
-      neighbors[i].Insert(graph.neighbors[i][j]);
-    }
+  int nindices = graph.neighbor_offsets[NPoints()];
+  neighbor_offsets = new int [ NPoints() + 1 ];
+  for (int i = 0; i <= NPoints(); i++) neighbor_offsets[i] = graph.neighbor_offsets[i];
+  if (nindices > 0) {
+    neighbor_indices = new int [ nindices ];
+    for (int i = 0; i < nindices; i++) neighbor_indices[i] = graph.neighbor_indices[i];
   }
 }
 
@@ -55,20 +60,42 @@ R3SurfelPointGraph(const R3SurfelPointGraph& graph)
 R3SurfelPointGraph::
 R3SurfelPointGraph(const R3SurfelPointSet& set, int max_neighbors, RNLength max_distance)
   : set(set),
-    neighbors(NULL),
+    neighbor_offsets(NULL),
+    neighbor_indices(NULL),
     max_neighbors(max_neighbors),
     max_distance(max_distance)
 {
-  // Allocate neighbors
-  neighbors = new RNArray<R3SurfelPoint *> [ NPoints() ];
-
-  // Find neighbors with kdtree
-  RNArray<R3SurfelPoint *> points;
-  for (int i = 0; i < NPoints(); i++) points.Insert(Point(i));
-  R3Kdtree<R3SurfelPoint *> kdtree(points, SurfelPointPosition, NULL);
-  for (int i = 0; i < NPoints(); i++) {
-    kdtree.FindClosest(Point(i), 0, max_distance, max_neighbors, neighbors[i]);
+  // Allocate neighbor offsets
+  neighbor_offsets = new int [ NPoints() + 1 ];
+  for (int i = 0; i <= NPoints(); i++) neighbor_offsets[i] = 0;
+  if ((NPoints() == 0) || (max_neighbors <= 0)) return;
+
+  // Build kdtree
+  R3Point *positions = new R3Point [ NPoints() ];
+  for (int i = 0; i < NPoints(); i++) positions[i] = Point(i)->Position();
+  R3StaticKdtree kdtree(positions, NPoints());
+
+  // Find neighbors of all points at once (in parallel)
+  int *closest = new int [ (size_t) NPoints() * max_neighbors ];
+  int *counts = new int [ NPoints() ];
+  kdtree.FindClosestBatch(positions, NPoints(), max_neighbors, max_distance, closest, NULL, counts);
+
+  // Pack neighbors into compressed rows
+  for (int i = 0; i < NPoints(); i++) neighbor_offsets[i+1] = neighbor_offsets[i] + counts[i];
+  int nindices = neighbor_offsets[NPoints()];
+  if (nindices > 0) {
+    neighbor_indices = new int [ nindices ];
+    for (int i = 0; i < NPoints(); i++) {
+      const int *point_closest = &closest[(size_t) i * max_neighbors];
+      int *point_neighbors = &neighbor_indices[neighbor_offsets[i]];
+      for (int j = 0; j < counts[i]; j++) point_neighbors[j] = point_closest[j];
+    }
   }
+
+  // Delete temporary data
+  delete [] positions;
+  delete [] closest;
+  delete [] counts;
 }
 
 
@@ -77,10 +104,8 @@ R3SurfelPointGraph::
 ~R3SurfelPointGraph(void)
 {
   // Delete neighbors
-  if (neighbors) {
-    delete [] neighbors;
-    neighbors = NULL;
-  }
+  if (neighbor_offsets) delete [] neighbor_offsets;
+  if (neighbor_indices) delete [] neighbor_indices;
 }
 
 
@@ -175,41 +200,47 @@ Draw(RNFlags flags) const
 ////////////////////////////////////////////////////////////////////////
 
 void R3SurfelPointGraph::
-UpdateNormals(void) const
+ComputeNormals(R3Vector *normals, R3Vector *tangents, RNScalar *variances) const
 {
-  // Declare variables (fill it only if needed)
-  R3Point *positions = NULL;
+  // Gather positions
+  if (NPoints() == 0) return;
+  R3Point *positions = new R3Point [ NPoints() ];
+  for (int i = 0; i < NPoints(); i++) positions[i] = Point(i)->Position();
 
-  // Compute normals for all points that don't already have them
-  for (int i = 0; i < NPoints(); i++) {
-    R3SurfelPoint *point = Point(i);
-    if (point->HasNormal()) continue;
+  // Compute normals with PCA of neighborhoods (in parallel)
+  R3EstimateNormals(NPoints(), positions, neighbor_offsets, neighbor_indices,
+    normals, tangents, variances);
 
-    // Allocate array of positions
-    if (!positions) {
-      positions = new R3Point [MaxNeighbors() + 1];
-      if (!positions) RNAbort("Unable to allocate positions to update normals");
-    }
+  // Delete positions
+  delete [] positions;
+}
 
-    // Create array of positions for neighborhood
-    int npositions = 0;
-    positions[npositions++] = point->Position();
-    for (int j = 0; j < NNeighbors(i); j++) {
-      R3SurfelPoint *neighbor = Neighbor(i, j);
-      positions[npositions++] = neighbor->Position();
-    }
 
-    // Compute normal with PCA of neighborhood
-    R3Point centroid = R3Centroid(npositions, positions);
-    R3Triad triad = R3PrincipleAxes(centroid, npositions, positions);
-    R3Vector normal = triad[2];
 
-    // Assign normal
-    point->SetNormal(normal);
+void R3SurfelPointGraph::
+UpdateNormals(void) const
+{
+  // Check if any point is missing a normal
+  int nmissing = 0;
+  for (int i = 0; i < NPoints(); i++) {
+    if (!Point(i)->HasNormal()) nmissing++;
+  }
+  if (nmissing == 0) return;
+
+  // Compute normals with PCA of neighborhoods
+  R3Vector *normals = new R3Vector [ NPoints() ];
+  ComputeNormals(normals);
+
+  // Assign normals for all points that don't already have them
+  for (int i = 0; i < NPoints(); i++) {
+    R3SurfelPoint *point = Point(i);
+    if (point->HasNormal()) continue;
+    if (normals[i].IsZero()) continue;
+    point->SetNormal(normals[i]);
   }
 
   // Delete data
-  if (positions) delete [] positions;
+  delete [] normals;
 }
 
 
@@ -253,25 +284,33 @@ RemoveOutlierEdges(RNScalar max_zscore)
     stddevs[i] = sqrt(variance);
   }
 
-  // Remove outlier edges
+  // Remove outlier edges (and pack remaining edges into compressed rows)
+  int nindices = 0;
   for (int i = 0; i < NPoints(); i++) {
-    if (stddevs[i] == 0) continue;
-    R3SurfelPoint *point0 = Point(i);
-    R3Point position0 = point0->Position();
-    for (int j = 0; j < neighbors[i].NEntries(); j++) {
-      R3SurfelPoint *point1 = neighbors[i].Kth(j);
-      R3Point position1 = point1->Position();
-      RNLength edge_length = R3Distance(position0, position1);
-      RNScalar zscore = (edge_length - means[i]) / stddevs[i];
-      if (zscore > max_zscore) {
-        // Remove edge
-        RNArrayEntry *entry = neighbors[i].KthEntry(j);
-        neighbors[i].EntryContents(entry) = neighbors[i].Tail();
-        neighbors[i].RemoveTail();
-        j--;
+    int *point_neighbors = &neighbor_indices[neighbor_offsets[i]];
+    int nneighbors = NNeighbors(i);
+    if (stddevs[i] > 0) {
+      R3SurfelPoint *point0 = Point(i);
+      R3Point position0 = point0->Position();
+      for (int j = 0; j < nneighbors; j++) {
+        R3SurfelPoint *point1 = Point(point_neighbors[j]);
+        R3Point position1 = point1->Position();
+        RNLength edge_length = R3Distance(position0, position1);
+        RNScalar zscore = (edge_length - means[i]) / stddevs[i];
+        if (zscore > max_zscore) {
+          // Remove edge
+          point_neighbors[j] = point_neighbors[nneighbors-1];
+          nneighbors--;
+          j--;
+        }
       }
     }
+    neighbor_offsets[i] = nindices;
+    for (int j = 0; j < nneighbors; j++) {
+      neighbor_indices[nindices++] = point_neighbors[j];
+    }
   }    
+  neighbor_offsets[NPoints()] = nindices;
 
   // Delete temporary memory for edge length statistics
   delete [] means;
@@ -56,6 +56,11 @@ public:
   // Surfel neighbor access functions
   int NNeighbors(int surfel_index) const;
   R3SurfelPoint *Neighbor(int surfel_index, int neighbor_index) const;
+  int NeighborIndex(int surfel_index, int neighbor_index) const;
+
+  // Neighbor index arrays (neighbors of point i are indices[offsets[i] ... offsets[i+1]-1])
+  const int *NeighborOffsets(void) const;
+  const int *NeighborIndices(void) const;
 
 
   //////////////////////////////////
@@ -89,6 +94,7 @@ public:
 
   // Update functions
   void UpdateNormals(void) const;
+  void ComputeNormals(R3Vector *normals, R3Vector *tangents = NULL, RNScalar *variances = NULL) const;
 
   // Test function
   void RemoveOutlierEdges(RNScalar zscore);
@@ -96,7 +102,8 @@ public:
 
 private:
   R3SurfelPointSet set;
-  RNArray<R3SurfelPoint *> *neighbors;
+  int *neighbor_offsets;
+  int *neighbor_indices;
   int max_neighbors;
   RNLength max_distance;
 };
@@ -184,7 +191,7 @@ inline int R3SurfelPointGraph::
 NNeighbors(int surfel_index) const
 {
   // Return number of neighbors
-  return neighbors[surfel_index].NEntries();
+  return neighbor_offsets[surfel_index+1] - neighbor_offsets[surfel_index];
 }
 
 
@@ -193,7 +200,34 @@ inline R3SurfelPoint *R3SurfelPointGraph::
 Neighbor(int surfel_index, int neighbor_index) const
 {
   // Return neighbor
-  return neighbors[surfel_index][neighbor_index];
+  return Point(NeighborIndex(surfel_index, neighbor_index));
+}
+
+
+
+inline int R3SurfelPointGraph::
+NeighborIndex(int surfel_index, int neighbor_index) const
+{
+  // Return index of neighbor
+  return neighbor_indices[neighbor_offsets[surfel_index] + neighbor_index];
+}
+
+
+
+inline const int *R3SurfelPointGraph::
+NeighborOffsets(void) const
+{
+  // Return offsets of neighbors of each point in neighbor indices
+  return neighbor_offsets;
+}
+
+
+
+inline const int *R3SurfelPointGraph::
+NeighborIndices(void) const
+{
+  // Return indices of neighbors of all points
+  return neighbor_indices;
 }
 
 
@@ -385,10 +385,14 @@ InsertPoints(R3SurfelBlock *block, const R3SurfelConstraint& constraint)
   // Read block
   if (block->database) block->database->ReadBlock(block);
 
+  // Check all surfels at once
+  std::vector<unsigned char> surfel_mask(block->NSurfels(), 1);
+  constraint.CheckSurfels(block, surfel_mask.data());
+
   // Copy points
   for (int i = 0; i < block->NSurfels(); i++) {
+    if (!surfel_mask[i]) continue;
     const R3Surfel *surfel = block->Surfel(i);
-    if (!constraint.Check(block, surfel)) continue;
     points[npoints].Reset(block, surfel);
     bbox.Union(points[npoints].Position());
     timestamp_range.Union(points[npoints].Timestamp());
@@ -1065,64 +1069,76 @@ WriteXYZFile(const char *filename) const
 void R3SurfelPointSet::
 UpdateNormals(RNScalar max_neighborhood_radius, int max_neighborhood_points) const
 {
-  // Declare variables (fill it only if needed)
-  R3Kdtree<R3SurfelPoint *> *kdtree = NULL;
-  RNArray<R3SurfelPoint *> neighbors;
-  R3Point pointset_centroid = Centroid();
-  R3Point *positions = NULL;
-
-  // Compute normals and radii for all points that don't already have them
+  // Order points so that ones without normals or radii are first
+  int *order = new int [ NPoints() ];
+  int nmissing = 0, nother = NPoints();
   for (int i = 0; i < NPoints(); i++) {
     R3SurfelPoint *point = Point(i);
-    if (point->HasNormal() && (point->Radius() > 0)) continue;
-
-    // Allocate kdtree
-    if (!kdtree) {
-      RNArray<R3SurfelPoint *> points;
-      for (int j = 0; j < NPoints(); j++) points.Insert(Point(j));
-      if (!kdtree) kdtree = new R3Kdtree<R3SurfelPoint *>(points, SurfelPointPosition, NULL);
-      if (!kdtree) RNAbort("Unable to allocate kdtree to update normals");
-    }
+    if (point->HasNormal() && (point->Radius() > 0)) order[--nother] = i;
+    else order[nmissing++] = i;
+  }
 
-    // Find neighbors with kdtree
-    neighbors.Truncate(0);
-    kdtree->FindClosest(point, 0, max_neighborhood_radius, max_neighborhood_points, neighbors);
-    if (neighbors.NEntries() < 3) continue;
+  // Check if there is anything to do
+  if ((nmissing == 0) || (max_neighborhood_points <= 0)) {
+    delete [] order;
+    return;
+  }
 
-    // Allocate array of positions
-    if (!positions) {
-      positions = new R3Point [max_neighborhood_points + 1];
-      if (!positions) RNAbort("Unable to allocate positions to update normals");
+  // Build kdtree
+  R3Point pointset_centroid = Centroid();
+  R3Point *positions = new R3Point [ NPoints() ];
+  for (int i = 0; i < NPoints(); i++) positions[i] = Point(order[i])->Position();
+  R3StaticKdtree kdtree(positions, NPoints());
+
+  // Find neighbors of all points without normals at once (in parallel)
+  int K = max_neighborhood_points;
+  int *neighbor_indices = new int [ (size_t) nmissing * K ];
+  RNLength *neighbor_distances = new RNLength [ (size_t) nmissing * K ];
+  int *neighbor_counts = new int [ nmissing ];
+  kdtree.FindClosestBatch(positions, nmissing, K, max_neighborhood_radius,
+    neighbor_indices, neighbor_distances, neighbor_counts);
+
+  // Pack neighbors into compressed rows (in place)
+  int *neighbor_offsets = new int [ nmissing + 1 ];
+  neighbor_offsets[0] = 0;
+  for (int i = 0; i < nmissing; i++) {
+    int offset = neighbor_offsets[i];
+    for (int j = 0; j < neighbor_counts[i]; j++) {
+      neighbor_indices[offset + j] = neighbor_indices[(size_t) i * K + j];
     }
+    neighbor_offsets[i+1] = offset + neighbor_counts[i];
+  }
 
-    // Create array of positions for neighborhood
-    int npositions = 0;
-    positions[npositions++] = point->Position();
-    for (int j = 0; j < neighbors.NEntries(); j++) {
-      R3SurfelPoint *neighbor = neighbors.Kth(j);
-      positions[npositions++] = neighbor->Position();
-    }
+  // Compute normals with PCA of neighborhoods (in parallel)
+  R3Vector *normals = new R3Vector [ nmissing ];
+  R3Vector *tangents = new R3Vector [ nmissing ];
+  RNScalar *variances = new RNScalar [ 3 * nmissing ];
+  R3EstimateNormals(nmissing, positions, neighbor_offsets, neighbor_indices,
+    normals, tangents, variances);
+
+  // Assign normals and radii for all points that don't already have them
+  for (int i = 0; i < nmissing; i++) {
+    R3SurfelPoint *point = Point(order[i]);
+    int nneighbors = neighbor_counts[i];
+    if (nneighbors < 3) continue;
 
     // Compute radius of neighborhood
-    int neighbor_index = (npositions <= 6) ? npositions-1 : 6;
-    RNScalar radius0 = R3Distance(positions[neighbor_index], point->Position());
+    int neighbor_index = (nneighbors < 6) ? nneighbors-1 : 5;
+    RNScalar radius0 = neighbor_distances[(size_t) i * K + neighbor_index];
     if (radius0 < RN_EPSILON) radius0 = RN_EPSILON;
-    
-    // Compute normal with PCA of neighborhood
-    RNScalar variances[3];
-    R3Point centroid = R3Centroid(npositions, positions);
-    R3Triad triad = R3PrincipleAxes(centroid, npositions, positions, NULL, variances);
-    R3Vector normal = triad[2];
-    R3Vector tangent = triad[0];
-    RNScalar aspect = (variances[0] > 0) ? sqrt(variances[1]/variances[0]) : 1;
+    RNScalar aspect = (variances[3*i+0] > 0) ? sqrt(variances[3*i+1]/variances[3*i+0]) : 1;
     RNScalar radius1 = aspect * radius0;
 
     // Flip normal
+    R3Vector normal = normals[i];
     R3SurfelBlock *block = point->Block();
     R3SurfelNode *node = block->Node();
     R3SurfelScan *scan = (node) ? node->Scan() : NULL;
     if (scan) {
       // Orient normal towards scan viewpoint
+      R3Point centroid = positions[i];
+      for (int j = neighbor_offsets[i]; j < neighbor_offsets[i+1]; j++) centroid += positions[neighbor_indices[j]];
+      centroid /= nneighbors + 1;
       R3Plane plane(centroid, normal);
       const R3Point& viewpoint = scan->Viewpoint();
       if (R3SignedDistance(plane, viewpoint) < 0) normal.Flip();
@@ -1136,16 +1152,23 @@ UpdateNormals(RNScalar max_neighborhood_radius, int max_neighborhood_points) con
     // Assign normal
     if (!point->HasNormal()) point->SetNormal(normal);
 
-    // Assign normal
-    if (!point->HasTangent()) point->SetTangent(tangent);
+    // Assign tangent
+    if (!point->HasTangent()) point->SetTangent(tangents[i]);
     
     // Assign radius
     if (point->Radius(0) == 0) point->SetRadius(radius0, radius1);
   }
 
   // Delete data
-  if (positions) delete [] positions;
-  if (kdtree) delete kdtree;
+  delete [] order;
+  delete [] positions;
+  delete [] neighbor_indices;
+  delete [] neighbor_distances;
+  delete [] neighbor_counts;
+  delete [] neighbor_offsets;
+  delete [] normals;
+  delete [] tangents;
+  delete [] variances;
 }
 
 
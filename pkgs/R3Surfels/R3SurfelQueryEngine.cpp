@@ -0,0 +1,707 @@
+/* Source file for the R3 surfel query engine class */
+
+
+
+////////////////////////////////////////////////////////////////////////
+// INCLUDE FILES
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Surfels.h"
+#include <queue>
+#include <set>
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Namespace
+////////////////////////////////////////////////////////////////////////
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constants
+////////////////////////////////////////////////////////////////////////
+
+// Maximum number of surfels in a leaf range of a block index
+static const int R3surfel_query_leaf_size = 16;
+
+
+
+////////////////////////////////////////////////////////////////////////
+// CONSTRUCTORS/DESTRUCTORS
+////////////////////////////////////////////////////////////////////////
+
+static void
+UpdateBoundingBoxes(R3SurfelNode *node)
+{
+  // Compute cached bounding boxes now, so that concurrent queries only read them
+  node->BBox();
+  for (int i = 0; i < node->NBlocks(); i++) node->Block(i)->BBox();
+  for (int i = 0; i < node->NParts(); i++) UpdateBoundingBoxes(node->Part(i));
+}
+
+
+
+R3SurfelQueryEngine::
+R3SurfelQueryEngine(R3SurfelTree *tree, R3SurfelNode *source_node,
+  unsigned long long max_cached_surfels)
+  : tree(tree),
+    source_node(source_node),
+    block_indices(),
+    lru_block_indices(),
+    ncached_surfels(0),
+    max_cached_surfels(max_cached_surfels),
+    mutex()
+{
+  // Search whole tree by default
+  if (!this->source_node) this->source_node = tree->RootNode();
+
+  // Update bounding boxes
+  if (this->source_node) UpdateBoundingBoxes(this->source_node);
+}
+
+
+
+R3SurfelQueryEngine::
+~R3SurfelQueryEngine(void)
+{
+  // Delete block indices
+  EmptyCache();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// BLOCK INDEX FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+struct R3SurfelQueryCoordinateCompare {
+  const float *positions;
+  int dim;
+  bool operator()(int a, int b) const { return positions[3*a+dim] < positions[3*b+dim]; }
+};
+
+
+
+static void
+BuildBlockIndex(R3SurfelQueryEngine::BlockIndex *index,
+  const float *positions, int *order, int start, int end)
+{
+  // Check if leaf range
+  if (end - start <= R3surfel_query_leaf_size) return;
+
+  // Find longest axis of range
+  float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for (int i = start; i < end; i++) {
+    const float *p = &positions[3*order[i]];
+    for (int dim = 0; dim < 3; dim++) {
+      if (p[dim] < lo[dim]) lo[dim] = p[dim];
+      if (p[dim] > hi[dim]) hi[dim] = p[dim];
+    }
+  }
+  int split_dimension = 0;
+  if (hi[1] - lo[1] > hi[split_dimension] - lo[split_dimension]) split_dimension = 1;
+  if (hi[2] - lo[2] > hi[split_dimension] - lo[split_dimension]) split_dimension = 2;
+
+  // Partition range at median
+  int mid = (start + end) / 2;
+  R3SurfelQueryCoordinateCompare compare;
+  compare.positions = positions;
+  compare.dim = split_dimension;
+  std::nth_element(order + start, order + mid, order + end, compare);
+  index->split_dimensions[mid] = (unsigned char) split_dimension;
+
+  // Partition subranges on either side of median
+  BuildBlockIndex(index, positions, order, start, mid);
+  BuildBlockIndex(index, positions, order, mid + 1, end);
+}
+
+
+
+static R3SurfelQueryEngine::BlockIndex *
+CreateBlockIndex(R3SurfelBlock *block)
+{
+  // Allocate block index
+  R3SurfelQueryEngine::BlockIndex *index = new R3SurfelQueryEngine::BlockIndex();
+  int n = block->NSurfels();
+  index->block = block;
+  index->nsurfels = n;
+  index->positions = new float [ 3 * n ];
+  index->surfel_indices = new int [ n ];
+  index->split_dimensions = new unsigned char [ n ];
+  index->nreferences = 0;
+
+  // Copy surfel positions
+  R3SurfelDatabase *database = block->Database();
+  if (database) database->ReadBlock(block);
+  float *positions = new float [ 3 * n ];
+  for (int i = 0; i < n; i++) {
+    const R3Surfel *surfel = block->Surfel(i);
+    positions[3*i+0] = surfel->X();
+    positions[3*i+1] = surfel->Y();
+    positions[3*i+2] = surfel->Z();
+    index->surfel_indices[i] = i;
+    index->split_dimensions[i] = 0;
+  }
+  if (database) database->ReleaseBlock(block);
+
+  // Sort surfel indices into implicit kd tree order
+  BuildBlockIndex(index, positions, index->surfel_indices, 0, n);
+
+  // Store positions in kd tree order
+  for (int i = 0; i < n; i++) {
+    const float *p = &positions[3*index->surfel_indices[i]];
+    index->positions[3*i+0] = p[0];
+    index->positions[3*i+1] = p[1];
+    index->positions[3*i+2] = p[2];
+  }
+
+  // Delete temporary positions
+  delete [] positions;
+
+  // Return block index
+  return index;
+}
+
+
+
+static void
+DeleteBlockIndex(R3SurfelQueryEngine::BlockIndex *index)
+{
+  // Delete block index
+  delete [] index->positions;
+  delete [] index->surfel_indices;
+  delete [] index->split_dimensions;
+  delete index;
+}
+
+
+
+R3SurfelQueryEngine::BlockIndex *R3SurfelQueryEngine::
+FindBlockIndex(R3SurfelBlock *block)
+{
+  // Check cache (and mark index as most recently used)
+  mutex.Lock();
+  std::map<R3SurfelBlock *, BlockIndex *>::iterator it = block_indices.find(block);
+  BlockIndex *index = (it != block_indices.end()) ? it->second : NULL;
+  if (index) {
+    lru_block_indices.splice(lru_block_indices.begin(), lru_block_indices, index->lru_position);
+    index->nreferences++;
+  }
+  mutex.Unlock();
+  if (index) return index;
+
+  // Build index (without holding lock)
+  index = CreateBlockIndex(block);
+
+  // Insert index into cache (unless another thread did first)
+  mutex.Lock();
+  it = block_indices.find(block);
+  if (it == block_indices.end()) {
+    block_indices[block] = index;
+    lru_block_indices.push_front(index);
+    index->lru_position = lru_block_indices.begin();
+    ncached_surfels += index->nsurfels;
+  }
+  else {
+    DeleteBlockIndex(index);
+    index = it->second;
+    lru_block_indices.splice(lru_block_indices.begin(), lru_block_indices, index->lru_position);
+  }
+  index->nreferences++;
+  mutex.Unlock();
+
+  // Return block index (must be released after search)
+  return index;
+}
+
+
+
+void R3SurfelQueryEngine::
+ReleaseBlockIndex(BlockIndex *index)
+{
+  // Release reference and delete indices over the cache limit
+  mutex.Lock();
+  assert(index->nreferences > 0);
+  index->nreferences--;
+  EvictBlockIndices();
+  mutex.Unlock();
+}
+
+
+
+void R3SurfelQueryEngine::
+EvictBlockIndices(void)
+{
+  // Delete least recently used indices not being searched (mutex must be locked)
+  std::list<BlockIndex *>::iterator it = lru_block_indices.end();
+  while ((ncached_surfels > max_cached_surfels) && (it != lru_block_indices.begin())) {
+    BlockIndex *index = *(--it);
+    if (index->nreferences > 0) continue;
+    it = lru_block_indices.erase(it);
+    block_indices.erase(index->block);
+    ncached_surfels -= index->nsurfels;
+    DeleteBlockIndex(index);
+  }
+}
+
+
+
+void R3SurfelQueryEngine::
+SetMaxCachedSurfels(unsigned long long max_cached_surfels)
+{
+  // Set maximum number of surfels in cached indices
+  this->max_cached_surfels = max_cached_surfels;
+  EvictBlockIndices();
+}
+
+
+
+void R3SurfelQueryEngine::
+InvalidateBlock(R3SurfelBlock *block)
+{
+  // Remove block index from cache
+  std::map<R3SurfelBlock *, BlockIndex *>::iterator it = block_indices.find(block);
+  if (it == block_indices.end()) return;
+  BlockIndex *index = it->second;
+  assert(index->nreferences == 0);
+  lru_block_indices.erase(index->lru_position);
+  ncached_surfels -= index->nsurfels;
+  DeleteBlockIndex(index);
+  block_indices.erase(it);
+}
+
+
+
+void R3SurfelQueryEngine::
+EmptyCache(void)
+{
+  // Delete all block indices
+  std::map<R3SurfelBlock *, BlockIndex *>::iterator it;
+  for (it = block_indices.begin(); it != block_indices.end(); it++) {
+    DeleteBlockIndex(it->second);
+  }
+
+  // Empty cache
+  block_indices.clear();
+  lru_block_indices.clear();
+  ncached_surfels = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// BLOCK SEARCH FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+struct R3SurfelQueryResultCompare {
+  bool operator()(const R3SurfelQueryEngine::Result& a, const R3SurfelQueryEngine::Result& b) const {
+    return a.distance_squared < b.distance_squared; }
+};
+
+
+
+static void
+InsertClosestInBlock(const R3SurfelQueryEngine::BlockIndex *index, int i,
+  const RNCoord query[3], RNLength min_distance_squared, RNLength& max_distance_squared,
+  int max_points, std::vector<R3SurfelQueryEngine::Result>& results)
+{
+  // Compute squared distance
+  const float *p = &index->positions[3*i];
+  RNLength dx = p[0] - query[0];
+  RNLength dy = p[1] - query[1];
+  RNLength dz = p[2] - query[2];
+  RNLength distance_squared = dx*dx + dy*dy + dz*dz;
+  if (distance_squared < min_distance_squared) return;
+  if (distance_squared > max_distance_squared) return;
+
+  // Insert result in sorted order
+  R3SurfelQueryEngine::Result result;
+  result.distance_squared = distance_squared;
+  result.block = index->block;
+  result.surfel_index = index->surfel_indices[i];
+  R3SurfelQueryResultCompare compare;
+  results.insert(std::upper_bound(results.begin(), results.end(), result, compare), result);
+
+  // Keep only max_points closest and update max distance
+  if ((max_points > 0) && ((int) results.size() >= max_points)) {
+    if ((int) results.size() > max_points) results.pop_back();
+    max_distance_squared = results.back().distance_squared;
+  }
+}
+
+
+
+static void
+FindClosestInBlock(const R3SurfelQueryEngine::BlockIndex *index, int start, int end,
+  const RNCoord query[3], RNLength min_distance_squared, RNLength& max_distance_squared,
+  int max_points, std::vector<R3SurfelQueryEngine::Result>& results)
+{
+  // Check if leaf range
+  if (end - start <= R3surfel_query_leaf_size) {
+    for (int i = start; i < end; i++) {
+      InsertClosestInBlock(index, i, query, min_distance_squared, max_distance_squared, max_points, results);
+    }
+    return;
+  }
+
+  // Compute signed distance to split plane through median
+  int mid = (start + end) / 2;
+  int dim = index->split_dimensions[mid];
+  RNLength side = query[dim] - index->positions[3*mid+dim];
+
+  // Search closer side first, then median, then farther side
+  if (side <= 0) {
+    FindClosestInBlock(index, start, mid, query, min_distance_squared, max_distance_squared, max_points, results);
+    if (side*side > max_distance_squared) return;
+    InsertClosestInBlock(index, mid, query, min_distance_squared, max_distance_squared, max_points, results);
+    FindClosestInBlock(index, mid + 1, end, query, min_distance_squared, max_distance_squared, max_points, results);
+  }
+  else {
+    FindClosestInBlock(index, mid + 1, end, query, min_distance_squared, max_distance_squared, max_points, results);
+    if (side*side > max_distance_squared) return;
+    InsertClosestInBlock(index, mid, query, min_distance_squared, max_distance_squared, max_points, results);
+    FindClosestInBlock(index, start, mid, query, min_distance_squared, max_distance_squared, max_points, results);
+  }
+}
+
+
+
+static void
+FindAllInBlock(const R3SurfelQueryEngine::BlockIndex *index, int start, int end,
+  const RNCoord lo[3], const RNCoord hi[3], std::vector<R3SurfelQueryEngine::Result>& results)
+{
+  // Determine which surfels to check and which subranges to search
+  int mid = (start + end) / 2;
+  int check_start = start, check_end = end;
+  if (end - start > R3surfel_query_leaf_size) {
+    int dim = index->split_dimensions[mid];
+    RNCoord split = index->positions[3*mid+dim];
+    if (lo[dim] <= split) FindAllInBlock(index, start, mid, lo, hi, results);
+    if (hi[dim] >= split) FindAllInBlock(index, mid + 1, end, lo, hi, results);
+    check_start = mid;
+    check_end = mid + 1;
+  }
+
+  // Check surfels in leaf range (or median of interior range)
+  for (int i = check_start; i < check_end; i++) {
+    const float *p = &index->positions[3*i];
+    if ((p[0] < lo[0]) || (p[0] > hi[0])) continue;
+    if ((p[1] < lo[1]) || (p[1] > hi[1])) continue;
+    if ((p[2] < lo[2]) || (p[2] > hi[2])) continue;
+    R3SurfelQueryEngine::Result result;
+    result.distance_squared = 0;
+    result.block = index->block;
+    result.surfel_index = index->surfel_indices[i];
+    results.push_back(result);
+  }
+}
+
+
+
+static void
+FindAllInBlock(const R3SurfelQueryEngine::BlockIndex *index, int start, int end,
+  const RNCoord query[3], RNLength min_distance_squared, RNLength max_distance_squared,
+  std::vector<R3SurfelQueryEngine::Result>& results)
+{
+  // Determine which surfels to check and which subranges to search
+  int mid = (start + end) / 2;
+  int check_start = start, check_end = end;
+  if (end - start > R3surfel_query_leaf_size) {
+    int dim = index->split_dimensions[mid];
+    RNLength side = query[dim] - index->positions[3*mid+dim];
+    if ((side <= 0) || (side*side <= max_distance_squared)) FindAllInBlock(index, start, mid, query, min_distance_squared, max_distance_squared, results);
+    if ((side >= 0) || (side*side <= max_distance_squared)) FindAllInBlock(index, mid + 1, end, query, min_distance_squared, max_distance_squared, results);
+    check_start = mid;
+    check_end = mid + 1;
+  }
+
+  // Check surfels in leaf range (or median of interior range)
+  for (int i = check_start; i < check_end; i++) {
+    const float *p = &index->positions[3*i];
+    RNLength dx = p[0] - query[0];
+    RNLength dy = p[1] - query[1];
+    RNLength dz = p[2] - query[2];
+    RNLength distance_squared = dx*dx + dy*dy + dz*dz;
+    if (distance_squared < min_distance_squared) continue;
+    if (distance_squared > max_distance_squared) continue;
+    R3SurfelQueryEngine::Result result;
+    result.distance_squared = distance_squared;
+    result.block = index->block;
+    result.surfel_index = index->surfel_indices[i];
+    results.push_back(result);
+  }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// TREE SEARCH FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+struct R3SurfelQueryCandidate {
+  RNLength distance_squared;
+  R3SurfelNode *node;
+  R3SurfelBlock *block;
+  bool operator<(const R3SurfelQueryCandidate& candidate) const {
+    return distance_squared > candidate.distance_squared; }
+};
+
+
+
+static RNLength
+SquaredDistance(const R3Point& point, const R3Box& box)
+{
+  // Return squared distance from point to box (zero if inside)
+  RNLength distance_squared = 0;
+  for (int dim = 0; dim < 3; dim++) {
+    RNCoord d = 0;
+    if (point[dim] < box[RN_LO][dim]) d = box[RN_LO][dim] - point[dim];
+    else if (point[dim] > box[RN_HI][dim]) d = point[dim] - box[RN_HI][dim];
+    distance_squared += d * d;
+  }
+  return distance_squared;
+}
+
+
+
+void R3SurfelQueryEngine::
+FindBlocks(R3SurfelNode *node, const R3Box& query_box,
+  RNArray<R3SurfelBlock *>& blocks) const
+{
+  // Check bounding box
+  if (!R3Intersects(node->BBox(), query_box)) return;
+
+  // Check if leaf node
+  if (node->NParts() == 0) {
+    for (int i = 0; i < node->NBlocks(); i++) {
+      R3SurfelBlock *block = node->Block(i);
+      if (!R3Intersects(block->BBox(), query_box)) continue;
+      blocks.Insert(block);
+    }
+  }
+  else {
+    for (int i = 0; i < node->NParts(); i++) {
+      FindBlocks(node->Part(i), query_box, blocks);
+    }
+  }
+}
+
+
+
+int R3SurfelQueryEngine::
+InsertResults(const std::vector<Result>& results,
+  R3SurfelPointSet& points, RNLength *distances) const
+{
+  // Read blocks with results (once per block)
+  std::set<R3SurfelBlock *> blocks;
+  for (unsigned int i = 0; i < results.size(); i++) {
+    R3SurfelBlock *block = results[i].block;
+    if (blocks.find(block) != blocks.end()) continue;
+    if (block->Database()) block->Database()->ReadBlock(block);
+    blocks.insert(block);
+  }
+
+  // Insert points
+  for (unsigned int i = 0; i < results.size(); i++) {
+    R3SurfelPoint point(results[i].block, results[i].surfel_index);
+    points.InsertPoint(point);
+    if (distances) distances[i] = sqrt(results[i].distance_squared);
+  }
+
+  // Release blocks
+  std::set<R3SurfelBlock *>::iterator it;
+  for (it = blocks.begin(); it != blocks.end(); it++) {
+    R3SurfelBlock *block = *it;
+    if (block->Database()) block->Database()->ReleaseBlock(block);
+  }
+
+  // Return number of points inserted
+  return (int) results.size();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// QUERY FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+int R3SurfelQueryEngine::
+FindClosest(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance, int max_points,
+  R3SurfelPointSet& points, RNLength *distances)
+{
+  // Check arguments
+  if (!source_node) return 0;
+  if (max_points <= 0) return 0;
+  if (max_distance < 0) return 0;
+  if (min_distance < 0) min_distance = 0;
+  RNLength min_distance_squared = min_distance * min_distance;
+  RNLength max_distance_squared = max_distance * max_distance;
+
+  // Visit nodes and blocks in order of distance to their bounding boxes
+  std::vector<Result> results;
+  std::priority_queue<R3SurfelQueryCandidate> candidates;
+  R3SurfelQueryCandidate candidate;
+  candidate.distance_squared = SquaredDistance(query_position, source_node->BBox());
+  candidate.node = source_node;
+  candidate.block = NULL;
+  candidates.push(candidate);
+  while (!candidates.empty()) {
+    // Pop closest candidate
+    candidate = candidates.top();
+    candidates.pop();
+    if (candidate.distance_squared > max_distance_squared) break;
+
+    // Search block
+    if (candidate.block) {
+      BlockIndex *index = FindBlockIndex(candidate.block);
+      const R3Point& origin = candidate.block->PositionOrigin();
+      RNCoord query[3];
+      query[0] = query_position.X() - origin.X();
+      query[1] = query_position.Y() - origin.Y();
+      query[2] = query_position.Z() - origin.Z();
+      FindClosestInBlock(index, 0, index->nsurfels, query,
+        min_distance_squared, max_distance_squared, max_points, results);
+      ReleaseBlockIndex(index);
+      continue;
+    }
+
+    // Queue blocks of leaf node or parts of interior node
+    R3SurfelNode *node = candidate.node;
+    if (node->NParts() == 0) {
+      for (int i = 0; i < node->NBlocks(); i++) {
+        R3SurfelQueryCandidate child;
+        child.block = node->Block(i);
+        child.node = node;
+        child.distance_squared = SquaredDistance(query_position, child.block->BBox());
+        if (child.distance_squared <= max_distance_squared) candidates.push(child);
+      }
+    }
+    else {
+      for (int i = 0; i < node->NParts(); i++) {
+        R3SurfelQueryCandidate child;
+        child.node = node->Part(i);
+        child.block = NULL;
+        child.distance_squared = SquaredDistance(query_position, child.node->BBox());
+        if (child.distance_squared <= max_distance_squared) candidates.push(child);
+      }
+    }
+  }
+
+  // Insert closest points into point set
+  return InsertResults(results, points, distances);
+}
+
+
+
+int R3SurfelQueryEngine::
+FindClosest(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance,
+  R3SurfelPoint& closest_point, RNLength *closest_distance)
+{
+  // Find closest point
+  R3SurfelPointSet points;
+  RNLength distance = FLT_MAX;
+  if (!FindClosest(query_position, min_distance, max_distance, 1, points, &distance)) return 0;
+
+  // Return closest point
+  closest_point = *(points.Point(0));
+  if (closest_distance) *closest_distance = distance;
+  return 1;
+}
+
+
+
+int R3SurfelQueryEngine::
+FindAll(const R3Point& query_position,
+  RNLength min_distance, RNLength max_distance,
+  R3SurfelPointSet& points)
+{
+  // Check arguments
+  if (!source_node) return 0;
+  if (max_distance < 0) return 0;
+  if (min_distance < 0) min_distance = 0;
+  RNLength min_distance_squared = min_distance * min_distance;
+  RNLength max_distance_squared = max_distance * max_distance;
+
+  // Find blocks overlapping sphere
+  R3Vector query_radius(max_distance, max_distance, max_distance);
+  R3Box query_box(query_position - query_radius, query_position + query_radius);
+  RNArray<R3SurfelBlock *> blocks;
+  FindBlocks(source_node, query_box, blocks);
+
+  // Search blocks
+  std::vector<Result> results;
+  for (int i = 0; i < blocks.NEntries(); i++) {
+    R3SurfelBlock *block = blocks.Kth(i);
+    if (SquaredDistance(query_position, block->BBox()) > max_distance_squared) continue;
+    BlockIndex *index = FindBlockIndex(block);
+    const R3Point& origin = block->PositionOrigin();
+    RNCoord query[3];
+    query[0] = query_position.X() - origin.X();
+    query[1] = query_position.Y() - origin.Y();
+    query[2] = query_position.Z() - origin.Z();
+    FindAllInBlock(index, 0, index->nsurfels, query,
+      min_distance_squared, max_distance_squared, results);
+    ReleaseBlockIndex(index);
+  }
+
+  // Sort results by distance (once, rather than with every insertion)
+  std::stable_sort(results.begin(), results.end(), R3SurfelQueryResultCompare());
+
+  // Insert points into point set
+  return InsertResults(results, points, NULL);
+}
+
+
+
+int R3SurfelQueryEngine::
+FindAll(const R3Box& query_box, R3SurfelPointSet& points)
+{
+  // Check arguments
+  if (!source_node) return 0;
+  if (query_box.IsEmpty()) return 0;
+
+  // Find blocks overlapping box
+  RNArray<R3SurfelBlock *> blocks;
+  FindBlocks(source_node, query_box, blocks);
+
+  // Search blocks
+  std::vector<Result> results;
+  for (int i = 0; i < blocks.NEntries(); i++) {
+    R3SurfelBlock *block = blocks.Kth(i);
+    const R3Point& origin = block->PositionOrigin();
+    RNCoord lo[3], hi[3];
+    for (int dim = 0; dim < 3; dim++) {
+      lo[dim] = query_box[RN_LO][dim] - origin[dim];
+      hi[dim] = query_box[RN_HI][dim] - origin[dim];
+    }
+
+    // Check if block is entirely inside box
+    if (R3Contains(query_box, block->BBox())) {
+      for (int j = 0; j < block->NSurfels(); j++) {
+        Result result;
+        result.distance_squared = 0;
+        result.block = block;
+        result.surfel_index = j;
+        results.push_back(result);
+      }
+    }
+    else {
+      BlockIndex *index = FindBlockIndex(block);
+      FindAllInBlock(index, 0, index->nsurfels, lo, hi, results);
+      ReleaseBlockIndex(index);
+    }
+  }
+
+  // Insert points into point set
+  return InsertResults(results, points, NULL);
+}
+
+
+
+} // namespace gaps
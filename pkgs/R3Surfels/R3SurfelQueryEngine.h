@@ -0,0 +1,187 @@
+/* Include file for the R3 surfel query engine class */
+#ifndef __R3__SURFEL__QUERY__ENGINE__H__
+#define __R3__SURFEL__QUERY__ENGINE__H__
+
+
+
+////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+////////////////////////////////////////////////////////////////////////
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// CLASS DEFINITION
+////////////////////////////////////////////////////////////////////////
+
+// Answers spatial queries on the surfels in the leaf nodes of a tree.
+// Nodes and blocks are pruned with their bounding boxes, and a spatial
+// index is built (and cached) for a block the first time it is searched,
+// so blocks are read from the database only when they contain results.
+// The least recently used indices are deleted when the cache holds more
+// than a maximum number of surfels.
+// Queries can be executed from multiple threads at once.
+
+class R3SurfelQueryEngine {
+public:
+  //////////////////////////////////////////
+  //// CONSTRUCTOR/DESTRUCTOR FUNCTIONS ////
+  //////////////////////////////////////////
+
+  // Constructor functions
+  R3SurfelQueryEngine(R3SurfelTree *tree, R3SurfelNode *source_node = NULL,
+    unsigned long long max_cached_surfels = 16 * 1024 * 1024);
+
+  // Destructor function
+  ~R3SurfelQueryEngine(void);
+
+
+  ////////////////////////////
+  //// PROPERTY FUNCTIONS ////
+  ////////////////////////////
+
+  // Access functions
+  R3SurfelTree *Tree(void) const;
+  R3SurfelNode *SourceNode(void) const;
+
+  // Cache property functions
+  int NCachedBlocks(void) const;
+  unsigned long long NCachedSurfels(void) const;
+  unsigned long long MaxCachedSurfels(void) const;
+
+
+  /////////////////////////
+  //// QUERY FUNCTIONS ////
+  /////////////////////////
+
+  // Search for closest one
+  int FindClosest(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance,
+    R3SurfelPoint& closest_point, RNLength *closest_distance = NULL);
+
+  // Search for closest K
+  int FindClosest(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance, int max_points,
+    R3SurfelPointSet& points, RNLength *distances = NULL);
+
+  // Search for all within some distance
+  int FindAll(const R3Point& query_position,
+    RNLength min_distance, RNLength max_distance,
+    R3SurfelPointSet& points);
+
+  // Search for all inside box
+  int FindAll(const R3Box& query_box, R3SurfelPointSet& points);
+
+
+  ////////////////////////////////
+  //// MANIPULATION FUNCTIONS ////
+  ////////////////////////////////
+
+  // Cache manipulation functions (not safe during queries)
+  void SetMaxCachedSurfels(unsigned long long max_cached_surfels);
+  void InvalidateBlock(R3SurfelBlock *block);
+  void EmptyCache(void);
+
+
+  ////////////////////////////////////////////////////////////////////////
+  // INTERNAL STUFF BELOW HERE
+  ////////////////////////////////////////////////////////////////////////
+
+public:
+  // Internal block index type
+  struct BlockIndex {
+    R3SurfelBlock *block;
+    int nsurfels;
+    float *positions;
+    int *surfel_indices;
+    unsigned char *split_dimensions;
+    std::list<BlockIndex *>::iterator lru_position;
+    int nreferences;
+  };
+
+  // Internal query result type
+  struct Result {
+    RNLength distance_squared;
+    R3SurfelBlock *block;
+    int surfel_index;
+  };
+
+protected:
+  // Internal functions
+  BlockIndex *FindBlockIndex(R3SurfelBlock *block);
+  void ReleaseBlockIndex(BlockIndex *index);
+  void EvictBlockIndices(void);
+  void FindBlocks(R3SurfelNode *node, const R3Box& query_box,
+    RNArray<R3SurfelBlock *>& blocks) const;
+  int InsertResults(const std::vector<Result>& results,
+    R3SurfelPointSet& points, RNLength *distances) const;
+
+private:
+  R3SurfelTree *tree;
+  R3SurfelNode *source_node;
+  std::map<R3SurfelBlock *, BlockIndex *> block_indices;
+  std::list<BlockIndex *> lru_block_indices;
+  unsigned long long ncached_surfels;
+  unsigned long long max_cached_surfels;
+  RNMutex mutex;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// INLINE FUNCTION DEFINITIONS
+////////////////////////////////////////////////////////////////////////
+
+inline R3SurfelTree *R3SurfelQueryEngine::
+Tree(void) const
+{
+  // Return tree
+  return tree;
+}
+
+
+
+inline R3SurfelNode *R3SurfelQueryEngine::
+SourceNode(void) const
+{
+  // Return node at root of searched subtree
+  return source_node;
+}
+
+
+
+inline int R3SurfelQueryEngine::
+NCachedBlocks(void) const
+{
+  // Return number of blocks with cached spatial indices
+  return (int) block_indices.size();
+}
+
+
+
+inline unsigned long long R3SurfelQueryEngine::
+NCachedSurfels(void) const
+{
+  // Return number of surfels in cached spatial indices
+  return ncached_surfels;
+}
+
+
+
+inline unsigned long long R3SurfelQueryEngine::
+MaxCachedSurfels(void) const
+{
+  // Return maximum number of surfels in cached spatial indices
+  return max_cached_surfels;
+}
+
+
+
+// End namespace
+}
+
+
+// End include guard
+#endif
@@ -153,6 +153,34 @@ RemoveNode(R3SurfelNode *node)
 //  HIGH-LEVEL MANIPULATION FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
 
+struct R3SurfelTreeSamplingTask {
+  R3SurfelDatabase *database;
+  R3SurfelBlock *block;
+  RNScalar probability;
+  const RNScalar *random_values;
+  RNArray<const R3Surfel *> surfels;
+};
+
+
+
+static void
+SampleBlocksTask(int start, int end, void *data)
+{
+  // Read blocks and select surfels with pre-drawn random values
+  R3SurfelTreeSamplingTask *tasks = (R3SurfelTreeSamplingTask *) data;
+  for (int i = start; i < end; i++) {
+    R3SurfelTreeSamplingTask *task = &tasks[i];
+    task->database->ReadBlock(task->block);
+    if (!task->random_values) continue;
+    for (int k = 0; k < task->block->NSurfels(); k++) {
+      if (task->random_values[k] > task->probability) continue;
+      task->surfels.Insert(task->block->Surfel(k));
+    }
+  }
+}
+
+
+
 int R3SurfelTree::
 CreateMultiresolutionBlocks(R3SurfelNode *node, RNScalar multiresolution_factor, RNScalar max_complexity, RNScalar max_resolution)
 {
@@ -191,40 +219,65 @@ CreateMultiresolutionBlocks(R3SurfelNode *node, RNScalar multiresolution_factor,
     if (target_resolution > max_res) target_resolution = max_res;
   }
 
-  // Construct set with surfels sampled from blocks of parts
-  R3SurfelPointSet set;
+  // Compute subsampling probability of blocks of parts based on block resolution
+  int nblocks = 0;
+  for (int i = 0; i < node->NParts(); i++) nblocks += node->Part(i)->NBlocks();
+  R3SurfelTreeSamplingTask *tasks = new R3SurfelTreeSamplingTask [ nblocks ];
+  unsigned int nrandom_values = 0;
+  int ntasks = 0;
   for (int i = 0; i < node->NParts(); i++) {
     R3SurfelNode *part = node->Part(i);
     for (int j = 0; j < part->NBlocks(); j++) {
       R3SurfelBlock *block = part->Block(j);
-          
-      // Read block
-      database->ReadBlock(block);
-          
-      // Compute subsampling probability based on block resolution
       RNScalar block_resolution = block->Resolution();
       if (block_resolution == 0) continue;
-      RNScalar probability = target_resolution / block_resolution;
-          
-      // Insert surfels from block
-      if (probability >= 1) {
-        // Insert all surfels from block
-        set.InsertPoints(block);
-      }
-      else {
-        // Insert subset of surfels from block
-        for (int k = 0; k < block->NSurfels(); k++) {
-          if (RNRandomScalar() > probability) continue;
-          const R3Surfel *surfel = block->Surfel(k);
-          R3SurfelPoint point(block, surfel);
-          set.InsertPoint(point);
-        }
-      }
+      R3SurfelTreeSamplingTask *task = &tasks[ntasks++];
+      task->database = database;
+      task->block = block;
+      task->probability = target_resolution / block_resolution;
+      task->random_values = NULL;
+      if (task->probability < 1) nrandom_values += block->NSurfels();
+    }
+  }
 
-      // Release block
-      database->ReleaseBlock(block);
+  // Draw random values serially (in the same order as a serial traversal)
+  std::vector<RNScalar> random_values(nrandom_values);
+  for (unsigned int k = 0; k < nrandom_values; k++) {
+    random_values[k] = RNRandomScalar();
+  }
+
+  // Read blocks and select subsets of surfels in parallel
+  unsigned int random_offset = 0;
+  for (int i = 0; i < ntasks; i++) {
+    if (tasks[i].probability >= 1) continue;
+    tasks[i].random_values = random_values.data() + random_offset;
+    random_offset += tasks[i].block->NSurfels();
+  }
+  RNParallelFor(0, ntasks, SampleBlocksTask, tasks, 1);
+
+  // Construct set with surfels sampled from blocks of parts (in order)
+  R3SurfelPointSet set;
+  for (int i = 0; i < ntasks; i++) {
+    R3SurfelTreeSamplingTask *task = &tasks[i];
+    R3SurfelBlock *block = task->block;
+    if (!task->random_values) {
+      // Insert all surfels from block
+      set.InsertPoints(block);
+    }
+    else {
+      // Insert subset of surfels from block
+      for (int k = 0; k < task->surfels.NEntries(); k++) {
+        R3SurfelPoint point(block, task->surfels.Kth(k));
+        set.InsertPoint(point);
+      }
     }
+
+    // Release block
+    database->ReleaseBlock(block);
   }
+
+  // Delete sampling tasks
+  delete [] tasks;
       
   // Create block from set
   R3SurfelBlock *block = new R3SurfelBlock(&set);
@@ -659,6 +712,86 @@ SplitNode(R3SurfelNode *node,
 
 
 
+struct R3SurfelTreeSplitBlocksTask {
+  R3SurfelTree *tree;
+  R3SurfelNode *node;
+  RNScalar max_complexity;
+  RNLength max_extent;
+  int status;
+};
+
+
+
+static void
+SplitBlocksTask(void *data)
+{
+  // Split blocks of one leaf node
+  R3SurfelTreeSplitBlocksTask *task = (R3SurfelTreeSplitBlocksTask *) data;
+  task->status = task->tree->SplitBlocks(task->node, task->max_complexity, task->max_extent);
+}
+
+
+
+static int
+SplitLeafBlocksInParallel(R3SurfelTree *tree, R3SurfelNode *start_node,
+  RNScalar max_block_complexity, RNLength max_block_extent)
+{
+  // Find leaf nodes whose blocks will be split by SplitNode
+  RNArray<R3SurfelNode *> leaves;
+  RNArray<R3SurfelNode *> stack;
+  stack.Insert(start_node);
+  while (!stack.IsEmpty()) {
+    R3SurfelNode *node = stack.Tail();
+    stack.RemoveTail();
+    if (node->NParts() == 0) {
+      if (((max_block_complexity > 0) && (node->Complexity() > max_block_complexity)) ||
+          ((max_block_extent > 0) && (node->BBox().LongestAxisLength() > max_block_extent))) {
+        leaves.Insert(node);
+      }
+    }
+    for (int i = 0; i < node->NParts(); i++) {
+      stack.Insert(node->Part(i));
+    }
+  }
+
+  // Check leaves
+  if (leaves.IsEmpty()) return 0;
+
+  // Split blocks of different leaf nodes in parallel
+  // (blocks created for later parts are then already small enough, 
+  // so SplitNode produces the same tree as when run serially)
+  R3SurfelTreeSplitBlocksTask *tasks = new R3SurfelTreeSplitBlocksTask [ leaves.NEntries() ];
+  RNTaskGroup group;
+  for (int i = 0; i < leaves.NEntries(); i++) {
+    tasks[i].tree = tree;
+    tasks[i].node = leaves.Kth(i);
+    tasks[i].max_complexity = max_block_complexity;
+    tasks[i].max_extent = max_block_extent;
+    tasks[i].status = 0;
+    group.Insert(SplitBlocksTask, &tasks[i]);
+  }
+  group.Wait();
+
+  // Gather status
+  int status = 0;
+  for (int i = 0; i < leaves.NEntries(); i++) status |= tasks[i].status;
+  delete [] tasks;
+
+  // Put blocks of leaves in a fixed order in the database
+  // (tasks inserted and removed blocks in a nondeterministic order)
+  RNArray<R3SurfelBlock *> leaf_blocks;
+  for (int i = 0; i < leaves.NEntries(); i++) {
+    R3SurfelNode *leaf = leaves.Kth(i);
+    for (int j = 0; j < leaf->NBlocks(); j++) leaf_blocks.Insert(leaf->Block(j));
+  }
+  tree->Database()->ReorderBlocks(leaf_blocks);
+
+  // Return whether any blocks were split
+  return status;
+}
+
+
+
 int R3SurfelTree::
 SplitNodes(R3SurfelNode *start_node,
     int max_parts_per_node, int max_blocks_per_node, 
@@ -671,6 +804,13 @@ SplitNodes(R3SurfelNode *start_node,
   stack.Insert(start_node);
   int status = 0;
 
+  // Split blocks of leaf nodes in parallel 
+  if (RNNumThreads() > 1) {
+    RNScalar max_leaf_block_complexity = max_block_complexity;
+    if (max_leaf_block_complexity > max_leaf_complexity) max_leaf_block_complexity = max_leaf_complexity;
+    status |= SplitLeafBlocksInParallel(this, start_node, max_leaf_block_complexity, max_block_extent);
+  }
+
   // Split nodes into manageable sized chunks
   while (!stack.IsEmpty()) {
     // Pop node from stack
@@ -934,11 +1074,15 @@ SplitBlock(R3SurfelNode *node, R3SurfelBlock *block, const R3SurfelConstraint& c
   // Read block
   database->ReadBlock(block);
 
+  // Check all surfels at once
+  std::vector<unsigned char> surfel_mask(block->NSurfels(), 1);
+  constraint.CheckSurfels(block, surfel_mask.data());
+
   // Partition surfels according to constraint
   RNArray<const R3Surfel *> subset1, subset2;
   for (int i = 0; i < block->NSurfels(); i++) {
     const R3Surfel *surfel = block->Surfel(i);
-    if (constraint.Check(block, surfel)) subset1.Insert(surfel);
+    if (surfel_mask[i]) subset1.Insert(surfel);
     else subset2.Insert(surfel);
   }
 
@@ -952,10 +1096,12 @@ SplitBlock(R3SurfelNode *node, R3SurfelBlock *block, const R3SurfelConstraint& c
     return 0;
   }
 
-  // Update node
+  // Update node (locked because ancestors are shared with other leaf nodes)
+  mutex.Lock();
   node->InsertBlock(block1); 
   node->InsertBlock(block2); 
   node->RemoveBlock(block);
+  mutex.Unlock();
 
   // Remove old block
   block->SetDirty(FALSE);
@@ -160,6 +160,9 @@ protected:
 
   // Node stuff
   RNArray<R3SurfelNode *> nodes;
+
+  // Lock for node updates from multiple threads
+  RNMutex mutex;
 };
 
 
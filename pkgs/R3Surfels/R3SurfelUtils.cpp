@@ -225,10 +225,14 @@ VisitResidentSurfels(R3SurfelScene *scene,
       if (!constraint->Check(block->BBox())) continue;
       if (block->Database() && !block->Database()->IsBlockResident(block)) continue;
 
+      // Check all surfels at once
+      std::vector<unsigned char> surfel_mask(block->NSurfels(), 1);
+      constraint->CheckSurfels(block, surfel_mask.data());
+
       // Visit surfels
       for (int i = 0; i < block->NSurfels(); i++) {
+        if (!surfel_mask[i]) continue;
         const R3Surfel *surfel = block->Surfel(i);
-        if (!constraint->Check(block, surfel)) continue;
         (*callback_function)(block, surfel, callback_data);
       }
     }
@@ -2360,10 +2364,18 @@ CreateNormals(R3SurfelPointGraph *graph, RNBoolean fast_and_approximate)
     return NULL;
   }
 
-  // Allocate temporary memory
-  R3Point *positions = new R3Point [graph->MaxNeighbors() + 1];
+  // Compute normals with PCA of neighborhoods (in parallel)
+  if (!fast_and_approximate) {
+    graph->ComputeNormals(normals);
+    for (int i = 0; i < graph->NPoints(); i++) {
+      // Flip normal so that positive in max dimension
+      int dim = normals[i].MaxDimension();
+      if (normals[i][dim] < 0) normals[i].Flip();
+    }
+    return normals;
+  }
 
-  // Compute normals
+  // Compute normals with vector cross products of random neighbors
   for (int i = 0; i < graph->NPoints(); i++) {
     const R3SurfelPoint *point = graph->Point(i);
     if (graph->NNeighbors(i) < 2) { 
@@ -2371,33 +2383,17 @@ CreateNormals(R3SurfelPointGraph *graph, RNBoolean fast_and_approximate)
       normals[i] = R3zero_vector; 
     }
     else {
-      if (fast_and_approximate) {
-        // Compute normal with vector cross product
-        positions[0] = point->Position();
-        int index1 = (int) (RNRandomScalar() * graph->NNeighbors(i));
-        int index2 = (index1 + graph->NNeighbors(i)/2) % graph->NNeighbors(i);
-        const R3SurfelPoint *neighbor1 = graph->Neighbor(i, index1);
-        const R3SurfelPoint *neighbor2 = graph->Neighbor(i, index2);
-        positions[1] = neighbor1->Position();
-        positions[2] = neighbor2->Position();
-        R3Vector v1 = positions[1] - positions[0];
-        R3Vector v2 = positions[2] - positions[0];
-        R3Vector n = v1 % v2;
-        n.Normalize();
-        normals[i] = n;
-      }
-      else {
-        // Compute normal with PCA of neighborhood
-        positions[0] = point->Position();
-        for (int j = 0; j < graph->NNeighbors(i); j++) {
-          const R3SurfelPoint *neighbor = graph->Neighbor(i, j);
-          positions[j+1] = neighbor->Position();
-        }
-        int npositions = graph->NNeighbors(i) + 1;
-        R3Point centroid = R3Centroid(npositions, positions);
-        R3Triad triad = R3PrincipleAxes(centroid, npositions, positions);
-        normals[i] = triad[2];
-      }
+      // Compute normal with vector cross product
+      R3Point position0 = point->Position();
+      int index1 = (int) (RNRandomScalar() * graph->NNeighbors(i));
+      int index2 = (index1 + graph->NNeighbors(i)/2) % graph->NNeighbors(i);
+      const R3SurfelPoint *neighbor1 = graph->Neighbor(i, index1);
+      const R3SurfelPoint *neighbor2 = graph->Neighbor(i, index2);
+      R3Vector v1 = neighbor1->Position() - position0;
+      R3Vector v2 = neighbor2->Position() - position0;
+      R3Vector n = v1 % v2;
+      n.Normalize();
+      normals[i] = n;
 
       // Flip normal so that positive in max dimension
       int dim = normals[i].MaxDimension();
@@ -2405,9 +2401,6 @@ CreateNormals(R3SurfelPointGraph *graph, RNBoolean fast_and_approximate)
     }
   }
 
-  // Delete positions
-  delete [] positions;
-
   // Return normals
   return normals;
 #endif
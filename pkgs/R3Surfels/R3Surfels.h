@@ -104,6 +104,8 @@ class R3SurfelScene;
 #include "R3SurfelLabelRelationship.h"
 #include "R3SurfelLabelAssignment.h"
 #include "R3SurfelScene.h"
+#include "R3SurfelIngester.h"
+#include "R3SurfelQueryEngine.h"
 
 
 
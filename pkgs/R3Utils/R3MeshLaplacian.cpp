@@ -0,0 +1,434 @@
+// Source file for mesh laplacian class
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Include files
+////////////////////////////////////////////////////////////////////////
+
+#include "R3Utils/R3Utils.h"
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constant definitions
+////////////////////////////////////////////////////////////////////////
+
+// Number of vertices or edges in each block of parallel loops
+static const int block_size = 4096;
+
+// Faces whose area is smaller than this fraction of their squared edge lengths are ignored
+static const RNScalar degenerate_face_ratio = 1.0E-8;
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Structure definitions
+////////////////////////////////////////////////////////////////////////
+
+struct R3MeshLaplacianAssemblyData {
+  R3Mesh *mesh;
+  int weighting;
+  RNScalar *edge_weights;
+  int *row_offsets;
+  int *row_counts;
+  int *columns;
+  RNScalar *values;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Utility functions
+////////////////////////////////////////////////////////////////////////
+
+static RNScalar
+CotangentOppositeEdge(R3Mesh *mesh, R3MeshEdge *edge, R3MeshFace *face)
+{
+  // Get vectors from vertex opposite edge to the vertices of edge
+  R3MeshVertex *opposite_vertex = mesh->VertexAcrossFace(face, edge);
+  if (!opposite_vertex) return 0;
+  const R3Point& p = mesh->VertexPosition(opposite_vertex);
+  R3Vector u = mesh->VertexPosition(mesh->VertexOnEdge(edge, 0)) - p;
+  R3Vector v = mesh->VertexPosition(mesh->VertexOnEdge(edge, 1)) - p;
+
+  // Ignore degenerate faces (the same test is applied for each edge of the face)
+  RNScalar sine = (u % v).Length();
+  if (sine <= degenerate_face_ratio * (u.Dot(u) + v.Dot(v))) return 0;
+
+  // Return cotangent of angle at opposite vertex
+  return u.Dot(v) / sine;
+}
+
+
+
+static void
+ComputeEdgeWeightsTask(int start, int end, void *data)
+{
+  // Compute weights of a range of edges
+  R3MeshLaplacianAssemblyData *task = (R3MeshLaplacianAssemblyData *) data;
+  R3Mesh *mesh = task->mesh;
+  for (int i = start; i < end; i++) {
+    R3MeshEdge *edge = mesh->Edge(i);
+    if (task->weighting == R3_MESH_LAPLACIAN_UNIFORM_WEIGHTS) {
+      task->edge_weights[i] = 1.0;
+    }
+    else {
+      RNScalar weight = 0;
+      for (int k = 0; k < 2; k++) {
+        R3MeshFace *face = mesh->FaceOnEdge(edge, k);
+        if (face) weight += 0.5 * CotangentOppositeEdge(mesh, edge, face);
+      }
+      task->edge_weights[i] = weight;
+    }
+  }
+}
+
+
+
+static void
+FillRowsTask(int start, int end, void *data)
+{
+  // Fill a range of rows with sorted entries
+  R3MeshLaplacianAssemblyData *task = (R3MeshLaplacianAssemblyData *) data;
+  R3Mesh *mesh = task->mesh;
+  for (int i = start; i < end; i++) {
+    R3MeshVertex *vertex = mesh->Vertex(i);
+    int *row_columns = &task->columns[task->row_offsets[i]];
+    RNScalar *row_values = &task->values[task->row_offsets[i]];
+
+    // Add entries for neighbors and diagonal
+    int n = 0;
+    RNScalar diagonal = 0;
+    for (int j = 0; j < mesh->VertexValence(vertex); j++) {
+      R3MeshEdge *edge = mesh->EdgeOnVertex(vertex, j);
+      R3MeshVertex *neighbor = mesh->VertexAcrossEdge(edge, vertex);
+      int column = mesh->VertexID(neighbor);
+      if (column == i) continue;
+      RNScalar weight = task->edge_weights[mesh->EdgeID(edge)];
+      row_columns[n] = column;
+      row_values[n] = -weight;
+      diagonal += weight;
+      n++;
+    }
+    row_columns[n] = i;
+    row_values[n] = diagonal;
+    n++;
+
+    // Sort entries by column (rows are short, so use insertion sort)
+    for (int j = 1; j < n; j++) {
+      int column = row_columns[j];
+      RNScalar value = row_values[j];
+      int k = j;
+      while ((k > 0) && (row_columns[k-1] > column)) {
+        row_columns[k] = row_columns[k-1];
+        row_values[k] = row_values[k-1];
+        k--;
+      }
+      row_columns[k] = column;
+      row_values[k] = value;
+    }
+
+    // Merge entries of duplicate edges
+    int count = 0;
+    for (int j = 0; j < n; j++) {
+      if ((count > 0) && (row_columns[count-1] == row_columns[j])) {
+        row_values[count-1] += row_values[j];
+      }
+      else {
+        row_columns[count] = row_columns[j];
+        row_values[count] = row_values[j];
+        count++;
+      }
+    }
+
+    // Remember number of entries in row
+    task->row_counts[i] = count;
+  }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Constructor/destructor functions
+////////////////////////////////////////////////////////////////////////
+
+R3MeshLaplacian::
+R3MeshLaplacian(R3Mesh *mesh, int weighting)
+  : mesh(mesh),
+    weighting(weighting),
+    matrix(),
+    vertex_areas(NULL),
+    tolerance(1.0E-6),
+    max_iterations(0)
+{
+  // Allocate vertex areas
+  int nvertices = mesh->NVertices();
+  vertex_areas = new RNArea [ nvertices ];
+  for (int i = 0; i < nvertices; i++) vertex_areas[i] = 0;
+  if (nvertices == 0) return;
+
+  // Compute lumped vertex areas (one third of area of each attached face)
+  for (int i = 0; i < mesh->NFaces(); i++) {
+    R3MeshFace *face = mesh->Face(i);
+    const R3Point& p0 = mesh->VertexPosition(mesh->VertexOnFace(face, 0));
+    const R3Point& p1 = mesh->VertexPosition(mesh->VertexOnFace(face, 1));
+    const R3Point& p2 = mesh->VertexPosition(mesh->VertexOnFace(face, 2));
+    RNArea area = 0.5 * ((p1 - p0) % (p2 - p0)).Length();
+    for (int k = 0; k < 3; k++) {
+      vertex_areas[mesh->VertexID(mesh->VertexOnFace(face, k))] += area / 3.0;
+    }
+  }
+
+  // Allocate rows with room for every neighbor and the diagonal
+  int *row_offsets = new int [ nvertices + 1 ];
+  int *row_counts = new int [ nvertices ];
+  row_offsets[0] = 0;
+  for (int i = 0; i < nvertices; i++) {
+    R3MeshVertex *vertex = mesh->Vertex(i);
+    row_offsets[i+1] = row_offsets[i] + mesh->VertexValence(vertex) + 1;
+  }
+  int *columns = new int [ row_offsets[nvertices] ];
+  RNScalar *values = new RNScalar [ row_offsets[nvertices] ];
+
+  // Compute edge weights and fill rows in parallel
+  R3MeshLaplacianAssemblyData task;
+  task.mesh = mesh;
+  task.weighting = weighting;
+  task.edge_weights = new RNScalar [ mesh->NEdges() ];
+  task.row_offsets = row_offsets;
+  task.row_counts = row_counts;
+  task.columns = columns;
+  task.values = values;
+  RNParallelFor(0, mesh->NEdges(), ComputeEdgeWeightsTask, &task, block_size);
+  RNParallelFor(0, nvertices, FillRowsTask, &task, block_size);
+
+  // Compact rows (merged duplicates leave gaps)
+  int nentries = 0;
+  for (int i = 0; i < nvertices; i++) {
+    int start = row_offsets[i];
+    row_offsets[i] = nentries;
+    for (int j = 0; j < row_counts[i]; j++) {
+      columns[nentries] = columns[start + j];
+      values[nentries] = values[start + j];
+      nentries++;
+    }
+  }
+  row_offsets[nvertices] = nentries;
+
+  // Copy rows into matrix
+  matrix.Reset(nvertices, nvertices, row_offsets, columns, values);
+
+  // Delete temporary memory
+  delete [] task.edge_weights;
+  delete [] row_offsets;
+  delete [] row_counts;
+  delete [] columns;
+  delete [] values;
+}
+
+
+
+R3MeshLaplacian::
+~R3MeshLaplacian(void)
+{
+  // Delete vertex areas
+  if (vertex_areas) delete [] vertex_areas;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Solve functions
+////////////////////////////////////////////////////////////////////////
+
+int R3MeshLaplacian::
+SolveScreenedPoisson(RNScalar mass_weight, const RNScalar *rhs, RNScalar *x, int nfunctions) const
+{
+  // Check matrix
+  int n = matrix.NRows();
+  if (n == 0) return 1;
+
+  // Copy laplacian
+  const int *row_offsets = matrix.RowOffsets();
+  const int *columns = matrix.Columns();
+  RNScalar *values = new RNScalar [ matrix.NEntries() ];
+  for (int i = 0; i < matrix.NEntries(); i++) values[i] = matrix.Values()[i];
+
+  // Add weighted vertex areas to diagonal (rows of isolated vertices keep their values)
+  RNBoolean *isolated = new RNBoolean [ n ];
+  for (int i = 0; i < n; i++) {
+    isolated[i] = FALSE;
+    for (int j = row_offsets[i]; j < row_offsets[i+1]; j++) {
+      if (columns[j] != i) continue;
+      values[j] += mass_weight * vertex_areas[i];
+      if (values[j] == 0) { values[j] = 1; isolated[i] = TRUE; }
+      break;
+    }
+  }
+
+  // Create system matrix
+  RNSparseMatrix a;
+  a.Reset(n, n, row_offsets, columns, values);
+
+  // Solve for each function
+  int converged = 1;
+  RNScalar *b = new RNScalar [ n ];
+  for (int k = 0; k < nfunctions; k++) {
+    RNScalar *function_values = &x[k * n];
+    for (int i = 0; i < n; i++) b[i] = (isolated[i]) ? function_values[i] : rhs[k * n + i];
+    if (!a.SolveConjugateGradient(b, function_values, tolerance, max_iterations)) converged = 0;
+  }
+
+  // Delete temporary memory
+  delete [] values;
+  delete [] isolated;
+  delete [] b;
+
+  // Return whether all solves converged
+  return converged;
+}
+
+
+
+int R3MeshLaplacian::
+SolveHarmonic(const RNBoolean *constrained, RNScalar *values, int nfunctions) const
+{
+  // Check matrix
+  int n = matrix.NRows();
+  if (n == 0) return 1;
+
+  // Assign indices of unconstrained vertices
+  int *free_indices = new int [ n ];
+  int *free_vertices = new int [ n ];
+  int nfree = 0;
+  for (int i = 0; i < n; i++) {
+    if (constrained[i]) free_indices[i] = -1;
+    else { free_indices[i] = nfree; free_vertices[nfree++] = i; }
+  }
+
+  // Check if there is anything to solve
+  if (nfree == 0) {
+    delete [] free_indices;
+    delete [] free_vertices;
+    return 1;
+  }
+
+  // Extract rows and columns of unconstrained vertices (column order is preserved)
+  const int *row_offsets = matrix.RowOffsets();
+  const int *columns = matrix.Columns();
+  const RNScalar *laplacian_values = matrix.Values();
+  int *free_row_offsets = new int [ nfree + 1 ];
+  int *free_columns = new int [ matrix.NEntries() ];
+  RNScalar *free_values = new RNScalar [ matrix.NEntries() ];
+  RNBoolean *isolated = new RNBoolean [ nfree ];
+  int nentries = 0;
+  for (int f = 0; f < nfree; f++) {
+    int i = free_vertices[f];
+    free_row_offsets[f] = nentries;
+    isolated[f] = FALSE;
+    for (int j = row_offsets[i]; j < row_offsets[i+1]; j++) {
+      int column = free_indices[columns[j]];
+      if (column < 0) continue;
+      free_columns[nentries] = column;
+      free_values[nentries] = laplacian_values[j];
+      if ((column == f) && (free_values[nentries] == 0)) {
+        free_values[nentries] = 1;
+        isolated[f] = TRUE;
+      }
+      nentries++;
+    }
+  }
+  free_row_offsets[nfree] = nentries;
+  RNSparseMatrix a;
+  a.Reset(nfree, nfree, free_row_offsets, free_columns, free_values);
+
+  // Solve for each function
+  int converged = 1;
+  RNScalar *b = new RNScalar [ nfree ];
+  RNScalar *x = new RNScalar [ nfree ];
+  for (int k = 0; k < nfunctions; k++) {
+    RNScalar *function_values = &values[k * n];
+
+    // Move constrained values to right hand side (b = -L_fc x_c)
+    for (int f = 0; f < nfree; f++) {
+      int i = free_vertices[f];
+      x[f] = function_values[i];
+      b[f] = 0;
+      if (isolated[f]) { b[f] = x[f]; continue; }
+      for (int j = row_offsets[i]; j < row_offsets[i+1]; j++) {
+        if (free_indices[columns[j]] >= 0) continue;
+        b[f] -= laplacian_values[j] * function_values[columns[j]];
+      }
+    }
+
+    // Solve system
+    if (!a.SolveConjugateGradient(b, x, tolerance, max_iterations)) converged = 0;
+
+    // Copy solution
+    for (int f = 0; f < nfree; f++) {
+      function_values[free_vertices[f]] = x[f];
+    }
+  }
+
+  // Delete temporary memory
+  delete [] free_indices;
+  delete [] free_vertices;
+  delete [] free_row_offsets;
+  delete [] free_columns;
+  delete [] free_values;
+  delete [] isolated;
+  delete [] b;
+  delete [] x;
+
+  // Return whether all solves converged
+  return converged;
+}
+
+
+
+int R3MeshLaplacian::
+Smooth(RNScalar time_step)
+{
+  // Check matrix
+  int n = matrix.NRows();
+  if ((n == 0) || (time_step <= 0)) return 1;
+  if (n != mesh->NVertices()) {
+    RNFail("Mesh has changed since laplacian was computed\n");
+    return 0;
+  }
+
+  // Solve (M + t L) p' = M p for all coordinates as (M/t + L) p' = M p / t
+  RNScalar *rhs = new RNScalar [ 3 * n ];
+  RNScalar *x = new RNScalar [ 3 * n ];
+  for (int dim = 0; dim < 3; dim++) {
+    for (int i = 0; i < n; i++) {
+      x[dim * n + i] = mesh->VertexPosition(mesh->Vertex(i))[dim];
+      rhs[dim * n + i] = vertex_areas[i] * x[dim * n + i] / time_step;
+    }
+  }
+  int converged = SolveScreenedPoisson(1.0 / time_step, rhs, x, 3);
+
+  // Move vertices
+  for (int i = 0; i < n; i++) {
+    R3Point position(x[i], x[n + i], x[2*n + i]);
+    mesh->SetVertexPosition(mesh->Vertex(i), position);
+  }
+
+  // Delete temporary memory
+  delete [] rhs;
+  delete [] x;
+
+  // Return whether all solves converged
+  return converged;
+}
+
+
+
+} // namespace gaps
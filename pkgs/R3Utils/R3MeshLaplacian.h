@@ -0,0 +1,163 @@
+// Include file for mesh laplacian class
+#ifndef __R3__MESH__LAPLACIAN__H__
+#define __R3__MESH__LAPLACIAN__H__
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+// Weighting schemes
+
+#define R3_MESH_LAPLACIAN_COTANGENT_WEIGHTS 0
+#define R3_MESH_LAPLACIAN_UNIFORM_WEIGHTS   1
+
+
+
+// Class declaration
+
+// The laplacian of a mesh assembled as a sparse matrix L with a row for
+// every vertex (L_ij = -w_ij for neighbors and L_ii = sum of w_ij), along
+// with lumped vertex areas M (one third of the area of the attached faces).
+// With cotangent weights, L is the stiffness matrix of piecewise linear
+// functions, so it is symmetric positive semidefinite, and the linear
+// systems below are solved with the parallel conjugate gradient solver of
+// RNSparseMatrix.  The matrix is computed when the laplacian is
+// constructed, so it must be rebuilt if the mesh changes.
+
+class R3MeshLaplacian {
+public:
+  // Constructor/destructors
+  R3MeshLaplacian(R3Mesh *mesh, int weighting = R3_MESH_LAPLACIAN_COTANGENT_WEIGHTS);
+  ~R3MeshLaplacian(void);
+
+  // Property functions
+  R3Mesh *Mesh(void) const;
+  int Weighting(void) const;
+  const RNSparseMatrix& Matrix(void) const;
+  RNArea VertexArea(int vertex_index) const;
+  const RNArea *VertexAreas(void) const;
+
+  // Solver parameters
+  RNScalar Tolerance(void) const;
+  int MaxIterations(void) const;
+  void SetTolerance(RNScalar tolerance);
+  void SetMaxIterations(int max_iterations);
+    // Solves stop when the residual is less than tolerance times the norm of the right hand side,
+    // or after max_iterations (default of 0 means the number of vertices)
+
+  // Solve functions (return 1 if the solver converged)
+  int SolveScreenedPoisson(RNScalar mass_weight, const RNScalar *rhs, RNScalar *x, int nfunctions = 1) const;
+    // Solves (mass_weight M + L) x = rhs, starting from the values in x.
+    // Values of function k for vertex i are at x[k*NVertices + i] (and likewise for rhs)
+  int SolveHarmonic(const RNBoolean *constrained, RNScalar *values, int nfunctions = 1) const;
+    // Replaces values of unconstrained vertices with the harmonic interpolation of the values of
+    // constrained vertices (every connected component must have a constrained vertex)
+  int Smooth(RNScalar time_step);
+    // Moves vertices by one implicit step of mean curvature flow, (M + time_step L) p' = M p,
+    // where time_step is in units of squared distance
+
+public:
+  // Internal data
+  R3Mesh *mesh;
+  int weighting;
+  RNSparseMatrix matrix;
+  RNArea *vertex_areas;
+  RNScalar tolerance;
+  int max_iterations;
+};
+
+
+
+// Inline functions
+
+inline R3Mesh *R3MeshLaplacian::
+Mesh(void) const
+{
+  // Return mesh
+  return mesh;
+}
+
+
+
+inline int R3MeshLaplacian::
+Weighting(void) const
+{
+  // Return weighting scheme
+  return weighting;
+}
+
+
+
+inline const RNSparseMatrix& R3MeshLaplacian::
+Matrix(void) const
+{
+  // Return laplacian matrix
+  return matrix;
+}
+
+
+
+inline RNArea R3MeshLaplacian::
+VertexArea(int vertex_index) const
+{
+  // Return lumped area of vertex
+  return vertex_areas[vertex_index];
+}
+
+
+
+inline const RNArea *R3MeshLaplacian::
+VertexAreas(void) const
+{
+  // Return lumped areas of vertices
+  return vertex_areas;
+}
+
+
+
+inline RNScalar R3MeshLaplacian::
+Tolerance(void) const
+{
+  // Return relative residual at which solves stop
+  return tolerance;
+}
+
+
+
+inline int R3MeshLaplacian::
+MaxIterations(void) const
+{
+  // Return maximum number of solver iterations
+  return max_iterations;
+}
+
+
+
+inline void R3MeshLaplacian::
+SetTolerance(RNScalar tolerance)
+{
+  // Set relative residual at which solves stop
+  this->tolerance = tolerance;
+}
+
+
+
+inline void R3MeshLaplacian::
+SetMaxIterations(int max_iterations)
+{
+  // Set maximum number of solver iterations
+  this->max_iterations = max_iterations;
+}
+
+
+
+// End namespace
+}
+
+
+
+// End include guard
+#endif
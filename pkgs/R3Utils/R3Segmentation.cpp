@@ -710,6 +710,26 @@ RemovePoint(R3SegmentationPoint *point)
 
 
 
+struct R3SegmentationPointAffinityTask {
+  const R3SegmentationCluster *cluster;
+  RNScalar *affinities;
+};
+
+
+
+static void
+ComputePointAffinitiesTask(int start, int end, void *data)
+{
+  // Compute affinities of a block of points in cluster
+  R3SegmentationPointAffinityTask *task = (R3SegmentationPointAffinityTask *) data;
+  const R3SegmentationCluster *cluster = task->cluster;
+  for (int i = start; i < end; i++) {
+    task->affinities[i] = cluster->Affinity(cluster->points.Kth(i));
+  }
+}
+
+
+
 void R3SegmentationCluster::
 InsertChild(R3SegmentationCluster *child)
 {
@@ -756,14 +776,30 @@ InsertChild(R3SegmentationCluster *child)
 
   // Update affinities for current points
   if (points.NEntries() < 4 * child->points.NEntries()) {
+    // Compute affinities of points in parallel if cluster is large
+    // (they are summed in order below, so the result does not change)
+    RNScalar *affinities = NULL;
+    const int min_parallel_points = 4096;
+    if (points.NEntries() >= min_parallel_points) {
+      R3SegmentationPointAffinityTask task;
+      affinities = new RNScalar [ points.NEntries() ];
+      task.cluster = this;
+      task.affinities = affinities;
+      RNParallelFor(0, points.NEntries(), ComputePointAffinitiesTask, &task, 1024);
+    }
+
+    // Update affinities
     for (int i = 0; i < points.NEntries(); i++) {
       R3SegmentationPoint *point = points.Kth(i);
-      RNScalar affinity = Affinity(point);
+      RNScalar affinity = (affinities) ? affinities[i] : Affinity(point);
       if (affinity < 0) affinity = 0;
       possible_affinity += affinity - point->cluster_affinity;
       total_affinity += affinity - point->cluster_affinity;
       point->cluster_affinity = affinity;
     }
+
+    // Delete affinities
+    if (affinities) delete [] affinities;
   }
 
   // Insert points from child
@@ -1328,6 +1364,62 @@ FindR3SegmentationPair(R3SegmentationCluster *cluster1, R3SegmentationCluster *c
 
 
 
+struct R3SegmentationPairCandidate {
+  R3SegmentationCluster *cluster;
+  RNScalar affinity;
+};
+
+struct R3SegmentationPairCandidatesTask {
+  const RNArray<R3SegmentationCluster *> *clusters;
+  std::vector<R3SegmentationPairCandidate> *candidates;
+};
+
+
+
+static void
+FindPairCandidatesTask(int start, int end, void *data)
+{
+  // Find clusters with points neighboring a sample of points in each cluster, 
+  // in the order that they are encountered, and compute their affinities
+  R3SegmentationPairCandidatesTask *task = (R3SegmentationPairCandidatesTask *) data;
+  for (int i = start; i < end; i++) {
+    R3SegmentationCluster *cluster0 = task->clusters->Kth(i);
+    std::vector<R3SegmentationPairCandidate>& candidates = task->candidates[i];
+
+    // Sample points
+    const int max_points = 64;
+    int jstep = cluster0->points.NEntries() / max_points;
+    if (jstep == 0) jstep = 1;
+    for (int j = 0; j < cluster0->points.NEntries(); j += jstep) {
+      R3SegmentationPoint *point0 = cluster0->points.Kth(j);
+
+      // Check neighbors
+      for (int k = 0; k < point0->neighbors.NEntries(); k++) {
+        R3SegmentationPoint *point1 = point0->neighbors.Kth(k);
+        if (point0 == point1) continue;
+        R3SegmentationCluster *cluster1 = point1->cluster;
+        if (!cluster1) continue;
+        if (cluster0 == cluster1) continue;
+
+        // Check if already found cluster
+        RNBoolean found = FALSE;
+        for (unsigned int m = 0; m < candidates.size(); m++) {
+          if (candidates[m].cluster == cluster1) { found = TRUE; break; }
+        }
+        if (found) continue;
+
+        // Insert candidate
+        R3SegmentationPairCandidate candidate;
+        candidate.cluster = cluster1;
+        candidate.affinity = cluster0->Affinity(cluster1);
+        candidates.push_back(candidate);
+      }
+    }
+  }
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // R3Segmentation functions
 ////////////////////////////////////////////////////////////////////////
@@ -1778,13 +1870,19 @@ CreateNeighbors(
   double max_neighbor_category_difference,
   RNBoolean partition_identifiers)
 {
-  // Create kdtree of points
+  // Create kdtree of points (for finding points near cluster primitives)
   R3SegmentationPoint tmp; int position_offset = (unsigned char *) &(tmp.position) - (unsigned char *) &tmp;
   kdtree = new R3Kdtree<R3SegmentationPoint *>(points, position_offset);
   if (!kdtree) {
     RNFail("Unable to create kdtree\n");
     return 0;
   }
+
+  // Create hash grid of point positions (for fixed-radius neighbor searches)
+  R3Point *positions = new R3Point [ points.NEntries() ];
+  for (int i = 0; i < points.NEntries(); i++) positions[i] = points[i]->position;
+  R3HashGrid grid(positions, points.NEntries(), max_neighbor_distance);
+  int *closest = new int [ (max_neighbor_count > 0) ? max_neighbor_count : 1 ];
   
   // Create arrays of neighbor points
   for (int i = 0; i < points.NEntries(); i++) {
@@ -1800,7 +1898,9 @@ CreateNeighbors(
     // Create neighbors
     double min_affinity = 0;
     RNArray<R3SegmentationPoint *> neighbors;
-    if (kdtree->FindClosest(point, 0, max_d, max_neighbor_count, neighbors)) {
+    int nclosest = grid.FindClosest(point->position, 0, max_d, max_neighbor_count, closest);
+    for (int j = 0; j < nclosest; j++) neighbors.Insert(points.Kth(closest[j]));
+    if (neighbors.NEntries() > 0) {
       for (int j = 0; j < neighbors.NEntries(); j++) {
         R3SegmentationPoint *neighbor = neighbors.Kth(j);
         if (neighbor == point) continue;
@@ -1845,6 +1945,10 @@ CreateNeighbors(
     }
   }
 
+  // Delete temporary data
+  delete [] positions;
+  delete [] closest;
+
   // Reset cluster affinities
   for (int i = 0; i < points.NEntries(); i++) {
     R3SegmentationPoint *point = points.Kth(i);
@@ -2102,44 +2206,49 @@ MergeClusters(void)
   int cluster_count = clusters.NEntries();
   int merge_count = 0;
   int push_count = 0;
+  RNTime step_time;
+  step_time.Read();
 
   //////////
 
-  // Create pairs between clusters with neighbor points
+  // Find neighbor clusters and compute their affinities (in parallel)
+  std::vector<R3SegmentationPairCandidate> *candidates = new std::vector<R3SegmentationPairCandidate> [ clusters.NEntries() ];
+  R3SegmentationPairCandidatesTask task;
+  task.clusters = &clusters;
+  task.candidates = candidates;
+  RNParallelFor(0, clusters.NEntries(), FindPairCandidatesTask, &task, 256);
+
+  // Create pairs between clusters with neighbor points (in cluster order, so that
+  // the pairs and their order are the same as if they were found serially)
   RNArray<R3SegmentationPair *> pairs;
   for (int i = 0; i < clusters.NEntries(); i++) {
     R3SegmentationCluster *cluster0 = clusters.Kth(i);
+    for (unsigned int j = 0; j < candidates[i].size(); j++) {
+      R3SegmentationCluster *cluster1 = candidates[i][j].cluster;
+      RNScalar affinity = candidates[i][j].affinity;
 
-    // Sample points
-    const int max_points = 64;
-    int jstep = cluster0->points.NEntries() / max_points;
-    if (jstep == 0) jstep = 1;
-    for (int j = 0; j < cluster0->points.NEntries(); j += jstep) {
-      R3SegmentationPoint *point0 = cluster0->points.Kth(j);
+      // Check if already have pair
+      if (FindR3SegmentationPair(cluster0, cluster1)) continue;
 
-      // Check neighbors
-      for (int k = 0; k < point0->neighbors.NEntries(); k++) {
-        R3SegmentationPoint *point1 = point0->neighbors.Kth(k);
-        if (point0 == point1) continue;
-        R3SegmentationCluster *cluster1 = point1->cluster;
-        if (!cluster1) continue;
-        if (cluster0 == cluster1) continue;
+      // Check affinity
+      if ((affinity < min_pair_affinity) && (cluster_count <= max_clusters) && (min_cluster_points == 0) && (min_cluster_area == 0)) continue;
 
-        // Check if already have pair
-        if (FindR3SegmentationPair(cluster0, cluster1)) continue;
+      // Create pair
+      R3SegmentationPair *pair = new R3SegmentationPair(cluster0, cluster1, affinity);
+      if (!pair) continue;
 
-        // Compute affinity
-        RNScalar affinity = cluster0->Affinity(cluster1);
-        if ((affinity < min_pair_affinity) && (cluster_count <= max_clusters) && (min_cluster_points == 0) && (min_cluster_area == 0)) continue;
+      // Insert pair
+      pairs.Insert(pair);
+    }
+  }
 
-        // Create pair
-        R3SegmentationPair *pair = new R3SegmentationPair(cluster0, cluster1, affinity);
-        if (!pair) continue;
+  // Delete candidates
+  delete [] candidates;
 
-        // Insert pair
-        pairs.Insert(pair);
-      }        
-    }
+  // Print debug message
+  if (print_progress) {
+    printf("        MA %.3f %d %d\n", step_time.Elapsed(), cluster_count, pairs.NEntries());
+    step_time.Read();
   }
 
   // Check if there are any pairs
@@ -2230,6 +2339,12 @@ MergeClusters(void)
     delete pair;
   }
 
+  // Print debug message
+  if (print_progress) {
+    printf("        MB %.3f %d %d\n", step_time.Elapsed(), merge_count, push_count);
+    step_time.Read();
+  }
+
   // Remove merged clusters
   RNArray<R3SegmentationCluster *> merged_clusters;
   RNArray<R3SegmentationCluster *> all_clusters = clusters;
@@ -13,6 +13,7 @@
 
 namespace gaps {
 class R3Segmentation;
+class R3MeshLaplacian;
 class R3OrientedBoxManipulator;
 class R3SurfelViewer;
 class R3SurfelSegmenter;
@@ -25,6 +26,7 @@ class R3SurfelLabelerCommand;
 
 /* Dependency include files */
 
+#include "RNMath/RNMath.h"
 #include "R3Graphics/R3Graphics.h"
 #include "R3Surfels/R3Surfels.h"
 
@@ -39,6 +41,7 @@ class R3SurfelLabelerCommand;
 /* Processing utility include files */
 
 #include "R3Segmentation.h"
+#include "R3MeshLaplacian.h"
 
 
 
@@ -26,7 +26,7 @@ int RNInitBasics(void)
     if ((RNbasics_active_count++) > 0) return TRUE;
 
     // Initialize submodules
-    // ???
+    if (!RNInitThreads()) return FALSE;
     
     // Seed random number generator
     RNSeedRandomScalar();
@@ -46,7 +46,7 @@ void RNStopBasics(void)
     if ((--RNbasics_active_count) > 0) return;
 
     // Stop submodules
-    // ???
+    RNStopThreads();
 }
 
 
@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <vector>
 #include <map>
+#include <list>
 
 
 
@@ -3,6 +3,12 @@
 
 // Include files
 #include "RNBasics.h"
+#if (RN_OS == RN_WINDOWS)
+#   include <io.h>
+#   include <map>
+#else
+#   include <unistd.h>
+#endif
 
 
 
@@ -93,6 +99,141 @@ RNFileTell(FILE *fp)
   
 
 
+////////////////////////////////////////////////////////////////////////
+// POSITIONAL READ FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+#if (RN_OS == RN_WINDOWS)
+
+struct RNFileReadHandle {
+  HANDLE file_handle;
+  HANDLE read_handle;
+};
+
+static std::map<FILE *, RNFileReadHandle> RNfile_read_handles;
+static RNMutex RNfile_read_handles_mutex;
+
+
+
+static HANDLE
+RNFindFileReadHandle(FILE *fp)
+{
+  // Find handle reopened for overlapped reads (cached per file, checked
+  // against the handle of fp in case fp was closed without RNFileCloseReadAt)
+  HANDLE file_handle = (HANDLE) _get_osfhandle(_fileno(fp));
+  RNfile_read_handles_mutex.Lock();
+  std::map<FILE *, RNFileReadHandle>::iterator it = RNfile_read_handles.find(fp);
+  if (it != RNfile_read_handles.end()) {
+    if (it->second.file_handle == file_handle) {
+      HANDLE read_handle = it->second.read_handle;
+      RNfile_read_handles_mutex.Unlock();
+      return read_handle;
+    }
+    CloseHandle(it->second.read_handle);
+    RNfile_read_handles.erase(it);
+  }
+
+  // Reopen the file for overlapped reads (ReadFile on the
+  // synchronous handle of fp would move its file pointer)
+  HANDLE read_handle = ReOpenFile(file_handle, GENERIC_READ,
+    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, FILE_FLAG_OVERLAPPED);
+  if (read_handle != INVALID_HANDLE_VALUE) {
+    RNFileReadHandle entry;
+    entry.file_handle = file_handle;
+    entry.read_handle = read_handle;
+    RNfile_read_handles[fp] = entry;
+  }
+
+  // Return handle
+  RNfile_read_handles_mutex.Unlock();
+  return read_handle;
+}
+
+#endif
+
+
+
+int
+RNFileReadAt(FILE *fp, void *ptr, unsigned long long nbytes, unsigned long long offset)
+{
+    // Read nbytes at offset directly from the file descriptor, 
+    // so that multiple threads can read from the same file at once.
+    // Writes to fp must be flushed before data can be read this way.
+    char *buffer = (char *) ptr;
+    unsigned long long sofar = 0;
+#if (RN_OS == RN_WINDOWS)
+    // Get handle reopened for overlapped reads
+    HANDLE handle = RNFindFileReadHandle(fp);
+    if (handle == INVALID_HANDLE_VALUE) {
+        RNFail("Unable to reopen file for read at offset %llu\n", offset);
+        return 0;
+    }
+
+    // Create event signaled when this read completes (the handle is
+    // shared by all threads, so it cannot be waited on itself)
+    HANDLE event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (!event) {
+        RNFail("Unable to create event for read at offset %llu\n", offset);
+        return 0;
+    }
+#endif
+    while (sofar < nbytes) {
+#if (RN_OS == RN_WINDOWS)
+        // Windows
+        unsigned long long position = offset + sofar;
+        unsigned long long remaining = nbytes - sofar;
+        DWORD count = (remaining > 0x40000000ULL) ? 0x40000000 : (DWORD) remaining;
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = (DWORD) (position & 0xFFFFFFFFULL);
+        overlapped.OffsetHigh = (DWORD) (position >> 32);
+        overlapped.hEvent = event;
+        DWORD n = 0;
+        if ((!ReadFile(handle, buffer + sofar, count, NULL, &overlapped) && (GetLastError() != ERROR_IO_PENDING)) ||
+            !GetOverlappedResult(handle, &overlapped, &n, TRUE) || (n == 0)) {
+            RNFail("Unable to read %llu bytes at offset %llu\n", nbytes, offset);
+            CloseHandle(event);
+            return 0;
+        }
+#else
+        // Linux/unix/cygwin etc.
+        ssize_t n = pread(fileno(fp), buffer + sofar, nbytes - sofar, offset + sofar);
+        if (n <= 0) {
+            RNFail("Unable to read %llu bytes at offset %llu\n", nbytes, offset);
+            return 0;
+        }
+#endif
+        sofar += n;
+    }
+
+#if (RN_OS == RN_WINDOWS)
+    // Close event
+    CloseHandle(event);
+#endif
+
+    // Return success
+    return 1;
+}
+
+
+
+void
+RNFileCloseReadAt(FILE *fp)
+{
+#if (RN_OS == RN_WINDOWS)
+    // Close handle cached by RNFileReadAt
+    RNfile_read_handles_mutex.Lock();
+    std::map<FILE *, RNFileReadHandle>::iterator it = RNfile_read_handles.find(fp);
+    if (it != RNfile_read_handles.end()) {
+        CloseHandle(it->second.read_handle);
+        RNfile_read_handles.erase(it);
+    }
+    RNfile_read_handles_mutex.Unlock();
+#endif
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // FILE I/O FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
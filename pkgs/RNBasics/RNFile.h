@@ -34,6 +34,16 @@ unsigned long long RNFileTell(FILE *fp);
 
 
 
+////////////////////////////////////////////////////////////////////////
+// Positional read functions (do not use or move the file cursor)
+////////////////////////////////////////////////////////////////////////
+
+int RNFileReadAt(FILE *fp, void *ptr, unsigned long long nbytes, unsigned long long offset);
+void RNFileCloseReadAt(FILE *fp);
+  // Releases resources cached by RNFileReadAt for fp (call before closing fp)
+
+
+
 ////////////////////////////////////////////////////////////////////////
 // File I/O functions
 ////////////////////////////////////////////////////////////////////////
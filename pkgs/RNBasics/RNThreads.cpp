@@ -0,0 +1,490 @@
+/* Source file for GAPS thread utilities */
+
+
+
+/* Include files */
+
+#include "RNBasics.h"
+#include <thread>
+#include <condition_variable>
+#include <deque>
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+/* Task queue type definitions */
+
+struct RNTask {
+  void (*function)(void *);
+  void *data;
+  RNTaskGroup *group;
+};
+
+struct RNTaskQueue {
+  std::mutex mutex;
+  std::deque<RNTask> tasks;
+};
+
+
+
+/* Task execution function */
+
+void RNExecuteTask(void (*function)(void *), void *data, RNTaskGroup *group);
+
+
+
+/* Thread pool class definition */
+
+class RNThreadPool {
+public:
+  RNThreadPool(void);
+  ~RNThreadPool(void);
+  void Start(int nthreads);
+  void Stop(void);
+  void Push(int index, const RNTask& task);
+  RNBoolean Pop(int index, RNTask& task);
+  static void WorkerLoop(int index);
+
+public:
+  std::vector<std::thread> workers;
+  std::vector<RNTaskQueue *> queues;
+  std::atomic<int> nqueues;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::atomic<int> nqueued;
+  std::atomic<int> npending;
+  std::atomic<int> stop;
+};
+
+
+
+/* Private variables */
+
+static RNThreadPool RNthread_pool;
+static std::atomic<int> RNnthreads(0);
+static std::atomic<int> RNnext_queue_index(0);
+static thread_local int RNthread_index = 0;
+static thread_local int RNthread_queue_index = -1;
+
+
+
+static int
+RNThreadQueueIndex(void)
+{
+  // Assign queues to threads outside the pool round-robin (so that they do not all share one)
+  if (RNthread_queue_index < 0) RNthread_queue_index = RNnext_queue_index++;
+  return RNthread_queue_index;
+}
+
+
+
+int RNInitThreads()
+{
+  // Worker threads are started when tasks are first inserted
+  return TRUE;
+}
+
+
+
+void RNStopThreads()
+{
+  // Check if tasks are pending
+  if (RNthread_pool.npending > 0) {
+    RNFail("Unable to stop threads while tasks are pending\n");
+    return;
+  }
+
+  // Terminate worker threads
+  RNthread_pool.Stop();
+}
+
+
+
+int
+RNNumThreads(void)
+{
+  // Use hardware concurrency if not set explicitly
+  // (set atomically, in case several threads get here at once)
+  int nthreads = RNnthreads;
+  while (nthreads <= 0) {
+    int default_nthreads = std::thread::hardware_concurrency();
+    if (default_nthreads <= 0) default_nthreads = 1;
+    if (RNnthreads.compare_exchange_weak(nthreads, default_nthreads)) nthreads = default_nthreads;
+  }
+
+  // Return number of threads (including the calling thread)
+  return nthreads;
+}
+
+
+
+void
+RNSetNumThreads(int nthreads)
+{
+  // Check if anything changed
+  if (nthreads == RNnthreads) return;
+
+  // Check if tasks are pending (the pool can only be restarted when idle)
+  if (RNthread_pool.npending > 0) {
+    RNFail("Unable to change number of threads while tasks are pending\n");
+    return;
+  }
+
+  // Terminate worker threads (they are restarted when needed)
+  RNthread_pool.Stop();
+
+  // Remember number of threads (0 means hardware concurrency)
+  RNnthreads = nthreads;
+}
+
+
+
+int
+RNThreadIndex(void)
+{
+  // Return index of calling thread in [0, RNNumThreads())
+  return RNthread_index;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Mutex functions
+////////////////////////////////////////////////////////////////////////
+
+RNMutex::
+RNMutex(void)
+{
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Thread pool functions
+////////////////////////////////////////////////////////////////////////
+
+RNThreadPool::
+RNThreadPool(void)
+  : nqueues(0),
+    nqueued(0),
+    npending(0),
+    stop(0)
+{
+}
+
+
+
+RNThreadPool::
+~RNThreadPool(void)
+{
+  // Join worker threads before exit
+  Stop();
+}
+
+
+
+void RNThreadPool::
+Start(int nthreads)
+{
+  // Check if already started
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!queues.empty()) return;
+
+  // Create one queue per thread (queue 0 is for the calling thread)
+  for (int i = 0; i < nthreads; i++) {
+    queues.push_back(new RNTaskQueue());
+  }
+
+  // Publish queues (Push and Pop read them without the pool lock)
+  nqueues = nthreads;
+
+  // Create worker threads
+  stop = 0;
+  for (int i = 1; i < nthreads; i++) {
+    workers.push_back(std::thread(WorkerLoop, i));
+  }
+}
+
+
+
+void RNThreadPool::
+Stop(void)
+{
+  // Signal workers to stop
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queues.empty()) return;
+    nqueues = 0;
+    stop = 1;
+  }
+  condition.notify_all();
+
+  // Join workers
+  for (unsigned int i = 0; i < workers.size(); i++) {
+    workers[i].join();
+  }
+
+  // Delete queues
+  for (unsigned int i = 0; i < queues.size(); i++) {
+    assert(queues[i]->tasks.empty());
+    delete queues[i];
+  }
+
+  // Reset everything
+  workers.clear();
+  queues.clear();
+  nqueued = 0;
+  stop = 0;
+}
+
+
+
+void RNThreadPool::
+Push(int index, const RNTask& task)
+{
+  // Insert task at tail of queue for thread (and count it before it can be popped)
+  RNTaskQueue *queue = queues[index % nqueues];
+  queue->mutex.lock();
+  queue->tasks.push_back(task);
+  nqueued++;
+  queue->mutex.unlock();
+
+  // Wake up a sleeping worker (taking the pool lock, so that a worker
+  // cannot miss the notification between checking the count and waiting)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+  }
+  condition.notify_one();
+}
+
+
+
+RNBoolean RNThreadPool::
+Pop(int index, RNTask& task)
+{
+  // Check if there are any queued tasks
+  if (nqueued <= 0) return FALSE;
+  int nqueues = this->nqueues;
+  if (nqueues <= 0) return FALSE;
+
+  // Take most recent task from own queue (the count is decremented while
+  // the queue is locked, so it is never larger than the number of queued tasks)
+  RNTaskQueue *queue = queues[index % nqueues];
+  queue->mutex.lock();
+  if (!queue->tasks.empty()) {
+    task = queue->tasks.back();
+    queue->tasks.pop_back();
+    nqueued--;
+    queue->mutex.unlock();
+    return TRUE;
+  }
+  queue->mutex.unlock();
+
+  // Steal oldest task from another queue
+  for (int i = 1; i < nqueues; i++) {
+    RNTaskQueue *victim = queues[(index + i) % nqueues];
+    victim->mutex.lock();
+    if (!victim->tasks.empty()) {
+      task = victim->tasks.front();
+      victim->tasks.pop_front();
+      nqueued--;
+      victim->mutex.unlock();
+      return TRUE;
+    }
+    victim->mutex.unlock();
+  }
+
+  // No task found
+  return FALSE;
+}
+
+
+
+void RNThreadPool::
+WorkerLoop(int index)
+{
+  // Remember thread index (workers use their own queue)
+  RNthread_index = index;
+  RNthread_queue_index = index;
+
+  // Execute tasks until stopped
+  RNThreadPool *pool = &RNthread_pool;
+  while (TRUE) {
+    // Execute a task if there is one
+    RNTask task;
+    if (pool->Pop(index, task)) {
+      RNExecuteTask(task.function, task.data, task.group);
+      continue;
+    }
+
+    // Sleep until a task is queued or the pool is stopped
+    // (the count is checked again under the lock before waiting)
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    while (!pool->stop && (pool->nqueued <= 0)) pool->condition.wait(lock);
+    if (pool->stop) break;
+  }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Task group functions
+////////////////////////////////////////////////////////////////////////
+
+void
+RNExecuteTask(void (*function)(void *), void *data, RNTaskGroup *group)
+{
+  // Execute task
+  (*function)(data);
+
+  // Update group
+  if (!group) return;
+  RNthread_pool.npending--;
+  if (--group->npending > 0) return;
+
+  // Wake up threads waiting for group (taking the pool lock, so that
+  // a waiting thread cannot miss the notification)
+  {
+    std::lock_guard<std::mutex> lock(RNthread_pool.mutex);
+  }
+  RNthread_pool.condition.notify_all();
+}
+
+
+
+RNTaskGroup::
+RNTaskGroup(void)
+  : npending(0)
+{
+}
+
+
+
+RNTaskGroup::
+~RNTaskGroup(void)
+{
+  // Wait for tasks to finish
+  Wait();
+}
+
+
+
+void RNTaskGroup::
+Insert(void (*function)(void *), void *data)
+{
+  // Execute task immediately if single-threaded
+  int nthreads = RNNumThreads();
+  if (nthreads <= 1) {
+    (*function)(data);
+    return;
+  }
+
+  // Start thread pool
+  RNthread_pool.Start(nthreads);
+
+  // Queue task for the calling thread
+  RNTask task;
+  task.function = function;
+  task.data = data;
+  task.group = this;
+  npending++;
+  RNthread_pool.npending++;
+  RNthread_pool.Push(RNThreadQueueIndex(), task);
+}
+
+
+
+void RNTaskGroup::
+Wait(void)
+{
+  // Help execute queued tasks until all in this group are done
+  RNThreadPool *pool = &RNthread_pool;
+  while (npending > 0) {
+    // Execute a task if there is one
+    RNTask task;
+    if (pool->Pop(RNThreadQueueIndex(), task)) {
+      RNExecuteTask(task.function, task.data, task.group);
+      continue;
+    }
+
+    // Sleep until a task is queued or the group is done
+    // (both are checked again under the lock before waiting)
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    while ((npending > 0) && (pool->nqueued <= 0)) pool->condition.wait(lock);
+  }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// Parallel loop functions
+////////////////////////////////////////////////////////////////////////
+
+struct RNParallelForChunk {
+  void (*function)(int, int, void *);
+  void *data;
+  int start, end;
+};
+
+
+
+static void
+RNParallelForTask(void *ptr)
+{
+  // Execute function on chunk
+  RNParallelForChunk *chunk = (RNParallelForChunk *) ptr;
+  (*chunk->function)(chunk->start, chunk->end, chunk->data);
+}
+
+
+
+void
+RNParallelFor(int start, int end,
+  void (*function)(int start, int end, void *data), void *data,
+  int grain_size)
+{
+  // Check range
+  int n = end - start;
+  if (n <= 0) return;
+
+  // Execute serially if single-threaded
+  int nthreads = RNNumThreads();
+  if ((nthreads <= 1) || (n == 1)) {
+    (*function)(start, end, data);
+    return;
+  }
+
+  // Determine chunk size (several chunks per thread for load balancing)
+  if (grain_size <= 0) grain_size = n / (8 * nthreads);
+  if (grain_size < 1) grain_size = 1;
+  int nchunks = (n + grain_size - 1) / grain_size;
+
+  // Create chunks
+  RNParallelForChunk *chunks = new RNParallelForChunk [ nchunks ];
+  for (int i = 0; i < nchunks; i++) {
+    chunks[i].function = function;
+    chunks[i].data = data;
+    chunks[i].start = start + i * grain_size;
+    chunks[i].end = chunks[i].start + grain_size;
+    if (chunks[i].end > end) chunks[i].end = end;
+  }
+
+  // Execute chunks in parallel
+  RNTaskGroup group;
+  for (int i = 0; i < nchunks; i++) {
+    group.Insert(RNParallelForTask, &chunks[i]);
+  }
+  group.Wait();
+
+  // Delete chunks
+  delete [] chunks;
+}
+
+
+
+} // namespace gaps
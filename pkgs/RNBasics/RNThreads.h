@@ -0,0 +1,141 @@
+/* Include file for GAPS thread utilities */
+#ifndef __RN__THREADS__H__
+#define __RN__THREADS__H__
+
+
+
+/* Standard library include files */
+
+#include <atomic>
+#include <mutex>
+
+
+
+/* Begin namespace */
+namespace gaps {
+
+
+
+/* Initialization functions */
+
+int RNInitThreads();
+void RNStopThreads();
+
+
+
+/* Thread count functions */
+
+int RNNumThreads(void);
+void RNSetNumThreads(int nthreads);
+  // Must be called while no task groups are pending (e.g., between parallel
+  // loops on the main thread), since it restarts the thread pool; otherwise it fails
+int RNThreadIndex(void);
+  // Returns index of calling thread in [0, RNNumThreads()).  A thread that waits
+  // for a task group (e.g., in a nested RNParallelFor) executes other queued tasks
+  // with the same index, so scratch memory indexed by RNThreadIndex must not be
+  // in use across such a wait
+
+
+
+/* Mutual exclusion lock */
+
+class RNMutex {
+public:
+  // Constructor functions
+  RNMutex(void);
+
+  // Manipulation functions
+  void Lock(void);
+  void Unlock(void);
+  RNBoolean TryLock(void);
+
+private:
+  // Not implemented
+  RNMutex(const RNMutex& mutex);
+  RNMutex& operator=(const RNMutex& mutex);
+
+private:
+  std::mutex mutex;
+};
+
+
+
+/* Group of tasks executed by the shared work-stealing thread pool */
+
+class RNTaskGroup {
+public:
+  // Constructor functions
+  RNTaskGroup(void);
+  ~RNTaskGroup(void);
+
+  // Property functions
+  int NPendingTasks(void) const;
+
+  // Manipulation functions
+  void Insert(void (*function)(void *), void *data);
+  void Wait(void);
+
+private:
+  // Not implemented
+  RNTaskGroup(const RNTaskGroup& group);
+  RNTaskGroup& operator=(const RNTaskGroup& group);
+
+private:
+  friend void RNExecuteTask(void (*)(void *), void *, RNTaskGroup *);
+  std::atomic<int> npending;
+};
+
+
+
+/* Parallel loop functions */
+
+void RNParallelFor(int start, int end,
+  void (*function)(int start, int end, void *data), void *data,
+  int grain_size = 0);
+
+
+
+/* Inline functions */
+
+inline void RNMutex::
+Lock(void)
+{
+  // Acquire lock
+  mutex.lock();
+}
+
+
+
+inline void RNMutex::
+Unlock(void)
+{
+  // Release lock
+  mutex.unlock();
+}
+
+
+
+inline RNBoolean RNMutex::
+TryLock(void)
+{
+  // Acquire lock if it is available
+  return (mutex.try_lock()) ? TRUE : FALSE;
+}
+
+
+
+inline int RNTaskGroup::
+NPendingTasks(void) const
+{
+  // Return number of tasks inserted but not finished
+  return npending;
+}
+
+
+
+// End namespace
+}
+
+
+// End include guard
+#endif
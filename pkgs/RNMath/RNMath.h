@@ -21,6 +21,7 @@ namespace gaps {
 class RNVector;
 class RNMatrix;
 class RNDenseMatrix;
+class RNSparseMatrix;
 class RNPolynomial;
 class RNPolynomialTerm;
 class RNAlgebraic;
@@ -38,6 +39,7 @@ class RNSystemOfEquations;
 #include "RNMatrix.h"
 #include "RNDenseMatrix.h"
 #include "RNDenseLUMatrix.h"
+#include "RNSparseMatrix.h"
 
 
 // Expression and equation classes
@@ -0,0 +1,576 @@
+// Source file for sparse matrix class
+
+
+
+// Include files
+
+#include "RNMath.h"
+
+
+
+// Namespace
+
+namespace gaps {
+
+
+
+// Constants
+
+// Number of rows in each block of parallel loops (and partial sums)
+static const int block_size = 1024;
+
+
+
+// Utility functions
+
+struct RNSparseMatrixColumnCompare {
+  RNSparseMatrixColumnCompare(const int *columns) : columns(columns) {};
+  bool operator()(int a, int b) const { return (columns[a] != columns[b]) ? (columns[a] < columns[b]) : (a < b); };
+  const int *columns;
+};
+
+
+
+// Functions
+
+RNSparseMatrix::
+RNSparseMatrix(void)
+  : nrows(0), ncols(0), row_offsets(NULL), columns(NULL), values(NULL)
+{
+}
+
+
+
+RNSparseMatrix::
+RNSparseMatrix(int nrows, int ncols, int nentries, const int *rows, const int *columns, const RNScalar *values)
+  : nrows(0), ncols(0), row_offsets(NULL), columns(NULL), values(NULL)
+{
+  // Build matrix from triplets
+  Reset(nrows, ncols, nentries, rows, columns, values);
+}
+
+
+
+RNSparseMatrix::
+RNSparseMatrix(const RNSparseMatrix& matrix)
+  : nrows(0), ncols(0), row_offsets(NULL), columns(NULL), values(NULL)
+{
+  // Copy matrix
+  *this = matrix;
+}
+
+
+
+RNSparseMatrix::
+~RNSparseMatrix(void)
+{
+  // Delete arrays
+  if (row_offsets) delete [] row_offsets;
+  if (columns) delete [] columns;
+  if (values) delete [] values;
+}
+
+
+
+int RNSparseMatrix::
+NRows(void) const
+{
+  // Return number of rows
+  return nrows;
+}
+
+
+
+int RNSparseMatrix::
+NColumns(void) const
+{
+  // Return number of columns
+  return ncols;
+}
+
+
+
+RNScalar RNSparseMatrix::
+Value(int i, int j) const
+{
+  // Return entry (i,j), found by binary search in row i
+  assert((i >= 0) && (i < nrows) && (j >= 0) && (j < ncols));
+  const int *start = &columns[row_offsets[i]];
+  const int *end = &columns[row_offsets[i+1]];
+  const int *entry = std::lower_bound(start, end, j);
+  if ((entry == end) || (*entry != j)) return 0;
+  return values[entry - columns];
+}
+
+
+
+void RNSparseMatrix::
+SetValue(int i, int j, RNScalar value)
+{
+  // Set entry (i,j), which must be in the pattern of nonzero entries
+  assert((i >= 0) && (i < nrows) && (j >= 0) && (j < ncols));
+  const int *start = &columns[row_offsets[i]];
+  const int *end = &columns[row_offsets[i+1]];
+  const int *entry = std::lower_bound(start, end, j);
+  if ((entry == end) || (*entry != j)) {
+    RNFail("Entry (%d,%d) is not in sparse matrix\n", i, j);
+    return;
+  }
+  values[entry - columns] = value;
+}
+
+
+
+RNBoolean RNSparseMatrix::
+IsDense(void) const
+{
+  return FALSE;
+}
+
+
+
+RNBoolean RNSparseMatrix::
+IsSparse(void) const
+{
+  return TRUE;
+}
+
+
+
+RNBoolean RNSparseMatrix::
+IsSymmetric(void) const
+{
+  // Check if square
+  if (nrows != ncols) return FALSE;
+
+  // Check if every entry matches its transpose
+  for (int i = 0; i < nrows; i++) {
+    for (int k = row_offsets[i]; k < row_offsets[i+1]; k++) {
+      if (Value(columns[k], i) != values[k]) return FALSE;
+    }
+  }
+
+  // Passed all tests
+  return TRUE;
+}
+
+
+
+RNVector RNSparseMatrix::
+Diagonal(void) const
+{
+  // Return vector of diagonal entries
+  int n = (nrows < ncols) ? nrows : ncols;
+  RNVector diagonal(n);
+  for (int i = 0; i < n; i++) diagonal[i] = Value(i, i);
+  return diagonal;
+}
+
+
+
+void RNSparseMatrix::
+Multiply(RNScalar a)
+{
+  // Scale values
+  for (int k = 0; k < NEntries(); k++) values[k] *= a;
+}
+
+
+
+void RNSparseMatrix::
+Reset(int nrows, int ncols, int nentries, const int *rows, const int *columns, const RNScalar *values)
+{
+  // Delete previous arrays
+  if (this->row_offsets) { delete [] this->row_offsets; this->row_offsets = NULL; }
+  if (this->columns) { delete [] this->columns; this->columns = NULL; }
+  if (this->values) { delete [] this->values; this->values = NULL; }
+
+  // Set dimensions
+  this->nrows = nrows;
+  this->ncols = ncols;
+  this->row_offsets = new int [ nrows + 1 ];
+  for (int i = 0; i <= nrows; i++) this->row_offsets[i] = 0;
+
+  // Bucket triplets by row
+  for (int k = 0; k < nentries; k++) {
+    assert((rows[k] >= 0) && (rows[k] < nrows) && (columns[k] >= 0) && (columns[k] < ncols));
+    this->row_offsets[rows[k]+1]++;
+  }
+  for (int i = 0; i < nrows; i++) this->row_offsets[i+1] += this->row_offsets[i];
+  int *order = new int [ nentries ];
+  int *next = new int [ nrows ];
+  for (int i = 0; i < nrows; i++) next[i] = this->row_offsets[i];
+  for (int k = 0; k < nentries; k++) order[next[rows[k]]++] = k;
+  delete [] next;
+
+  // Sort entries of each row by column, summing values of duplicates
+  this->columns = new int [ nentries ];
+  this->values = new RNScalar [ nentries ];
+  int count = 0;
+  for (int i = 0; i < nrows; i++) {
+    int start = this->row_offsets[i];
+    int end = this->row_offsets[i+1];
+    std::sort(order + start, order + end, RNSparseMatrixColumnCompare(columns));
+    this->row_offsets[i] = count;
+    for (int k = start; k < end; k++) {
+      int entry = order[k];
+      if ((count > this->row_offsets[i]) && (this->columns[count-1] == columns[entry])) {
+        this->values[count-1] += values[entry];
+      }
+      else {
+        this->columns[count] = columns[entry];
+        this->values[count] = values[entry];
+        count++;
+      }
+    }
+  }
+  this->row_offsets[nrows] = count;
+  delete [] order;
+}
+
+
+
+void RNSparseMatrix::
+Reset(int nrows, int ncols, const int *row_offsets, const int *columns, const RNScalar *values)
+{
+  // Delete previous arrays
+  if (this->row_offsets) { delete [] this->row_offsets; this->row_offsets = NULL; }
+  if (this->columns) { delete [] this->columns; this->columns = NULL; }
+  if (this->values) { delete [] this->values; this->values = NULL; }
+
+  // Copy arrays
+  int nentries = row_offsets[nrows];
+  this->nrows = nrows;
+  this->ncols = ncols;
+  this->row_offsets = new int [ nrows + 1 ];
+  this->columns = new int [ nentries ];
+  this->values = new RNScalar [ nentries ];
+  for (int i = 0; i <= nrows; i++) this->row_offsets[i] = row_offsets[i];
+  for (int k = 0; k < nentries; k++) this->columns[k] = columns[k];
+  for (int k = 0; k < nentries; k++) this->values[k] = values[k];
+}
+
+
+
+struct RNSparseMatrixMultiplyData {
+  const RNSparseMatrix *matrix;
+  const RNScalar *x;
+  RNScalar *y;
+};
+
+
+
+static void
+MultiplyTask(int start, int end, void *data)
+{
+  // Compute range of rows of y = A x
+  RNSparseMatrixMultiplyData *task = (RNSparseMatrixMultiplyData *) data;
+  const int *row_offsets = task->matrix->RowOffsets();
+  const int *columns = task->matrix->Columns();
+  const RNScalar *values = task->matrix->Values();
+  for (int i = start; i < end; i++) {
+    RNScalar sum = 0;
+    for (int k = row_offsets[i]; k < row_offsets[i+1]; k++) {
+      sum += values[k] * task->x[columns[k]];
+    }
+    task->y[i] = sum;
+  }
+}
+
+
+
+void RNSparseMatrix::
+Multiply(const RNScalar *x, RNScalar *y) const
+{
+  // Compute y = A x in parallel over rows
+  RNSparseMatrixMultiplyData task;
+  task.matrix = this;
+  task.x = x;
+  task.y = y;
+  RNParallelFor(0, nrows, MultiplyTask, &task, block_size);
+}
+
+
+
+struct RNSparseMatrixSolveData {
+  const RNSparseMatrix *matrix;
+  const RNScalar *b;
+  const RNScalar *inverse_diagonal;
+  RNScalar *x, *r, *z, *p, *q;
+  RNScalar alpha, beta;
+  RNScalar *partial_sums;
+};
+
+
+
+static void
+InitializeResidualTask(int start, int end, void *data)
+{
+  // Compute r = b - A x, z = D^-1 r, p = z, and partial sums of r.z, r.r, and b.b for blocks
+  RNSparseMatrixSolveData *task = (RNSparseMatrixSolveData *) data;
+  const int *row_offsets = task->matrix->RowOffsets();
+  const int *columns = task->matrix->Columns();
+  const RNScalar *values = task->matrix->Values();
+  int nrows = task->matrix->NRows();
+  for (int block = start; block < end; block++) {
+    RNScalar rz = 0, rr = 0, bb = 0;
+    int row_end = (block + 1) * block_size;
+    if (row_end > nrows) row_end = nrows;
+    for (int i = block * block_size; i < row_end; i++) {
+      RNScalar ax = 0;
+      for (int k = row_offsets[i]; k < row_offsets[i+1]; k++) ax += values[k] * task->x[columns[k]];
+      task->r[i] = task->b[i] - ax;
+      task->z[i] = task->inverse_diagonal[i] * task->r[i];
+      task->p[i] = task->z[i];
+      rz += task->r[i] * task->z[i];
+      rr += task->r[i] * task->r[i];
+      bb += task->b[i] * task->b[i];
+    }
+    task->partial_sums[3*block+0] = rz;
+    task->partial_sums[3*block+1] = rr;
+    task->partial_sums[3*block+2] = bb;
+  }
+}
+
+
+
+static void
+ComputeDirectionProductTask(int start, int end, void *data)
+{
+  // Compute q = A p and partial sums of p.q for blocks
+  RNSparseMatrixSolveData *task = (RNSparseMatrixSolveData *) data;
+  const int *row_offsets = task->matrix->RowOffsets();
+  const int *columns = task->matrix->Columns();
+  const RNScalar *values = task->matrix->Values();
+  int nrows = task->matrix->NRows();
+  for (int block = start; block < end; block++) {
+    RNScalar pq = 0;
+    int row_end = (block + 1) * block_size;
+    if (row_end > nrows) row_end = nrows;
+    for (int i = block * block_size; i < row_end; i++) {
+      RNScalar sum = 0;
+      for (int k = row_offsets[i]; k < row_offsets[i+1]; k++) sum += values[k] * task->p[columns[k]];
+      task->q[i] = sum;
+      pq += task->p[i] * sum;
+    }
+    task->partial_sums[3*block+0] = pq;
+    task->partial_sums[3*block+1] = 0;
+    task->partial_sums[3*block+2] = 0;
+  }
+}
+
+
+
+static void
+UpdateSolutionTask(int start, int end, void *data)
+{
+  // Compute x += alpha p, r -= alpha q, z = D^-1 r, and partial sums of r.z and r.r for blocks
+  RNSparseMatrixSolveData *task = (RNSparseMatrixSolveData *) data;
+  int nrows = task->matrix->NRows();
+  RNScalar alpha = task->alpha;
+  for (int block = start; block < end; block++) {
+    RNScalar rz = 0, rr = 0;
+    int row_end = (block + 1) * block_size;
+    if (row_end > nrows) row_end = nrows;
+    for (int i = block * block_size; i < row_end; i++) {
+      task->x[i] += alpha * task->p[i];
+      task->r[i] -= alpha * task->q[i];
+      task->z[i] = task->inverse_diagonal[i] * task->r[i];
+      rz += task->r[i] * task->z[i];
+      rr += task->r[i] * task->r[i];
+    }
+    task->partial_sums[3*block+0] = rz;
+    task->partial_sums[3*block+1] = rr;
+    task->partial_sums[3*block+2] = 0;
+  }
+}
+
+
+
+static void
+UpdateDirectionTask(int start, int end, void *data)
+{
+  // Compute p = z + beta p
+  RNSparseMatrixSolveData *task = (RNSparseMatrixSolveData *) data;
+  int nrows = task->matrix->NRows();
+  RNScalar beta = task->beta;
+  int row_start = start * block_size;
+  int row_end = end * block_size;
+  if (row_end > nrows) row_end = nrows;
+  for (int i = row_start; i < row_end; i++) {
+    task->p[i] = task->z[i] + beta * task->p[i];
+  }
+}
+
+
+
+static void
+SumPartialSums(const RNScalar *partial_sums, int nblocks, RNScalar sums[3])
+{
+  // Sum partial sums of blocks in order (so that results do not depend on threads)
+  sums[0] = sums[1] = sums[2] = 0;
+  for (int block = 0; block < nblocks; block++) {
+    sums[0] += partial_sums[3*block+0];
+    sums[1] += partial_sums[3*block+1];
+    sums[2] += partial_sums[3*block+2];
+  }
+}
+
+
+
+int RNSparseMatrix::
+SolveConjugateGradient(const RNScalar *b, RNScalar *x, RNScalar tolerance, int max_iterations,
+  int *niterations, RNScalar *relative_residual) const
+{
+  // Initialize results
+  if (niterations) *niterations = 0;
+  if (relative_residual) *relative_residual = 0;
+
+  // Check matrix
+  if (nrows != ncols) {
+    RNFail("Conjugate gradient solver requires a square matrix\n");
+    return 0;
+  }
+
+  // Check dimensions
+  int n = nrows;
+  if (n == 0) return 1;
+  if (max_iterations <= 0) max_iterations = n;
+  int nblocks = (n + block_size - 1) / block_size;
+
+  // Allocate temporary vectors
+  RNScalar *inverse_diagonal = new RNScalar [ n ];
+  RNScalar *r = new RNScalar [ n ];
+  RNScalar *z = new RNScalar [ n ];
+  RNScalar *p = new RNScalar [ n ];
+  RNScalar *q = new RNScalar [ n ];
+  RNScalar *partial_sums = new RNScalar [ 3 * nblocks ];
+
+  // Compute jacobi preconditioner
+  for (int i = 0; i < n; i++) {
+    RNScalar d = Value(i, i);
+    inverse_diagonal[i] = (d > 0) ? 1.0 / d : 1.0;
+  }
+
+  // Compute initial residual
+  RNSparseMatrixSolveData task;
+  task.matrix = this;
+  task.b = b;
+  task.inverse_diagonal = inverse_diagonal;
+  task.x = x;
+  task.r = r;
+  task.z = z;
+  task.p = p;
+  task.q = q;
+  task.alpha = 0;
+  task.beta = 0;
+  task.partial_sums = partial_sums;
+  RNScalar sums[3];
+  RNParallelFor(0, nblocks, InitializeResidualTask, &task, 1);
+  SumPartialSums(partial_sums, nblocks, sums);
+  RNScalar rz = sums[0], rr = sums[1], bb = sums[2];
+
+  // Check right hand side
+  RNBoolean converged = FALSE;
+  int iteration = 0;
+  RNScalar residual = 0;
+  if (bb == 0) {
+    // Solution is zero
+    for (int i = 0; i < n; i++) x[i] = 0;
+    converged = TRUE;
+  }
+  else {
+    // Check initial residual
+    RNScalar max_rr = tolerance * tolerance * bb;
+    residual = sqrt(rr / bb);
+    if (rr <= max_rr) converged = TRUE;
+
+    // Iterate
+    while (!converged && (iteration < max_iterations)) {
+      // Compute step along search direction
+      RNParallelFor(0, nblocks, ComputeDirectionProductTask, &task, 1);
+      SumPartialSums(partial_sums, nblocks, sums);
+      RNScalar pq = sums[0];
+      if (pq <= 0) break;
+      task.alpha = rz / pq;
+
+      // Update solution and residual
+      RNParallelFor(0, nblocks, UpdateSolutionTask, &task, 1);
+      SumPartialSums(partial_sums, nblocks, sums);
+      RNScalar rz_next = sums[0];
+      rr = sums[1];
+      residual = sqrt(rr / bb);
+      iteration++;
+      if (rr <= max_rr) { converged = TRUE; break; }
+
+      // Update search direction
+      task.beta = rz_next / rz;
+      rz = rz_next;
+      RNParallelFor(0, nblocks, UpdateDirectionTask, &task, 1);
+    }
+  }
+
+  // Delete temporary vectors
+  delete [] inverse_diagonal;
+  delete [] r;
+  delete [] z;
+  delete [] p;
+  delete [] q;
+  delete [] partial_sums;
+
+  // Return results
+  if (niterations) *niterations = iteration;
+  if (relative_residual) *relative_residual = residual;
+  return (converged) ? 1 : 0;
+}
+
+
+
+RNSparseMatrix& RNSparseMatrix::
+operator=(const RNSparseMatrix& matrix)
+{
+  // Check for self assignment
+  if (this == &matrix) return *this;
+
+  // Delete previous arrays
+  if (row_offsets) { delete [] row_offsets; row_offsets = NULL; }
+  if (columns) { delete [] columns; columns = NULL; }
+  if (values) { delete [] values; values = NULL; }
+
+  // Copy arrays
+  nrows = matrix.nrows;
+  ncols = matrix.ncols;
+  if (matrix.row_offsets) {
+    int nentries = matrix.NEntries();
+    row_offsets = new int [ nrows + 1 ];
+    columns = new int [ nentries ];
+    values = new RNScalar [ nentries ];
+    for (int i = 0; i <= nrows; i++) row_offsets[i] = matrix.row_offsets[i];
+    for (int k = 0; k < nentries; k++) columns[k] = matrix.columns[k];
+    for (int k = 0; k < nentries; k++) values[k] = matrix.values[k];
+  }
+
+  // Return this
+  return *this;
+}
+
+
+
+RNVector
+operator*(const RNSparseMatrix& matrix, const RNVector& vector)
+{
+  // Return product of matrix and vector
+  assert(matrix.NColumns() == vector.NRows());
+  RNScalar *x = new RNScalar [ vector.NRows() ];
+  RNScalar *y = new RNScalar [ matrix.NRows() ];
+  for (int i = 0; i < vector.NRows(); i++) x[i] = vector[i];
+  matrix.Multiply(x, y);
+  RNVector result(matrix.NRows(), y);
+  delete [] x;
+  delete [] y;
+  return result;
+}
+
+
+
+} // namespace gaps
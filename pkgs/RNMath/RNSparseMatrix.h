@@ -0,0 +1,123 @@
+// Include file for sparse matrix class
+#ifndef __RN__SPARSE__MATRIX__H__
+#define __RN__SPARSE__MATRIX__H__
+
+
+
+// Begin namespace
+namespace gaps {
+
+
+
+// Class definition
+
+// A sparse matrix in compressed sparse row (CSR) format.  The pattern of
+// nonzero entries is fixed when the matrix is built from (row, column,
+// value) triplets, after which only the values of existing entries can be
+// changed.  Products and the conjugate gradient solver are computed in
+// parallel over blocks of rows, with reductions summed in block order so
+// that results do not depend on the number of threads.
+
+class RNSparseMatrix : public RNMatrix {
+public:
+  // Constructor/destructor
+  RNSparseMatrix(void);
+  RNSparseMatrix(int nrows, int ncols, int nentries, const int *rows, const int *columns, const RNScalar *values);
+    // Builds matrix from triplets (values of duplicate entries are summed)
+  RNSparseMatrix(const RNSparseMatrix& matrix);
+  virtual ~RNSparseMatrix(void);
+
+  // Entry access
+  virtual int NRows(void) const;
+  virtual int NColumns(void) const;
+  virtual RNScalar Value(int i, int j) const;
+  virtual void SetValue(int i, int j, RNScalar value);
+  int NEntries(void) const;
+  const int *RowOffsets(void) const;
+  const int *Columns(void) const;
+  const RNScalar *Values(void) const;
+    // Entries of row i are at RowOffsets()[i] to RowOffsets()[i+1]-1, sorted by column
+
+  // Property functions/operators
+  virtual RNBoolean IsDense(void) const;
+  virtual RNBoolean IsSparse(void) const;
+  virtual RNBoolean IsSymmetric(void) const;
+  virtual RNVector Diagonal(void) const;
+
+  // Matrix manipulation
+  virtual void Multiply(RNScalar a);
+  virtual void Reset(int nrows, int ncols, int nentries, const int *rows, const int *columns, const RNScalar *values);
+  virtual void Reset(int nrows, int ncols, const int *row_offsets, const int *columns, const RNScalar *values);
+    // Copies matrix in CSR format (columns of each row must be sorted and unique)
+
+  // Products
+  void Multiply(const RNScalar *x, RNScalar *y) const;
+    // Computes y = A x (y must not overlap x)
+
+  // Linear solvers
+  int SolveConjugateGradient(const RNScalar *b, RNScalar *x, RNScalar tolerance = 1.0E-6, int max_iterations = 0,
+    int *niterations = NULL, RNScalar *relative_residual = NULL) const;
+    // Solves A x = b for symmetric positive definite A with Jacobi preconditioned conjugate
+    // gradients, starting from the values in x.  Stops when the residual is less than tolerance
+    // times the norm of b, or after max_iterations (default is NRows).  Returns 1 if converged.
+
+  // Assignment operators
+  RNSparseMatrix& operator=(const RNSparseMatrix& matrix);
+
+  // Arithmetic operators
+  friend RNVector operator*(const RNSparseMatrix& matrix, const RNVector& vector);
+
+protected:
+  int nrows;
+  int ncols;
+  int *row_offsets;
+  int *columns;
+  RNScalar *values;
+};
+
+
+
+// Inline functions
+
+inline int RNSparseMatrix::
+NEntries(void) const
+{
+  // Return number of nonzero entries
+  return (row_offsets) ? row_offsets[nrows] : 0;
+}
+
+
+
+inline const int *RNSparseMatrix::
+RowOffsets(void) const
+{
+  // Return offsets of rows in columns and values (nrows+1 entries)
+  return row_offsets;
+}
+
+
+
+inline const int *RNSparseMatrix::
+Columns(void) const
+{
+  // Return column of each entry
+  return columns;
+}
+
+
+
+inline const RNScalar *RNSparseMatrix::
+Values(void) const
+{
+  // Return value of each entry
+  return values;
+}
+
+
+
+// End namespace
+}
+
+
+// End include guard
+#endif